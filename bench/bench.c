@@ -0,0 +1,795 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   周期路径基准测试模块。
+
+   在模拟网段（见sim.c）上配置给定数量的从站和域，周期性调用
+   ecrt_master_receive()、ecrt_domain_process()、ecrt_domain_queue()和
+   ecrt_master_send()，并分别记录每个阶段的耗时。结果以CSV格式通过
+   /proc/ec_bench 提供，每个阶段一行。
+
+   给出masters参数时，多个主站在各自的测试线程中同时运行相同的周期，
+   每个主站输出自己的结果。用cpus参数把测试线程绑定到CPU，并用主站模块的
+   thread_cpus参数绑定主站线程，可以比较绑定前后主站之间的相互干扰。
+*/
+
+/*****************************************************************************/
+
+#include <linux/version.h>
+#include <linux/module.h>
+#include <linux/kthread.h>
+#include <linux/delay.h>
+#include <linux/vmalloc.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/mutex.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/err.h>
+#include <linux/atomic.h>
+
+#include "../master/globals.h"
+#include "../master/domain.h"
+#include "../master/datagram_pair.h"
+#include "sim.h"
+
+/*****************************************************************************/
+
+#define PFX "ec_bench: "
+
+/** 每个从站每个方向的最大PDO条目数（32位条目）。
+ */
+#define EC_BENCH_MAX_ENTRIES 255
+
+/** 最大域数量。
+ */
+#define EC_BENCH_MAX_DOMAINS 16
+
+/** 正式测量前的预热周期数。
+ */
+#define EC_BENCH_WARMUP 100
+
+/*****************************************************************************/
+
+/** 测量的阶段。
+ */
+enum
+{
+    EC_BENCH_RECEIVE, /**< ecrt_master_receive() */
+    EC_BENCH_PROCESS, /**< 所有域的ecrt_domain_process() */
+    EC_BENCH_QUEUE,   /**< 所有域的ecrt_domain_queue() */
+    EC_BENCH_SEND,    /**< ecrt_master_send() */
+    EC_BENCH_TOTAL,   /**< 整个周期 */
+    EC_BENCH_PHASES
+};
+
+static const char *ec_bench_phase_names[EC_BENCH_PHASES] = {
+    "receive", "process", "queue", "send", "total"};
+
+/** 测试状态。
+ */
+typedef enum
+{
+    EC_BENCH_STATE_RUNNING,
+    EC_BENCH_STATE_DONE,
+    EC_BENCH_STATE_FAILED
+} ec_bench_state_t;
+
+/** 一个阶段的统计结果（原始单位：有周期计数器时为CPU周期，否则为纳秒）。
+ */
+typedef struct
+{
+    u32 min; /**< 最小值。 */
+    u32 avg; /**< 平均值。 */
+    u32 p99; /**< 99百分位。 */
+    u32 max; /**< 最大值。 */
+} ec_bench_result_t;
+
+/** 一个主站的测试上下文。
+ */
+typedef struct
+{
+    unsigned int index;                         /**< 主站序号（从0开始）。 */
+    struct task_struct *thread;                 /**< 测试线程。 */
+    u32 *samples;                               /**< 所有阶段的样本。 */
+    ec_bench_result_t results[EC_BENCH_PHASES]; /**< 统计结果。 */
+    ec_bench_state_t state;                     /**< 测试状态。 */
+    int error;                                  /**< 失败时的错误代码。 */
+    int synced;                                 /**< 已到达同步点。 */
+} ec_bench_ctx_t;
+
+/*****************************************************************************/
+
+static unsigned int master_index = 0;
+static unsigned int slaves = 10;
+static unsigned int domain_size = 1024;
+static unsigned int domains = 1;
+static unsigned int cycles = 10000;
+static unsigned int period_us = 0;
+static bool redundancy = false;
+static unsigned int masters = 1;
+static int cpus[EC_BENCH_SIM_MAX_MASTERS];
+static unsigned int cpu_count = 0;
+
+module_param(master_index, uint, S_IRUGO);
+MODULE_PARM_DESC(master_index, "主站索引");
+module_param(slaves, uint, S_IRUGO);
+MODULE_PARM_DESC(slaves, "模拟从站数量（1-1000）");
+module_param(domain_size, uint, S_IRUGO);
+MODULE_PARM_DESC(domain_size, "过程数据总字节数（64-16384）");
+module_param(domains, uint, S_IRUGO);
+MODULE_PARM_DESC(domains, "域数量");
+module_param(cycles, uint, S_IRUGO);
+MODULE_PARM_DESC(cycles, "测量的周期数");
+module_param(period_us, uint, S_IRUGO);
+MODULE_PARM_DESC(period_us, "周期间隔（微秒），0表示连续运行");
+module_param(redundancy, bool, S_IRUGO);
+MODULE_PARM_DESC(redundancy, "提供备份设备");
+module_param(masters, uint, S_IRUGO);
+MODULE_PARM_DESC(masters, "同时测试的主站数量（1-4），从master_index开始");
+module_param_array(cpus, int, &cpu_count, S_IRUGO);
+MODULE_PARM_DESC(cpus, "每个测试线程绑定的CPU，不给出时不绑定");
+
+/*****************************************************************************/
+
+static struct proc_dir_entry *ec_bench_proc = NULL;
+static ec_bench_ctx_t ec_bench_ctx[EC_BENCH_SIM_MAX_MASTERS];
+static atomic_t ec_bench_ready = ATOMIC_INIT(0);
+
+static DEFINE_MUTEX(ec_bench_mutex);
+static size_t ec_bench_data_size = 0;
+static unsigned int ec_bench_datagrams = 0;
+
+static ec_pdo_entry_info_t ec_bench_out_entries[EC_BENCH_MAX_ENTRIES];
+static ec_pdo_entry_info_t ec_bench_in_entries[EC_BENCH_MAX_ENTRIES];
+
+/*****************************************************************************/
+
+#ifdef EC_HAVE_CYCLES
+#define ec_bench_stamp() ((u64)get_cycles())
+#else
+#define ec_bench_stamp() ((u64)ktime_to_ns(ktime_get()))
+#endif
+
+/*****************************************************************************/
+
+/**
+ * @brief 比较两个样本，用于sort()。
+ */
+static int ec_bench_cmp(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 把原始单位转换为纳秒。
+ * @param value 原始值。
+ * @return 纳秒。
+ */
+static u64 ec_bench_to_ns(u32 value)
+{
+#ifdef EC_HAVE_CYCLES
+    return div_u64((u64)value * 1000000ULL, cpu_khz);
+#else
+    return value;
+#endif
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 为一个阶段计算统计结果。
+ * @param samples 该阶段的样本（会被排序）。
+ * @param result 结果。
+ */
+static void ec_bench_evaluate(u32 *samples, ec_bench_result_t *result)
+{
+    u64 sum = 0;
+    unsigned int i;
+
+    sort(samples, cycles, sizeof(u32), ec_bench_cmp, NULL);
+
+    for (i = 0; i < cycles; i++)
+    {
+        sum += samples[i];
+    }
+
+    result->min = samples[0];
+    result->max = samples[cycles - 1];
+    result->p99 = samples[(cycles - 1) * 99 / 100];
+    result->avg = div_u64(sum, cycles);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 创建从站配置和域。
+ * @param master 主站。
+ * @param domain 输出的域数组（domains 个）。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 过程数据平均分配给所有从站，每个从站各有一个输出PDO和一个
+ * 输入PDO，由32位条目组成。从站按顺序轮流分配给各个域。
+ */
+static int ec_bench_configure(ec_master_t *master, ec_domain_t **domain)
+{
+    ec_pdo_info_t pdos[2];
+    ec_sync_info_t syncs[3];
+    ec_slave_config_t *sc;
+    unsigned int i, bytes, n_out, n_in;
+    int ret;
+
+    bytes = domain_size / slaves;
+    n_out = clamp(DIV_ROUND_UP(bytes / 2, 4), 1U, EC_BENCH_MAX_ENTRIES * 1U);
+    n_in = clamp(DIV_ROUND_UP(bytes - bytes / 2, 4), 1U,
+                 EC_BENCH_MAX_ENTRIES * 1U);
+
+    for (i = 0; i < EC_BENCH_MAX_ENTRIES; i++)
+    {
+        ec_bench_out_entries[i].index = 0x7000;
+        ec_bench_out_entries[i].subindex = i + 1;
+        ec_bench_out_entries[i].bit_length = 32;
+        ec_bench_in_entries[i].index = 0x6000;
+        ec_bench_in_entries[i].subindex = i + 1;
+        ec_bench_in_entries[i].bit_length = 32;
+    }
+
+    pdos[0].index = 0x1600;
+    pdos[0].n_entries = n_out;
+    pdos[0].entries = ec_bench_out_entries;
+    pdos[1].index = 0x1A00;
+    pdos[1].n_entries = n_in;
+    pdos[1].entries = ec_bench_in_entries;
+
+    memset(syncs, 0, sizeof(syncs));
+    syncs[0].index = 2;
+    syncs[0].dir = EC_DIR_OUTPUT;
+    syncs[0].n_pdos = 1;
+    syncs[0].pdos = &pdos[0];
+    syncs[0].watchdog_mode = EC_WD_DEFAULT;
+    syncs[1].index = 3;
+    syncs[1].dir = EC_DIR_INPUT;
+    syncs[1].n_pdos = 1;
+    syncs[1].pdos = &pdos[1];
+    syncs[1].watchdog_mode = EC_WD_DEFAULT;
+    syncs[2].index = 0xff;
+
+    for (i = 0; i < domains; i++)
+    {
+        domain[i] = ecrt_master_create_domain(master);
+        if (!domain[i])
+        {
+            return -ENOMEM;
+        }
+    }
+
+    for (i = 0; i < slaves; i++)
+    {
+        sc = ecrt_master_slave_config(master, 0, i, 0x00000000, 0x00000000);
+        if (!sc)
+        {
+            return -ENOMEM;
+        }
+
+        ret = ecrt_slave_config_pdos(sc, EC_END, syncs);
+        if (ret)
+        {
+            return ret;
+        }
+
+        ret = ecrt_slave_config_reg_pdo_entry(
+            sc, 0x7000, 1, domain[i % domains], NULL);
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        ret = ecrt_slave_config_reg_pdo_entry(
+            sc, 0x6000, 1, domain[i % domains], NULL);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 把所有域数据报的预期工作计数器告知模拟网段。
+ * @param domain 域数组。
+ * @details 所有主站的配置相同，因此每个测试线程都写入相同的应答表。
+ */
+static void ec_bench_setup_wkc(ec_domain_t **domain)
+{
+    ec_bench_wkc_t table[EC_BENCH_SIM_MAX_WKC];
+    ec_datagram_pair_t *pair;
+    unsigned int i, count = 0, datagrams = 0;
+    size_t data_size = 0;
+
+    for (i = 0; i < domains; i++)
+    {
+        data_size += ecrt_domain_size(domain[i]);
+
+        list_for_each_entry(pair, &domain[i]->datagram_pairs, list)
+        {
+            if (count < EC_BENCH_SIM_MAX_WKC)
+            {
+                table[count].address =
+                    EC_READ_U32(pair->datagrams[EC_DEVICE_MAIN].address);
+                table[count].wkc = pair->expected_working_counter;
+                count++;
+            }
+            datagrams++;
+        }
+    }
+
+    if (datagrams > count)
+    {
+        printk(KERN_WARNING PFX "只有前 %u 个数据报（共 %u 个）会得到应答。\n",
+               count, datagrams);
+    }
+
+    ec_bench_sim_set_wkc(table, count);
+
+    mutex_lock(&ec_bench_mutex);
+    ec_bench_data_size = data_size;
+    ec_bench_datagrams = datagrams;
+    mutex_unlock(&ec_bench_mutex);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 执行一个周期并记录各阶段耗时。
+ * @param master 主站。
+ * @param domain 域数组。
+ * @param sample 本周期的样本数组（EC_BENCH_PHASES 个，可为NULL）。
+ */
+static void ec_bench_cycle(ec_master_t *master, ec_domain_t **domain,
+                           u32 *sample)
+{
+    u64 t[EC_BENCH_PHASES + 1];
+    unsigned int i;
+
+    t[0] = ec_bench_stamp();
+    ecrt_master_receive(master);
+    t[1] = ec_bench_stamp();
+    for (i = 0; i < domains; i++)
+    {
+        ecrt_domain_process(domain[i]);
+    }
+    t[2] = ec_bench_stamp();
+    for (i = 0; i < domains; i++)
+    {
+        ecrt_domain_queue(domain[i]);
+    }
+    t[3] = ec_bench_stamp();
+    ecrt_master_send(master);
+    t[4] = ec_bench_stamp();
+
+    if (sample)
+    {
+        for (i = 0; i < EC_BENCH_TOTAL; i++)
+        {
+            sample[i * cycles] = (u32)(t[i + 1] - t[i]);
+        }
+        sample[EC_BENCH_TOTAL * cycles] = (u32)(t[4] - t[0]);
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 在两个周期之间等待。
+ */
+static void ec_bench_wait(void)
+{
+    if (period_us)
+    {
+        usleep_range(period_us, period_us + 1);
+    }
+    else
+    {
+        cond_resched();
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 等待所有测试线程完成预热，使各主站同时测量。
+ * @param ctx 测试上下文。
+ */
+static void ec_bench_sync(ec_bench_ctx_t *ctx)
+{
+    if (!ctx->synced)
+    {
+        ctx->synced = 1;
+        atomic_inc(&ec_bench_ready);
+    }
+
+    while (atomic_read(&ec_bench_ready) < masters && !kthread_should_stop())
+    {
+        usleep_range(100, 200);
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 执行一个主站的基准测试。
+ * @param ctx 测试上下文。
+ * @return 成功返回0，否则返回负错误代码。
+ */
+static int ec_bench_run(ec_bench_ctx_t *ctx)
+{
+    ec_domain_t *domain[EC_BENCH_MAX_DOMAINS];
+    ec_master_t *master;
+    unsigned int i;
+    int ret;
+
+    master = ecrt_request_master(master_index + ctx->index);
+    if (!master)
+    {
+        return -ENODEV;
+    }
+
+    ret = ec_bench_configure(master, domain);
+    if (ret)
+    {
+        goto out_release;
+    }
+
+    ret = ecrt_master_activate(master);
+    if (ret)
+    {
+        goto out_release;
+    }
+
+    ec_bench_setup_wkc(domain);
+
+    for (i = 0; i < EC_BENCH_WARMUP && !kthread_should_stop(); i++)
+    {
+        ec_bench_cycle(master, domain, NULL);
+        ec_bench_wait();
+    }
+
+    ec_bench_sync(ctx);
+
+    for (i = 0; i < cycles; i++)
+    {
+        if (kthread_should_stop())
+        {
+            ret = -EINTR;
+            goto out_release;
+        }
+        ec_bench_cycle(master, domain, ctx->samples + i);
+        ec_bench_wait();
+    }
+
+    mutex_lock(&ec_bench_mutex);
+    for (i = 0; i < EC_BENCH_PHASES; i++)
+    {
+        ec_bench_evaluate(ctx->samples + i * cycles, &ctx->results[i]);
+    }
+    mutex_unlock(&ec_bench_mutex);
+
+out_release:
+    ecrt_release_master(master);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 测试线程。
+ * @param data 测试上下文。
+ * @return 总是返回0。
+ * @details 测试结束后线程保持空闲，直到模块卸载时被停止。
+ */
+static int ec_bench_thread_func(void *data)
+{
+    ec_bench_ctx_t *ctx = data;
+    int ret = ec_bench_run(ctx);
+
+    if (!ctx->synced)
+    {
+        // 不让其他测试线程一直等待
+        ctx->synced = 1;
+        atomic_inc(&ec_bench_ready);
+    }
+
+    mutex_lock(&ec_bench_mutex);
+    ctx->error = ret;
+    ctx->state = ret ? EC_BENCH_STATE_FAILED : EC_BENCH_STATE_DONE;
+    mutex_unlock(&ec_bench_mutex);
+
+    if (ret)
+    {
+        printk(KERN_ERR PFX "主站 %u 测试失败：%d\n",
+               master_index + ctx->index, ret);
+    }
+    else
+    {
+        printk(KERN_INFO PFX "主站 %u 测试完成。\n",
+               master_index + ctx->index);
+    }
+
+    while (!kthread_should_stop())
+    {
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (!kthread_should_stop())
+        {
+            schedule();
+        }
+        __set_current_state(TASK_RUNNING);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 输出测试结果。
+ * @details 第一行注释给出状态；所有主站的测试完成后输出CSV表头和每个主站
+ * 每个阶段一行。纳秒列总是有效；周期列只在有CPU周期计数器时输出。
+ */
+static int ec_bench_show(struct seq_file *m, void *v)
+{
+    const ec_bench_ctx_t *ctx;
+    const ec_bench_result_t *r;
+    unsigned int i, j;
+
+    mutex_lock(&ec_bench_mutex);
+
+    for (j = 0; j < masters; j++)
+    {
+        if (ec_bench_ctx[j].state == EC_BENCH_STATE_RUNNING)
+        {
+            seq_puts(m, "# state=running\n");
+            goto out;
+        }
+    }
+    for (j = 0; j < masters; j++)
+    {
+        if (ec_bench_ctx[j].state == EC_BENCH_STATE_FAILED)
+        {
+            seq_printf(m, "# state=failed error=%d\n", ec_bench_ctx[j].error);
+            goto out;
+        }
+    }
+
+#ifdef EC_HAVE_CYCLES
+    seq_printf(m, "# state=done clock=cycles cpu_khz=%u\n", cpu_khz);
+#else
+    seq_puts(m, "# state=done clock=ns\n");
+#endif
+    seq_puts(m, "slaves,domains,domain_size,datagrams,redundancy,"
+                "masters,master,pinned,cycles,"
+                "phase,min_ns,avg_ns,p99_ns,max_ns,"
+                "min_cycles,avg_cycles,p99_cycles,max_cycles\n");
+
+    for (j = 0; j < masters; j++)
+    {
+        ctx = &ec_bench_ctx[j];
+        for (i = 0; i < EC_BENCH_PHASES; i++)
+        {
+            r = &ctx->results[i];
+            seq_printf(m, "%u,%u,%zu,%u,%u,%u,%u,%u,%u,%s,"
+                          "%llu,%llu,%llu,%llu,",
+                       slaves, domains, ec_bench_data_size,
+                       ec_bench_datagrams, redundancy ? 1 : 0, masters,
+                       master_index + j, j < cpu_count ? 1 : 0, cycles,
+                       ec_bench_phase_names[i],
+                       ec_bench_to_ns(r->min), ec_bench_to_ns(r->avg),
+                       ec_bench_to_ns(r->p99), ec_bench_to_ns(r->max));
+#ifdef EC_HAVE_CYCLES
+            seq_printf(m, "%u,%u,%u,%u\n", r->min, r->avg, r->p99, r->max);
+#else
+            seq_puts(m, ",,,\n");
+#endif
+        }
+    }
+
+out:
+    mutex_unlock(&ec_bench_mutex);
+    return 0;
+}
+
+/*****************************************************************************/
+
+static int ec_bench_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, ec_bench_show, NULL);
+}
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+static const struct proc_ops ec_bench_fops = {
+    .proc_open = ec_bench_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+#else
+static const struct file_operations ec_bench_fops = {
+    .owner = THIS_MODULE,
+    .open = ec_bench_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+#endif
+
+/*****************************************************************************/
+
+/**
+ * @brief 停止测试线程并释放样本。
+ */
+static void ec_bench_ctx_clear(void)
+{
+    ec_bench_ctx_t *ctx;
+    unsigned int i;
+
+    for (i = 0; i < EC_BENCH_SIM_MAX_MASTERS; i++)
+    {
+        ctx = &ec_bench_ctx[i];
+        if (ctx->thread)
+        {
+            kthread_stop(ctx->thread);
+            ctx->thread = NULL;
+        }
+        if (ctx->samples)
+        {
+            vfree(ctx->samples);
+            ctx->samples = NULL;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 模块初始化。
+ * @return 成功返回0，否则返回负错误代码。
+ */
+int __init init_bench_module(void)
+{
+    ec_bench_ctx_t *ctx;
+    unsigned int i;
+    int ret;
+
+    if (slaves < 1 || slaves > 1000 || domains < 1 ||
+        domains > EC_BENCH_MAX_DOMAINS || domains > slaves || cycles < 1 ||
+        cycles > 1000000 || domain_size < 64 || domain_size > 16384 ||
+        masters < 1 || masters > EC_BENCH_SIM_MAX_MASTERS ||
+        cpu_count > masters)
+    {
+        printk(KERN_ERR PFX "参数无效。\n");
+        return -EINVAL;
+    }
+
+    for (i = 0; i < cpu_count; i++)
+    {
+        if (cpus[i] < 0 || cpus[i] >= nr_cpu_ids || !cpu_online(cpus[i]))
+        {
+            printk(KERN_ERR PFX "CPU %d 无效。\n", cpus[i]);
+            return -EINVAL;
+        }
+    }
+
+    for (i = 0; i < masters; i++)
+    {
+        ctx = &ec_bench_ctx[i];
+        ctx->index = i;
+        ctx->state = EC_BENCH_STATE_RUNNING;
+        ctx->samples = vmalloc(sizeof(u32) * cycles * EC_BENCH_PHASES);
+        if (!ctx->samples)
+        {
+            ret = -ENOMEM;
+            goto out_ctx;
+        }
+    }
+
+    ret = ec_bench_sim_init(masters, redundancy ? 2 : 1);
+    if (ret)
+    {
+        goto out_ctx;
+    }
+
+    ec_bench_proc = proc_create("ec_bench", S_IRUGO, NULL, &ec_bench_fops);
+    if (!ec_bench_proc)
+    {
+        ret = -ENOMEM;
+        goto out_sim;
+    }
+
+    for (i = 0; i < masters; i++)
+    {
+        ctx = &ec_bench_ctx[i];
+        ctx->thread = kthread_create(ec_bench_thread_func, ctx,
+                                     "ec_bench/%u", i);
+        if (IS_ERR(ctx->thread))
+        {
+            ret = PTR_ERR(ctx->thread);
+            ctx->thread = NULL;
+            goto out_proc;
+        }
+        if (i < cpu_count)
+        {
+            kthread_bind(ctx->thread, cpus[i]);
+        }
+        wake_up_process(ctx->thread);
+    }
+
+    printk(KERN_INFO PFX "%u 个主站，%u 个从站，%u 个域，%u 字节，"
+           "%u 个周期%s%s。\n", masters, slaves, domains, domain_size, cycles,
+           redundancy ? "，冗余" : "", cpu_count ? "，绑定CPU" : "");
+    return 0;
+
+out_proc:
+    ec_bench_ctx_clear(); // 先停止测试线程
+    proc_remove(ec_bench_proc);
+out_sim:
+    ec_bench_sim_clear();
+out_ctx:
+    ec_bench_ctx_clear();
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 模块清理。
+ */
+void __exit cleanup_bench_module(void)
+{
+    ec_bench_ctx_clear();
+    proc_remove(ec_bench_proc);
+    ec_bench_sim_clear();
+}
+
+/*****************************************************************************/
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Florian Pose <fp@igh-essen.com>");
+MODULE_DESCRIPTION("EtherCAT周期路径基准测试");
+
+module_init(init_bench_module);
+module_exit(cleanup_bench_module);
+
+/*****************************************************************************/
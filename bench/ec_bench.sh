@@ -0,0 +1,226 @@
+#!/bin/sh
+
+#------------------------------------------------------------------------------
+#
+#  EtherCAT cyclic-path benchmark driver
+#
+#  $Id$
+#
+#  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+#
+#  This file is part of the IgH EtherCAT Master.
+#
+#  The IgH EtherCAT Master is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License version 2, as
+#  published by the Free Software Foundation.
+#
+#  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+#  Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License along
+#  with the IgH EtherCAT Master; if not, write to the Free Software
+#  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+#  ---
+#
+#  The license mentioned above concerns the source code only. Using the
+#  EtherCAT technology and brand is only permitted in compliance with the
+#  industrial property and similar rights of Beckhoff Automation GmbH.
+#
+#------------------------------------------------------------------------------
+
+MAC_PREFIX=02:00:00:EC:BE
+PROC=/proc/ec_bench
+RT_PRIORITY=80
+
+MASTER_MODULE=
+BENCH_MODULE=
+OUTPUT=-
+CYCLES=10000
+PERIOD=0
+TIMEOUT=600
+
+SIZES="64 256 1024 4096 16384"
+SLAVES="10 100 1000"
+DOMAINS="1 4"
+REDUNDANCY="0 1"
+MASTERS="1"
+PINNING="0"
+
+#------------------------------------------------------------------------------
+
+usage()
+{
+    cat <<EOF
+Usage: $0 -m <ec_master.ko> -b <ec_bench.ko> [OPTIONS]
+
+Runs the cyclic-path benchmark for every combination of the given
+parameters against a simulated segment and writes one CSV row per
+combination and phase (receive, process, queue, send, total).
+
+Options:
+  -m <file>    ec_master module to load.
+  -b <file>    ec_bench module to load.
+  -o <file>    Output file (default: stdout).
+  -c <n>       Measured cycles per combination (default: $CYCLES).
+  -p <us>      Cycle period in microseconds, 0 = back-to-back
+               (default: $PERIOD).
+  -s <list>    Domain sizes in bytes (default: "$SIZES").
+  -n <list>    Slave counts (default: "$SLAVES").
+  -d <list>    Domain counts (default: "$DOMAINS").
+  -r <list>    Redundancy settings, 0 and/or 1 (default: "$REDUNDANCY").
+  -M <list>    Numbers of masters cycling at the same time, 1-4
+               (default: "$MASTERS").
+  -a <list>    CPU pinning settings, 0 and/or 1 (default: "$PINNING").
+  -h           Show this help.
+
+Cross-master interference: with -M, every master gets its own simulated
+segment and benchmark thread, all masters measure at the same time and
+each one reports its own rows. With pinning 1, master N's threads run
+with SCHED_FIFO priority $RT_PRIORITY on CPU N+1 (thread_cpus,
+thread_policy and thread_priority module parameters) and its benchmark
+thread is bound to the same CPU; CPU 0 is left to the rest of the system.
+Compare the p99 and max columns of "-M '1 4' -a '0 1'" to see how much
+the lines disturb each other with and without pinning.
+
+Both ec_master and ec_bench are reloaded for every combination, so no
+master state (statistics, histograms, timeouts) carries over between rows.
+
+Must be run as root. Any loaded ec_master module is unloaded first.
+EOF
+}
+
+#------------------------------------------------------------------------------
+
+# list <count> <format> <offset>: comma-separated list of <format> applied to
+# N + <offset> for N = 0 .. <count> - 1
+list()
+{
+    N=0
+    RESULT=
+    while [ $N -lt $1 ]; do
+        RESULT=$RESULT${RESULT:+,}$(printf "$2" $((N + $3)))
+        N=$((N + 1))
+    done
+    echo $RESULT
+}
+
+#------------------------------------------------------------------------------
+
+# load_master <redundancy> <masters> <pinning>
+load_master()
+{
+    rmmod ec_master 2>/dev/null
+
+    ARGS="main_devices=$(list $2 "$MAC_PREFIX:%X0" 0)"
+    if [ "$1" = "1" ]; then
+        ARGS="$ARGS backup_devices=$(list $2 "$MAC_PREFIX:%X1" 0)"
+    fi
+    if [ "$3" = "1" ]; then
+        ARGS="$ARGS thread_cpus=$(list $2 %u 1)"
+        ARGS="$ARGS thread_policy=$(list $2 fifo 0)"
+        ARGS="$ARGS thread_priority=$(list $2 $RT_PRIORITY 0)"
+    fi
+
+    insmod "$MASTER_MODULE" $ARGS || exit 1
+}
+
+#------------------------------------------------------------------------------
+
+# run_point <redundancy> <size> <slaves> <domains> <masters> <pinning>
+run_point()
+{
+    load_master $1 $5 $6
+
+    ARGS="masters=$5"
+    if [ "$6" = "1" ]; then
+        ARGS="$ARGS cpus=$(list $5 %u 1)"
+    fi
+
+    if ! insmod "$BENCH_MODULE" redundancy=$1 domain_size=$2 slaves=$3 \
+        domains=$4 cycles=$CYCLES period_us=$PERIOD $ARGS; then
+        echo "Failed to load $BENCH_MODULE" \
+            "(redundancy=$1 domain_size=$2 slaves=$3 domains=$4 $ARGS)." >&2
+        return 1
+    fi
+
+    WAITED=0
+    while grep -q "^# state=running" $PROC; do
+        if [ $WAITED -ge $TIMEOUT ]; then
+            echo "Timeout waiting for benchmark results." >&2
+            break
+        fi
+        sleep 1
+        WAITED=$((WAITED + 1))
+    done
+
+    if grep -q "^# state=done" $PROC; then
+        if [ -z "$HEADER_DONE" ]; then
+            grep -v "^#" $PROC | head -n 1
+            HEADER_DONE=1
+        fi
+        grep -v "^#" $PROC | tail -n +2
+    else
+        head -n 1 $PROC >&2
+    fi
+
+    rmmod ec_bench
+}
+
+#------------------------------------------------------------------------------
+
+while getopts "m:b:o:c:p:s:n:d:r:M:a:h" OPT; do
+    case $OPT in
+        m) MASTER_MODULE=$OPTARG ;;
+        b) BENCH_MODULE=$OPTARG ;;
+        o) OUTPUT=$OPTARG ;;
+        c) CYCLES=$OPTARG ;;
+        p) PERIOD=$OPTARG ;;
+        s) SIZES=$OPTARG ;;
+        n) SLAVES=$OPTARG ;;
+        d) DOMAINS=$OPTARG ;;
+        r) REDUNDANCY=$OPTARG ;;
+        M) MASTERS=$OPTARG ;;
+        a) PINNING=$OPTARG ;;
+        h) usage; exit 0 ;;
+        *) usage >&2; exit 1 ;;
+    esac
+done
+
+if [ -z "$MASTER_MODULE" -o -z "$BENCH_MODULE" ]; then
+    usage >&2
+    exit 1
+fi
+
+if [ "$OUTPUT" != "-" ]; then
+    exec >"$OUTPUT"
+fi
+
+HEADER_DONE=
+
+for RED in $REDUNDANCY; do
+    for MST in $MASTERS; do
+        for PIN in $PINNING; do
+            if [ $PIN = 1 -a $MST -ge $(nproc) ]; then
+                echo "Not enough CPUs to pin $MST masters." >&2
+                continue
+            fi
+            for SIZE in $SIZES; do
+                for NUM in $SLAVES; do
+                    for DOM in $DOMAINS; do
+                        if [ $DOM -gt $NUM ]; then
+                            continue
+                        fi
+                        run_point $RED $SIZE $NUM $DOM $MST $PIN
+                    done
+                done
+            done
+        done
+    done
+done
+
+rmmod ec_master
+
+#------------------------------------------------------------------------------
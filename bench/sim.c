@@ -0,0 +1,392 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   基准测试用的模拟EtherCAT网段。
+
+   每个模拟端口是一个不注册到网络协议栈的net_device。发送的帧被复制到
+   端口的接收环中，并在下一次轮询时通过ecdev_receive()交还给主站，
+   相当于一个没有传输延迟的闭合网段。主端口上的逻辑数据报按应答表填写
+   工作计数器，其余数据报原样返回（工作计数器为0），因此主站扫描到0个从站。
+   可以同时为多个主站各提供一组端口，各组使用相同的应答表。
+*/
+
+/*****************************************************************************/
+
+#include <linux/version.h>
+#include <linux/module.h>
+#include <linux/netdevice.h>
+#include <linux/etherdevice.h>
+#include <linux/spinlock.h>
+
+#include "../master/globals.h"
+#include "../master/datagram.h"
+#include "../devices/ecdev.h"
+#include "sim.h"
+
+/*****************************************************************************/
+
+/** 每个端口接收环中的帧数。
+ */
+#define EC_BENCH_SIM_RING_SIZE 32
+
+/*****************************************************************************/
+
+/** 模拟端口。
+ */
+typedef struct
+{
+    struct net_device *dev;   /**< 网络设备。 */
+    ec_device_t *ecdev;       /**< 主站的EtherCAT设备。 */
+    unsigned int index;       /**< 端口索引（主/备份）。 */
+    unsigned int master;      /**< 端口所属主站的序号。 */
+    int open;                 /**< 已通过ecdev_open()打开。 */
+    spinlock_t lock;          /**< 保护接收环索引的锁。 */
+    unsigned int rx_head;     /**< 接收环写索引。 */
+    unsigned int rx_tail;     /**< 接收环读索引。 */
+    unsigned long rx_dropped; /**< 因接收环已满而丢弃的帧数。 */
+    size_t rx_size[EC_BENCH_SIM_RING_SIZE];                 /**< 帧长度。 */
+    uint8_t rx_data[EC_BENCH_SIM_RING_SIZE][ETH_FRAME_LEN]; /**< 帧数据。 */
+} ec_bench_sim_port_t;
+
+/*****************************************************************************/
+
+static ec_bench_sim_port_t
+    ec_bench_sim_ports[EC_BENCH_SIM_MAX_MASTERS * EC_MAX_NUM_DEVICES];
+static unsigned int ec_bench_sim_num_ports = 0;
+
+static ec_bench_wkc_t ec_bench_sim_wkc[EC_BENCH_SIM_MAX_WKC];
+static unsigned int ec_bench_sim_wkc_count = 0;
+static DEFINE_SPINLOCK(ec_bench_sim_wkc_lock);
+
+/*****************************************************************************/
+
+/**
+ * @brief 按应答表填写帧中逻辑数据报的工作计数器。
+ * @param port 模拟端口。
+ * @param frame 以太网帧。
+ * @param size 帧长度。
+ */
+static void ec_bench_sim_process(
+    const ec_bench_sim_port_t *port, /**< 模拟端口 */
+    uint8_t *frame,                  /**< 以太网帧 */
+    size_t size                      /**< 帧长度 */
+)
+{
+    uint8_t *cur = frame + ETH_HLEN + EC_FRAME_HEADER_SIZE;
+    const uint8_t *end = frame + size;
+    uint16_t len_flags, data_size;
+    uint8_t type;
+    uint32_t address;
+    unsigned int i;
+
+    if (port->index != EC_DEVICE_MAIN)
+    {
+        // 闭合环网中所有从站都已由主端口的帧处理
+        return;
+    }
+
+    while (cur + EC_DATAGRAM_HEADER_SIZE + EC_DATAGRAM_FOOTER_SIZE <= end)
+    {
+        type = EC_READ_U8(cur);
+        len_flags = EC_READ_U16(cur + 6);
+        data_size = len_flags & 0x07FF;
+
+        if (cur + EC_DATAGRAM_HEADER_SIZE + data_size +
+                EC_DATAGRAM_FOOTER_SIZE > end)
+        {
+            break;
+        }
+
+        if (type == EC_DATAGRAM_LRD || type == EC_DATAGRAM_LWR ||
+            type == EC_DATAGRAM_LRW)
+        {
+            address = EC_READ_U32(cur + 2);
+            for (i = 0; i < ec_bench_sim_wkc_count; i++)
+            {
+                if (ec_bench_sim_wkc[i].address == address)
+                {
+                    EC_WRITE_U16(cur + EC_DATAGRAM_HEADER_SIZE + data_size,
+                                 ec_bench_sim_wkc[i].wkc);
+                    break;
+                }
+            }
+        }
+
+        if (!(len_flags & 0x8000))
+        {
+            break;
+        }
+        cur += EC_DATAGRAM_HEADER_SIZE + data_size + EC_DATAGRAM_FOOTER_SIZE;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 打开模拟端口。
+ * @param dev 网络设备。
+ * @return 总是返回0。
+ */
+static int ec_bench_sim_open(struct net_device *dev)
+{
+    netif_start_queue(dev);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 停止模拟端口。
+ * @param dev 网络设备。
+ * @return 总是返回0。
+ */
+static int ec_bench_sim_stop(struct net_device *dev)
+{
+    netif_stop_queue(dev);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 发送一帧：复制到接收环中并模拟从站处理。
+ * @param skb 套接字缓冲区（归主站所有，不能释放）。
+ * @param dev 网络设备。
+ * @return 总是返回NETDEV_TX_OK。
+ */
+static netdev_tx_t ec_bench_sim_xmit(struct sk_buff *skb, struct net_device *dev)
+{
+    ec_bench_sim_port_t *port = *(ec_bench_sim_port_t **)netdev_priv(dev);
+    unsigned int head, next;
+
+    spin_lock(&port->lock);
+    head = port->rx_head;
+    next = (head + 1) % EC_BENCH_SIM_RING_SIZE;
+    if (unlikely(next == port->rx_tail || skb->len > ETH_FRAME_LEN))
+    {
+        port->rx_dropped++;
+        spin_unlock(&port->lock);
+        return NETDEV_TX_OK;
+    }
+    spin_unlock(&port->lock);
+
+    memcpy(port->rx_data[head], skb->data, skb->len);
+    port->rx_size[head] = skb->len;
+
+    spin_lock(&ec_bench_sim_wkc_lock);
+    ec_bench_sim_process(port, port->rx_data[head], skb->len);
+    spin_unlock(&ec_bench_sim_wkc_lock);
+
+    spin_lock(&port->lock);
+    port->rx_head = next;
+    spin_unlock(&port->lock);
+    return NETDEV_TX_OK;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 轮询函数：把接收环中的帧交给主站。
+ * @param dev 网络设备。
+ */
+static void ec_bench_sim_poll(struct net_device *dev)
+{
+    ec_bench_sim_port_t *port = *(ec_bench_sim_port_t **)netdev_priv(dev);
+    unsigned int tail, head;
+
+    spin_lock(&port->lock);
+    tail = port->rx_tail;
+    head = port->rx_head;
+    spin_unlock(&port->lock);
+
+    while (tail != head)
+    {
+        ecdev_receive(port->ecdev, port->rx_data[tail], port->rx_size[tail]);
+        tail = (tail + 1) % EC_BENCH_SIM_RING_SIZE;
+    }
+
+    spin_lock(&port->lock);
+    port->rx_tail = tail;
+    spin_unlock(&port->lock);
+}
+
+/*****************************************************************************/
+
+static const struct net_device_ops ec_bench_sim_netdev_ops = {
+    .ndo_open = ec_bench_sim_open,
+    .ndo_stop = ec_bench_sim_stop,
+    .ndo_start_xmit = ec_bench_sim_xmit,
+};
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放一个模拟端口。
+ * @param port 模拟端口。
+ */
+static void ec_bench_sim_port_clear(ec_bench_sim_port_t *port)
+{
+    if (port->ecdev)
+    {
+        if (port->open)
+        {
+            ecdev_close(port->ecdev);
+            port->open = 0;
+        }
+        ecdev_withdraw(port->ecdev);
+        port->ecdev = NULL;
+    }
+    if (port->dev)
+    {
+        free_netdev(port->dev);
+        port->dev = NULL;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 创建模拟端口并提供给主站。
+ * @param num_masters 主站数量。
+ * @param num_ports 每个主站的端口数量（1：仅主设备，2：主设备和备份设备）。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 第一个主站必须以 main_devices=02:00:00:EC:BE:00
+ * （和 backup_devices=02:00:00:EC:BE:01）加载，第二个主站使用
+ * 02:00:00:EC:BE:10（和 02:00:00:EC:BE:11），依此类推。
+ */
+int ec_bench_sim_init(unsigned int num_masters, unsigned int num_ports)
+{
+    ec_bench_sim_port_t *port;
+    uint8_t mac[ETH_ALEN] = {EC_BENCH_SIM_MAC, 0x00};
+    unsigned int i;
+    int ret;
+
+    if (num_masters < 1 || num_masters > EC_BENCH_SIM_MAX_MASTERS ||
+        num_ports < 1 || num_ports > EC_MAX_NUM_DEVICES)
+    {
+        return -EINVAL;
+    }
+
+    for (i = 0; i < num_masters * num_ports; i++)
+    {
+        port = &ec_bench_sim_ports[i];
+        memset(port, 0, offsetof(ec_bench_sim_port_t, rx_size));
+        port->index = i % num_ports;
+        port->master = i / num_ports;
+        spin_lock_init(&port->lock);
+
+        port->dev = alloc_etherdev(sizeof(ec_bench_sim_port_t *));
+        if (!port->dev)
+        {
+            ret = -ENOMEM;
+            goto out_clear;
+        }
+        *(ec_bench_sim_port_t **)netdev_priv(port->dev) = port;
+        port->dev->netdev_ops = &ec_bench_sim_netdev_ops;
+        mac[ETH_ALEN - 1] = port->master << 4 | port->index;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 15, 0)
+        eth_hw_addr_set(port->dev, mac);
+#else
+        memcpy(port->dev->dev_addr, mac, ETH_ALEN);
+#endif
+        ec_bench_sim_num_ports = i + 1;
+
+        port->ecdev = ecdev_offer(port->dev, ec_bench_sim_poll, THIS_MODULE);
+        if (!port->ecdev)
+        {
+            printk(KERN_ERR "ec_bench: 没有主站接受模拟设备 %pM。\n", mac);
+            ret = -ENODEV;
+            goto out_clear;
+        }
+    }
+
+    for (i = 0; i < num_masters * num_ports; i++)
+    {
+        port = &ec_bench_sim_ports[i];
+        ret = ecdev_open(port->ecdev);
+        if (ret)
+        {
+            printk(KERN_ERR "ec_bench: 打开模拟设备失败：%d\n", ret);
+            goto out_clear;
+        }
+        port->open = 1;
+        ecdev_set_link(port->ecdev, 1);
+    }
+
+    return 0;
+
+out_clear:
+    ec_bench_sim_clear();
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 从主站撤回并释放所有模拟端口。
+ */
+void ec_bench_sim_clear(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < ec_bench_sim_num_ports; i++)
+    {
+        if (ec_bench_sim_ports[i].rx_dropped)
+        {
+            printk(KERN_WARNING "ec_bench: 端口 %u 丢弃了 %lu 帧。\n",
+                   i, ec_bench_sim_ports[i].rx_dropped);
+        }
+        ec_bench_sim_port_clear(&ec_bench_sim_ports[i]);
+    }
+    ec_bench_sim_num_ports = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 设置逻辑数据报的应答表。
+ * @param table 应答条目。
+ * @param count 条目数量（超过 EC_BENCH_SIM_MAX_WKC 的部分被忽略）。
+ */
+void ec_bench_sim_set_wkc(const ec_bench_wkc_t *table, unsigned int count)
+{
+    if (count > EC_BENCH_SIM_MAX_WKC)
+    {
+        count = EC_BENCH_SIM_MAX_WKC;
+    }
+
+    spin_lock(&ec_bench_sim_wkc_lock);
+    memcpy(ec_bench_sim_wkc, table, count * sizeof(ec_bench_wkc_t));
+    ec_bench_sim_wkc_count = count;
+    spin_unlock(&ec_bench_sim_wkc_lock);
+}
+
+/*****************************************************************************/
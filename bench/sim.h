@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2008  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   基准测试用的模拟EtherCAT网段。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_BENCH_SIM_H__
+#define __EC_BENCH_SIM_H__
+
+#include <linux/types.h>
+
+/*****************************************************************************/
+
+/** 模拟网段最多可应答的逻辑数据报数量。
+ */
+#define EC_BENCH_SIM_MAX_WKC 64
+
+/** 最多模拟的主站数量。
+ */
+#define EC_BENCH_SIM_MAX_MASTERS 4
+
+/** 模拟设备的MAC地址前缀（本地管理地址，最后一个字节的高4位为主站序号，
+ * 低4位为设备索引）。
+ */
+#define EC_BENCH_SIM_MAC 0x02, 0x00, 0x00, 0xEC, 0xBE
+
+/*****************************************************************************/
+
+/** 逻辑数据报的应答条目。
+ */
+typedef struct
+{
+    uint32_t address; /**< 逻辑地址。 */
+    uint16_t wkc;     /**< 应答的工作计数器。 */
+} ec_bench_wkc_t;
+
+/*****************************************************************************/
+
+int ec_bench_sim_init(unsigned int, unsigned int);
+void ec_bench_sim_clear(void);
+void ec_bench_sim_set_wkc(const ec_bench_wkc_t *, unsigned int);
+
+/*****************************************************************************/
+
+#endif
@@ -74,6 +74,15 @@ void ecdev_receive(ec_device_t *device, const void *data, size_t size);
 void ecdev_set_link(ec_device_t *device, uint8_t state);
 uint8_t ecdev_get_link(const ec_device_t *device);
 
+/******************************************************************************
+ * Hardware timestamping (optional)
+ *****************************************************************************/
+
+uint8_t ecdev_get_timestamping(const ec_device_t *device);
+void ecdev_set_rx_timestamp(ec_device_t *device, ktime_t hwtstamp);
+void ecdev_set_tx_timestamp(ec_device_t *device, const struct sk_buff *skb,
+        ktime_t hwtstamp);
+
 /*****************************************************************************/
 
 #endif
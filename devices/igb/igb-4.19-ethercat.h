@@ -686,6 +686,9 @@ void igb_ptp_rx_pktstamp(struct igb_q_vector *q_vector, void *va,
 			 struct sk_buff *skb);
 int igb_ptp_set_ts_config(struct net_device *netdev, struct ifreq *ifr);
 int igb_ptp_get_ts_config(struct net_device *netdev, struct ifreq *ifr);
+void igb_ptp_ec_enable(struct igb_adapter *adapter);
+ktime_t igb_ptp_ec_rx_pktstamp(struct igb_q_vector *q_vector, void *va);
+void igb_ptp_ec_tx_hwtstamp(struct igb_adapter *adapter);
 void igb_set_flag_queue_pairs(struct igb_adapter *, const u32);
 unsigned int igb_get_max_rss_queues(struct igb_adapter *);
 #ifdef CONFIG_IGB_HWMON
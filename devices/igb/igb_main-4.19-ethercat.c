@@ -2939,6 +2939,10 @@ void ec_poll(struct net_device *netdev)
 		adapter->ec_watchdog_jiffies = jiffies;
 	}
 
+	/* pass a pending Tx timestamp before the response is received */
+	if (adapter->ptp_tx_skb)
+		igb_ptp_ec_tx_hwtstamp(adapter);
+
 	for (i = 0; i < adapter->num_q_vectors; i++) {
 		struct igb_q_vector *q_vector = adapter->q_vector[i];
 		if (q_vector->tx.ring) {
@@ -3482,6 +3486,8 @@ static int igb_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 
 	/* do hw tstamp init after resetting */
 	igb_ptp_init(adapter);
+	if (adapter->ecdev && ecdev_get_timestamping(adapter->ecdev))
+		igb_ptp_ec_enable(adapter);
 
 	dev_info(&pdev->dev, "Intel(R) Gigabit Ethernet Network Connection\n");
 	/* print bus type/speed/width info, not applicable to i354 */
@@ -6242,6 +6248,20 @@ netdev_tx_t igb_xmit_frame_ring(struct sk_buff *skb,
 		}
 	}
 
+	/* EtherCAT frames are owned by the master, so no reference is taken */
+	if (unlikely(adapter->ecdev &&
+				(skb_shinfo(skb)->tx_flags & SKBTX_HW_TSTAMP))) {
+		if (adapter->tstamp_config.tx_type == HWTSTAMP_TX_ON &&
+		    !test_and_set_bit_lock(__IGB_PTP_TX_IN_PROGRESS,
+					   &adapter->state)) {
+			tx_flags |= IGB_TX_FLAGS_TSTAMP;
+			adapter->ptp_tx_skb = skb;
+			adapter->ptp_tx_start = jiffies;
+		} else {
+			adapter->tx_hwtstamp_skipped++;
+		}
+	}
+
 	if (skb_vlan_tag_present(skb)) {
 		tx_flags |= IGB_TX_FLAGS_VLAN;
 		tx_flags |= (skb_vlan_tag_get(skb) << IGB_TX_FLAGS_VLAN_SHIFT);
@@ -6271,7 +6291,9 @@ cleanup_tx_tstamp:
 	if (unlikely(tx_flags & IGB_TX_FLAGS_TSTAMP)) {
 		struct igb_adapter *adapter = netdev_priv(tx_ring->netdev);
 
-		dev_kfree_skb_any(adapter->ptp_tx_skb);
+		/* EtherCAT frames belong to the master and are not freed */
+		if (!adapter->ecdev)
+			dev_kfree_skb_any(adapter->ptp_tx_skb);
 		adapter->ptp_tx_skb = NULL;
 		if (adapter->hw.mac.type == e1000_82576)
 			cancel_work_sync(&adapter->ptp_tx_work);
@@ -8476,6 +8498,12 @@ static int igb_clean_rx_irq(struct igb_q_vector *q_vector, const int budget)
 		if (adapter->ecdev) {
 			unsigned char *va = page_address(rx_buffer->page) + rx_buffer->page_offset;
 			unsigned int size = le16_to_cpu(rx_desc->wb.upper.length);
+			if (igb_test_staterr(rx_desc, E1000_RXDADV_STAT_TSIP)) {
+				ecdev_set_rx_timestamp(adapter->ecdev,
+						igb_ptp_ec_rx_pktstamp(q_vector, va));
+				va += IGB_TS_HDR_LEN;
+				size -= IGB_TS_HDR_LEN;
+			}
 			ecdev_receive(adapter->ecdev, va, size);
 			adapter->ec_watchdog_jiffies = jiffies;
 
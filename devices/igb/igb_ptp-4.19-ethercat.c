@@ -625,7 +625,9 @@ static void igb_ptp_tx_work(struct work_struct *work)
 
 	if (time_is_before_jiffies(adapter->ptp_tx_start +
 				   IGB_PTP_TX_TIMEOUT)) {
-		dev_kfree_skb_any(adapter->ptp_tx_skb);
+		/* EtherCAT frames belong to the master and are not freed */
+		if (!adapter->ecdev)
+			dev_kfree_skb_any(adapter->ptp_tx_skb);
 		adapter->ptp_tx_skb = NULL;
 		clear_bit_unlock(__IGB_PTP_TX_IN_PROGRESS, &adapter->state);
 		adapter->tx_hwtstamp_timeouts++;
@@ -637,6 +639,10 @@ static void igb_ptp_tx_work(struct work_struct *work)
 		return;
 	}
 
+	/* EtherCAT timestamps are passed on by igb_ptp_ec_tx_hwtstamp() */
+	if (adapter->ecdev)
+		return;
+
 	tsynctxctl = rd32(E1000_TSYNCTXCTL);
 	if (tsynctxctl & E1000_TSYNCTXCTL_VALID)
 		igb_ptp_tx_hwtstamp(adapter);
@@ -714,6 +720,10 @@ void igb_ptp_tx_hang(struct igb_adapter *adapter)
 	if (!adapter->ptp_tx_skb)
 		return;
 
+	/* EtherCAT frames belong to the master, see igb_ptp_ec_tx_hwtstamp() */
+	if (adapter->ecdev)
+		return;
+
 	if (!test_bit(__IGB_PTP_TX_IN_PROGRESS, &adapter->state))
 		return;
 
@@ -828,6 +838,98 @@ void igb_ptp_rx_pktstamp(struct igb_q_vector *q_vector, void *va,
 		ktime_sub_ns(skb_hwtstamps(skb)->hwtstamp, adjust);
 }
 
+/**
+ * igb_ptp_ec_rx_pktstamp - retrieve Rx per packet timestamp for EtherCAT
+ * @q_vector: Pointer to interrupt specific structure
+ * @va: Pointer to address containing Rx buffer
+ *
+ * Same as igb_ptp_rx_pktstamp(), but returns the timestamp instead of
+ * storing it in an skb, because EtherCAT frames are passed to the master
+ * directly from the Rx buffer.
+ **/
+ktime_t igb_ptp_ec_rx_pktstamp(struct igb_q_vector *q_vector, void *va)
+{
+	__le64 *regval = (__le64 *)va;
+	struct igb_adapter *adapter = q_vector->adapter;
+	struct skb_shared_hwtstamps hwtstamps;
+	int adjust = 0;
+
+	igb_ptp_systim_to_hwtstamp(adapter, &hwtstamps,
+				   le64_to_cpu(regval[1]));
+
+	if (adapter->hw.mac.type == e1000_i210) {
+		switch (adapter->link_speed) {
+		case SPEED_10:
+			adjust = IGB_I210_RX_LATENCY_10;
+			break;
+		case SPEED_100:
+			adjust = IGB_I210_RX_LATENCY_100;
+			break;
+		case SPEED_1000:
+			adjust = IGB_I210_RX_LATENCY_1000;
+			break;
+		}
+	}
+
+	return ktime_sub_ns(hwtstamps.hwtstamp, adjust);
+}
+
+/**
+ * igb_ptp_ec_tx_hwtstamp - pass a pending Tx timestamp to the EtherCAT master
+ * @adapter: Board private structure.
+ *
+ * Called from the EtherCAT poll routine, as interrupts and the Tx work
+ * are not used in EtherCAT mode. Only one frame can be timestamped at a
+ * time; the skb belongs to the master and must not be freed here.
+ **/
+void igb_ptp_ec_tx_hwtstamp(struct igb_adapter *adapter)
+{
+	struct e1000_hw *hw = &adapter->hw;
+	struct skb_shared_hwtstamps hwtstamps;
+	u64 regval;
+	int adjust = 0;
+
+	if (!test_bit(__IGB_PTP_TX_IN_PROGRESS, &adapter->state))
+		return;
+
+	if (!(rd32(E1000_TSYNCTXCTL) & E1000_TSYNCTXCTL_VALID)) {
+		if (time_is_before_jiffies(adapter->ptp_tx_start +
+					   IGB_PTP_TX_TIMEOUT)) {
+			adapter->ptp_tx_skb = NULL;
+			clear_bit_unlock(__IGB_PTP_TX_IN_PROGRESS,
+					 &adapter->state);
+			adapter->tx_hwtstamp_timeouts++;
+			rd32(E1000_TXSTMPH);
+		}
+		return;
+	}
+
+	regval = rd32(E1000_TXSTMPL);
+	regval |= (u64)rd32(E1000_TXSTMPH) << 32;
+
+	igb_ptp_systim_to_hwtstamp(adapter, &hwtstamps, regval);
+
+	if (adapter->hw.mac.type == e1000_i210) {
+		switch (adapter->link_speed) {
+		case SPEED_10:
+			adjust = IGB_I210_TX_LATENCY_10;
+			break;
+		case SPEED_100:
+			adjust = IGB_I210_TX_LATENCY_100;
+			break;
+		case SPEED_1000:
+			adjust = IGB_I210_TX_LATENCY_1000;
+			break;
+		}
+	}
+
+	ecdev_set_tx_timestamp(adapter->ecdev, adapter->ptp_tx_skb,
+			       ktime_add_ns(hwtstamps.hwtstamp, adjust));
+
+	adapter->ptp_tx_skb = NULL;
+	clear_bit_unlock(__IGB_PTP_TX_IN_PROGRESS, &adapter->state);
+}
+
 /**
  * igb_ptp_rx_rgtstamp - retrieve Rx timestamp stored in register
  * @q_vector: Pointer to interrupt specific structure
@@ -1069,6 +1171,33 @@ static int igb_ptp_set_timestamp_mode(struct igb_adapter *adapter,
 	return 0;
 }
 
+/**
+ * igb_ptp_ec_enable - timestamp all frames for the EtherCAT master
+ * @adapter: Board private structure
+ *
+ * Called at probe time if the master requests hardware timestamps. The
+ * configuration is kept in tstamp_config, so igb_ptp_reset() restores it.
+ **/
+void igb_ptp_ec_enable(struct igb_adapter *adapter)
+{
+	struct hwtstamp_config config;
+
+	config.flags = 0;
+	config.tx_type = HWTSTAMP_TX_ON;
+	config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+	if (!(adapter->ptp_flags & IGB_PTP_ENABLED) ||
+	    igb_ptp_set_timestamp_mode(adapter, &config)) {
+		dev_info(&adapter->pdev->dev,
+			 "Hardware timestamps not supported for EtherCAT\n");
+		return;
+	}
+
+	memcpy(&adapter->tstamp_config, &config,
+	       sizeof(adapter->tstamp_config));
+	dev_info(&adapter->pdev->dev, "EtherCAT hardware timestamps enabled\n");
+}
+
 /**
  * igb_ptp_set_ts_config - set hardware time stamping config
  * @netdev:
@@ -1216,7 +1345,9 @@ void igb_ptp_suspend(struct igb_adapter *adapter)
 
 	cancel_work_sync(&adapter->ptp_tx_work);
 	if (adapter->ptp_tx_skb) {
-		dev_kfree_skb_any(adapter->ptp_tx_skb);
+		/* EtherCAT frames belong to the master and are not freed */
+		if (!adapter->ecdev)
+			dev_kfree_skb_any(adapter->ptp_tx_skb);
 		adapter->ptp_tx_skb = NULL;
 		clear_bit_unlock(__IGB_PTP_TX_IN_PROGRESS, &adapter->state);
 	}
@@ -160,6 +160,39 @@ watchdog_mode参数以及ecrt_slave_config_sync_manager()）。
  */
 #define EC_HAVE_SYNC_TO
 
+/** 定义，如果方法ecrt_master_request_fd()可用。
+ */
+#define EC_HAVE_REQUEST_FD
+
+/** 定义，如果方法ecrt_master_emerg_read()和ec_emergency_t可用。
+ */
+#define EC_HAVE_EMERG_JOURNAL
+
+/** 定义，如果方法ecrt_master_sdo_batch()和ec_sdo_batch_item_t可用。
+ */
+#define EC_HAVE_SDO_BATCH
+
+/** 定义，如果方法ecrt_master_request_state()可用。
+ */
+#define EC_HAVE_GROUP_STATE
+
+/** 定义，如果方法ecrt_master_rtt_state()和ec_master_rtt_state_t可用。
+ */
+#define EC_HAVE_RTT_STATE
+
+/** 定义，如果方法ecrt_master_reference_clock_timestamps()可用。
+ */
+#define EC_HAVE_HW_TIMESTAMPS
+
+/** 定义，如果方法ecrt_master_redundancy_state()和
+ * ec_master_redundancy_state_t可用。
+ */
+#define EC_HAVE_REDUNDANCY_STATE
+
+/** 定义，如果主站的周期引擎（ecrt_master_cyclic_start()等方法）可用。
+ */
+#define EC_HAVE_CYCLIC_ENGINE
+
 /*****************************************************************************/
 
 /** 列表结束标记。
@@ -272,6 +305,108 @@ typedef struct
 
 /*****************************************************************************/
 
+/**
+ * @brief       设备的往返时间估计。
+ *
+ * @details     用于ecrt_master_rtt_state()的输出参数。往返时间从发送帧到
+ *              接收帧的轮询为止测量，估计值中减去了帧的传输时间。应用程序
+ *              可以用这些值在同一个周期内判断帧是否已经丢失。
+ *
+ * @see         ecrt_master_rtt_state()。
+ */
+typedef struct
+{
+    unsigned int samples;        /**< 采样数（帧数）。 */
+    uint32_t rtt_ns;             /**< 平滑后的往返时间（纳秒）。 */
+    uint32_t rtt_var_ns;         /**< 往返时间的平均偏差（纳秒）。 */
+    uint32_t rtt_peak_ns;        /**< 缓慢衰减的峰值（纳秒）。 */
+    uint32_t last_rtt_ns;        /**< 最近一次测量的往返时间，包括传输时间。 */
+    uint32_t last_frame_size;    /**< 最近一次测量的帧长度（字节）。 */
+    uint32_t cyclic_timeout_ns;  /**< 最近一次测量的帧长度下，过程数据
+                                   报的超时（纳秒）。 */
+    uint32_t mailbox_timeout_ns; /**< 同样长度下，邮箱数据报的超时（纳秒）。 */
+    unsigned int adaptive : 1;   /**< \a true，如果主站使用自适应超时。否则
+                                   超时是固定的，上面的超时仅供参考。 */
+} ec_master_rtt_state_t;
+
+/*****************************************************************************/
+
+/**
+ * @brief       冗余环的状态。
+ *
+ * @details     用于ecrt_master_redundancy_state()的输出参数。主站在每次
+ *              ecrt_master_receive()中检查帧在哪个设备上返回：帧在发送它的
+ *              设备上返回时，环在某处断开。所以电缆断开在断开后的第一个
+ *              周期就能发现。每次变化还会作为事件报告。
+ *
+ * @see         ecrt_master_redundancy_state()。
+ */
+typedef struct
+{
+    unsigned int ring_open : 1; /**< \a true，如果环断开。 */
+    unsigned int shared_tx : 1; /**< \a true，如果备份帧直接使用主数据
+                                  （模块参数redundancy_fast）。 */
+    unsigned int switchovers;   /**< 环状态变化的次数。 */
+    uint64_t last_cycle;        /**< 最近一次变化时ecrt_master_send()的
+                                  调用次数。 */
+    uint64_t last_time_ns;      /**< 最近一次变化的单调时钟时间（纳秒）。 */
+} ec_master_redundancy_state_t;
+
+/*****************************************************************************/
+
+/**
+ * @brief       主站周期引擎的配置。
+ *
+ * @details     用于ecrt_master_cyclic_start()。周期引擎是主站的一个实时线程，
+ *              按固定周期依次执行ecrt_master_receive()、所有域的
+ *              ecrt_domain_process()、应用程序回调、所有域的
+ *              ecrt_domain_queue()、分布式时钟同步和ecrt_master_send()。
+ *
+ *              使用分布式时钟时，唤醒时间对齐到SYNC0的时间网格（从第一次
+ *              ecrt_master_application_time()的时间开始，每个周期一个点，
+ *              不包括各从站的SYNC0偏移），再加上\a sync0_offset_ns。
+ *
+ * @see         ecrt_master_cyclic_start()。
+ */
+typedef struct
+{
+    uint32_t period_ns;       /**< 周期（纳秒）。使用分布式时钟时应等于
+                                SYNC0的周期。 */
+    int32_t sync0_offset_ns;  /**< 周期开始相对于SYNC0事件的相位（纳秒），
+                                负值表示在SYNC0之前。绝对值必须小于周期。 */
+    int cpu;                  /**< 周期线程绑定的CPU，-1表示不绑定。 */
+    int priority;             /**< 周期线程的SCHED_FIFO优先级（1-99）。 */
+    unsigned int dc_sync : 1; /**< \a true：每个周期设置应用程序时间，并同步
+                                参考时钟和从站时钟。 */
+#ifdef __KERNEL__
+    void (*cb)(void *);       /**< 在处理域之后、域排队之前调用的函数，
+                                可以为NULL。 */
+    void *cb_data;            /**< 传递给\a cb的参数。 */
+#endif
+} ec_cyclic_config_t;
+
+/*****************************************************************************/
+
+/**
+ * @brief       主站周期引擎的状态。
+ *
+ * @details     用于ecrt_master_cyclic_state()的输出参数。唤醒延迟和执行时间
+ *              的直方图和其他热路径直方图一起读取（'ethercat stats'）。
+ *
+ * @see         ecrt_master_cyclic_state()。
+ */
+typedef struct
+{
+    unsigned int running : 1; /**< \a true，如果周期引擎正在运行。 */
+    uint32_t period_ns;       /**< 周期（纳秒）。 */
+    int32_t sync0_offset_ns;  /**< 相对于SYNC0事件的相位（纳秒）。 */
+    uint64_t cycles;          /**< 执行的周期数。 */
+    uint64_t overruns;        /**< 没有在下一次唤醒之前结束的周期数。 */
+    uint64_t missed;          /**< 因此跳过的周期数。 */
+} ec_cyclic_state_t;
+
+/*****************************************************************************/
+
 /**
  * @brief       从站配置状态。
  *
@@ -546,6 +681,47 @@ typedef enum
     EC_AL_STATE_OP = 8,     /**< Operational. */
 } ec_al_state_t;
 
+/*****************************************************************************/
+
+/** 主站紧急消息日志中的一条CoE紧急消息。
+ *
+ * \see ecrt_master_emerg_read()。
+ */
+typedef struct
+{
+    uint32_t seq;            /**< 序号，在主站范围内连续递增。 */
+    uint16_t slave_position; /**< 发送消息的从站的环位置。 */
+    uint16_t error_code;     /**< 错误码。 */
+    uint64_t timestamp;      /**< 接收时间 [ns，自UNIX纪元起]。 */
+    uint64_t cycle;          /**< 接收时ecrt_master_send()的调用次数。 */
+    uint8_t error_register;  /**< 错误寄存器。 */
+    uint8_t data[5];         /**< 厂商特定的数据。 */
+    uint8_t reserved[2];     /**< 保留。 */
+} ec_emergency_t;
+
+/*****************************************************************************/
+
+/** ecrt_master_sdo_batch()一次最多处理的操作数。
+ */
+#define EC_SDO_BATCH_MAX_ITEMS 4096
+
+/** SDO批量传输中的一个操作。
+ *
+ * \see ecrt_master_sdo_batch()。
+ */
+typedef struct
+{
+    uint16_t slave_position; /**< 从站位置。 */
+    uint16_t index;          /**< SDO索引。 */
+    uint8_t subindex;        /**< SDO子索引。 */
+    ec_direction_t dir;      /**< EC_DIR_INPUT上传，EC_DIR_OUTPUT下载。 */
+    uint8_t *data;           /**< 下载的数据或上传的目标缓冲区。 */
+    size_t data_size;        /**< 下载的数据大小或目标缓冲区的大小。 */
+    size_t result_size;      /**< 输出：上传的数据大小。 */
+    uint32_t abort_code;     /**< 输出：SDO中止代码。 */
+    int error;               /**< 输出：0或负数错误代码。 */
+} ec_sdo_batch_item_t;
+
 /******************************************************************************
  * Global functions
  *****************************************************************************/
@@ -931,6 +1107,25 @@ extern "C"
         uint32_t *abort_code     /**< SDO上传的中止代码 */
     );
 
+    /**
+     * @brief 并行执行一批SDO上传/下载操作。
+     *
+     * 所有操作同时交给各从站的状态机：同一从站的操作按数组顺序依次
+     * 执行，不同从站的操作并行执行，因此可以共享同一帧。此方法会阻塞，
+     * 直到所有操作处理完毕，并且不能在实时上下文中调用。每个操作的结果
+     * 写入其\a result_size 、\a abort_code 和\a error 字段。
+     *
+     * @param master EtherCAT主站
+     * @param items 操作数组
+     * @param count 操作数（最多EC_SDO_BATCH_MAX_ITEMS）
+     * @return 失败的操作数，参数错误时返回负数错误代码
+     */
+    int ecrt_master_sdo_batch(
+        ec_master_t *master,        /**< EtherCAT主站 */
+        ec_sdo_batch_item_t *items, /**< 操作数组 */
+        unsigned int count          /**< 操作数 */
+    );
+
     /**
      * @brief 执行SoE写入请求。
      *
@@ -1157,6 +1352,101 @@ extern "C"
         ec_master_link_state_t *state /**< 用于存储信息的结构体。 */
     );
 
+    /**
+     * @brief     读取设备的往返时间估计。
+     * @details   估计值在每次接收帧时更新，可以在实时上下文中调用。
+     *
+     * @param     master EtherCAT主站。
+     * @param     dev_idx 设备索引（0 = 主设备，1 = 第一个备份设备，...）。
+     * @param     state 用于存储信息的结构体。
+     * @retval    成功返回0，否则返回负错误代码。
+     */
+    int ecrt_master_rtt_state(
+        const ec_master_t *master,   /**< EtherCAT主站。 */
+        unsigned int dev_idx,        /**< 设备索引。 */
+        ec_master_rtt_state_t *state /**< 用于存储信息的结构体。 */
+    );
+
+    /**
+     * @brief     读取冗余环的状态。
+     * @details   状态在ecrt_master_receive()中更新，可以在实时上下文中调用。
+     *            没有备份设备时，环总是闭合的。
+     *
+     * @param     master EtherCAT主站。
+     * @param     state 用于存储信息的结构体。
+     * @retval    成功返回0，否则返回负错误代码。
+     */
+    int ecrt_master_redundancy_state(
+        const ec_master_t *master,          /**< EtherCAT主站。 */
+        ec_master_redundancy_state_t *state /**< 用于存储信息的结构体。 */
+    );
+
+    /**
+     * @brief     启动主站的周期引擎。
+     * @details   用于没有自己的实时任务的应用程序。必须在ecrt_master_activate()
+     *            之后调用。引擎运行期间，应用程序不能再调用ecrt_master_send()、
+     *            ecrt_master_receive()以及域的处理和排队方法；内核应用程序
+     *            在回调函数中读写过程数据，用户空间应用程序用
+     *            ecrt_master_cyclic_wait()等待每个周期。
+     *
+     *            EoE等其他总线访问由主站内部加锁处理，不需要
+     *            ecrt_master_callbacks()。
+     *
+     * @param     master EtherCAT主站。
+     * @param     config 周期引擎的配置。
+     * @retval    0 成功。
+     * @retval    -EPERM 主站没有激活。
+     * @retval    -EBUSY 周期引擎已经在运行。
+     * @retval    -EINVAL 配置无效。
+     * @retval    <0 其他错误代码。
+     */
+    int ecrt_master_cyclic_start(
+        ec_master_t *master,             /**< EtherCAT主站。 */
+        const ec_cyclic_config_t *config /**< 周期引擎的配置。 */
+    );
+
+    /**
+     * @brief     停止主站的周期引擎。
+     * @details   ecrt_master_deactivate()也会停止周期引擎。引擎没有运行时
+     *            不做任何事。
+     *
+     * @param     master EtherCAT主站。
+     * @retval    成功返回0，否则返回负错误代码。
+     */
+    int ecrt_master_cyclic_stop(
+        ec_master_t *master /**< EtherCAT主站。 */
+    );
+
+    /**
+     * @brief     等待周期引擎的下一个周期。
+     * @details   等待直到周期数不等于\a cycle，然后把当前的周期数写入
+     *            \a cycle。返回时域已经处理完毕，输入数据是最新的；写入的
+     *            输出数据在下一个周期发送。返回的周期数与传入的值相差超过1
+     *            时，说明调用者错过了周期。不能在实时上下文中调用。
+     *
+     * @param     master EtherCAT主站。
+     * @param     cycle 上一次看到的周期数（第一次调用时为0）。
+     * @retval    0 成功。
+     * @retval    -ENXIO 周期引擎没有运行或已经停止。
+     * @retval    -EINTR 等待被信号中断。
+     */
+    int ecrt_master_cyclic_wait(
+        ec_master_t *master, /**< EtherCAT主站。 */
+        uint64_t *cycle      /**< 上一次看到的/当前的周期数。 */
+    );
+
+    /**
+     * @brief     读取周期引擎的状态。
+     *
+     * @param     master EtherCAT主站。
+     * @param     state 用于存储信息的结构体。
+     * @retval    成功返回0，否则返回负错误代码。
+     */
+    int ecrt_master_cyclic_state(
+        const ec_master_t *master, /**< EtherCAT主站。 */
+        ec_cyclic_state_t *state   /**< 用于存储信息的结构体。 */
+    );
+
     /**
      * @brief     设置应用程序时间。
      * @details   当使用分布式时钟操作从站时，主站需要知道应用程序的时间。时间不会由主站自行递增，因此必须周期性调用此方法。
@@ -1225,6 +1515,30 @@ extern "C"
         uint32_t *time       /**< 用于存储查询的系统时间的指针。 */
     );
 
+    /**
+     * @brief     获取携带参考时钟时间的帧的网卡硬件时间戳。
+     * @details   返回 ecrt_master_reference_clock_time() 读取的同步数据报文
+     *            在网卡上的发送和接收时间。时间基于网卡的时钟（例如PTP硬件
+     *            时钟），与驱动和轮询的延迟无关。应用程序的时间基于同一时钟
+     *            时，可以用它们更精确地估计与参考时钟的偏差。
+     *
+     * @attention 需要以hw_timestamps=1加载主站模块，并且网卡驱动支持硬件
+     *            时间戳。
+     *
+     * @param     master EtherCAT主站。
+     * @param     sent_ns 发送时间（纳秒）。
+     * @param     received_ns 接收时间（纳秒）。
+     * @retval    0 成功。
+     * @retval    -ENXIO 未找到参考时钟。
+     * @retval    -EIO 未接收到从站同步数据报文。
+     * @retval    -ENODATA 该帧没有硬件时间戳。
+     */
+    int ecrt_master_reference_clock_timestamps(
+        ec_master_t *master,  /**< EtherCAT主站。 */
+        uint64_t *sent_ns,    /**< 发送时间（纳秒）。 */
+        uint64_t *received_ns /**< 接收时间（纳秒）。 */
+    );
+
     /**
      * @brief     将64位DC参考从站时钟时间值数据报文加入发送队列。
      * @details   该数据报文读取DC参考从站的64位DC时间戳（寄存器 \a 0x0910:0x0917）。结果可使用 ecrt_master_64bit_reference_clock_time() 方法进行检查。
@@ -1296,6 +1610,54 @@ extern "C"
     ecrt_master_exec_slave_requests(ec_master_t *master /**< EtherCAT主站。 */
     );
 
+    /**
+     * @brief     从主站的紧急消息日志中批量读取CoE紧急消息。
+     * @details   主站把所有从站的CoE紧急消息按接收顺序写入一个环形日志，
+     * 每条消息带有时间戳、从站位置和周期计数。日志的大小由模块参数
+     * emerg_journal_size决定，写满后覆盖最早的消息。
+     *
+     * 读取从序号\a seq 开始，读取后\a seq 指向下一条未读的消息。初始
+     * 值可以是0，也可以是上次读取的结果。已被覆盖的消息会被跳过，读者
+     * 可以通过返回消息序号的间隔发现丢失的消息。此方法不阻塞，也不影响
+     * 其他读者和ecrt_slave_config_emerg_pop()。
+     *
+     * 在用户空间中，日志在第一次调用时通过mmap()只读映射，之后的调用
+     * 只读取内存。可以在实时上下文中调用。
+     *
+     * @param     master EtherCAT主站。
+     * @param     seq 读取序号，读取后前进。
+     * @param     entries 目标数组。
+     * @param     count \a entries 的容量。
+     * @return    读取的消息数，失败时返回负错误代码。
+     */
+    int ecrt_master_emerg_read(
+        ec_master_t *master,     /**< EtherCAT主站。 */
+        uint32_t *seq,           /**< 读取序号。 */
+        ec_emergency_t *entries, /**< 目标数组。 */
+        unsigned int count       /**< 目标数组的容量。 */
+    );
+
+#ifndef __KERNEL__
+
+    /**
+     * @brief     返回异步请求的完成通知文件描述符。
+     * @details   激活主站后，用户空间库把SDO、FoE和寄存器请求的状态映射到
+     * 共享内存中，ecrt_sdo_request_state()、ecrt_foe_request_state()和
+     * ecrt_reg_request_state()只读取内存，不再为每次轮询调用ioctl()。
+     * 返回的eventfd在有请求结束时变为可读，可以用poll()/epoll()等待，
+     * 读取8字节计数值后复位。文件描述符属于主站对象，在停用主站时关闭。
+     * VoE处理程序不受影响，仍然需要调用ecrt_voe_handler_execute()。
+     *
+     * 必须在ecrt_master_activate()之后调用。
+     *
+     * @param     master EtherCAT主站。
+     * @return    文件描述符，失败时返回负错误代码。
+     */
+    int ecrt_master_request_fd(ec_master_t *master /**< EtherCAT主站。 */
+    );
+
+#endif /* #ifndef __KERNEL__ */
+
     /**
      * @brief     重新尝试配置从站。
      * @details   通过此方法，应用程序可以告知主站将所有从站置于OP状态。通常情况下，这是不必要的，因为主站会自动执行此操作。但对于可以在运行时由供应商重新配置的特殊从站，这可能是有用的。
@@ -1305,6 +1667,28 @@ extern "C"
     void ecrt_master_reset(ec_master_t *master /**< EtherCAT主站。 */
     );
 
+    /**
+     * @brief     为一组从站配置同时请求AL状态。
+     * @details   所有从站的请求一起生效。请求SAFEOP或OP时，各从站先单独完成
+     * 配置，最后一次状态转换由主站对所有从站一起执行（广播写入或打包的
+     * 数据报），并一起检查结果。拒绝状态转换或超时的从站单独处理。
+     * 尚未连接从站的配置被忽略。
+     *
+     * 不能在实时上下文中调用。
+     *
+     * @param     master EtherCAT主站。
+     * @param     configs 从站配置数组。
+     * @param     count 从站配置数。
+     * @param     state 请求的AL状态。
+     * @return    成功返回0，否则返回负错误代码。
+     */
+    int ecrt_master_request_state(
+        ec_master_t *master,               /**< EtherCAT主站。 */
+        ec_slave_config_t *const *configs, /**< 从站配置数组。 */
+        unsigned int count,                /**< 从站配置数。 */
+        ec_al_state_t state                /**< 请求的AL状态。 */
+    );
+
     /******************************************************************************
      * Slave configuration methods
      *****************************************************************************/
@@ -1707,7 +2091,7 @@ extern "C"
     /**
      * @brief     读取CoE紧急溢出次数。
      *
-     * 当CoE紧急消息无法存储在环形缓冲区中并且必须被丢弃时，溢出计数器将递增。调用ecrt_slave_config_emerg_clear()以重置计数器。
+     * 当CoE紧急消息无法存储在环形缓冲区中并且必须被丢弃时，溢出计数器将递增。环形缓冲区中的消息在弹出之前已被主站的紧急消息日志覆盖时（见ecrt_master_emerg_read()），也计为溢出。调用ecrt_slave_config_emerg_clear()以重置计数器。
      *
      * \return 上次清除以来的溢出次数，否则返回负数的错误代码。
      */
@@ -83,6 +83,11 @@ ec_master_t *ecrt_open_master(unsigned int master_index)
 
     master->process_data = NULL;
     master->process_data_size = 0;
+    master->req_shm = NULL;
+    master->req_shm_size = 0;
+    master->req_fd = -1;
+    master->emerg = NULL;
+    master->emerg_size = 0;
     master->first_domain = NULL;
     master->first_config = NULL;
 
@@ -116,11 +116,62 @@ size_t ecrt_foe_request_progress(const ec_foe_request_t *req)
 
 /*****************************************************************************/
 
+/** Reads the request state from the shared status slot.
+ */
+static ec_request_state_t ec_foe_request_slot_state(ec_foe_request_t *req)
+{
+    const ec_req_shm_slot_t *slot = req->slot;
+    ec_request_state_t state;
+    ec_ioctl_foe_request_t data;
+    uint32_t issued;
+    int ret;
+
+    state = ec_master_slot_state(slot, &issued);
+    req->progress = slot->progress;
+    if (state == EC_REQUEST_BUSY || issued == req->slot_seen) {
+        return state;
+    }
+
+    req->result = slot->abort_code;
+    req->error_code = slot->error_code;
+
+    if (state == EC_REQUEST_SUCCESS && slot->data_size) {
+        // FoE data is never copied to the shared region
+        if (req->mem_size < slot->data_size) {
+            fprintf(stderr, "Received %u bytes do not fit into FoE data"
+                    " memory (%zu bytes)!\n", slot->data_size, req->mem_size);
+            return EC_REQUEST_ERROR;
+        }
+
+        data.config_index = req->config->index;
+        data.request_index = req->index;
+        data.data = req->data;
+
+        ret = ioctl(req->config->master->fd,
+                EC_IOCTL_FOE_REQUEST_DATA, &data);
+        if (EC_IOCTL_IS_ERROR(ret)) {
+            fprintf(stderr, "Failed to get FoE data: %s\n",
+                    strerror(EC_IOCTL_ERRNO(ret)));
+            return EC_REQUEST_ERROR;
+        }
+        req->data_size = slot->data_size;
+    }
+
+    req->slot_seen = issued;
+    return state;
+}
+
+/*****************************************************************************/
+
 ec_request_state_t ecrt_foe_request_state(ec_foe_request_t *req)
 {
     ec_ioctl_foe_request_t data;
     int ret;
 
+    if (req->slot) {
+        return ec_foe_request_slot_state(req);
+    }
+
     data.config_index = req->config->index;
     data.request_index = req->index;
 
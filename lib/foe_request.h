@@ -43,6 +43,8 @@ struct ec_foe_request {
     size_t progress; /**< Current position of a BUSY request. */
     ec_foe_error_t result; /**< FoE request abort code. Zero on success. */
     uint32_t error_code; /**< Error code from an FoE Error Request. */
+    void *slot; /**< Shared status slot (ec_req_shm_slot_t), or NULL. */
+    uint32_t slot_seen; /**< Issue count of the last consumed completion. */
 };
 
 /*****************************************************************************/
@@ -32,11 +32,17 @@
 #include <errno.h>
 #include <string.h>
 #include <sys/mman.h>
+#if !defined(USE_RTDM) && !defined(USE_RTDM_XENOMAI_V3)
+#include <sys/eventfd.h>
+#endif
 
 #include "ioctl.h"
 #include "master.h"
 #include "domain.h"
 #include "slave_config.h"
+#include "sdo_request.h"
+#include "foe_request.h"
+#include "reg_request.h"
 
 /****************************************************************************/
 
@@ -63,6 +69,17 @@ void ec_master_clear_config(ec_master_t *master)
         master->process_data = NULL;
     }
 
+    if (master->req_shm) {
+        munmap(master->req_shm, master->req_shm_size);
+        master->req_shm = NULL;
+        master->req_shm_size = 0;
+    }
+
+    if (master->req_fd != -1) {
+        close(master->req_fd);
+        master->req_fd = -1;
+    }
+
     d = master->first_domain;
     while (d) {
         next_d = d->next;
@@ -94,6 +111,12 @@ void ec_master_clear(ec_master_t *master)
 {
     ec_master_clear_config(master);
 
+    if (master->emerg) {
+        munmap(master->emerg, master->emerg_size);
+        master->emerg = NULL;
+        master->emerg_size = 0;
+    }
+
     if (master->fd != -1) {
 #if USE_RTDM
         rt_dev_close(master->fd);
@@ -517,6 +540,31 @@ int ecrt_master_sdo_upload_complete(ec_master_t *master, uint16_t slave_position
 
 /****************************************************************************/
 
+int ecrt_master_sdo_batch(ec_master_t *master, ec_sdo_batch_item_t *items,
+        unsigned int count)
+{
+    ec_ioctl_sdo_batch_t batch;
+    int ret;
+
+    if (!count) {
+        return 0;
+    }
+
+    batch.items = items;
+    batch.count = count;
+
+    ret = ioctl(master->fd, EC_IOCTL_SDO_BATCH, &batch);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to execute SDO batch: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return batch.failed;
+}
+
+/****************************************************************************/
+
 int ecrt_master_write_idn(ec_master_t *master, uint16_t slave_position,
         uint8_t drive_no, uint16_t idn, uint8_t *data, size_t data_size,
         uint16_t *error_code)
@@ -616,6 +664,282 @@ int ecrt_master_setup_domain_memory(ec_master_t *master)
 
 /*****************************************************************************/
 
+/** Attaches a shared status slot to the matching request.
+ */
+static void ec_master_attach_slot(ec_master_t *master,
+        const ec_req_shm_slot_t *slot)
+{
+    ec_slave_config_t *sc;
+
+    for (sc = master->first_config; sc; sc = sc->next) {
+        if (sc->index == slot->config_index) {
+            break;
+        }
+    }
+    if (!sc) {
+        return;
+    }
+
+    switch (slot->type) {
+        case EC_REQ_SHM_SDO:
+            {
+                ec_sdo_request_t *req;
+                for (req = sc->first_sdo_request; req; req = req->next) {
+                    if (req->index == slot->request_index) {
+                        req->slot = (void *) slot;
+                        req->slot_seen = 0;
+                        break;
+                    }
+                }
+            }
+            break;
+        case EC_REQ_SHM_FOE:
+            {
+                ec_foe_request_t *req;
+                for (req = sc->first_foe_request; req; req = req->next) {
+                    if (req->index == slot->request_index) {
+                        req->slot = (void *) slot;
+                        req->slot_seen = 0;
+                        break;
+                    }
+                }
+            }
+            break;
+        case EC_REQ_SHM_REG:
+            {
+                ec_reg_request_t *reg;
+                for (reg = sc->first_reg_request; reg; reg = reg->next) {
+                    if (reg->index == slot->request_index) {
+                        reg->slot = (void *) slot;
+                        reg->slot_seen = 0;
+                        break;
+                    }
+                }
+            }
+            break;
+    }
+}
+
+/*****************************************************************************/
+
+/** Maps the shared request status region.
+ *
+ * Afterwards, ecrt_*_request_state() read the request states from memory
+ * instead of issuing an ioctl() per call. Failure is not an error: the
+ * requests keep using ioctl().
+ */
+static void ec_master_setup_req_shm(ec_master_t *master)
+{
+#if !defined(USE_RTDM) && !defined(USE_RTDM_XENOMAI_V3)
+    ec_ioctl_req_shm_t io;
+    const ec_req_shm_header_t *header;
+    const ec_req_shm_slot_t *slots;
+    uint8_t *mem;
+    unsigned int i;
+    int ret;
+
+    io.eventfd = -1;
+    ret = ioctl(master->fd, EC_IOCTL_REQ_SHM, &io);
+    if (EC_IOCTL_IS_ERROR(ret) || !io.slot_count) {
+        return;
+    }
+
+    mem = mmap(0, io.map_size, PROT_READ, MAP_SHARED, master->fd,
+            EC_IOCTL_MMAP_OFFSET(EC_IOCTL_MMAP_REQ_SHM));
+    if (mem == MAP_FAILED) {
+        return;
+    }
+
+    header = (const ec_req_shm_header_t *) mem;
+    if (header->magic != EC_REQ_SHM_MAGIC
+            || header->version != EC_REQ_SHM_VERSION) {
+        munmap(mem, io.map_size);
+        return;
+    }
+
+    master->req_shm = mem;
+    master->req_shm_size = io.map_size;
+
+    slots = (const ec_req_shm_slot_t *) (mem + header->slot_offset);
+    for (i = 0; i < header->slot_count; i++) {
+        ec_master_attach_slot(master, &slots[i]);
+    }
+#endif
+}
+
+/*****************************************************************************/
+
+ec_request_state_t ec_master_slot_state(const void *ptr, uint32_t *issued)
+{
+    const volatile ec_req_shm_slot_t *slot = ptr;
+    uint32_t i = slot->issued;
+
+    __sync_synchronize();
+    if (slot->completed != i) {
+        return EC_REQUEST_BUSY;
+    }
+
+    // results are valid once completed matches
+    __sync_synchronize();
+    *issued = i;
+    return (ec_request_state_t) slot->state;
+}
+
+/*****************************************************************************/
+
+#if !defined(USE_RTDM) && !defined(USE_RTDM_XENOMAI_V3)
+
+/** Maps the master's emergency journal.
+ */
+static int ec_master_map_emerg(ec_master_t *master)
+{
+    ec_ioctl_master_t io;
+    const ec_emerg_journal_header_t *header;
+    uint8_t *mem;
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_MASTER, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get master info: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    if (!io.emerg_map_size) {
+        return -ENODEV;
+    }
+
+    mem = mmap(0, io.emerg_map_size, PROT_READ, MAP_SHARED, master->fd,
+            EC_IOCTL_MMAP_OFFSET(EC_IOCTL_MMAP_EMERG));
+    if (mem == MAP_FAILED) {
+        ret = errno;
+        EC_PRINT_ERR("Failed to map emergency journal: %s\n",
+                strerror(ret));
+        return -ret;
+    }
+
+    header = (const ec_emerg_journal_header_t *) mem;
+    if (header->magic != EC_EMERG_JOURNAL_MAGIC
+            || header->version != EC_EMERG_JOURNAL_VERSION) {
+        EC_PRINT_ERR("Invalid emergency journal layout.\n");
+        munmap(mem, io.emerg_map_size);
+        return -EPROTO;
+    }
+
+    master->emerg = mem;
+    master->emerg_size = io.emerg_map_size;
+    return 0;
+}
+
+#endif
+
+/*****************************************************************************/
+
+int ecrt_master_emerg_read(ec_master_t *master, uint32_t *seq,
+        ec_emergency_t *entries, unsigned int count)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return -EOPNOTSUPP;
+#else
+    const volatile ec_emerg_journal_header_t *header;
+    const volatile ec_emergency_t *journal, *slot;
+    uint32_t head, mask, s, cur;
+    unsigned int n = 0;
+    int ret;
+
+    if (!master->emerg) {
+        ret = ec_master_map_emerg(master);
+        if (ret) {
+            return ret;
+        }
+    }
+
+    header = (const volatile ec_emerg_journal_header_t *) master->emerg;
+    journal = (const volatile ec_emergency_t *)
+        (master->emerg + header->entry_offset);
+    mask = header->entry_count - 1;
+
+    head = header->head;
+    __sync_synchronize();
+
+    s = *seq;
+    if ((int32_t) (head - s) < 0) {
+        return 0;
+    }
+    if (head - s > mask + 1) {
+        // skip what has been overwritten already
+        s = head - (mask + 1);
+    }
+
+    while (n < count && s != head) {
+        slot = &journal[s & mask];
+        cur = slot->seq;
+        if (cur != s) {
+            if ((int32_t) (cur - s) < 0) {
+                break; // still being written
+            }
+            s++; // overwritten
+            continue;
+        }
+
+        __sync_synchronize();
+        memcpy(&entries[n], (const void *) slot, sizeof(ec_emergency_t));
+        __sync_synchronize();
+
+        if (slot->seq == s) {
+            n++;
+        }
+        s++;
+    }
+
+    *seq = s;
+    return n;
+#endif
+}
+
+/*****************************************************************************/
+
+int ecrt_master_request_fd(ec_master_t *master)
+{
+#if defined(USE_RTDM) || defined(USE_RTDM_XENOMAI_V3)
+    return -EOPNOTSUPP;
+#else
+    ec_ioctl_req_shm_t io;
+    int fd, ret;
+
+    if (master->req_fd != -1) {
+        return master->req_fd;
+    }
+
+    if (!master->req_shm) {
+        EC_PRINT_ERR("Request status region not available."
+                " Master not activated?\n");
+        return -ENODEV;
+    }
+
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd == -1) {
+        ret = errno;
+        EC_PRINT_ERR("Failed to create eventfd: %s\n", strerror(ret));
+        return -ret;
+    }
+
+    io.eventfd = fd;
+    ret = ioctl(master->fd, EC_IOCTL_REQ_SHM, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to set request eventfd: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        close(fd);
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    master->req_fd = fd;
+    return fd;
+#endif
+}
+
+/*****************************************************************************/
+
 int ecrt_master_activate(ec_master_t *master)
 {
     ec_ioctl_master_activate_t io;
@@ -653,6 +977,7 @@ int ecrt_master_activate(ec_master_t *master)
         master->process_data[0] = 0x00;
     }
 
+    ec_master_setup_req_shm(master);
     return 0;
 }
 
@@ -858,6 +1183,117 @@ int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
 
 /****************************************************************************/
 
+int ecrt_master_rtt_state(const ec_master_t *master, unsigned int dev_idx,
+        ec_master_rtt_state_t *state)
+{
+    ec_ioctl_rtt_state_t io;
+    int ret;
+
+    io.dev_idx = dev_idx;
+    io.state = state;
+
+    ret = ioctl(master->fd, EC_IOCTL_MASTER_RTT_STATE, &io);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get round-trip time state: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_redundancy_state(const ec_master_t *master,
+        ec_master_redundancy_state_t *state)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_MASTER_REDUNDANCY_STATE, state);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get redundancy state: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cyclic_start(ec_master_t *master,
+        const ec_cyclic_config_t *config)
+{
+    ec_ioctl_cyclic_t data;
+    int ret;
+
+    memset(&data, 0, sizeof(data));
+    data.period_ns = config->period_ns;
+    data.sync0_offset_ns = config->sync0_offset_ns;
+    data.cpu = config->cpu;
+    data.priority = config->priority;
+    data.dc_sync = config->dc_sync;
+
+    ret = ioctl(master->fd, EC_IOCTL_CYCLIC_START, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to start cyclic engine: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cyclic_stop(ec_master_t *master)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_CYCLIC_STOP, NULL);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to stop cyclic engine: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cyclic_wait(ec_master_t *master, uint64_t *cycle)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_CYCLIC_WAIT, cycle);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        // EINTR and ENXIO are for the caller to handle
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
+int ecrt_master_cyclic_state(const ec_master_t *master,
+        ec_cyclic_state_t *state)
+{
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_CYCLIC_STATE, state);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to get cyclic engine state: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
+
 void ecrt_master_application_time(ec_master_t *master, uint64_t app_time)
 {
     uint64_t time;
@@ -937,6 +1373,29 @@ int ecrt_master_reference_clock_time(ec_master_t *master, uint32_t *time)
 
 /****************************************************************************/
 
+int ecrt_master_reference_clock_timestamps(ec_master_t *master,
+        uint64_t *sent_ns, uint64_t *received_ns)
+{
+    ec_ioctl_hw_timestamps_t data;
+    int ret;
+
+    ret = ioctl(master->fd, EC_IOCTL_REF_CLOCK_TIMESTAMPS, &data);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        ret = EC_IOCTL_ERRNO(ret);
+        if (ret != EIO && ret != ENXIO && ret != ENODATA) {
+            EC_PRINT_ERR("Failed to get reference clock timestamps: %s\n",
+                    strerror(ret));
+        }
+        return -ret;
+    }
+
+    *sent_ns = data.sent_ns;
+    *received_ns = data.received_ns;
+    return 0;
+}
+
+/****************************************************************************/
+
 static int lastErr64BitRefClkQueue = 0;
 void ecrt_master_64bit_reference_clock_time_queue(ec_master_t *master)
 {
@@ -1050,3 +1509,43 @@ void ecrt_master_reset(ec_master_t *master)
 }
 
 /****************************************************************************/
+
+int ecrt_master_request_state(ec_master_t *master,
+        ec_slave_config_t *const *configs, unsigned int count,
+        ec_al_state_t state)
+{
+    ec_ioctl_request_state_t io;
+    uint32_t *indices;
+    unsigned int i;
+    int ret;
+
+    if (!count) {
+        return 0;
+    }
+
+    indices = malloc(count * sizeof(*indices));
+    if (!indices) {
+        EC_PRINT_ERR("Failed to allocate memory.\n");
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < count; i++) {
+        indices[i] = configs[i]->index;
+    }
+
+    io.config_indices = indices;
+    io.count = count;
+    io.al_state = state;
+
+    ret = ioctl(master->fd, EC_IOCTL_REQUEST_STATE, &io);
+    free(indices);
+    if (EC_IOCTL_IS_ERROR(ret)) {
+        EC_PRINT_ERR("Failed to request state: %s\n",
+                strerror(EC_IOCTL_ERRNO(ret)));
+        return -EC_IOCTL_ERRNO(ret);
+    }
+
+    return 0;
+}
+
+/****************************************************************************/
@@ -36,6 +36,11 @@ struct ec_master {
     int fd;
     uint8_t *process_data;
     size_t process_data_size;
+    uint8_t *req_shm; /**< Shared request status region, or NULL. */
+    size_t req_shm_size; /**< Size of \a req_shm. */
+    int req_fd; /**< Request completion eventfd, or -1. */
+    uint8_t *emerg; /**< Mapped emergency journal, or NULL. */
+    size_t emerg_size; /**< Size of \a emerg. */
 
     ec_domain_t *first_domain;
     ec_slave_config_t *first_config;
@@ -44,5 +49,6 @@ struct ec_master {
 /*****************************************************************************/
 
 void ec_master_clear(ec_master_t *);
+ec_request_state_t ec_master_slot_state(const void *, uint32_t *);
 
 /*****************************************************************************/
@@ -61,11 +61,57 @@ uint8_t *ecrt_reg_request_data(ec_reg_request_t *reg)
 
 /*****************************************************************************/
 
+/** Reads the request state from the shared status slot.
+ */
+static ec_request_state_t ec_reg_request_slot_state(ec_reg_request_t *reg)
+{
+    const ec_req_shm_slot_t *slot = reg->slot;
+    ec_request_state_t state;
+    ec_ioctl_reg_request_t io;
+    uint32_t issued;
+    int ret;
+
+    state = ec_master_slot_state(slot, &issued);
+    if (state != EC_REQUEST_SUCCESS || issued == reg->slot_seen) {
+        return state;
+    }
+
+    if (slot->data_size) { // new data waiting to be copied
+        if (slot->flags & EC_REQ_SHM_FLAG_INLINE
+                && slot->data_size <= reg->mem_size) {
+            memcpy(reg->data, reg->config->master->req_shm
+                    + slot->data_offset, slot->data_size);
+        } else {
+            io.config_index = reg->config->index;
+            io.request_index = reg->index;
+            io.data = reg->data;
+            io.mem_size = reg->mem_size;
+
+            ret = ioctl(reg->config->master->fd,
+                    EC_IOCTL_REG_REQUEST_DATA, &io);
+            if (EC_IOCTL_IS_ERROR(ret)) {
+                EC_PRINT_ERR("Failed to get register data: %s\n",
+                        strerror(EC_IOCTL_ERRNO(ret)));
+                return EC_REQUEST_ERROR;
+            }
+        }
+    }
+
+    reg->slot_seen = issued;
+    return state;
+}
+
+/*****************************************************************************/
+
 ec_request_state_t ecrt_reg_request_state(ec_reg_request_t *reg)
 {
     ec_ioctl_reg_request_t io;
     int ret;
 
+    if (reg->slot) {
+        return ec_reg_request_slot_state(reg);
+    }
+
     io.config_index = reg->config->index;
     io.request_index = reg->index;
 
@@ -38,6 +38,8 @@ struct ec_reg_request {
     unsigned int index; /**< Request index (identifier). */
     uint8_t *data; /**< Data memory. */
     size_t mem_size; /**< Size of \a data. */
+    void *slot; /**< Shared status slot (ec_req_shm_slot_t), or NULL. */
+    uint32_t slot_seen; /**< Issue count of the last consumed completion. */
 };
 
 /*****************************************************************************/
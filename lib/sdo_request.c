@@ -127,11 +127,62 @@ size_t ecrt_sdo_request_data_size(const ec_sdo_request_t *req)
 
 /*****************************************************************************/
 
+/** Reads the request state from the shared status slot.
+ */
+static ec_request_state_t ec_sdo_request_slot_state(ec_sdo_request_t *req)
+{
+    const ec_req_shm_slot_t *slot = req->slot;
+    ec_request_state_t state;
+    ec_ioctl_sdo_request_t data;
+    uint32_t issued;
+    int ret;
+
+    state = ec_master_slot_state(slot, &issued);
+    if (state != EC_REQUEST_SUCCESS || issued == req->slot_seen) {
+        return state;
+    }
+
+    if (slot->data_size) { // new data waiting to be copied
+        if (req->mem_size < slot->data_size) {
+            EC_PRINT_ERR("Received %u bytes do not fit info SDO data"
+                    " memory (%zu bytes)!\n", slot->data_size, req->mem_size);
+            return EC_REQUEST_ERROR;
+        }
+
+        if (slot->flags & EC_REQ_SHM_FLAG_INLINE) {
+            memcpy(req->data, req->config->master->req_shm
+                    + slot->data_offset, slot->data_size);
+        } else {
+            data.config_index = req->config->index;
+            data.request_index = req->index;
+            data.data = req->data;
+
+            ret = ioctl(req->config->master->fd,
+                    EC_IOCTL_SDO_REQUEST_DATA, &data);
+            if (EC_IOCTL_IS_ERROR(ret)) {
+                EC_PRINT_ERR("Failed to get SDO data: %s\n",
+                        strerror(EC_IOCTL_ERRNO(ret)));
+                return EC_REQUEST_ERROR;
+            }
+        }
+        req->data_size = slot->data_size;
+    }
+
+    req->slot_seen = issued;
+    return state;
+}
+
+/*****************************************************************************/
+
 ec_request_state_t ecrt_sdo_request_state(ec_sdo_request_t *req)
 {
     ec_ioctl_sdo_request_t data;
     int ret;
 
+    if (req->slot) {
+        return ec_sdo_request_slot_state(req);
+    }
+
     data.config_index = req->config->index;
     data.request_index = req->index;
 
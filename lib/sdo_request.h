@@ -41,6 +41,8 @@ struct ec_sdo_request {
     uint8_t *data; /**< Pointer to SDO data. */
     size_t mem_size; /**< Size of SDO data memory. */
     size_t data_size; /**< Size of SDO data. */
+    void *slot; /**< Shared status slot (ec_req_shm_slot_t), or NULL. */
+    uint32_t slot_seen; /**< Issue count of the last consumed completion. */
 };
 
 /*****************************************************************************/
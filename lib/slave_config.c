@@ -626,6 +626,8 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request(ec_slave_config_t *sc,
     req->sdo_subindex = data.sdo_subindex;
     req->data_size = size;
     req->mem_size = size;
+    req->slot = NULL;
+    req->slot_seen = 0;
 
     ec_slave_config_add_sdo_request(sc, req);
 
@@ -681,6 +683,8 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request_complete(ec_slave_config_
     req->sdo_subindex = data.sdo_subindex;
     req->data_size = size;
     req->mem_size = size;
+    req->slot = NULL;
+    req->slot_seen = 0;
 
     ec_slave_config_add_sdo_request(sc, req);
 
@@ -747,6 +751,8 @@ ec_foe_request_t *ecrt_slave_config_create_foe_request(ec_slave_config_t *sc,
     req->index = data.request_index;
     req->data_size = size;
     req->mem_size = size;
+    req->slot = NULL;
+    req->slot_seen = 0;
 
     ec_slave_config_add_foe_request(sc, req);
 
@@ -812,6 +818,8 @@ ec_reg_request_t *ecrt_slave_config_create_reg_request(ec_slave_config_t *sc,
     reg->config = sc;
     reg->index = io.request_index;
     reg->mem_size = size;
+    reg->slot = NULL;
+    reg->slot_seen = 0;
 
     ec_slave_config_add_reg_request(sc, reg);
 
@@ -37,6 +37,8 @@
 #include <stdlib.h>
 #include <strings.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <string.h>
@@ -68,7 +70,12 @@ class MasterIndexParser:
 /*****************************************************************************/
 
 CommandMbg::CommandMbg():
-    m_verbosity(Normal)
+    m_verbosity(Normal),
+    m_concurrency(DEFAULT_CONCURRENCY),
+    m_masterDev(NULL),
+    m_epollFd(-1),
+    m_udpSockFd(-1),
+    m_udpQueued(0)
 {
     m_terminate = 0;
 }
@@ -95,6 +102,13 @@ void CommandMbg::setVerbosity(Verbosity v)
 
 /*****************************************************************************/
 
+void CommandMbg::setConcurrency(unsigned int c)
+{
+    m_concurrency = c ? c : 1;
+};
+
+/*****************************************************************************/
+
 void CommandMbg::throwInvalidUsageException(const stringstream &s)
 {
     throw InvalidUsageException(s);
@@ -198,70 +212,536 @@ void CommandMbg::printBuff(uint8_t *in_buffer, size_t in_nbytes)
 
 /****************************************************************************/
 
-int CommandMbg::processMessage(uint8_t *in_buffer, size_t &inout_nbytes)
+
+/** Checks a received packet and prepares the ioctl for it.
+ *
+ * \return 0 if the request can be passed to the master, -1 otherwise.
+ */
+int CommandMbg::parseMessage(Request *req)
 {
-    uint8_t                 *buff = in_buffer;
-    ec_ioctl_mbox_gateway_t  ioctl;
-    
+    uint8_t *buff = req->buffer;
+
     if (m_verbosity >= CommandMbg::Debug) {
-        cout << "Received packet (size: " << inout_nbytes 
+        cout << "Received packet (size: " << req->nbytes
              << " bytes):" << endl;
-        printBuff(in_buffer, inout_nbytes);
+        printBuff(req->buffer, req->nbytes);
     }
-    
+
     // check there's enough room for the EtherCAT Header
     // and get the length of the following data
-    if (inout_nbytes < EC_FRAME_HEADER_SIZE) {
+    if (req->nbytes < EC_FRAME_HEADER_SIZE) {
         if (m_verbosity >= CommandMbg::Normal) {
             cout << "Message error, received bytes < EtherCAT Header size" << endl;
         }
         return -1;
     }
-    ioctl.data_size = EC_READ_U16(buff) & 0x7FF;
-    ioctl.buff_size = MAX_BUFF_SIZE - EC_FRAME_HEADER_SIZE;
-    buff           += EC_FRAME_HEADER_SIZE;
-    
+    req->ioctl.data_size = EC_READ_U16(buff) & 0x7FF;
+    req->ioctl.buff_size = MAX_BUFF_SIZE - EC_FRAME_HEADER_SIZE;
+    req->ioctl.data      = buff + EC_FRAME_HEADER_SIZE;
+
     // check we have all the data we expect
-    if (inout_nbytes < EC_FRAME_HEADER_SIZE + ioctl.data_size) {
+    if (req->nbytes < EC_FRAME_HEADER_SIZE + req->ioctl.data_size) {
         if (m_verbosity >= CommandMbg::Normal) {
-            cout << "Message error, received bytes (" << inout_nbytes
-                 << ") < packet size (" << EC_FRAME_HEADER_SIZE + ioctl.data_size
+            cout << "Message error, received bytes (" << req->nbytes
+                 << ") < packet size (" << EC_FRAME_HEADER_SIZE + req->ioctl.data_size
                  << ")" << endl;
         }
         return -1;
-    } else if ( (inout_nbytes > EC_FRAME_HEADER_SIZE + ioctl.data_size) &&
+    } else if ( (req->nbytes > EC_FRAME_HEADER_SIZE + req->ioctl.data_size) &&
                 (m_verbosity >= CommandMbg::Verbose) ) {
-        cout << "Message warning, received bytes (" << inout_nbytes
-             << ") > packet size (" << EC_FRAME_HEADER_SIZE + ioctl.data_size
+        cout << "Message warning, received bytes (" << req->nbytes
+             << ") > packet size (" << EC_FRAME_HEADER_SIZE + req->ioctl.data_size
              << "), ignoring extra data" << endl;
     }
-    
-    m_masterDev->open(MasterDevice::ReadWrite);
-    
-    // send the data
-    ioctl.data = buff;
-    if (m_masterDev->processMessage(&ioctl) < 0) {
+
+    // requests to the same mailbox address are never processed in parallel
+    req->slave = req->ioctl.data_size >= 4
+        ? EC_READ_U16(buff + EC_FRAME_HEADER_SIZE + 2) : 0;
+
+    return 0;
+}
+
+/****************************************************************************/
+
+/** Updates the EtherCAT header of a processed request.
+ */
+void CommandMbg::finishMessage(Request *req)
+{
+    if (req->result) {
         if (m_verbosity >= CommandMbg::Normal) {
-            cout << "Message failed with code: " << strerror(errno)
+            cout << "Message failed with code: " << strerror(req->result)
                  << ", Check ethercat logs for more information" << endl;
         }
-        return -1;
+        return;
     }
 
-    m_masterDev->close();
-
     // update EtherCAT header length and returned byte count
-    EC_WRITE_U16(in_buffer, (ioctl.data_size & 0x7FF) | (EC_READ_U16(in_buffer) & 0xF800));
-    inout_nbytes = EC_FRAME_HEADER_SIZE + ioctl.data_size;
-    
+    EC_WRITE_U16(req->buffer, (req->ioctl.data_size & 0x7FF)
+            | (EC_READ_U16(req->buffer) & 0xF800));
+    req->nbytes = EC_FRAME_HEADER_SIZE + req->ioctl.data_size;
+
     if (m_verbosity >= CommandMbg::Debug) {
-        cout << "ECat master replied with (size: " << inout_nbytes
+        cout << "ECat master replied with (size: " << req->nbytes
              << " bytes):" << endl;
-        printBuff(in_buffer, inout_nbytes);
+        printBuff(req->buffer, req->nbytes);
     }
-    
-    
-    return 0;
+}
+
+/****************************************************************************/
+
+static int setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if (flags == -1) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/****************************************************************************/
+
+void CommandMbg::receiveUdp(int udpSockFd)
+{
+    Request   *req;
+    socklen_t  addrlen;
+    ssize_t    nbytes;
+
+    while (1) {
+        req = new Request();
+        addrlen = sizeof(req->addr);
+        nbytes = recvfrom(udpSockFd, req->buffer, MAX_BUFF_SIZE, 0,
+                          (struct sockaddr*)&req->addr, &addrlen);
+        if (nbytes <= 0) {
+            int recvErr = errno;
+            delete req;
+            if ((nbytes < 0) && (recvErr != EAGAIN) && (recvErr != EWOULDBLOCK)
+                    && (m_verbosity >= CommandMbg::Normal)) {
+                cout << "UDP client read error " << recvErr
+                     << " " << strerror(recvErr)
+                     << ", on " << udpSockFd << endl;
+            }
+            return;
+        }
+
+        req->nbytes = nbytes;
+        if (parseMessage(req)) {
+            delete req;
+            continue;
+        }
+
+        if (m_udpQueued >= MAX_UDP_QUEUE) {
+            // datagrams may be lost anyway, the client will retry
+            if (m_verbosity >= CommandMbg::Verbose) {
+                cout << "UDP request dropped, too many outstanding requests"
+                     << endl;
+            }
+            delete req;
+            continue;
+        }
+
+        m_udpQueued++;
+        m_pending.push_back(req);
+    }
+}
+
+/****************************************************************************/
+
+void CommandMbg::acceptClient(int tcpSockFd)
+{
+    struct sockaddr_in  clientAddr;
+    socklen_t           addrlen;
+    struct epoll_event  ev;
+    int                 clientFd;
+    Client             *client;
+
+    while (1) {
+        addrlen  = sizeof(clientAddr);
+        clientFd = accept(tcpSockFd, (struct sockaddr*)&clientAddr, &addrlen);
+        if (clientFd == -1) {
+            if ( (errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+                 (m_verbosity >= CommandMbg::Verbose) ) {
+                cout << "Error accepting TCP client connection" << endl;
+            }
+            return;
+        }
+
+        // check connection count
+        if (m_clients.size() >= MAX_CONNECTIONS) {
+            shutdown(clientFd, SHUT_RDWR);
+            close(clientFd);
+            if (m_verbosity >= CommandMbg::Verbose) {
+                cout << "TCP client connection rejected, too many connections" << endl;
+            }
+            continue;
+        }
+
+        if (setNonBlocking(clientFd)) {
+            close(clientFd);
+            if (m_verbosity >= CommandMbg::Normal) {
+                cout << "Unable to configure TCP client connection" << endl;
+            }
+            continue;
+        }
+
+        client = new Client();
+        client->fd      = clientFd;
+        client->rxBytes = 0;
+        client->events  = EPOLLIN;
+        client->closed  = false;
+
+        ev.events  = client->events;
+        ev.data.fd = clientFd;
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, clientFd, &ev) == -1) {
+            stringstream err;
+            err << "Unable to watch TCP client connection: "
+                << strerror(errno);
+            close(clientFd);
+            delete client;
+            throwCommandException(err);
+        }
+        m_clients[clientFd] = client;
+
+        if (m_verbosity >= CommandMbg::Verbose) {
+            cout << "New TCP client connection on " << clientFd << endl;
+        }
+    }
+}
+
+/****************************************************************************/
+
+void CommandMbg::receiveTcp(Client *client)
+{
+    ssize_t nbytes;
+
+    while (!client->closed && client->requests.size() < MAX_CLIENT_QUEUE) {
+        nbytes = recv(client->fd, client->rxBuffer + client->rxBytes,
+                      MAX_BUFF_SIZE - client->rxBytes, 0);
+        if (nbytes <= 0) {
+            if ( (nbytes < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ) {
+                break;
+            }
+
+            // got error or connection closed by client
+            if ((nbytes == 0) || (errno == ECONNRESET)) {
+                if (m_verbosity >= CommandMbg::Verbose) {
+                    cout << "TCP client connection closed on " << client->fd << endl;
+                }
+            } else {
+                if (m_verbosity >= CommandMbg::Normal) {
+                    cout << "TCP client read error " << errno
+                         << " " << strerror(errno)
+                         << ", connection closed on " << client->fd << endl;
+                }
+            }
+            closeClient(client);
+            return;
+        }
+
+        client->rxBytes += nbytes;
+        parseClientFrames(client);
+    }
+
+    if (!client->closed) {
+        updateEvents(client);
+    }
+}
+
+/****************************************************************************/
+
+/** Queues the complete packets in a client's receive buffer.
+ *
+ * A tcp stream may carry several packets per read, or a packet split over
+ * several reads, so the EtherCAT header length delimits the packets.
+ */
+void CommandMbg::parseClientFrames(Client *client)
+{
+    Request *req;
+    size_t   size;
+
+    while (!client->closed && client->requests.size() < MAX_CLIENT_QUEUE
+            && client->rxBytes >= EC_FRAME_HEADER_SIZE) {
+        size = EC_FRAME_HEADER_SIZE + (EC_READ_U16(client->rxBuffer) & 0x7FF);
+        if (size > MAX_BUFF_SIZE) {
+            if (m_verbosity >= CommandMbg::Normal) {
+                cout << "Message error, packet size (" << size
+                     << ") too large, connection closed on " << client->fd
+                     << endl;
+            }
+            closeClient(client);
+            return;
+        }
+        if (client->rxBytes < size) {
+            break;
+        }
+
+        req = new Request();
+        req->client = client;
+        req->nbytes = size;
+        memcpy(req->buffer, client->rxBuffer, size);
+        client->rxBytes -= size;
+        memmove(client->rxBuffer, client->rxBuffer + size, client->rxBytes);
+
+        if (parseMessage(req)) {
+            delete req;
+            continue;
+        }
+
+        client->requests.push_back(req);
+        m_pending.push_back(req);
+    }
+}
+
+/****************************************************************************/
+
+void CommandMbg::writeClient(Client *client)
+{
+    ssize_t nbytes;
+
+    while (!client->txBuffer.empty()) {
+        nbytes = send(client->fd, client->txBuffer.data(),
+                      client->txBuffer.size(), MSG_NOSIGNAL);
+        if (nbytes < 0) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                break;
+            }
+
+            // write error
+            if (m_verbosity >= CommandMbg::Normal) {
+                cout << "TCP client write error " << errno
+                     << " " << strerror(errno)
+                     << ", connection closed on " << client->fd << endl;
+            }
+            closeClient(client);
+            return;
+        }
+        client->txBuffer.erase(0, nbytes);
+    }
+
+    updateEvents(client);
+}
+
+/****************************************************************************/
+
+/** Sends the replies of a client's leading finished requests.
+ */
+void CommandMbg::flushResponses(Client *client)
+{
+    Request *req;
+
+    while (!client->requests.empty() && client->requests.front()->done) {
+        req = client->requests.front();
+        client->requests.pop_front();
+        if (!client->closed && req->result == 0) {
+            client->txBuffer.append((const char *) req->buffer, req->nbytes);
+        }
+        delete req;
+    }
+
+    if (client->closed) {
+        return;
+    }
+
+    writeClient(client);
+
+    // the queue may have room for packets that are already buffered
+    if (!client->closed) {
+        parseClientFrames(client);
+    }
+    if (!client->closed) {
+        updateEvents(client);
+    }
+}
+
+/****************************************************************************/
+
+void CommandMbg::updateEvents(Client *client)
+{
+    struct epoll_event ev;
+    uint32_t           events = 0;
+
+    if (client->requests.size() < MAX_CLIENT_QUEUE) {
+        events |= EPOLLIN;
+    }
+    if (!client->txBuffer.empty()) {
+        events |= EPOLLOUT;
+    }
+
+    if (events == client->events) {
+        return;
+    }
+
+    ev.events  = events;
+    ev.data.fd = client->fd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, client->fd, &ev) == 0) {
+        client->events = events;
+    }
+}
+
+/****************************************************************************/
+
+/** Closes a client connection.
+ *
+ * Requests that are not dispatched yet are dropped. The client is freed by
+ * releaseClients() once its dispatched requests have finished.
+ */
+void CommandMbg::closeClient(Client *client)
+{
+    list<Request *>::iterator it;
+
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, client->fd, NULL);
+    close(client->fd);
+    m_clients.erase(client->fd);
+    client->closed = true;
+
+    it = client->requests.begin();
+    while (it != client->requests.end()) {
+        if ((*it)->dispatched) {
+            ++it;
+            continue;
+        }
+        m_pending.remove(*it);
+        delete *it;
+        it = client->requests.erase(it);
+    }
+
+    m_closedClients.push_back(client);
+}
+
+/****************************************************************************/
+
+void CommandMbg::releaseClients()
+{
+    list<Client *>::iterator it = m_closedClients.begin();
+
+    while (it != m_closedClients.end()) {
+        if ((*it)->requests.empty()) {
+            delete *it;
+            it = m_closedClients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/****************************************************************************/
+
+/** Submits pending requests to the master.
+ *
+ * Requests are submitted in arrival order, but only one per mailbox
+ * address at a time, so a slow slave only delays requests to itself. The
+ * submit ioctl returns at once; the master processes the requests of
+ * different slaves in parallel and signals completions with POLLPRI on the
+ * master device.
+ */
+void CommandMbg::dispatch()
+{
+    list<Request *>::iterator it = m_pending.begin();
+    list<Request *> failed;
+    Request *req;
+
+    while (it != m_pending.end() && m_inFlight.size() < m_concurrency) {
+        req = *it;
+        if (m_busySlaves.count(req->slave)) {
+            ++it;
+            continue;
+        }
+
+        if (m_masterDev->submitMessage(&req->ioctl) < 0) {
+            if (errno == EBUSY) {
+                // another application talks to this slave, retry later
+                ++it;
+                continue;
+            }
+            req->result = errno;
+            it = m_pending.erase(it);
+            req->dispatched = true;
+            failed.push_back(req);
+            continue;
+        }
+
+        it = m_pending.erase(it);
+        m_busySlaves.insert(req->slave);
+        m_inFlight[req->ioctl.id] = req;
+        req->dispatched = true;
+    }
+
+    // replying may close clients and modify the pending list
+    while (!failed.empty()) {
+        req = failed.front();
+        failed.pop_front();
+        completeRequest(req);
+    }
+}
+
+/****************************************************************************/
+
+/** Replies to a finished request.
+ */
+void CommandMbg::completeRequest(Request *req)
+{
+    finishMessage(req);
+
+    if (!req->client) {
+        // udp: reply immediately
+        m_udpQueued--;
+        if ( (req->result == 0) &&
+             (sendto(m_udpSockFd, req->buffer, req->nbytes, 0,
+                     (struct sockaddr*)&req->addr, sizeof(req->addr)) < 0) &&
+             (m_verbosity >= CommandMbg::Normal) ) {
+            cout << "UDP client send error " << errno
+                 << " " << strerror(errno)
+                 << ", on " << m_udpSockFd << endl;
+        }
+        delete req;
+    } else {
+        req->done = true;
+        flushResponses(req->client);
+    }
+}
+
+/****************************************************************************/
+
+/** Collects the finished requests from the master.
+ *
+ * \param wait Block until at least one request has finished.
+ */
+void CommandMbg::collectCompletions(bool wait)
+{
+    ec_ioctl_mbg_result_t results[MAX_COMPLETIONS];
+    ec_ioctl_mbg_complete_t data;
+    map<uint32_t, Request *>::iterator it;
+    Request *req;
+    unsigned int i;
+
+    do {
+        data.results = results;
+        data.max_count = MAX_COMPLETIONS;
+        data.wait = wait;
+        if (m_masterDev->completeMessages(&data) < 0) {
+            if (errno != EINTR && m_verbosity >= CommandMbg::Normal) {
+                cout << "Failed to collect mailbox gateway results: "
+                     << strerror(errno) << endl;
+            }
+            return;
+        }
+
+        for (i = 0; i < data.count; i++) {
+            it = m_inFlight.find(results[i].id);
+            if (it == m_inFlight.end()) {
+                continue;
+            }
+            req = it->second;
+            m_inFlight.erase(it);
+            m_busySlaves.erase(req->slave);
+
+            req->result = -results[i].error;
+            req->ioctl.data_size = results[i].data_size;
+            completeRequest(req);
+        }
+
+        wait = false;
+    } while (data.count == MAX_COMPLETIONS);
 }
 
 /****************************************************************************/
@@ -270,26 +750,19 @@ void CommandMbg::execute(const StringVector &args)
 {
     int                 tcpSockFd;
     int                 udpSockFd;
-    int                 clientFd;
-    int                 sockFd;
     struct sockaddr_in  serverAddr;
-    struct sockaddr_in  clientAddr;
-    socklen_t           addrlen;
     int                 retries;
-    fd_set              masterSet;
-    fd_set              sockSet;
-    int                 minFd;
-    int                 maxFd;
-    int                 tmpFd;
-    int                 limitFd;
-    struct timeval      loopTimeout;
+    struct epoll_event  ev;
+    struct epoll_event  events[MAX_EVENTS];
     int                 nready;
-    uint8_t             buffer[MAX_BUFF_SIZE]; 
-    size_t              nbytes;
+    int                 i;
+    int                 fd;
+    map<int, Client *>::iterator client;
+
 
-    
     // ensure a single master
     m_masterDev = new MasterDevice(getSingleMasterIndex());
+    m_masterDev->open(MasterDevice::ReadWrite);
 
 
     // create TCP socket
@@ -334,7 +807,7 @@ void CommandMbg::execute(const StringVector &args)
             err << "Unable to bind TCP socket on port " << SVR_PORT;
             throwCommandException(err);
         }
-        
+
         sleep(10);
     }
     if (m_verbosity >= CommandMbg::Verbose) {
@@ -347,6 +820,9 @@ void CommandMbg::execute(const StringVector &args)
     } else if (m_verbosity >= CommandMbg::Normal) {
         cout << "TCP socket listening for connections on port " << SVR_PORT << endl;
     }
+    if (setNonBlocking(tcpSockFd)) {
+        throwCommandException("Unable to configure TCP socket (non-blocking)");
+    }
 
 
     // create UDP socket
@@ -369,7 +845,7 @@ void CommandMbg::execute(const StringVector &args)
             err << "Unable to bind UDP socket on port " << SVR_PORT;
             throwCommandException(err);
         }
-        
+
         sleep(10);
     }
     if (m_verbosity >= CommandMbg::Verbose) {
@@ -378,180 +854,112 @@ void CommandMbg::execute(const StringVector &args)
     if (m_verbosity >= CommandMbg::Normal) {
         cout << "UDP socket listening for connections on port " << SVR_PORT << endl;
     }
+    if (setNonBlocking(udpSockFd)) {
+        throwCommandException("Unable to configure UDP socket (non-blocking)");
+    }
+    m_udpSockFd = udpSockFd;
 
 
-    // clear the socket set
-    FD_ZERO(&masterSet);
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd == -1) {
+        throwCommandException("Unable to create epoll instance");
+    }
 
-    // set the TCP and UDP flags in the socket read set 
-    FD_SET(tcpSockFd, &masterSet);
-    FD_SET(udpSockFd, &masterSet);
-    
-    // get the socket fd range
-    minFd = (tcpSockFd < udpSockFd) ? tcpSockFd : udpSockFd;
-    maxFd = (tcpSockFd > udpSockFd) ? tcpSockFd : udpSockFd;
-    
-    // get the tcp connection limit
-    limitFd = maxFd + MAX_CONNECTIONS;
+    ev.events = EPOLLIN;
+    ev.data.fd = tcpSockFd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, tcpSockFd, &ev) == -1) {
+        throwCommandException("Unable to watch TCP socket");
+    }
+    ev.data.fd = udpSockFd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, udpSockFd, &ev) == -1) {
+        throwCommandException("Unable to watch UDP socket");
+    }
 
-    if (m_verbosity >= CommandMbg::Debug) {
-        cout << "tcpSockFd " << tcpSockFd
-             << ", udpSockFd " << udpSockFd
-             << ", minFd " << minFd
-             << ", maxFd " << maxFd
-             << ", limitFd " << limitFd << endl;
+    // the master signals finished requests with POLLPRI
+    ev.events = EPOLLPRI;
+    ev.data.fd = m_masterDev->getFD();
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, ev.data.fd, &ev) == -1) {
+        throwCommandException("Unable to watch master device");
     }
 
-    // run the server until
+    // run the server until terminated
     while (!m_terminate) {
-        // wait for a socket request (new connection or client request)
-        // Note: uses timeout of 5 seconds to allow checking of terminate flag
-        // Note: copy masterSet (active socket fd's) so that select can return
-        //   the ready sockets to sockSet
-        loopTimeout.tv_sec  = 5;
-        loopTimeout.tv_usec = 0;
-        sockSet = masterSet;
-        nready = select(maxFd+1, &sockSet, NULL, NULL, &loopTimeout);
-        
+        // Note: uses timeout of 1 second to allow checking of terminate flag
+        nready = epoll_wait(m_epollFd, events, MAX_EVENTS, 1000);
+
         // check for errors
         if (nready == -1) {
-            int selectErr = errno;
-            if (selectErr == EINTR) {
+            int epollErr = errno;
+            if (epollErr == EINTR) {
                 // server interrupted, loop
                 continue;
             } else {
                 stringstream err;
-                err << "Error during select " << errno 
-                    << ", " << strerror(selectErr);
+                err << "Error during epoll_wait " << epollErr
+                    << ", " << strerror(epollErr);
                 throwCommandException(err);
             }
         }
-        
-        // run through the existing connections looking for data to be read
-        // Note: cache the maxFd for the for loop to avoid looping too far
-        //   if a new clientFd is accepted
-        tmpFd = maxFd;
-        for (sockFd = minFd; sockFd <= tmpFd; sockFd++)
-        {
-            // skip if fd is not in set
-            if (!FD_ISSET(sockFd, &sockSet)) {
-                continue;
-            }
-            
+
+        for (i = 0; i < nready; i++) {
+            fd = events[i].data.fd;
+
             if (m_verbosity >= CommandMbg::Debug) {
-                cout << "Socket " << sockFd
-                     << " selected" << endl;
+                cout << "Socket " << fd << " selected" << endl;
             }
-            
-            if (sockFd == udpSockFd) {
-                // UDP socket datagram
-                addrlen = sizeof(clientAddr);
-                nbytes = recvfrom(udpSockFd, buffer, MAX_BUFF_SIZE, 0,
-                                  (struct sockaddr*)&clientAddr, &addrlen);
-                if (nbytes <= 0) {
-                    // got error or connection closed by client
-                    if ((nbytes == 0) || (errno == ECONNRESET)) {
-                        if (m_verbosity >= CommandMbg::Verbose) {
-                            cout << "UDP client connection closed on " << sockFd << endl;
-                        }
-                    } else {
-                        if (m_verbosity >= CommandMbg::Normal) {
-                            cout << "UDP client read error " << errno 
-                                 << " " << strerror(errno) 
-                                 << ", on " << sockFd << endl;
-                        }
-                    }
-                } else {
-                    // process the frame
-                    if (processMessage(buffer, nbytes) == 0) {
-                        // send the reply
-                        if (sendto(udpSockFd, buffer, nbytes, 0,
-                                   (struct sockaddr*)&clientAddr, sizeof(clientAddr)) < 0) {
-                            // send error
-                            if (m_verbosity >= CommandMbg::Normal) {
-                                cout << "UDP client send error " << errno 
-                                     << " " << strerror(errno) 
-                                     << ", on " << sockFd << endl;
-                            }
-                        }
-                    }
-                }
-            } else if (sockFd == tcpSockFd) {
-                // new TCP socket connection
-                // accept the connection
-                addrlen  = sizeof(clientAddr);
-                clientFd = accept(tcpSockFd, (struct sockaddr*)&clientAddr, &addrlen);
-                
-                // check for error
-                if ( (clientFd == -1) && (m_verbosity >= CommandMbg::Verbose) ) {
-                    cout << "Error accepting TCP client connection" << endl;
-                // check conneciton count
-                } else if (clientFd > limitFd) {
-                    shutdown(clientFd, SHUT_RDWR);
-                    if (m_verbosity >= CommandMbg::Verbose) {
-                        cout << "TCP client connection rejected, too many connections" << endl;
-                    }
-                } else {
+
+            if (fd == udpSockFd) {
+                receiveUdp(udpSockFd);
+            } else if (fd == tcpSockFd) {
+                acceptClient(tcpSockFd);
+            } else if (fd == m_masterDev->getFD()) {
+                collectCompletions();
+            } else if ((client = m_clients.find(fd)) != m_clients.end()) {
+                // TCP client connection
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
                     if (m_verbosity >= CommandMbg::Verbose) {
-                        cout << "New TCP client connection on " << clientFd << endl;
-                    }
-                    
-                    // add the connection to the master sock set (and min/maxFd's)
-                    FD_SET(clientFd, &masterSet);
-                    if (clientFd < minFd) minFd = clientFd;
-                    if (clientFd > maxFd) maxFd = clientFd;
-                    
-                    if (m_verbosity >= CommandMbg::Debug) {
-                        cout << "minFd " << minFd
-                             << ", maxFd " << maxFd << endl;
+                        cout << "TCP client connection closed on " << fd << endl;
                     }
+                    closeClient(client->second);
+                    continue;
                 }
-            } else {
-                // TCP client connection
-                nbytes = recv(sockFd, buffer, MAX_BUFF_SIZE, 0);
-                if (nbytes <= 0) {
-                    // got error or connection closed by client
-                    if ((nbytes == 0) || (errno == ECONNRESET)) {
-                       if (m_verbosity >= CommandMbg::Verbose) {
-                            cout << "TCP client connection closed on " << sockFd << endl;
-                        }
-                    } else {
-                        if (m_verbosity >= CommandMbg::Normal) {
-                            cout << "TCP client read error " << errno 
-                                 << " " << strerror(errno) 
-                                 << ", connection closed on " << sockFd << endl;
-                        }
-                    }
-
-                    // close the socket
-                    close(sockFd);
-
-                    // remove from master sock set
-                    FD_CLR(sockFd, &masterSet);
-                } else {
-                    // process the frame
-                    if (processMessage(buffer, nbytes) == 0) {
-                        // reply
-                        if (write(sockFd, buffer, nbytes) < 0) {
-                            // write error
-                            if (m_verbosity >= CommandMbg::Normal) {
-                                cout << "TCP client write error " << errno 
-                                     << " " << strerror(errno) 
-                                     << ", connection closed on " << sockFd << endl;
-                            }
-
-                            // close the socket
-                            close(sockFd);
-
-                            // remove from master sock set
-                            FD_CLR(sockFd, &masterSet);
-                        }
-                    }
+                if (events[i].events & EPOLLIN) {
+                    receiveTcp(client->second);
+                }
+                if ((events[i].events & EPOLLOUT)
+                        && (client = m_clients.find(fd)) != m_clients.end()) {
+                    writeClient(client->second);
                 }
             }
         }
+
+        dispatch();
+        releaseClients();
     }
-    
+
+    while (!m_clients.empty()) {
+        closeClient(m_clients.begin()->second);
+    }
+
+    // wait for the submitted requests, so that their clients can be released
+    while (!m_inFlight.empty()) {
+        size_t inFlight = m_inFlight.size();
+        collectCompletions(true);
+        if (m_inFlight.size() == inFlight) {
+            break;
+        }
+    }
+    releaseClients();
+    while (!m_pending.empty()) {
+        delete m_pending.front();
+        m_pending.pop_front();
+    }
+
+    close(m_epollFd);
+    close(udpSockFd);
+    close(tcpSockFd);
+    m_masterDev->close();
+
     if (m_verbosity >= CommandMbg::Normal) {
         cout << "Server exiting" << endl;
     }
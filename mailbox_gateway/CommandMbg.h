@@ -33,9 +33,14 @@
 #include <stdexcept>
 #include <vector>
 #include <list>
+#include <map>
+#include <set>
+#include <string>
 #include <sstream>
 using namespace std;
 
+#include <netinet/in.h>
+
 #include "../master/ioctl.h"
 
 
@@ -43,11 +48,26 @@ using namespace std;
 #define SVR_PORT          0x88A4
 
 /** the maximum tcp connection count */
-#define MAX_CONNECTIONS   16
+#define MAX_CONNECTIONS   64
 
 /** the maximum EtherCAT Mailbox Gateway data packet size */
 #define MAX_BUFF_SIZE     1500
 
+/** the default number of requests processed by the master at a time */
+#define DEFAULT_CONCURRENCY 8
+
+/** the maximum number of outstanding requests per tcp connection */
+#define MAX_CLIENT_QUEUE  32
+
+/** the maximum number of outstanding udp requests */
+#define MAX_UDP_QUEUE     64
+
+/** the maximum number of epoll events handled per wakeup */
+#define MAX_EVENTS        32
+
+/** the maximum number of completions collected per ioctl */
+#define MAX_COMPLETIONS   32
+
 
 /****************************************************************************/
 
@@ -108,6 +128,8 @@ class CommandMbg
         void setVerbosity(Verbosity);
         Verbosity getVerbosity() const;
 
+        void setConcurrency(unsigned int);
+
         typedef vector<string> StringVector;
         void execute(const StringVector &);
         
@@ -116,20 +138,74 @@ class CommandMbg
     protected:
         enum {BreakAfterBytes = 16};
 
+        struct Client;
+
+        /** A gateway request, from reception until the reply is sent. */
+        struct Request {
+            Client                  *client; /**< NULL for udp. */
+            struct sockaddr_in       addr;   /**< udp reply address. */
+            uint16_t                 slave;  /**< Mailbox address. */
+            uint8_t                  buffer[MAX_BUFF_SIZE];
+            size_t                   nbytes;
+            ec_ioctl_mbg_submit_t    ioctl;
+            int                      result; /**< errno of the request. */
+            bool                     dispatched;
+            bool                     done;
+        };
+
+        /** A tcp connection. Requests are answered in order. */
+        struct Client {
+            int                      fd;
+            uint8_t                  rxBuffer[MAX_BUFF_SIZE];
+            size_t                   rxBytes;
+            string                   txBuffer;
+            list<Request *>          requests;
+            uint32_t                 events; /**< Registered epoll events. */
+            bool                     closed;
+        };
+
         static void throwInvalidUsageException(const stringstream &);
         static void throwCommandException(const string &);
         static void throwCommandException(const stringstream &);
 
-        int processMessage(uint8_t *, size_t &);
+        int parseMessage(Request *);
+        void finishMessage(Request *);
 
         void printBuff(uint8_t *, size_t);
-        
+
+        void receiveUdp(int);
+        void acceptClient(int);
+        void receiveTcp(Client *);
+        void parseClientFrames(Client *);
+        void writeClient(Client *);
+        void flushResponses(Client *);
+        void updateEvents(Client *);
+        void closeClient(Client *);
+        void releaseClients();
+
+        void dispatch();
+        void completeRequest(Request *);
+        void collectCompletions(bool = false);
+
     private:
         string        m_masters;
         Verbosity     m_verbosity;
+        unsigned int  m_concurrency;
 
-        int           m_terminate;
+        volatile int  m_terminate;
         MasterDevice *m_masterDev;
+
+        int           m_epollFd;
+        int           m_udpSockFd;
+
+        map<int, Client *>  m_clients;
+        list<Client *>      m_closedClients;
+        list<Request *>     m_pending;    /**< Not yet dispatched. */
+        set<uint16_t>       m_busySlaves; /**< Slaves with a dispatched
+                                            request. */
+        map<uint32_t, Request *> m_inFlight; /**< Dispatched requests by
+                                               request ID. */
+        unsigned int        m_udpQueued;  /**< Outstanding udp requests. */
 };
 
 /****************************************************************************/
@@ -121,4 +121,18 @@ int MasterDevice::processMessage(ec_ioctl_mbox_gateway_t *data)
     return ioctl(m_fd, EC_IOCTL_MBOX_GATEWAY, data);
 }
 
+/****************************************************************************/
+
+int MasterDevice::submitMessage(ec_ioctl_mbg_submit_t *data)
+{
+    return ioctl(m_fd, EC_IOCTL_MBG_SUBMIT, data);
+}
+
+/****************************************************************************/
+
+int MasterDevice::completeMessages(ec_ioctl_mbg_complete_t *data)
+{
+    return ioctl(m_fd, EC_IOCTL_MBG_COMPLETE, data);
+}
+
 /*****************************************************************************/
@@ -76,6 +76,8 @@ class MasterDevice
         void getModule(ec_ioctl_module_t *);
         
         int processMessage(ec_ioctl_mbox_gateway_t *);
+        int submitMessage(ec_ioctl_mbg_submit_t *);
+        int completeMessages(ec_ioctl_mbg_complete_t *);
 
         unsigned int getMasterCount() const {return m_masterCount;}
 
@@ -50,6 +50,7 @@ CommandMbg::StringVector commandArgs;
 // option variables
 string                 masters = "-"; // all masters
 CommandMbg::Verbosity  verbosity = CommandMbg::Normal;
+unsigned int           concurrency = DEFAULT_CONCURRENCY;
 bool                   helpRequested = false;
 CommandMbg            *cmd;
 
@@ -69,6 +70,11 @@ string usage()
         << "                           than one master." << endl
         << "                           If there is only one master this" << endl
         << "                           option is not required." << endl
+        << "  --concurrency -c <n>     Maximum number of requests" << endl
+        << "                           processed at the same time," << endl
+        << "                           at most one per slave" << endl
+        << "                           (default " << DEFAULT_CONCURRENCY
+        << ")." << endl
         << "  --quiet   -q             Output no information, unless" << endl
         << "                           there are parameter errors." << endl
         << "  --verbose -v             Output more information." << endl
@@ -90,6 +96,7 @@ void getOptions(int argc, char **argv)
     static struct option longOptions[] = {
         //name,         has_arg,           flag, val
         {"master",      required_argument, NULL, 'm'},
+        {"concurrency", required_argument, NULL, 'c'},
         {"quiet",       no_argument,       NULL, 'q'},
         {"verbose",     no_argument,       NULL, 'v'},
         {"debug",       no_argument,       NULL, 'd'},
@@ -98,13 +105,26 @@ void getOptions(int argc, char **argv)
     };
 
     do {
-        c = getopt_long(argc, argv, "m:qvdh", longOptions, NULL);
+        c = getopt_long(argc, argv, "m:c:qvdh", longOptions, NULL);
 
         switch (c) {
             case 'm':
                 masters = optarg;
                 break;
 
+            case 'c':
+                {
+                    char *end;
+                    unsigned long value = strtoul(optarg, &end, 0);
+                    if (*end || !value || value > 256) {
+                        cerr << "Invalid concurrency '" << optarg << "'!"
+                            << endl << endl << usage();
+                        exit(1);
+                    }
+                    concurrency = value;
+                }
+                break;
+
             case 'q':
                 verbosity = CommandMbg::Quiet;
                 break;
@@ -208,6 +228,7 @@ int main(int argc, char **argv)
     cmd = new CommandMbg();
     cmd->setMasters(masters);
     cmd->setVerbosity(verbosity);
+    cmd->setConcurrency(concurrency);
     
     try {
         // execute server
@@ -37,6 +37,7 @@
 #include <linux/module.h>
 #include <linux/vmalloc.h>
 #include <linux/mm.h>
+#include <linux/poll.h>
 
 #include "cdev.h"
 #include "master.h"
@@ -55,6 +56,8 @@ static int eccdev_open(struct inode *, struct file *);
 static int eccdev_release(struct inode *, struct file *);
 static long eccdev_ioctl(struct file *, unsigned int, unsigned long);
 static int eccdev_mmap(struct file *, struct vm_area_struct *);
+static ssize_t eccdev_read(struct file *, char __user *, size_t, loff_t *);
+static unsigned int eccdev_poll(struct file *, poll_table *);
 
 /** 这是可用于vm_operations_struct的.fault成员的内核版本。
  */
@@ -86,7 +89,9 @@ static struct file_operations eccdev_fops = {
     .open           = eccdev_open,
     .release        = eccdev_release,
     .unlocked_ioctl = eccdev_ioctl,
-    .mmap           = eccdev_mmap
+    .mmap           = eccdev_mmap,
+    .read           = eccdev_read,
+    .poll           = eccdev_poll
 };
 
 /** 用于使用ecdevc_mmap()检索的虚拟内存区域的回调函数。
@@ -108,6 +113,7 @@ struct vm_operations_struct eccdev_vm_ops = {
 typedef struct {
     ec_cdev_t *cdev; /**< 字符设备 */
     ec_ioctl_context_t ctx; /**< 上下文 */
+    u32 event_seq; /**< 下一条要读取的事件的序号 */
 } ec_cdev_priv_t;
 
 /*****************************************************************************/
@@ -190,6 +196,8 @@ int eccdev_open(struct inode *inode, struct file *filp)
     priv->ctx.requested = 0;
     priv->ctx.process_data = NULL;
     priv->ctx.process_data_size = 0;
+    ec_mbg_queue_init(&priv->ctx.mbg);
+    priv->event_seq = ec_event_ring_head(&cdev->master->events);
 
     filp->private_data = priv;
 
@@ -215,6 +223,8 @@ int eccdev_release(struct inode *inode, struct file *filp)
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
     ec_master_t *master = priv->cdev->master;
 
+    ec_master_mbg_queue_clear(master, &priv->ctx.mbg);
+
     if (priv->ctx.requested) {
         ecrt_release_master(master);
     }
@@ -257,6 +267,87 @@ long eccdev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 }
 
 
+/*****************************************************************************/
+
+/**
+ * @brief 读取事件时调用
+ *
+ * @param filp 文件结构指针
+ * @param buf 用户空间缓冲区
+ * @param count 缓冲区大小
+ * @param ppos 文件位置（未使用）
+ * @return 读取的字节数，否则返回负值
+ *
+ * @details 返回尽可能多的完整事件记录（ec_event_t）。没有新记录时阻塞，
+ * 以O_NONBLOCK打开时返回-EAGAIN。
+ */
+ssize_t eccdev_read(struct file *filp, char __user *buf, size_t count,
+        loff_t *ppos)
+{
+    ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    ec_event_ring_t *ring = &priv->cdev->master->events;
+    ec_event_t event;
+    size_t done = 0;
+
+    if (count < sizeof(event)) {
+        return -EINVAL;
+    }
+
+    while (!ec_event_ring_ready(ring, priv->event_seq)) {
+        if (filp->f_flags & O_NONBLOCK) {
+            return -EAGAIN;
+        }
+        if (wait_event_interruptible(ring->wait,
+                    ec_event_ring_ready(ring, priv->event_seq))) {
+            return -ERESTARTSYS;
+        }
+    }
+
+    while (count - done >= sizeof(event)
+            && !ec_event_ring_fetch(ring, &priv->event_seq, &event)) {
+        if (copy_to_user(buf + done, &event, sizeof(event))) {
+            return done ? done : -EFAULT;
+        }
+        done += sizeof(event);
+    }
+
+    return done;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 调用poll()/select()时调用
+ *
+ * @param filp 文件结构指针
+ * @param wait poll表
+ * @return 有新事件时包含POLLIN | POLLRDNORM，此文件句柄有已完成的异步
+ *         邮箱网关请求时包含POLLPRI
+ *
+ * @details read()已用于事件通道，因此异步邮箱网关请求的完成通过POLLPRI
+ * 通知，结果用EC_IOCTL_MBG_COMPLETE收集。
+ */
+unsigned int eccdev_poll(struct file *filp, poll_table *wait)
+{
+    ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    ec_master_t *master = priv->cdev->master;
+    ec_event_ring_t *ring = &master->events;
+    unsigned int mask = 0;
+
+    poll_wait(filp, &ring->wait, wait);
+    poll_wait(filp, &master->request_queue, wait);
+
+    if (ec_event_ring_ready(ring, priv->event_seq)) {
+        mask |= POLLIN | POLLRDNORM;
+    }
+
+    if (ec_mbg_queue_done(&priv->ctx.mbg)) {
+        mask |= POLLPRI;
+    }
+
+    return mask;
+}
+
 /*****************************************************************************/
 
 #ifndef VM_DONTDUMP
@@ -285,9 +376,28 @@ long eccdev_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 int eccdev_mmap(struct file *filp, struct vm_area_struct *vma)
 {
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) filp->private_data;
+    unsigned long region = vma->vm_pgoff >>
+        (EC_IOCTL_MMAP_REGION_SHIFT - PAGE_SHIFT);
 
     EC_MASTER_DBG(priv->cdev->master, 1, "mmap()\n");
 
+    switch (region) {
+        case EC_IOCTL_MMAP_PROCESS_DATA:
+            break;
+        case EC_IOCTL_MMAP_PCAP:
+        case EC_IOCTL_MMAP_SCOPE:
+        case EC_IOCTL_MMAP_REQ_SHM:
+        case EC_IOCTL_MMAP_EMERG:
+            /* 捕获环、记录环、请求状态区域和紧急消息日志只能只读映射 */
+            if (vma->vm_flags & VM_WRITE) {
+                return -EPERM;
+            }
+            vma->vm_flags &= ~VM_MAYWRITE;
+            break;
+        default:
+            return -EINVAL;
+    }
+
     vma->vm_ops = &eccdev_vm_ops;
     vma->vm_flags |= VM_DONTDUMP; /* 页面将不会被交换出去 */
     vma->vm_private_data = priv;
@@ -297,6 +407,44 @@ int eccdev_mmap(struct file *filp, struct vm_area_struct *vma)
 
 /*****************************************************************************/
 
+/**
+ * @brief 返回mmap()偏移量对应的页面。
+ *
+ * @param priv 文件句柄的私有数据。
+ * @param offset mmap()偏移量（字节）。
+ * @return 页面，偏移量无效时返回NULL。
+ *
+ * @details 偏移量的高位选择区域（见EC_IOCTL_MMAP_REGION_SHIFT）。
+ */
+static struct page *eccdev_vma_page(ec_cdev_priv_t *priv,
+        unsigned long offset)
+{
+    unsigned long region = offset >> EC_IOCTL_MMAP_REGION_SHIFT;
+
+    offset &= EC_IOCTL_MMAP_REGION_SIZE - 1;
+
+    switch (region) {
+        case EC_IOCTL_MMAP_PROCESS_DATA:
+            if (offset >= priv->ctx.process_data_size) {
+                return NULL;
+            }
+            return vmalloc_to_page(priv->ctx.process_data + offset);
+        case EC_IOCTL_MMAP_PCAP:
+            return ec_pcap_ring_page(&priv->cdev->master->pcap, offset);
+        case EC_IOCTL_MMAP_SCOPE:
+            return ec_scope_page(&priv->cdev->master->scope, offset);
+        case EC_IOCTL_MMAP_REQ_SHM:
+            return ec_req_shm_page(&priv->cdev->master->req_shm, offset);
+        case EC_IOCTL_MMAP_EMERG:
+            return ec_emerg_journal_page(&priv->cdev->master->emerg_journal,
+                    offset);
+        default:
+            return NULL;
+    }
+}
+
+/*****************************************************************************/
+
 #if LINUX_VERSION_CODE >= PAGE_FAULT_VERSION
 
 /** 
@@ -340,11 +488,7 @@ int eccdev_vma_fault(struct vm_area_struct *vma, struct vm_fault *vmf)
     ec_cdev_priv_t *priv = (ec_cdev_priv_t *) vma->vm_private_data;
     struct page *page;
 
-    if (offset >= priv->ctx.process_data_size) {
-        return VM_FAULT_SIGBUS;
-    }
-
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
+    page = eccdev_vma_page(priv, offset);
     if (!page) {
         return VM_FAULT_SIGBUS;
     }
@@ -392,11 +536,10 @@ struct page *eccdev_vma_nopage(
 
     offset = (address - vma->vm_start) + (vma->vm_pgoff << PAGE_SHIFT);
 
-    if (offset >= priv->ctx.process_data_size)
+    page = eccdev_vma_page(priv, offset);
+    if (!page)
         return NOPAGE_SIGBUS;
 
-    page = vmalloc_to_page(priv->ctx.process_data + offset);
-
     EC_MASTER_DBG(master, 1, "无页错误回调函数 vma, address = %#lx,"
             " offset = %#lx, page = %p\n", address, offset, page);
 
@@ -37,6 +37,8 @@
 
 #include <linux/slab.h>
 
+#include "master.h"
+#include "slave_config.h"
 #include "coe_emerg_ring.h"
 
 /*****************************************************************************/
@@ -56,7 +58,7 @@ void ec_coe_emerg_ring_init(
 )
 {
     ring->sc = sc;
-    ring->msgs = NULL;
+    ring->seqs = NULL;
     ring->size = 0;
     ring->read_index = 0;
     ring->write_index = 0;
@@ -76,9 +78,9 @@ void ec_coe_emerg_ring_clear(
     ec_coe_emerg_ring_t *ring /**< 紧急环形缓冲区。 */
 )
 {
-    if (ring->msgs)
+    if (ring->seqs)
     {
-        kfree(ring->msgs);
+        kfree(ring->seqs);
     }
 }
 
@@ -109,19 +111,19 @@ int ec_coe_emerg_ring_size(
 
     ring->read_index = ring->write_index = 0;
 
-    if (ring->msgs)
+    if (ring->seqs)
     {
-        kfree(ring->msgs);
+        kfree(ring->seqs);
     }
-    ring->msgs = NULL;
+    ring->seqs = NULL;
 
     if (size == 0)
     {
         return 0;
     }
 
-    ring->msgs = kmalloc(sizeof(ec_coe_emerg_msg_t) * (size + 1), GFP_KERNEL);
-    if (!ring->msgs)
+    ring->seqs = kmalloc(sizeof(u32) * (size + 1), GFP_KERNEL);
+    if (!ring->seqs)
     {
         return -ENOMEM;
     }
@@ -136,13 +138,14 @@ int ec_coe_emerg_ring_size(
  * @brief 添加新的紧急消息。
  *
  * @param ring 紧急环形缓冲区对象。
- * @param msg 紧急消息的数据。
+ * @param seq 紧急消息在主站日志中的序号。
  *
- * @details 此函数用于向紧急环形缓冲区添加新的紧急消息。如果缓冲区已满，则溢出计数增加。
+ * @details 此函数用于向紧急环形缓冲区添加新的紧急消息。消息已经由调用者写入主站的
+ * 紧急消息日志，这里只保存它的序号。如果缓冲区已满，则溢出计数增加。
  */
 void ec_coe_emerg_ring_push(
     ec_coe_emerg_ring_t *ring, /**< 紧急环形缓冲区。 */
-    const u8 *msg              /**< 紧急消息。 */
+    u32 seq                    /**< 日志中的序号。 */
 )
 {
     if (!ring->size ||
@@ -152,8 +155,7 @@ void ec_coe_emerg_ring_push(
         return;
     }
 
-    memcpy(ring->msgs[ring->write_index].data, msg,
-           EC_COE_EMERGENCY_MSG_SIZE);
+    ring->seqs[ring->write_index] = seq;
     ring->write_index = (ring->write_index + 1) % (ring->size + 1);
 }
 
@@ -166,21 +168,36 @@ void ec_coe_emerg_ring_push(
  * @param msg 存储紧急消息的内存。
  * @return 如果成功移除消息，则返回0；否则返回负数的错误代码。
  *
- * @details 此函数用于从环形缓冲区中移除紧急消息。如果缓冲区为空，则返回-ENOENT表示没有可移除的消息。
+ * @details 此函数用于从环形缓冲区中移除紧急消息，并从主站的紧急消息日志中读取消息内容。
+ * 已被日志覆盖的消息被跳过并计为溢出。如果缓冲区为空，则返回-ENOENT表示没有可移除的消息。
  */
 int ec_coe_emerg_ring_pop(
     ec_coe_emerg_ring_t *ring, /**< 紧急环形缓冲区。 */
     u8 *msg                    /**< 存储紧急消息的内存。 */
 )
 {
-    if (ring->read_index == ring->write_index)
+    ec_emergency_t entry;
+    u32 seq;
+
+    while (ring->read_index != ring->write_index)
     {
-        return -ENOENT;
+        seq = ring->seqs[ring->read_index];
+        ring->read_index = (ring->read_index + 1) % (ring->size + 1);
+
+        if (ec_emerg_journal_get(&ring->sc->master->emerg_journal, seq,
+                                 &entry))
+        {
+            ring->overruns++;
+            continue;
+        }
+
+        EC_WRITE_U16(msg, entry.error_code);
+        EC_WRITE_U8(msg + 2, entry.error_register);
+        memcpy(msg + 3, entry.data, sizeof(entry.data));
+        return 0;
     }
 
-    memcpy(msg, ring->msgs[ring->read_index].data, EC_COE_EMERGENCY_MSG_SIZE);
-    ring->read_index = (ring->read_index + 1) % (ring->size + 1);
-    return 0;
+    return -ENOENT;
 }
 
 /*****************************************************************************/
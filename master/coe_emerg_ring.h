@@ -41,22 +41,16 @@
 
 /*****************************************************************************/
 
-/** EtherCAT CoE紧急消息记录。
-*/
-typedef struct
-{
-u8 data[EC_COE_EMERGENCY_MSG_SIZE]; /**< 消息数据。 */
-} ec_coe_emerg_msg_t;
-
-/*****************************************************************************/
-
 /** EtherCAT CoE紧急环形缓冲区。
+ *
+ * 消息本身保存在主站的紧急消息日志中（见ec_emerg_journal_t），环形缓冲区
+ * 只保存属于该从站配置的消息的序号。弹出时已被日志覆盖的消息计为溢出。
 */
 typedef struct
 {
 ec_slave_config_t *sc; /**< 拥有该环形缓冲区的从设备配置。 */
 
-ec_coe_emerg_msg_t *msgs; /**< 消息环形缓冲区。 */
+u32 *seqs;                /**< 消息在日志中的序号。 */
 size_t size;              /**< 环形缓冲区大小。 */
 
 unsigned int read_index;  /**< 读索引。 */
@@ -71,7 +65,7 @@ void ec_coe_emerg_ring_init(ec_coe_emerg_ring_t *, ec_slave_config_t *);
 void ec_coe_emerg_ring_clear(ec_coe_emerg_ring_t *);
 
 int ec_coe_emerg_ring_size(ec_coe_emerg_ring_t *, size_t);
-void ec_coe_emerg_ring_push(ec_coe_emerg_ring_t *, const u8 *);
+void ec_coe_emerg_ring_push(ec_coe_emerg_ring_t *, u32);
 int ec_coe_emerg_ring_pop(ec_coe_emerg_ring_t *, u8 *);
 int ec_coe_emerg_ring_clear_ring(ec_coe_emerg_ring_t *);
 int ec_coe_emerg_ring_overruns(ec_coe_emerg_ring_t *);
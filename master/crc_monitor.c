@@ -0,0 +1,182 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   ESC错误计数器的总线健康监视。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/jiffies.h>
+
+#include "crc_monitor.h"
+
+/*****************************************************************************/
+
+/**
+@brief 初始化从站的错误计数器。
+@param counters 错误计数器。
+*/
+void ec_crc_counters_init(
+    ec_crc_counters_t *counters /**< 错误计数器。 */
+)
+{
+    memset(counters, 0, sizeof(*counters));
+}
+
+/*****************************************************************************/
+
+/**
+@brief 用新读取的寄存器更新错误计数器。
+@param counters 错误计数器。
+@param data 从0x0300开始的EC_CRC_MONITOR_REG_SIZE字节。
+@details 读取时计数器已被清零，读取的值就是增量。第一次读取时，寄存器
+中已有的值作为增量计入。
+*/
+void ec_crc_counters_update(
+    ec_crc_counters_t *counters, /**< 错误计数器。 */
+    const uint8_t *data          /**< 读取的寄存器。 */
+)
+{
+    uint32_t *delta;
+    unsigned int port, i;
+
+    for (port = 0; port < EC_MAX_PORTS; port++)
+    {
+        delta = counters->delta[port];
+        delta[EC_CRC_RX_ERROR] = data[port * 2];
+        delta[EC_CRC_PHY_ERROR] = data[port * 2 + 1];
+        delta[EC_CRC_FWD_ERROR] = data[0x08 + port];
+        delta[EC_CRC_LOST_LINK] = data[0x10 + port];
+
+        counters->saturated[port] = 0;
+        for (i = 0; i < EC_CRC_PORT_COUNTERS; i++)
+        {
+            counters->total[port][i] += delta[i];
+            if (delta[i] == 0xFF)
+            {
+                counters->saturated[port] |= 1 << i;
+            }
+        }
+    }
+
+    counters->epu_delta = data[0x0C];
+    counters->pdi_delta = data[0x0D];
+    counters->epu_total += counters->epu_delta;
+    counters->pdi_total += counters->pdi_delta;
+
+    counters->valid = 1;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 初始化总线健康监视。
+@param monitor 总线健康监视。
+@param interval_ms 采样间隔（毫秒），0表示停用。
+*/
+void ec_crc_monitor_init(
+    ec_crc_monitor_t *monitor, /**< 总线健康监视。 */
+    unsigned int interval_ms   /**< 采样间隔。 */
+)
+{
+    monitor->jiffies_start = jiffies;
+    monitor->jiffies_last = jiffies;
+    monitor->sweep_interval = 0;
+    monitor->sweeps = 0;
+    ec_crc_monitor_set_interval(monitor, interval_ms);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 设置采样间隔。
+@param monitor 总线健康监视。
+@param interval_ms 采样间隔（毫秒），0表示停用。
+@details 新的间隔立即生效，下一次采样尽快开始。
+*/
+void ec_crc_monitor_set_interval(
+    ec_crc_monitor_t *monitor, /**< 总线健康监视。 */
+    unsigned int interval_ms   /**< 采样间隔。 */
+)
+{
+    monitor->interval_ms = interval_ms;
+    monitor->jiffies_next = jiffies;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 检查是否应该开始下一次采样。
+@param monitor 总线健康监视。
+@return 如果应该开始采样，返回非零值。
+*/
+int ec_crc_monitor_due(
+    const ec_crc_monitor_t *monitor /**< 总线健康监视。 */
+)
+{
+    return monitor->interval_ms &&
+           time_after_eq(jiffies, monitor->jiffies_next);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 记录采样开始。
+@param monitor 总线健康监视。
+*/
+void ec_crc_monitor_start(
+    ec_crc_monitor_t *monitor /**< 总线健康监视。 */
+)
+{
+    monitor->jiffies_start = jiffies;
+    monitor->jiffies_next =
+        jiffies + max(msecs_to_jiffies(monitor->interval_ms), 1UL);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 记录采样结束。
+@param monitor 总线健康监视。
+@details 增量对应两次采样开始之间的时间，用于计算速率。
+*/
+void ec_crc_monitor_done(
+    ec_crc_monitor_t *monitor /**< 总线健康监视。 */
+)
+{
+    monitor->sweep_interval = monitor->jiffies_start - monitor->jiffies_last;
+    monitor->jiffies_last = monitor->jiffies_start;
+    monitor->sweeps++;
+}
+
+/*****************************************************************************/
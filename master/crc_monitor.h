@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   ESC错误计数器的总线健康监视。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_CRC_MONITOR_H__
+#define __EC_CRC_MONITOR_H__
+
+#include <linux/types.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** 每次读取的错误计数器寄存器（0x0300 - 0x0313）的字节数。
+ */
+#define EC_CRC_MONITOR_REG_SIZE 20
+
+/** 每个端口的计数器。
+ */
+typedef enum
+{
+    EC_CRC_RX_ERROR,  /**< 无效帧计数器（0x0300 + 2 * 端口）。 */
+    EC_CRC_PHY_ERROR, /**< RX错误计数器（0x0301 + 2 * 端口）。 */
+    EC_CRC_FWD_ERROR, /**< 转发的RX错误计数器（0x0308 + 端口）。 */
+    EC_CRC_LOST_LINK, /**< 链路丢失计数器（0x0310 + 端口）。 */
+    EC_CRC_PORT_COUNTERS /**< 每个端口的计数器数量。 */
+} ec_crc_counter_t;
+
+/*****************************************************************************/
+
+/** 一个从站的错误计数器。
+ *
+ * ESC的计数器只有8位并且在0xFF饱和。采样用FPRW读取并同时清零计数器，
+ * 因此每次读取的值就是两次采样之间的增量，这里累计这些增量。读取到
+ * 0xFF的计数器在这段时间内饱和了，它的增量只是下限。
+ */
+typedef struct
+{
+    uint32_t total[EC_MAX_PORTS][EC_CRC_PORT_COUNTERS]; /**< 累计值。 */
+    uint32_t delta[EC_MAX_PORTS][EC_CRC_PORT_COUNTERS]; /**< 最近一次增量。 */
+    uint8_t saturated[EC_MAX_PORTS]; /**< 最近一次采样中饱和的计数器（位掩码）。 */
+    uint32_t epu_total;  /**< 累计的处理单元错误（0x030C）。 */
+    uint32_t pdi_total;  /**< 累计的PDI错误（0x030D）。 */
+    uint32_t epu_delta;  /**< 最近一次处理单元错误的增量。 */
+    uint32_t pdi_delta;  /**< 最近一次PDI错误的增量。 */
+    unsigned int valid;  /**< 至少读取过一次。 */
+} ec_crc_counters_t;
+
+/** 主站的总线健康监视。
+ */
+typedef struct
+{
+    unsigned int interval_ms;      /**< 采样间隔（毫秒），0表示停用。 */
+    unsigned long jiffies_next;    /**< 下一次采样的时刻。 */
+    unsigned long jiffies_start;   /**< 当前采样的开始时刻。 */
+    unsigned long jiffies_last;    /**< 上一次采样的开始时刻。 */
+    unsigned long sweep_interval;  /**< 最近两次采样开始的间隔（jiffies）。 */
+    unsigned int sweeps;           /**< 完成的采样次数。 */
+} ec_crc_monitor_t;
+
+/*****************************************************************************/
+
+void ec_crc_counters_init(ec_crc_counters_t *);
+void ec_crc_counters_update(ec_crc_counters_t *, const uint8_t *);
+
+void ec_crc_monitor_init(ec_crc_monitor_t *, unsigned int);
+void ec_crc_monitor_set_interval(ec_crc_monitor_t *, unsigned int);
+int ec_crc_monitor_due(const ec_crc_monitor_t *);
+void ec_crc_monitor_start(ec_crc_monitor_t *);
+void ec_crc_monitor_done(ec_crc_monitor_t *);
+
+/*****************************************************************************/
+
+#endif
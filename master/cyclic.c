@@ -0,0 +1,442 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   主站的周期引擎。
+
+   周期线程用绝对时间的高分辨率定时器睡眠，每个周期依次执行接收、域处理、
+   应用程序回调、域排队、分布式时钟同步和发送。周期超时时跳过已经错过的
+   唤醒时间，保持相位不变。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/kthread.h>
+#include <linux/hrtimer.h>
+#include <linux/sched.h>
+#include <linux/math64.h>
+
+#include "master.h"
+#include "domain.h"
+#include "cyclic.h"
+
+/*****************************************************************************/
+
+/** 1970-01-01和2000-01-01之间的秒数（见EC_TIMEVAL2NANO()）。
+ */
+#define EC_CYCLIC_EPOCH_OFFSET 946684800ULL
+
+/*****************************************************************************/
+
+/**
+@brief 初始化周期引擎。
+@param cyclic 周期引擎。
+*/
+void ec_cyclic_init(
+    ec_cyclic_t *cyclic /**< 周期引擎。 */
+)
+{
+    memset(cyclic, 0, sizeof(*cyclic));
+    init_waitqueue_head(&cyclic->wait);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 计算第一次唤醒的时间。
+@details 有DC参考时间时，唤醒对齐到SYNC0的时间网格
+         dc_ref_time + k * period，再加上相位偏移；否则从现在开始。
+@param master EtherCAT主站。
+@param now 当前的单调时钟时间（纳秒）。
+@return 第一次唤醒的单调时钟时间（纳秒）。
+*/
+static u64 ec_cyclic_first_wakeup(
+    const ec_master_t *master, /**< EtherCAT主站。 */
+    u64 now                    /**< 当前的单调时钟时间。 */
+)
+{
+    const ec_cyclic_t *cyclic = &master->cyclic;
+    u64 start = now + EC_CYCLIC_START_DELAY;
+    u64 grid, diff;
+    u32 remainder;
+
+    if (!master->dc_ref_time)
+    {
+        return start;
+    }
+
+    // 在应用程序时间中计算
+    grid = master->dc_ref_time + (s64)cyclic->config.sync0_offset_ns;
+    diff = start + cyclic->time_offset - grid;
+    if ((s64)diff < 0)
+    {
+        return grid - cyclic->time_offset;
+    }
+
+    remainder = do_div(diff, cyclic->config.period_ns);
+    if (remainder)
+    {
+        start += cyclic->config.period_ns - remainder;
+    }
+    return start;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 执行一个周期。
+@param master EtherCAT主站。
+@param wakeup 本周期计划的唤醒时间（单调时钟，纳秒）。
+*/
+static void ec_cyclic_cycle(
+    ec_master_t *master, /**< EtherCAT主站。 */
+    u64 wakeup           /**< 计划的唤醒时间。 */
+)
+{
+    ec_cyclic_t *cyclic = &master->cyclic;
+    ec_domain_t *domain;
+
+    // EoE等通过ec_master_internal_send_cb()访问总线的上下文也使用io_sem
+    ec_lock_down(&master->io_sem);
+
+    ecrt_master_receive(master);
+    list_for_each_entry(domain, &master->domains, list)
+    {
+        ecrt_domain_process(domain);
+    }
+
+    if (cyclic->config.cb)
+    {
+        cyclic->config.cb(cyclic->config.cb_data);
+    }
+
+    list_for_each_entry(domain, &master->domains, list)
+    {
+        ecrt_domain_queue(domain);
+    }
+
+    if (cyclic->config.dc_sync)
+    {
+        // 使用计划的时间，唤醒延迟不会传给从站时钟
+        ecrt_master_application_time(master, wakeup + cyclic->time_offset);
+        ecrt_master_sync_reference_clock(master);
+        ecrt_master_sync_slave_clocks(master);
+    }
+
+    ecrt_master_send(master);
+
+    ec_lock_up(&master->io_sem);
+
+    WRITE_ONCE(cyclic->cycles, cyclic->cycles + 1);
+    wake_up_interruptible(&cyclic->wait);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 周期线程。
+@param data EtherCAT主站。
+@return 总是返回0。
+*/
+static int ec_cyclic_thread(
+    void *data /**< EtherCAT主站。 */
+)
+{
+    ec_master_t *master = data;
+    ec_cyclic_t *cyclic = &master->cyclic;
+    const u64 period = cyclic->config.period_ns;
+    u64 next, now, end, missed;
+    ktime_t wakeup;
+
+    next = ec_cyclic_first_wakeup(master, ktime_to_ns(ktime_get()));
+
+    EC_MASTER_DBG(master, 1, "周期线程运行中，周期 %llu 纳秒。\n", period);
+
+    while (!kthread_should_stop())
+    {
+        wakeup = ns_to_ktime(next);
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (kthread_should_stop())
+        {
+            __set_current_state(TASK_RUNNING);
+            break;
+        }
+        schedule_hrtimeout_range(&wakeup, 0, HRTIMER_MODE_ABS);
+
+        now = ktime_to_ns(ktime_get());
+        if (now < next)
+        {
+            // 提前唤醒，例如kthread_stop()
+            continue;
+        }
+
+        ec_histogram_add(&master->hist[EC_HIST_CYCLIC_LATENCY],
+                         (u32)min_t(u64, now - next, U32_MAX));
+
+        ec_cyclic_cycle(master, next);
+
+        end = ktime_to_ns(ktime_get());
+        ec_histogram_add(&master->hist[EC_HIST_CYCLIC_EXEC],
+                         (u32)min_t(u64, end - now, U32_MAX));
+
+        next += period;
+        if (unlikely(end >= next))
+        {
+            // 跳过已经错过的唤醒时间，保持相位
+            missed = div64_u64(end - next, period) + 1;
+            cyclic->overruns++;
+            cyclic->missed += missed;
+            next += missed * period;
+        }
+    }
+
+    EC_MASTER_DBG(master, 1, "周期线程退出。\n");
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 启动周期引擎。
+@param master EtherCAT主站。
+@param config 周期引擎的配置。
+@return 成功返回0，否则返回负错误代码。
+*/
+int ecrt_master_cyclic_start(
+    ec_master_t *master,             /**< EtherCAT主站。 */
+    const ec_cyclic_config_t *config /**< 周期引擎的配置。 */
+)
+{
+    ec_cyclic_t *cyclic = &master->cyclic;
+    ec_thread_param_t *param = &master->thread_params[EC_THREAD_CYCLIC];
+    u64 real, mono;
+    int ret;
+
+    if (!master->active)
+    {
+        EC_MASTER_ERR(master, "启动周期引擎之前必须激活主站！\n");
+        return -EPERM;
+    }
+
+    if (cyclic->thread)
+    {
+        return -EBUSY;
+    }
+
+    if (config->period_ns < EC_CYCLIC_MIN_PERIOD ||
+        abs(config->sync0_offset_ns) >= config->period_ns ||
+        config->priority < 1 || config->priority > 99 ||
+        (config->cpu >= 0 &&
+         (config->cpu >= nr_cpu_ids || !cpu_online(config->cpu))))
+    {
+        EC_MASTER_ERR(master, "周期引擎的配置无效。\n");
+        return -EINVAL;
+    }
+
+    cyclic->config = *config;
+    cyclic->cycles = 0;
+    cyclic->overruns = 0;
+    cyclic->missed = 0;
+
+    // 应用程序时间：启动时的实时时钟（2000纪元）加上单调时钟的增量
+    mono = ktime_to_ns(ktime_get());
+    real = ktime_to_ns(ktime_get_real());
+    cyclic->time_offset =
+        (s64)(real - EC_CYCLIC_EPOCH_OFFSET * NSEC_PER_SEC - mono);
+
+    // 线程还没有运行，可以直接清除
+    ec_histogram_clear(&master->hist[EC_HIST_CYCLIC_LATENCY]);
+    ec_histogram_clear(&master->hist_base[EC_HIST_CYCLIC_LATENCY]);
+    ec_histogram_clear(&master->hist[EC_HIST_CYCLIC_EXEC]);
+    ec_histogram_clear(&master->hist_base[EC_HIST_CYCLIC_EXEC]);
+
+    if (config->cpu >= 0)
+    {
+        cpumask_copy(&param->cpus, cpumask_of(config->cpu));
+    }
+    else
+    {
+        cpumask_copy(&param->cpus, cpu_possible_mask);
+    }
+    param->policy = SCHED_FIFO;
+    param->priority = config->priority;
+
+    // 周期线程取代应用程序的实时任务，其他上下文通过io_sem访问总线
+    master->send_cb = ec_master_internal_send_cb;
+    master->receive_cb = ec_master_internal_receive_cb;
+    master->cb_data = master;
+
+    EC_MASTER_INFO(master, "启动周期引擎，周期 %u 纳秒，SYNC0相位 %d 纳秒。\n",
+                   config->period_ns, config->sync0_offset_ns);
+
+    cyclic->thread = kthread_create(ec_cyclic_thread, master,
+                                    "EtherCAT-CYC%u", master->index);
+    if (IS_ERR(cyclic->thread))
+    {
+        ret = (int)PTR_ERR(cyclic->thread);
+        EC_MASTER_ERR(master, "无法启动周期线程（错误代码 %i）！\n", ret);
+        cyclic->thread = NULL;
+        master->send_cb = master->app_send_cb;
+        master->receive_cb = master->app_receive_cb;
+        master->cb_data = master->app_cb_data;
+        return ret;
+    }
+
+    ret = ec_master_thread_apply(cyclic->thread, param);
+    if (ret)
+    {
+        EC_MASTER_WARN(master, "无法设置周期线程的调度参数（错误代码 %i）。\n",
+                       ret);
+    }
+    wake_up_process(cyclic->thread);
+
+#ifdef EC_EOE
+    // 应用程序没有回调函数时，EoE在激活时没有启动
+    if (!master->eoe_thread)
+    {
+        ec_master_eoe_start(master);
+    }
+#endif
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 停止周期引擎。
+@param master EtherCAT主站。
+@return 总是返回0。
+*/
+int ecrt_master_cyclic_stop(
+    ec_master_t *master /**< EtherCAT主站。 */
+)
+{
+    ec_cyclic_t *cyclic = &master->cyclic;
+
+    if (!cyclic->thread)
+    {
+        return 0;
+    }
+
+    kthread_stop(cyclic->thread);
+    cyclic->thread = NULL;
+    wake_up_interruptible(&cyclic->wait);
+
+    EC_MASTER_INFO(master, "周期引擎已停止，%llu 个周期，%llu 次超时。\n",
+                   cyclic->cycles, cyclic->overruns);
+
+#ifdef EC_EOE
+    if (!master->app_send_cb || !master->app_receive_cb)
+    {
+        ec_master_eoe_stop(master);
+    }
+#endif
+
+    master->send_cb = master->app_send_cb;
+    master->receive_cb = master->app_receive_cb;
+    master->cb_data = master->app_cb_data;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 等待周期引擎的下一个周期。
+@param master EtherCAT主站。
+@param cycle 上一次看到的周期数，返回当前的周期数。
+@return 成功返回0，否则返回负错误代码。
+*/
+int ecrt_master_cyclic_wait(
+    ec_master_t *master, /**< EtherCAT主站。 */
+    uint64_t *cycle      /**< 上一次看到的/当前的周期数。 */
+)
+{
+    ec_cyclic_t *cyclic = &master->cyclic;
+    u64 seen = *cycle;
+
+    if (!cyclic->thread)
+    {
+        return -ENXIO;
+    }
+
+    if (wait_event_interruptible(cyclic->wait,
+                                 !READ_ONCE(cyclic->thread) ||
+                                     READ_ONCE(cyclic->cycles) != seen))
+    {
+        return -EINTR;
+    }
+
+    if (!READ_ONCE(cyclic->thread))
+    {
+        return -ENXIO;
+    }
+
+    *cycle = READ_ONCE(cyclic->cycles);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 读取周期引擎的状态。
+@param master EtherCAT主站。
+@param state 用于存储信息的结构体。
+@return 总是返回0。
+*/
+int ecrt_master_cyclic_state(
+    const ec_master_t *master, /**< EtherCAT主站。 */
+    ec_cyclic_state_t *state   /**< 用于存储信息的结构体。 */
+)
+{
+    const ec_cyclic_t *cyclic = &master->cyclic;
+
+    state->running = cyclic->thread != NULL;
+    state->period_ns = cyclic->config.period_ns;
+    state->sync0_offset_ns = cyclic->config.sync0_offset_ns;
+    state->cycles = cyclic->cycles;
+    state->overruns = cyclic->overruns;
+    state->missed = cyclic->missed;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/** \cond */
+
+EXPORT_SYMBOL(ecrt_master_cyclic_start);
+EXPORT_SYMBOL(ecrt_master_cyclic_stop);
+EXPORT_SYMBOL(ecrt_master_cyclic_wait);
+EXPORT_SYMBOL(ecrt_master_cyclic_state);
+
+/** \endcond */
+
+/*****************************************************************************/
@@ -0,0 +1,79 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   主站的周期引擎。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_CYCLIC_H__
+#define __EC_CYCLIC_H__
+
+#include <linux/types.h>
+#include <linux/wait.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** 最短的周期（纳秒）。
+ */
+#define EC_CYCLIC_MIN_PERIOD 50000
+
+/** 第一次唤醒距离启动的最短时间（纳秒），给线程启动留出余量。
+ */
+#define EC_CYCLIC_START_DELAY 1000000
+
+/*****************************************************************************/
+
+/** 主站的周期引擎。
+ *
+ * 周期线程是这时唯一调用ecrt_master_send()/ecrt_master_receive()的实时
+ * 上下文，所以统计和直方图的单写入者假设仍然成立。
+ */
+typedef struct
+{
+    struct task_struct *thread; /**< 周期线程，NULL表示没有运行。 */
+    ec_cyclic_config_t config;  /**< 应用程序的配置。 */
+    s64 time_offset;            /**< 应用程序时间减去单调时钟时间（纳秒）。 */
+    u64 cycles;                 /**< 执行的周期数。 */
+    u64 overruns;               /**< 没有在下一次唤醒之前结束的周期数。 */
+    u64 missed;                 /**< 因此跳过的周期数。 */
+    wait_queue_head_t wait;     /**< 等待下一个周期的进程。 */
+} ec_cyclic_t;
+
+/*****************************************************************************/
+
+void ec_cyclic_init(ec_cyclic_t *);
+
+/*****************************************************************************/
+
+#endif
@@ -112,6 +112,12 @@ void ec_datagram_init(ec_datagram_t *datagram /**< EtherCAT数据报文。 */)
     datagram->cycles_received = 0;
 #endif
     datagram->jiffies_received = 0;
+    datagram->frame_size = 0;
+    datagram->tx_slot = 0;
+    datagram->hw_ns_sent = 0;
+    datagram->hw_ns_received = 0;
+    datagram->sched_class = EC_SCHED_CYCLIC;
+    datagram->tx_data = NULL;
     datagram->skip_count = 0;
     datagram->stats_output_jiffies = 0;
     memset(datagram->name, 0x00, EC_DATAGRAM_NAME_SIZE);
@@ -105,6 +105,12 @@ typedef struct
     cycles_t cycles_received; /**< 数据报接收时间 */
 #endif
     unsigned long jiffies_received;     /**< 数据报接收的jiffies时间 */
+    uint16_t frame_size;                /**< 发送数据报的帧在线路上的长度 */
+    uint8_t tx_slot;                    /**< 发送数据报的帧所用的发送缓冲区 */
+    u64 hw_ns_sent;                     /**< 网卡的发送时间戳（纳秒），0表示没有 */
+    u64 hw_ns_received;                 /**< 网卡的接收时间戳（纳秒），0表示没有 */
+    uint8_t sched_class;                /**< 调度类别（ec_sched_class_t） */
+    const uint8_t *tx_data;             /**< 发送的数据，NULL表示\a data */
     unsigned int skip_count;            /**< 尚未接收时的重新排队次数 */
     unsigned long stats_output_jiffies; /**< 上次统计输出时间 */
     char name[EC_DATAGRAM_NAME_SIZE];   /**< 数据报描述 */
@@ -155,6 +155,17 @@ int ec_datagram_pair_init(
         ec_datagram_zero(&pair->datagrams[dev_idx]);
     }
 
+    if (domain->master->redundancy_fast)
+    {
+        /* 备份帧直接从主数据报的内存构建，ecrt_domain_queue()不再复制 */
+        for (dev_idx = EC_DEVICE_BACKUP;
+             dev_idx < ec_master_num_devices(domain->master); dev_idx++)
+        {
+            pair->datagrams[dev_idx].tx_data =
+                pair->datagrams[EC_DEVICE_MAIN].data;
+        }
+    }
+
     return 0;
 
 out_datagrams:
@@ -39,6 +39,7 @@
 #include <linux/if_ether.h>
 #include <linux/netdevice.h>
 #include <linux/jiffies.h>
+#include <linux/ktime.h>
 
 #include "device.h"
 #include "master.h"
@@ -93,6 +94,12 @@ int ec_device_init(
         device->tx_skb[i] = NULL;
     }
     device->tx_ring_index = 0;
+    device->hw_timestamps = hw_timestamps;
+    device->hw_rx_ns = 0;
+    for (i = 0; i < EC_TX_RING_SIZE; i++)
+    {
+        device->hw_tx_ns[i] = 0;
+    }
 #ifdef EC_HAVE_CYCLES
     device->cycles_poll = 0;
 #endif
@@ -154,6 +161,12 @@ int ec_device_init(
         eth = (struct ethhdr *)skb_push(device->tx_skb[i], ETH_HLEN);
         eth->h_proto = htons(0x88A4);
         memset(eth->h_dest, 0xFF, ETH_ALEN);
+
+        if (device->hw_timestamps)
+        {
+            // 支持的驱动通过ecdev_set_tx_timestamp()报告发送时间
+            skb_shinfo(device->tx_skb[i])->tx_flags |= SKBTX_HW_TSTAMP;
+        }
     }
 
     return 0;
@@ -359,52 +372,37 @@ int ec_device_close(
 /*****************************************************************************/
 
 /**
- * @brief 记录一个数据包到主站的pcap缓冲区（如果有空间）。
+ * @brief 记录一个数据包到主站的pcap捕获环。
  *
  * @param device EtherCAT设备
+ * @param tx 非零表示发送的数据包
  * @param data 数据包的数据
  * @param size 数据包的大小
- * 
- * @details 检查是否有足够的空间将数据帧复制到pcap内存中，并记录到pcap缓冲区中。
+ *
+ * @details 捕获环写满后覆盖最早的记录，见ec_pcap_ring_record()。
  */
 static void pcap_record(
     ec_device_t *device, /**< EtherCAT设备 */
+    int tx,              /**< 发送的数据包 */
     const void *data,    /**< 数据包数据 */
     size_t size          /**< 数据包大小 */
 )
 {
-    // 检查是否有足够的空间将帧复制到pcap内存中
-    if (unlikely(device->master->pcap_data))
-    {
-        // 获取当前数据指针
-        void *curr_data = device->master->pcap_curr_data;
-        long available = pcap_size - (curr_data - device->master->pcap_data);
-        long reqd = size + sizeof(pcaprec_hdr_t);
-        if (unlikely(reqd <= available))
-        {
-            pcaprec_hdr_t *pcaphdr;
-            struct timeval t;
+    ec_master_t *master = device->master;
+    u64 timestamp;
 
-            // 更新当前数据指针
-            device->master->pcap_curr_data = curr_data + reqd;
+    if (likely(!master->pcap.mem))
+    {
+        return;
+    }
 
-            // 填写pcap帧头信息
-            pcaphdr = curr_data;
 #ifdef EC_RTDM
-            jiffies_to_timeval(device->jiffies_poll, &t);
+    timestamp = (u64) jiffies_to_msecs(device->jiffies_poll) * NSEC_PER_MSEC;
 #else
-            t = device->timeval_poll;
+    timestamp = ktime_to_ns(ktime_get_real());
 #endif
-            pcaphdr->ts_sec = t.tv_sec;
-            pcaphdr->ts_usec = t.tv_usec;
-            pcaphdr->incl_len = size;
-            pcaphdr->orig_len = size;
-            curr_data += sizeof(pcaprec_hdr_t);
-
-            // 复制数据帧
-            memcpy(curr_data, data, size);
-        }
-    }
+    ec_pcap_ring_record(&master->pcap, device - master->devices, tx,
+                        timestamp, data, size);
 }
 
 /*****************************************************************************/
@@ -426,6 +424,7 @@ uint8_t *ec_device_tx_data(
     /* 循环遍历套接字缓冲区，以防止多个帧在发送过程中发生竞争条件 */
     device->tx_ring_index++;
     device->tx_ring_index %= EC_TX_RING_SIZE;
+    device->hw_tx_ns[device->tx_ring_index] = 0;
     return device->tx_skb[device->tx_ring_index]->data + ETH_HLEN;
 }
 
@@ -474,7 +473,7 @@ void ec_device_send(
         device->master->device_stats.tx_count++;
         device->tx_bytes += ETH_HLEN + size;
         device->master->device_stats.tx_bytes += ETH_HLEN + size;
-        pcap_record(device, skb->data, ETH_HLEN + size);
+        pcap_record(device, 1, skb->data, ETH_HLEN + size);
 #ifdef EC_DEBUG_IF
         ec_debug_send(&device->dbg, skb->data, ETH_HLEN + size);
 #endif
@@ -514,6 +513,7 @@ void ec_device_clear_stats(
     device->rx_bytes = 0;
     device->last_rx_bytes = 0;
     device->tx_errors = 0;
+    ec_rtt_init(&device->rtt);
 
     for (i = 0; i < EC_RATE_COUNT; i++)
     {
@@ -658,9 +658,6 @@ void ec_device_poll(
     device->jiffies_poll = jiffies;
 #ifdef EC_DEBUG_RING
     do_gettimeofday(&device->timeval_poll);
-#elif !defined(EC_RTDM)
-    if (pcap_size)
-        do_gettimeofday(&device->timeval_poll);
 #endif
     device->poll(device->dev);
 }
@@ -894,7 +891,7 @@ void ecdev_receive(
         ec_print_data(data, size);
     }
 
-    pcap_record(device, data, size);
+    pcap_record(device, 0, data, size);
 #ifdef EC_DEBUG_IF
     ec_debug_send(&device->dbg, data, size);
 #endif
@@ -903,6 +900,76 @@ void ecdev_receive(
 #endif
 
     ec_master_receive_datagrams(device->master, device, ec_data, ec_size);
+    device->hw_rx_ns = 0;
+}
+
+/*****************************************************************************/
+
+/** 设置下一个接收的帧的硬件时间戳。
+ *
+ * 支持硬件时间戳的驱动在调用ecdev_receive()之前调用此函数。时间戳只对
+ * 紧接着的一帧有效。
+ *
+ * \ingroup DeviceInterface
+ *
+ * @param device EtherCAT设备
+ * @param hwtstamp 网卡时钟的接收时间
+ */
+void ecdev_set_rx_timestamp(
+    ec_device_t *device, /**< EtherCAT设备 */
+    ktime_t hwtstamp     /**< 网卡时钟的接收时间 */
+)
+{
+    device->hw_rx_ns = ktime_to_ns(hwtstamp);
+}
+
+/*****************************************************************************/
+
+/** 报告一个已发送帧的硬件时间戳。
+ *
+ * 支持硬件时间戳的驱动在发送时间可用后（最迟在下一次轮询中接收这一帧
+ * 之前）调用此函数。
+ *
+ * \ingroup DeviceInterface
+ *
+ * @param device EtherCAT设备
+ * @param skb 发送的套接字缓冲区
+ * @param hwtstamp 网卡时钟的发送时间
+ */
+void ecdev_set_tx_timestamp(
+    ec_device_t *device,       /**< EtherCAT设备 */
+    const struct sk_buff *skb, /**< 发送的套接字缓冲区 */
+    ktime_t hwtstamp           /**< 网卡时钟的发送时间 */
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_TX_RING_SIZE; i++)
+    {
+        if (device->tx_skb[i] == skb)
+        {
+            device->hw_tx_ns[i] = ktime_to_ns(hwtstamp);
+            return;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/** 查询主站是否需要硬件时间戳。
+ *
+ * 驱动可以据此在网卡中启用时间戳。
+ *
+ * \ingroup DeviceInterface
+ *
+ * @param device EtherCAT设备
+ * @return 非零值，如果需要硬件时间戳。
+ */
+uint8_t ecdev_get_timestamping(
+    const ec_device_t *device /**< EtherCAT设备 */
+)
+{
+    return device->hw_timestamps;
 }
 
 /*****************************************************************************/
@@ -936,6 +1003,9 @@ void ecdev_set_link(
         EC_MASTER_INFO(device->master,
                        "%s 的链路状态已更改为 %s。\n",
                        device->dev->name, (state ? "UP" : "DOWN"));
+        ec_event_ring_post(&device->master->events, EC_EVENT_LINK, 1,
+                           device - device->master->devices, state,
+                           NULL, 0);
     }
 }
 
@@ -975,6 +1045,9 @@ EXPORT_SYMBOL(ecdev_close);
 EXPORT_SYMBOL(ecdev_receive);
 EXPORT_SYMBOL(ecdev_get_link);
 EXPORT_SYMBOL(ecdev_set_link);
+EXPORT_SYMBOL(ecdev_set_rx_timestamp);
+EXPORT_SYMBOL(ecdev_set_tx_timestamp);
+EXPORT_SYMBOL(ecdev_get_timestamping);
 
 /** \endcond */
 
@@ -42,6 +42,7 @@
 
 #include "../devices/ecdev.h"
 #include "globals.h"
+#include "rtt.h"
 
 
 /**
@@ -101,10 +102,14 @@ struct ec_device
 #ifdef EC_HAVE_CYCLES
     cycles_t cycles_poll; /**< 上次轮询的周期数 */
 #endif
-#if defined(EC_DEBUG_RING) || !defined(EC_RTDM)
+#ifdef EC_DEBUG_RING
     struct timeval timeval_poll;
 #endif
     unsigned long jiffies_poll; /**< 上次轮询的 jiffies */
+    ec_rtt_t rtt;               /**< 在该设备上发送的帧的往返时间估计 */
+    uint8_t hw_timestamps;      /**< 向驱动请求硬件时间戳 */
+    u64 hw_rx_ns;               /**< 驱动为正在接收的帧设置的硬件时间戳，0表示没有 */
+    u64 hw_tx_ns[EC_TX_RING_SIZE]; /**< 各发送缓冲区最近一帧的硬件时间戳，0表示没有 */
 
     // 帧统计
     u64 tx_count;                      /**< 发送的帧数 */
@@ -0,0 +1,510 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   按从站类型共享的对象字典缓存。
+*/
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+#include "slave.h"
+#include "sdo.h"
+#include "ioctl.h"
+#include "dict_cache.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化字典缓存。
+ * @param cache 字典缓存。
+ */
+void ec_dict_cache_init(
+    ec_dict_cache_t *cache /**< 字典缓存。 */
+)
+{
+    INIT_LIST_HEAD(&cache->entries);
+    cache->count = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 清除字典缓存中的所有条目。
+ * @param cache 字典缓存。
+ */
+void ec_dict_cache_clear(
+    ec_dict_cache_t *cache /**< 字典缓存。 */
+)
+{
+    ec_dict_cache_entry_t *entry, *next;
+
+    list_for_each_entry_safe(entry, next, &cache->entries, list)
+    {
+        list_del(&entry->list);
+        vfree(entry->data);
+        kfree(entry);
+    }
+
+    cache->count = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 复制一个以零结尾的字符串。
+ * @param source 源，最长EC_IOCTL_STRING_SIZE字节。
+ * @return 新分配的字符串，空字符串或内存不足时返回NULL。
+ */
+static char *ec_dict_strdup(
+    const int8_t *source /**< 源字符串。 */
+)
+{
+    size_t len = strnlen((const char *)source, EC_IOCTL_STRING_SIZE - 1);
+    char *str;
+
+    if (!len || !(str = kmalloc(len + 1, GFP_KERNEL)))
+    {
+        return NULL;
+    }
+
+    memcpy(str, source, len);
+    str[len] = 0;
+    return str;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 复制字符串到定长字段。
+ * @param target 目标，EC_IOCTL_STRING_SIZE字节。
+ * @param source 源，可以为NULL。
+ */
+static void ec_dict_strcpy(
+    int8_t *target,    /**< 目标。 */
+    const char *source /**< 源。 */
+)
+{
+    if (source)
+    {
+        strncpy((char *)target, source, EC_IOCTL_STRING_SIZE);
+        target[EC_IOCTL_STRING_SIZE - 1] = 0;
+    }
+    else
+    {
+        target[0] = 0;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 把从站的对象字典打包。
+ * @param slave EtherCAT从站。
+ * @param buf 目标缓冲区，为NULL时只计算大小。
+ * @param sdo_count 输出SDO数量，可以为NULL。
+ * @param entry_count 输出条目数量，可以为NULL。
+ * @return 打包后的大小。
+ */
+size_t ec_dict_pack(
+    const ec_slave_t *slave,   /**< EtherCAT从站。 */
+    uint8_t *buf,              /**< 目标缓冲区。 */
+    unsigned int *sdo_count,   /**< SDO数量。 */
+    unsigned int *entry_count  /**< 条目数量。 */
+)
+{
+    const ec_sdo_t *sdo;
+    const ec_sdo_entry_t *entry;
+    ec_ioctl_sdo_export_sdo_t *sdo_rec;
+    ec_ioctl_sdo_export_entry_t *entry_rec;
+    unsigned int sdos = 0, entries = 0, i;
+    size_t size = 0;
+
+    list_for_each_entry(sdo, &slave->sdo_dictionary, list)
+    {
+        sdo_rec = buf ? (ec_ioctl_sdo_export_sdo_t *)(buf + size) : NULL;
+        size += sizeof(*sdo_rec);
+        sdos++;
+
+        if (sdo_rec)
+        {
+            memset(sdo_rec, 0, sizeof(*sdo_rec));
+            sdo_rec->sdo_index = sdo->index;
+            sdo_rec->object_code = sdo->object_code;
+            sdo_rec->max_subindex = sdo->max_subindex;
+            ec_dict_strcpy(sdo_rec->name, sdo->name);
+        }
+
+        list_for_each_entry(entry, &sdo->entries, list)
+        {
+            entry_rec = buf ?
+                (ec_ioctl_sdo_export_entry_t *)(buf + size) : NULL;
+            size += sizeof(*entry_rec);
+            entries++;
+
+            if (!entry_rec)
+            {
+                continue;
+            }
+
+            sdo_rec->entry_count++;
+            memset(entry_rec, 0, sizeof(*entry_rec));
+            entry_rec->subindex = entry->subindex;
+            for (i = 0; i < EC_SDO_ENTRY_ACCESS_COUNT; i++)
+            {
+                entry_rec->read_access[i] = entry->read_access[i];
+                entry_rec->write_access[i] = entry->write_access[i];
+            }
+            entry_rec->data_type = entry->data_type;
+            entry_rec->bit_length = entry->bit_length;
+            ec_dict_strcpy(entry_rec->description, entry->description);
+        }
+    }
+
+    if (sdo_count)
+    {
+        *sdo_count = sdos;
+    }
+    if (entry_count)
+    {
+        *entry_count = entries;
+    }
+
+    return size;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 检查打包的字典是否完整。
+ * @param data 打包的字典。
+ * @param size 大小。
+ * @param sdo_count 输出SDO数量，可以为NULL。
+ * @return 格式正确返回0，否则返回-EINVAL。
+ */
+int ec_dict_validate(
+    const uint8_t *data,    /**< 打包的字典。 */
+    size_t size,            /**< 大小。 */
+    unsigned int *sdo_count /**< SDO数量。 */
+)
+{
+    const ec_ioctl_sdo_export_sdo_t *sdo_rec;
+    size_t pos = 0;
+    unsigned int sdos = 0;
+
+    while (pos < size)
+    {
+        if (size - pos < sizeof(*sdo_rec))
+        {
+            return -EINVAL;
+        }
+
+        sdo_rec = (const ec_ioctl_sdo_export_sdo_t *)(data + pos);
+        pos += sizeof(*sdo_rec);
+
+        if ((size - pos) / sizeof(ec_ioctl_sdo_export_entry_t) <
+            sdo_rec->entry_count)
+        {
+            return -EINVAL;
+        }
+
+        pos += sdo_rec->entry_count * sizeof(ec_ioctl_sdo_export_entry_t);
+        sdos++;
+    }
+
+    if (sdo_count)
+    {
+        *sdo_count = sdos;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 查找缓存条目。
+ * @return 条目，不存在时返回NULL。
+ */
+static ec_dict_cache_entry_t *ec_dict_cache_find(
+    const ec_dict_cache_t *cache, /**< 字典缓存。 */
+    uint32_t vendor_id,           /**< 厂商ID。 */
+    uint32_t product_code,        /**< 产品代码。 */
+    uint32_t revision_number      /**< 修订号。 */
+)
+{
+    ec_dict_cache_entry_t *entry;
+
+    list_for_each_entry(entry, &cache->entries, list)
+    {
+        if (entry->vendor_id == vendor_id &&
+            entry->product_code == product_code &&
+            entry->revision_number == revision_number)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 向缓存中添加一个打包的字典。
+ * @param cache 字典缓存。
+ * @param vendor_id 厂商ID。
+ * @param product_code 产品代码。
+ * @param revision_number 修订号。
+ * @param data vmalloc()分配的打包字典，成功时由缓存接管。
+ * @param size 大小。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 已存在的同类型条目会被替换。
+ */
+int ec_dict_cache_add(
+    ec_dict_cache_t *cache,   /**< 字典缓存。 */
+    uint32_t vendor_id,       /**< 厂商ID。 */
+    uint32_t product_code,    /**< 产品代码。 */
+    uint32_t revision_number, /**< 修订号。 */
+    uint8_t *data,            /**< 打包的字典。 */
+    size_t size               /**< 大小。 */
+)
+{
+    ec_dict_cache_entry_t *entry;
+    unsigned int sdo_count;
+    int ret;
+
+    ret = ec_dict_validate(data, size, &sdo_count);
+    if (ret)
+    {
+        return ret;
+    }
+
+    entry = ec_dict_cache_find(cache, vendor_id, product_code,
+                               revision_number);
+    if (entry)
+    {
+        vfree(entry->data);
+    }
+    else
+    {
+        if (!(entry = kmalloc(sizeof(*entry), GFP_KERNEL)))
+        {
+            return -ENOMEM;
+        }
+
+        entry->vendor_id = vendor_id;
+        entry->product_code = product_code;
+        entry->revision_number = revision_number;
+        list_add_tail(&entry->list, &cache->entries);
+        cache->count++;
+    }
+
+    entry->data = data;
+    entry->size = size;
+    entry->sdo_count = sdo_count;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 按位置获取缓存条目。
+ * @param cache 字典缓存。
+ * @param pos 位置。
+ * @return 条目，不存在时返回NULL。
+ */
+const ec_dict_cache_entry_t *ec_dict_cache_get(
+    const ec_dict_cache_t *cache, /**< 字典缓存。 */
+    unsigned int pos              /**< 位置。 */
+)
+{
+    const ec_dict_cache_entry_t *entry;
+
+    list_for_each_entry(entry, &cache->entries, list)
+    {
+        if (pos--)
+            continue;
+        return entry;
+    }
+
+    return NULL;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 把刚上传的字典存入缓存。
+ * @param cache 字典缓存。
+ * @param slave 已完成字典上传的从站。
+ * @details 已有同类型条目或字典为空时不做任何事。
+ */
+void ec_dict_cache_store(
+    ec_dict_cache_t *cache, /**< 字典缓存。 */
+    const ec_slave_t *slave /**< EtherCAT从站。 */
+)
+{
+    const ec_sii_t *sii;
+    uint8_t *data;
+    size_t size;
+
+    if (!slave->sii_image || list_empty(&slave->sdo_dictionary))
+    {
+        return;
+    }
+
+    sii = &slave->sii_image->sii;
+    if (ec_dict_cache_find(cache, sii->vendor_id, sii->product_code,
+                           sii->revision_number))
+    {
+        return;
+    }
+
+    size = ec_dict_pack(slave, NULL, NULL, NULL);
+    if (!(data = vmalloc(size)))
+    {
+        EC_SLAVE_WARN(slave, "无法为字典缓存分配%zu字节。\n", size);
+        return;
+    }
+
+    ec_dict_pack(slave, data, NULL, NULL);
+
+    if (ec_dict_cache_add(cache, sii->vendor_id, sii->product_code,
+                          sii->revision_number, data, size))
+    {
+        vfree(data);
+        return;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "字典已缓存（0x%08X/0x%08X/0x%08X）。\n",
+                 sii->vendor_id, sii->product_code, sii->revision_number);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 从缓存建立从站的对象字典。
+ * @param cache 字典缓存。
+ * @param slave 字典为空的从站。
+ * @return 成功返回0，没有匹配条目时返回-ENOENT，否则返回负错误代码。
+ * @details 失败时从站的字典保持为空。
+ */
+int ec_dict_cache_apply(
+    const ec_dict_cache_t *cache, /**< 字典缓存。 */
+    ec_slave_t *slave             /**< EtherCAT从站。 */
+)
+{
+    const ec_dict_cache_entry_t *cached;
+    const ec_ioctl_sdo_export_sdo_t *sdo_rec;
+    const ec_ioctl_sdo_export_entry_t *entry_rec;
+    const ec_sii_t *sii;
+    ec_sdo_t *sdo, *next;
+    ec_sdo_entry_t *entry;
+    size_t pos = 0;
+    unsigned int i, j;
+
+    if (!slave->sii_image || !list_empty(&slave->sdo_dictionary))
+    {
+        return -ENOENT;
+    }
+
+    sii = &slave->sii_image->sii;
+    cached = ec_dict_cache_find(cache, sii->vendor_id, sii->product_code,
+                                sii->revision_number);
+    if (!cached)
+    {
+        return -ENOENT;
+    }
+
+    while (pos < cached->size)
+    {
+        sdo_rec = (const ec_ioctl_sdo_export_sdo_t *)(cached->data + pos);
+        pos += sizeof(*sdo_rec);
+
+        if (!(sdo = kmalloc(sizeof(ec_sdo_t), GFP_KERNEL)))
+        {
+            goto out_nomem;
+        }
+
+        ec_sdo_init(sdo, slave, sdo_rec->sdo_index);
+        sdo->object_code = sdo_rec->object_code;
+        sdo->max_subindex = sdo_rec->max_subindex;
+        sdo->name = ec_dict_strdup(sdo_rec->name);
+
+        if (ec_slave_add_sdo(slave, sdo))
+        {
+            ec_sdo_clear(sdo);
+            kfree(sdo);
+            goto out_nomem;
+        }
+
+        for (i = 0; i < sdo_rec->entry_count; i++)
+        {
+            entry_rec =
+                (const ec_ioctl_sdo_export_entry_t *)(cached->data + pos);
+            pos += sizeof(*entry_rec);
+
+            if (!(entry = kmalloc(sizeof(ec_sdo_entry_t), GFP_KERNEL)))
+            {
+                goto out_nomem;
+            }
+
+            ec_sdo_entry_init(entry, sdo, entry_rec->subindex);
+            for (j = 0; j < EC_SDO_ENTRY_ACCESS_COUNT; j++)
+            {
+                entry->read_access[j] = entry_rec->read_access[j];
+                entry->write_access[j] = entry_rec->write_access[j];
+            }
+            entry->data_type = entry_rec->data_type;
+            entry->bit_length = entry_rec->bit_length;
+            entry->description = ec_dict_strdup(entry_rec->description);
+            list_add_tail(&entry->list, &sdo->entries);
+        }
+    }
+
+    EC_SLAVE_DBG(slave, 1, "从缓存获取%u个SDO。\n", cached->sdo_count);
+    return 0;
+
+out_nomem:
+    EC_SLAVE_ERR(slave, "从缓存建立字典时内存不足！\n");
+    ec_ptr_table_clear(&slave->sdo_table);
+    list_for_each_entry_safe(sdo, next, &slave->sdo_dictionary, list)
+    {
+        list_del(&sdo->list);
+        ec_sdo_clear(sdo);
+        kfree(sdo);
+    }
+    return -ENOMEM;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   按从站类型共享的对象字典缓存。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_DICT_CACHE_H__
+#define __EC_DICT_CACHE_H__
+
+#include <linux/list.h>
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** 缓存的对象字典。
+ *
+ * 字典以EC_IOCTL_SLAVE_SDO_DICT_EXPORT的打包格式保存（一个
+ * ec_ioctl_sdo_export_sdo_t记录后紧跟其条目记录），插入后不再修改。
+ */
+typedef struct
+{
+    struct list_head list;    /**< 链表项。 */
+    uint32_t vendor_id;       /**< 厂商ID。 */
+    uint32_t product_code;    /**< 产品代码。 */
+    uint32_t revision_number; /**< 修订号。 */
+    uint8_t *data;            /**< 打包的字典。 */
+    size_t size;              /**< \a data 的大小。 */
+    unsigned int sdo_count;   /**< SDO数量。 */
+} ec_dict_cache_entry_t;
+
+/** 对象字典缓存。
+ *
+ * 同一厂商ID、产品代码和修订号的从站共享一份字典：第一个从站通过
+ * SDO信息服务上传后存入缓存，其余从站直接从缓存建立字典，不再进行
+ * 邮箱交换。缓存由master_sem保护。
+ */
+typedef struct
+{
+    struct list_head entries; /**< 缓存条目。 */
+    unsigned int count;       /**< 条目数量。 */
+} ec_dict_cache_t;
+
+/*****************************************************************************/
+
+void ec_dict_cache_init(ec_dict_cache_t *);
+void ec_dict_cache_clear(ec_dict_cache_t *);
+
+size_t ec_dict_pack(const ec_slave_t *, uint8_t *, unsigned int *,
+                    unsigned int *);
+int ec_dict_validate(const uint8_t *, size_t, unsigned int *);
+
+int ec_dict_cache_add(ec_dict_cache_t *, uint32_t, uint32_t, uint32_t,
+                      uint8_t *, size_t);
+const ec_dict_cache_entry_t *ec_dict_cache_get(const ec_dict_cache_t *,
+                                               unsigned int);
+void ec_dict_cache_store(ec_dict_cache_t *, const ec_slave_t *);
+int ec_dict_cache_apply(const ec_dict_cache_t *, ec_slave_t *);
+
+/*****************************************************************************/
+
+#endif
@@ -95,6 +95,7 @@ void ec_domain_init(
     /* Used by ec_domain_add_fmmu_config */
     memset(domain->offset_used, 0, sizeof(domain->offset_used));
     domain->sc_in_work = 0;
+    domain->scope = NULL;
 }
 
 /*****************************************************************************/
@@ -109,6 +110,12 @@ void ec_domain_clear(ec_domain_t *domain /**< EtherCAT域 */)
 {
     ec_datagram_pair_t *datagram_pair, *next_pair;
 
+    // 记录器引用了域的过程数据
+    if (domain->scope)
+    {
+        ec_scope_disable(domain->scope);
+    }
+
     // 遍历链表，释放并清除数据报对
     list_for_each_entry_safe(datagram_pair, next_pair,
                              &domain->datagram_pairs, list)
@@ -695,9 +702,8 @@ void ecrt_domain_process(ec_domain_t *domain)
     unsigned int redundancy;
 #endif
     unsigned int dev_idx;
-#ifdef EC_RT_SYSLOG
     unsigned int wc_change;
-#endif
+    u8 wc_expected[2];
 
 #if DEBUG_REDUNDANCY
     EC_MASTER_DBG(domain->master, 1, "域 %u 处理\n", domain->index);
@@ -769,7 +775,8 @@ void ecrt_domain_process(ec_domain_t *domain)
                     EC_MASTER_DBG(domain->master, 1, "主链路数据变化\n");
 #endif
                 }
-                else if (data_changed(pair->send_buffer, backup_datagram,
+                else if (backup_datagram->state == EC_DATAGRAM_RECEIVED &&
+                         data_changed(pair->send_buffer, backup_datagram,
                                       datagram_offset, fmmu->data_size))
                 {
                     /* 备用链路数据变化：复制到主内存 */
@@ -829,38 +836,48 @@ void ecrt_domain_process(ec_domain_t *domain)
         }
 #endif
         domain->redundancy_active = redundancy;
+        ec_event_ring_post(&domain->master->events, EC_EVENT_REDUNDANCY, 1,
+                           domain->index, redundancy, NULL, 0);
     }
 #else
     domain->redundancy_active = 0;
 #endif
 
-#ifdef EC_RT_SYSLOG
     wc_change = 0;
-#endif
     wc_total = 0;
     for (dev_idx = EC_DEVICE_MAIN;
          dev_idx < ec_master_num_devices(domain->master); dev_idx++)
     {
         if (wc_sum[dev_idx] != domain->working_counter[dev_idx])
         {
-#ifdef EC_RT_SYSLOG
             wc_change = 1;
-#endif
             domain->working_counter[dev_idx] = wc_sum[dev_idx];
         }
         wc_total += wc_sum[dev_idx];
     }
 
-#ifdef EC_RT_SYSLOG
+    // 过程数据记录器
+    if (unlikely(domain->scope))
+    {
+        ec_scope_sample(domain->scope);
+    }
+
     if (wc_change)
     {
         domain->working_counter_changes++;
     }
 
+    // 工作计数器变化每秒最多报告一次
     if (domain->working_counter_changes &&
         jiffies - domain->notify_jiffies > HZ)
     {
         domain->notify_jiffies = jiffies;
+        EC_WRITE_U16(wc_expected, domain->expected_working_counter);
+        ec_event_ring_post(&domain->master->events, EC_EVENT_WKC,
+                           min(domain->working_counter_changes, 0xffffU),
+                           domain->index, wc_total,
+                           wc_expected, sizeof(wc_expected));
+#ifdef EC_RT_SYSLOG
         if (domain->working_counter_changes == 1)
         {
             EC_MASTER_INFO(domain->master, "域 %u：工作计数器"
@@ -894,10 +911,10 @@ void ecrt_domain_process(ec_domain_t *domain)
         }
 #endif
         printk(KERN_CONT ".\n");
+#endif
 
         domain->working_counter_changes = 0;
     }
-#endif
 }
 
 
@@ -926,13 +943,16 @@ void ecrt_domain_queue(ec_domain_t *domain)
         ec_master_queue_datagram(domain->master,
                                  &datagram_pair->datagrams[EC_DEVICE_MAIN]);
 
-        /* 将主数据复制到备份数据报 */
+        /* 将主数据复制到备份数据报，除非备份数据报直接发送主数据 */
         for (dev_idx = EC_DEVICE_BACKUP;
              dev_idx < ec_master_num_devices(domain->master); dev_idx++)
         {
-            memcpy(datagram_pair->datagrams[dev_idx].data,
-                   datagram_pair->datagrams[EC_DEVICE_MAIN].data,
-                   datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+            if (!datagram_pair->datagrams[dev_idx].tx_data)
+            {
+                memcpy(datagram_pair->datagrams[dev_idx].data,
+                       datagram_pair->datagrams[EC_DEVICE_MAIN].data,
+                       datagram_pair->datagrams[EC_DEVICE_MAIN].data_size);
+            }
             ec_master_queue_datagram(domain->master,
                                      &datagram_pair->datagrams[dev_idx]);
         }
@@ -43,6 +43,7 @@
 #include "datagram.h"
 #include "master.h"
 #include "fmmu_config.h"
+#include "scope.h"
 
 /*****************************************************************************/
 
@@ -71,6 +72,8 @@ struct ec_domain
                                                      （按方向划分的 PDO）。 */
     const ec_slave_config_t *sc_in_work;          /**< 正在该域中被激活注册的 slave_config
                                                      （即 ecrt_slave_config_reg_pdo_entry()）。 */
+    ec_scope_t *scope;                            /**< 以该域为采样域的过程数据
+                                                     记录器，未启用时为NULL。 */
 };
 
 
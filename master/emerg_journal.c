@@ -0,0 +1,279 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   CoE紧急消息日志。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/ktime.h>
+
+#include "emerg_journal.h"
+
+/*****************************************************************************/
+
+/** 读取由生产者并发更新的序号，防止编译器缓存该值。
+ */
+static inline u32 ec_emerg_journal_load(const u32 *seq)
+{
+    return *(const volatile u32 *) seq;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化日志。
+ * @param journal 日志。
+ * @param size 请求的记录数。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 记录数向下取整为2的幂，并限制在EC_EMERG_JOURNAL_MIN_SIZE和
+ * EC_EMERG_JOURNAL_MAX_SIZE之间。头部占用一整页，使记录页对齐。每条记录
+ * 的序号初始化为比它第一次使用时的序号小一轮，读取端因此不会把未写入的
+ * 记录当作有效记录。
+ */
+int ec_emerg_journal_init(
+    ec_emerg_journal_t *journal, /**< 日志 */
+    size_t size                  /**< 记录数 */
+)
+{
+    ec_emerg_journal_header_t *header;
+    unsigned int i;
+
+    memset(journal, 0, sizeof(*journal));
+
+    size = clamp_t(size_t, size, EC_EMERG_JOURNAL_MIN_SIZE,
+                   EC_EMERG_JOURNAL_MAX_SIZE);
+    size = rounddown_pow_of_two(size);
+
+    journal->mem_size = PAGE_SIZE + size * sizeof(ec_emergency_t);
+    journal->mem = vmalloc_user(journal->mem_size);
+    if (!journal->mem)
+    {
+        journal->mem_size = 0;
+        return -ENOMEM;
+    }
+
+    header = journal->mem;
+    header->magic = EC_EMERG_JOURNAL_MAGIC;
+    header->version = EC_EMERG_JOURNAL_VERSION;
+    header->entry_offset = PAGE_SIZE;
+    header->entry_count = size;
+
+    journal->header = header;
+    journal->entries = (ec_emergency_t *) ((u8 *) journal->mem + PAGE_SIZE);
+    journal->mask = size - 1;
+    for (i = 0; i < size; i++)
+    {
+        journal->entries[i].seq = i - size;
+    }
+    atomic_set(&journal->reserved, 0);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放日志。
+ * @param journal 日志。
+ */
+void ec_emerg_journal_clear(
+    ec_emerg_journal_t *journal /**< 日志 */
+)
+{
+    if (journal->mem)
+    {
+        vfree(journal->mem);
+    }
+    memset(journal, 0, sizeof(*journal));
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 写入一条紧急消息。
+ * @param journal 日志。
+ * @param position 从站的环位置。
+ * @param cycle 周期计数。
+ * @param msg 紧急消息（EC_COE_EMERGENCY_MSG_SIZE字节）。
+ * @return 分配给消息的序号。
+ * @details 可以在任何上下文中并发调用。写满后覆盖最早的记录。
+ */
+u32 ec_emerg_journal_post(
+    ec_emerg_journal_t *journal, /**< 日志 */
+    u16 position,                /**< 从站位置 */
+    u64 cycle,                   /**< 周期计数 */
+    const u8 *msg                /**< 紧急消息 */
+)
+{
+    ec_emerg_journal_header_t *header = journal->header;
+    u32 seq = (u32)atomic_inc_return(&journal->reserved) - 1;
+    ec_emergency_t *entry = &journal->entries[seq & journal->mask];
+    u32 head;
+
+    entry->seq = seq - 1;
+    smp_wmb();
+
+    entry->slave_position = position;
+    entry->error_code = EC_READ_U16(msg);
+    entry->timestamp = ktime_to_ns(ktime_get_real());
+    entry->cycle = cycle;
+    entry->error_register = EC_READ_U8(msg + 2);
+    memcpy(entry->data, msg + 3, sizeof(entry->data));
+    memset(entry->reserved, 0, sizeof(entry->reserved));
+
+    smp_wmb();
+    entry->seq = seq;
+
+    // 其他生产者可能已经推进了head
+    do
+    {
+        head = ec_emerg_journal_load(&header->head);
+        if ((s32)(seq + 1 - head) <= 0)
+        {
+            break;
+        }
+    } while (cmpxchg(&header->head, head, seq + 1) != head);
+
+    return seq;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 读取指定序号的消息。
+ * @param journal 日志。
+ * @param seq 序号。
+ * @param entry 记录的副本。
+ * @return 成功返回0，记录已被覆盖时返回-ENOENT，尚未写入完成时返回
+ * -EAGAIN。
+ */
+int ec_emerg_journal_get(
+    const ec_emerg_journal_t *journal, /**< 日志 */
+    u32 seq,                           /**< 序号 */
+    ec_emergency_t *entry              /**< 记录的副本 */
+)
+{
+    const ec_emergency_t *slot = &journal->entries[seq & journal->mask];
+    u32 cur = ec_emerg_journal_load(&slot->seq);
+
+    if (cur != seq)
+    {
+        return (s32)(cur - seq) > 0 ? -ENOENT : -EAGAIN;
+    }
+
+    smp_rmb();
+    *entry = *slot;
+    smp_rmb();
+
+    if (ec_emerg_journal_load(&slot->seq) != seq)
+    {
+        return -ENOENT; // 读取期间被覆盖
+    }
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 批量读取消息。
+ * @param journal 日志。
+ * @param seq 读取序号，读取后指向下一条未读的消息。
+ * @param entries 目标数组。
+ * @param count \a entries 的容量。
+ * @return 读取的消息数。
+ * @details 跳过已被覆盖的消息，遇到尚未写入完成的消息时停止。
+ */
+unsigned int ec_emerg_journal_read(
+    const ec_emerg_journal_t *journal, /**< 日志 */
+    u32 *seq,                          /**< 读取序号 */
+    ec_emergency_t *entries,           /**< 目标数组 */
+    unsigned int count                 /**< 目标数组的容量 */
+)
+{
+    u32 head = ec_emerg_journal_load(&journal->header->head);
+    u32 s = *seq;
+    unsigned int n = 0;
+    int ret;
+
+    smp_rmb();
+
+    if ((s32)(head - s) < 0)
+    {
+        return 0;
+    }
+    if (head - s > journal->mask + 1)
+    {
+        s = head - (journal->mask + 1);
+    }
+
+    while (n < count && s != head)
+    {
+        ret = ec_emerg_journal_get(journal, s, &entries[n]);
+        if (ret == -EAGAIN)
+        {
+            break;
+        }
+        if (!ret)
+        {
+            n++;
+        }
+        s++;
+    }
+
+    *seq = s;
+    return n;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回映射到用户空间的页面。
+ * @param journal 日志。
+ * @param offset 区域内的偏移量。
+ * @return 页面，偏移量无效时返回NULL。
+ */
+struct page *ec_emerg_journal_page(
+    const ec_emerg_journal_t *journal, /**< 日志 */
+    unsigned long offset               /**< 区域内的偏移量 */
+)
+{
+    if (!journal->mem || offset >= journal->mem_size)
+    {
+        return NULL;
+    }
+    return vmalloc_to_page((u8 *) journal->mem + offset);
+}
+
+/*****************************************************************************/
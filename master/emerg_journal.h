@@ -0,0 +1,93 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   CoE紧急消息日志。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_EMERG_JOURNAL_H__
+#define __EC_EMERG_JOURNAL_H__
+
+#include <linux/types.h>
+#include <linux/mm.h>
+#include <linux/atomic.h>
+
+#include "globals.h"
+#include "ioctl.h"
+
+/*****************************************************************************/
+
+/** 日志的默认记录数。 */
+#define EC_EMERG_JOURNAL_DEFAULT_SIZE 1024
+
+/** 日志的最小记录数。 */
+#define EC_EMERG_JOURNAL_MIN_SIZE 64
+
+/** 日志的最大记录数。 */
+#define EC_EMERG_JOURNAL_MAX_SIZE 65536
+
+/*****************************************************************************/
+
+/** 主站范围的CoE紧急消息日志。
+ *
+ * 所有从站的紧急消息按接收顺序写入同一个环，每条记录带有时间戳和周期
+ * 计数，写满后覆盖最早的记录。日志由一个页对齐的头部
+ * （ec_emerg_journal_header_t）和记录数组组成，整体可以通过mmap()只读
+ * 映射到用户空间（见EC_IOCTL_MMAP_EMERG），读取端批量读取，不需要ioctl()。
+ * 生产者通过原子递增\a reserved 分配序号，不需要锁。
+ *
+ * 从站配置的紧急环形缓冲区只保存日志中的序号，是日志的一个视图。
+ */
+typedef struct
+{
+    void *mem;                          /**< vmalloc_user()分配的内存。 */
+    size_t mem_size;                    /**< \a mem 的大小。 */
+    ec_emerg_journal_header_t *header;  /**< 头部（位于\a mem 起始处）。 */
+    ec_emergency_t *entries;            /**< 记录。 */
+    u32 mask;                           /**< 记录索引掩码。 */
+    atomic_t reserved;                  /**< 已分配的序号数。 */
+} ec_emerg_journal_t;
+
+/*****************************************************************************/
+
+int ec_emerg_journal_init(ec_emerg_journal_t *, size_t);
+void ec_emerg_journal_clear(ec_emerg_journal_t *);
+u32 ec_emerg_journal_post(ec_emerg_journal_t *, u16, u64, const u8 *);
+int ec_emerg_journal_get(const ec_emerg_journal_t *, u32, ec_emergency_t *);
+unsigned int ec_emerg_journal_read(const ec_emerg_journal_t *, u32 *,
+                                   ec_emergency_t *, unsigned int);
+struct page *ec_emerg_journal_page(const ec_emerg_journal_t *,
+                                   unsigned long);
+
+/*****************************************************************************/
+
+#endif
@@ -246,6 +246,7 @@ int ec_eoe_init(
     eoe->auto_created = 0;
 
     ec_datagram_init(&eoe->datagram);
+    eoe->datagram.sched_class = EC_SCHED_EOE;
     eoe->queue_datagram = 0;
     eoe->state = ec_eoe_state_rx_start;
     eoe->opened = 0;
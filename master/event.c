@@ -0,0 +1,240 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   主站事件通道。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/ktime.h>
+
+#include "event.h"
+
+/*****************************************************************************/
+
+/** 读取由生产者并发更新的序号，防止编译器缓存该值。
+ */
+static inline u32 ec_event_ring_load(const u32 *seq)
+{
+    return *(const volatile u32 *) seq;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化事件环。
+ * @param ring 事件环。
+ * @details 每条记录的序号初始化为比它第一次使用时的序号小一轮，读者因此
+ * 不会把未写入的记录当作有效记录。
+ */
+void ec_event_ring_init(
+    ec_event_ring_t *ring /**< 事件环 */
+)
+{
+    unsigned int i;
+
+    memset(ring->events, 0, sizeof(ring->events));
+    for (i = 0; i < EC_EVENT_RING_SIZE; i++)
+    {
+        ring->events[i].seq = i - EC_EVENT_RING_SIZE;
+    }
+    atomic_set(&ring->head, 0);
+    atomic_set(&ring->published, 0);
+    ring->woken = 0;
+    init_waitqueue_head(&ring->wait);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 写入一条事件记录。
+ * @param ring 事件环。
+ * @param type 事件类型（EC_EVENT_*）。
+ * @param count 合并的事件数。
+ * @param index 设备索引、从站位置或域索引。
+ * @param value 事件值。
+ * @param data 附加数据，可以为NULL。
+ * @param size 附加数据的大小，超过记录容量的部分被截断。
+ * @details 可以在任何上下文（包括实时上下文）中并发调用。写入期间记录的
+ * 序号是分配的序号减一，读者把它当作尚未写入；写入完成后设置为分配的序号。
+ */
+void ec_event_ring_post(
+    ec_event_ring_t *ring, /**< 事件环 */
+    u16 type,              /**< 事件类型 */
+    u16 count,             /**< 合并的事件数 */
+    u32 index,             /**< 索引 */
+    u32 value,             /**< 事件值 */
+    const u8 *data,        /**< 附加数据 */
+    size_t size            /**< 附加数据的大小 */
+)
+{
+    u32 seq = (u32)atomic_inc_return(&ring->head) - 1;
+    ec_event_t *event = &ring->events[seq & (EC_EVENT_RING_SIZE - 1)];
+
+    event->seq = seq - 1;
+    smp_wmb();
+
+    event->type = type;
+    event->count = count;
+    event->timestamp = ktime_to_ns(ktime_get());
+    event->index = index;
+    event->value = value;
+    memset(event->data, 0, sizeof(event->data));
+    if (data)
+    {
+        memcpy(event->data, data, min(size, sizeof(event->data)));
+    }
+
+    smp_wmb();
+    event->seq = seq;
+    atomic_inc(&ring->published);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 有新记录时唤醒读者。
+ * @param ring 事件环。
+ * @details 只能由主站线程调用。
+ */
+void ec_event_ring_wake(
+    ec_event_ring_t *ring /**< 事件环 */
+)
+{
+    u32 published = (u32)atomic_read(&ring->published);
+
+    if (published != ring->woken)
+    {
+        ring->woken = published;
+        wake_up_interruptible(&ring->wait);
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回下一条记录的序号。
+ * @param ring 事件环。
+ * @return 序号，新打开的读者从这里开始读取。
+ */
+u32 ec_event_ring_head(
+    const ec_event_ring_t *ring /**< 事件环 */
+)
+{
+    return (u32)atomic_read(&ring->head);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 检查读者是否有可读取的记录。
+ * @param ring 事件环。
+ * @param seq 读者的读取序号。
+ * @return 序号为\a seq 的记录已写入完成或已被覆盖时返回非零。
+ */
+int ec_event_ring_ready(
+    const ec_event_ring_t *ring, /**< 事件环 */
+    u32 seq                      /**< 读取序号 */
+)
+{
+    const ec_event_t *event = &ring->events[seq & (EC_EVENT_RING_SIZE - 1)];
+
+    return (s32)(ec_event_ring_load(&event->seq) - seq) >= 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 读取一条事件记录。
+ * @param ring 事件环。
+ * @param seq 读者的读取序号，成功时前进。
+ * @param event 记录的副本。
+ * @return 成功返回0，没有可读取的记录时返回-EAGAIN。
+ * @details 读者落后超过一轮时返回一条EC_EVENT_OVERFLOW记录，其值为丢失的
+ * 记录数，然后从最早的有效记录继续读取。
+ */
+int ec_event_ring_fetch(
+    const ec_event_ring_t *ring, /**< 事件环 */
+    u32 *seq,                    /**< 读取序号 */
+    ec_event_t *event            /**< 记录的副本 */
+)
+{
+    const ec_event_t *slot = &ring->events[*seq & (EC_EVENT_RING_SIZE - 1)];
+    u32 head = (u32)atomic_read(&ring->head);
+    u32 first;
+
+    while (1)
+    {
+        if (head - *seq > EC_EVENT_RING_SIZE)
+        {
+            // 读者落后超过一轮
+            first = head - EC_EVENT_RING_SIZE;
+            memset(event, 0, sizeof(*event));
+            event->seq = *seq;
+            event->type = EC_EVENT_OVERFLOW;
+            event->count = 1;
+            event->timestamp = ktime_to_ns(ktime_get());
+            event->value = first - *seq;
+            *seq = first;
+            return 0;
+        }
+
+        if (ec_event_ring_load(&slot->seq) != *seq)
+        {
+            if (!ec_event_ring_ready(ring, *seq))
+            {
+                return -EAGAIN; // 尚未写入完成
+            }
+            // 已被覆盖，覆盖者分配的序号已经计入head
+            smp_rmb();
+            head = (u32)atomic_read(&ring->head);
+            continue;
+        }
+
+        smp_rmb();
+        *event = *slot;
+        smp_rmb();
+
+        if (ec_event_ring_load(&slot->seq) == *seq)
+        {
+            (*seq)++;
+            return 0;
+        }
+
+        // 读取期间被覆盖
+        smp_rmb();
+        head = (u32)atomic_read(&ring->head);
+    }
+}
+
+/*****************************************************************************/
@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   主站事件通道。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_EVENT_H__
+#define __EC_EVENT_H__
+
+#include <linux/types.h>
+#include <linux/wait.h>
+#include <linux/atomic.h>
+
+#include "globals.h"
+#include "ioctl.h"
+
+/*****************************************************************************/
+
+/** 事件环的记录数（必须是2的幂）。 */
+#define EC_EVENT_RING_SIZE 256
+
+/*****************************************************************************/
+
+/** 事件环。
+ *
+ * 链路、AL状态、工作计数器、冗余、超时和紧急消息等事件由各自的上下文
+ * （包括实时上下文）写入，生产者通过原子递增\a head 分配序号，不需要锁。
+ * 每条记录的\a seq 在写入完成后才设置为分配的序号，读者据此判断记录是否
+ * 有效或已被覆盖。环写满后覆盖最早的记录。
+ *
+ * 读者（主站字符设备的文件句柄）各自维护读取序号。实时上下文不能唤醒
+ * 等待队列，因此由主站线程调用ec_event_ring_wake()唤醒读者。
+ */
+typedef struct
+{
+    ec_event_t events[EC_EVENT_RING_SIZE]; /**< 记录。 */
+    atomic_t head;                         /**< 已分配的序号数。 */
+    atomic_t published;                    /**< 已写入完成的记录数。 */
+    u32 woken;                  /**< 上一次唤醒读者时的\a published 。 */
+    wait_queue_head_t wait;     /**< 读者的等待队列。 */
+} ec_event_ring_t;
+
+/*****************************************************************************/
+
+void ec_event_ring_init(ec_event_ring_t *);
+void ec_event_ring_post(ec_event_ring_t *, u16, u16, u32, u32,
+                        const u8 *, size_t);
+void ec_event_ring_wake(ec_event_ring_t *);
+u32 ec_event_ring_head(const ec_event_ring_t *);
+int ec_event_ring_ready(const ec_event_ring_t *, u32);
+int ec_event_ring_fetch(const ec_event_ring_t *, u32 *, ec_event_t *);
+
+/*****************************************************************************/
+
+#endif
@@ -413,7 +413,7 @@ void ec_fsm_change_state_status(ec_fsm_change_t *fsm, ec_datagram_t *datagram) {
         fsm->jiffies_start = fsm->datagram->jiffies_sent;
     }
 
-    slave->current_state = EC_READ_U8(fsm->datagram->data);
+    ec_slave_set_al_status(slave, EC_READ_U8(fsm->datagram->data));
 
     if (slave->current_state == fsm->requested_state) {
         // 状态已成功设置
@@ -708,7 +708,7 @@ void ec_fsm_change_state_check_ack(ec_fsm_change_t *fsm, ec_datagram_t *datagram
         fsm->jiffies_start = fsm->datagram->jiffies_sent;
     }
 
-    slave->current_state = EC_READ_U8(fsm->datagram->data);
+    ec_slave_set_al_status(slave, EC_READ_U8(fsm->datagram->data));
 
     if (!(slave->current_state & EC_SLAVE_STATE_ACK_ERR)) {
         char state_str[EC_STATE_STRING_SIZE];
@@ -327,7 +327,8 @@ int ec_fsm_coe_success(
  * 如果检查结果为真，将输出紧急请求。
  * 如果数据大小小于2或((EC_READ_U16(data) >> 12) & 0x0F)不等于0x01，则返回0。
  * 如果数据大小小于10，则输出接收到不完整的CoE紧急请求。
- * 否则，将将紧急请求数据推入紧急请求环形缓冲区中，并输出紧急请求的详细信息。
+ * 否则，将紧急请求写入主站的紧急消息日志，并把序号推入从站配置的紧急环形缓冲区中，
+ * 然后输出紧急请求的详细信息。
  */
 int ec_fsm_coe_check_emergency(
     ec_fsm_coe_t *fsm,   /**< 有限状态机 */
@@ -346,13 +347,21 @@ int ec_fsm_coe_check_emergency(
     }
 
     {
-        ec_slave_config_t *sc = fsm->slave->config;
+        ec_slave_t *slave = fsm->slave;
+        ec_slave_config_t *sc = slave->config;
+        u32 seq = ec_emerg_journal_post(&slave->master->emerg_journal,
+                                        slave->ring_position,
+                                        slave->master->cycle_count, data + 2);
         if (sc)
         {
-            ec_coe_emerg_ring_push(&sc->emerg_ring, data + 2);
+            ec_coe_emerg_ring_push(&sc->emerg_ring, seq);
         }
     }
 
+    ec_event_ring_post(&fsm->slave->master->events, EC_EVENT_EMERGENCY, 1,
+                       fsm->slave->ring_position, EC_READ_U16(data + 2),
+                       data + 2, EC_COE_EMERGENCY_MSG_SIZE);
+
     EC_SLAVE_WARN(fsm->slave, "接收到CoE紧急请求：\n"
                               "错误代码0x%04X，错误寄存器0x%02X，数据：\n",
                   EC_READ_U16(data + 2), EC_READ_U8(data + 4));
@@ -868,7 +877,14 @@ void ec_fsm_coe_dict_response_data(
         }
 
         ec_sdo_init(sdo, slave, sdo_index);
-        list_add_tail(&sdo->list, &slave->sdo_dictionary);
+        if (ec_slave_add_sdo(slave, sdo))
+        {
+            EC_SLAVE_ERR(slave, "为SDO字典索引分配内存失败！\n");
+            ec_sdo_clear(sdo);
+            kfree(sdo);
+            fsm->state = ec_fsm_coe_error;
+            return;
+        }
     }
 
     fragments_left = EC_READ_U16(data + 4);
@@ -49,6 +49,10 @@
 /** 允许在不设置新的系统时间偏移的情况下容忍的时间差（以纳秒为单位）。
  */
 #define EC_SYSTEM_TIME_TOLERANCE_NS 1000
+
+/** 分组状态转换的超时时间（秒），与单个从站的状态转换相同。
+ */
+#define EC_AL_GROUP_TIMEOUT 5
 /*****************************************************************************/
 
 void ec_fsm_master_state_start(ec_fsm_master_t *);
@@ -70,10 +74,19 @@ void ec_fsm_master_state_dc_write_offset(ec_fsm_master_t *);
 void ec_fsm_master_state_dc_reset_filter(ec_fsm_master_t *);
 void ec_fsm_master_state_write_sii(ec_fsm_master_t *);
 void ec_fsm_master_state_reboot_slave(ec_fsm_master_t *);
+void ec_fsm_master_state_group_write(ec_fsm_master_t *);
+void ec_fsm_master_state_group_read(ec_fsm_master_t *);
+void ec_fsm_master_state_crc_read(ec_fsm_master_t *);
 
 void ec_fsm_master_enter_dc_read_old_times(ec_fsm_master_t *);
 void ec_fsm_master_enter_clear_addresses(ec_fsm_master_t *);
 void ec_fsm_master_enter_write_system_times(ec_fsm_master_t *);
+void ec_fsm_master_enter_slave_state(ec_fsm_master_t *);
+int ec_fsm_master_action_group(ec_fsm_master_t *);
+void ec_fsm_master_enter_group_write(ec_fsm_master_t *);
+void ec_fsm_master_enter_group_read(ec_fsm_master_t *);
+int ec_fsm_master_action_crc_monitor(ec_fsm_master_t *);
+void ec_fsm_master_enter_crc_read(ec_fsm_master_t *);
 
 /*****************************************************************************/
 
@@ -91,9 +104,19 @@ void ec_fsm_master_init(
     ec_datagram_t *datagram /**< 用于通信的数据报对象。 */
 )
 {
+    unsigned int i;
+
     fsm->master = master;
     fsm->datagram = datagram;
 
+    for (i = 0; i < EC_FSM_MASTER_BATCH_SIZE - 1; i++)
+    {
+        ec_datagram_init(&fsm->batch_datagrams[i]);
+        snprintf(fsm->batch_datagrams[i].name, EC_DATAGRAM_NAME_SIZE,
+                 "master-fsm-%u", i + 1);
+        fsm->batch_datagrams[i].sched_class = EC_SCHED_FSM;
+    }
+
     ec_fsm_master_reset(fsm);
 
     // 初始化子状态机
@@ -114,9 +137,16 @@ void ec_fsm_master_clear(
     ec_fsm_master_t *fsm /**< 主站状态机指针。 */
 )
 {
+    unsigned int i;
+
     // 清理子状态机
     ec_fsm_reboot_clear(&fsm->fsm_reboot);
     ec_fsm_sii_clear(&fsm->fsm_sii);
+
+    for (i = 0; i < EC_FSM_MASTER_BATCH_SIZE - 1; i++)
+    {
+        ec_datagram_clear(&fsm->batch_datagrams[i]);
+    }
 }
 
 
@@ -148,6 +178,8 @@ void ec_fsm_master_reset(
     }
 
     fsm->rescan_required = 0;
+    fsm->batch_size = 0;
+    fsm->dc_slave_count = 0;
 }
 
 /*****************************************************************************/
@@ -163,12 +195,24 @@ int ec_fsm_master_exec(
     ec_fsm_master_t *fsm /**< 主站状态机指针。 */
 )
 {
+    unsigned int i;
+
     if (fsm->datagram->state == EC_DATAGRAM_SENT || fsm->datagram->state == EC_DATAGRAM_QUEUED)
     {
         // 数据报尚未发送或接收。
         return 0;
     }
 
+    for (i = 1; i < fsm->batch_size; i++)
+    {
+        if (fsm->batch_datagrams[i - 1].state == EC_DATAGRAM_SENT ||
+            fsm->batch_datagrams[i - 1].state == EC_DATAGRAM_QUEUED)
+        {
+            // 批量中的数据报尚未发送或接收。
+            return 0;
+        }
+    }
+
     fsm->state(fsm);
     return 1;
 }
@@ -475,13 +519,9 @@ void ec_fsm_master_state_broadcast(
         else
         {
             // 从第一个从站获取状态
+            ec_status_domain_process(&master->status_domain, master);
             fsm->slave = master->slaves;
-            ec_datagram_fprd(fsm->datagram, fsm->slave->station_address,
-                             0x0130, 2);
-            ec_datagram_zero(datagram);
-            fsm->datagram->device_index = fsm->slave->device_index;
-            fsm->retries = EC_FSM_RETRIES;
-            fsm->state = ec_fsm_master_state_read_al_status;
+            ec_fsm_master_enter_slave_state(fsm);
         }
     }
     else
@@ -551,6 +591,18 @@ void ec_fsm_master_action_idle(
         return; // 发现SII写请求
     }
 
+    // 检查是否有等待分组状态转换的从站。
+    if (ec_fsm_master_action_group(fsm))
+    {
+        return;
+    }
+
+    // 检查是否需要采样错误计数器。
+    if (ec_fsm_master_action_crc_monitor(fsm))
+    {
+        return;
+    }
+
     ec_fsm_master_restart(fsm);
 }
 
@@ -567,14 +619,70 @@ void ec_fsm_master_action_next_slave_state(
     ec_fsm_master_t *fsm /**< 主站状态机。 */
 )
 {
-    ec_master_t *master = fsm->master;
-
     // 是否还有其他从站需要查询？
     fsm->slave++;
+    fsm->idle = 1;
+    ec_fsm_master_enter_slave_state(fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     检查是否可以跳过当前从站的状态查询。
+ * @功能      状态域已提供当前从站的AL状态时，不再单独读取。
+ * @details   只有从站没有错误、不需要重启并且配置未更改时才跳过，
+ *            否则仍然走单独读取的路径，由它处理这些情况。
+ *            启用EC_LOOP_CONTROL时还需要读取DL状态，因此不跳过。
+ * @param     fsm 主站状态机指针。
+ * @retval    非零值，如果跳过了当前从站。
+ */
+static int ec_fsm_master_skip_slave_state(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+#ifdef EC_LOOP_CONTROL
+    return 0;
+#else
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave = fsm->slave;
+
+    if (!ec_status_domain_covers(&master->status_domain, slave) ||
+        slave->error_flag || slave->reboot || master->config_changed)
+    {
+        return 0;
+    }
+
+    // 允许从站开始配置（如果尚未完成）。
+    ec_fsm_slave_set_ready(&slave->fsm);
+    return 1;
+#endif
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     主站动作：从当前从站开始获取从站状态。
+ * @功能      读取第一个需要查询的从站的AL状态。
+ * @details   状态域已提供状态的从站被跳过。如果没有需要查询的从站，
+ *            执行空闲动作。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_enter_slave_state(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_master_t *master = fsm->master;
+
+    while (fsm->slave < master->slaves + master->slave_count &&
+           ec_fsm_master_skip_slave_state(fsm))
+    {
+        fsm->slave++;
+    }
+
     if (fsm->slave < master->slaves + master->slave_count)
     {
-        // 从下一个从站获取状态
-        fsm->idle = 1;
+        // 从从站获取状态
         ec_datagram_fprd(fsm->datagram,
                          fsm->slave->station_address, 0x0130, 2);
         ec_datagram_zero(fsm->datagram);
@@ -1268,10 +1376,111 @@ void ec_fsm_master_state_scan_slave(
 
 /*****************************************************************************/
 
+/**
+ * @brief     返回批量中的第i个数据报。
+ * @details   批量的第一个数据报是状态机的数据报，其余的是附加数据报。
+ * @param     fsm 主站状态机指针。
+ * @param     i 批量中的索引。
+ * @retval    数据报指针。
+ */
+static ec_datagram_t *ec_fsm_master_batch_datagram(
+    ec_fsm_master_t *fsm, /**< 主站状态机。 */
+    unsigned int i        /**< 批量中的索引。 */
+)
+{
+    return i ? &fsm->batch_datagrams[i - 1] : fsm->datagram;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     检查批量中的数据报是否需要重试。
+ * @details   只要有一个数据报超时并且还有重试次数，就重新发送整个批量。
+ *            读取和写入的寄存器都是幂等的，重复发送已接收的数据报没有影响。
+ * @param     fsm 主站状态机指针。
+ * @retval    非零值，如果需要重试。
+ */
+static int ec_fsm_master_batch_retry(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < fsm->batch_size; i++)
+    {
+        if (ec_fsm_master_batch_datagram(fsm, i)->state ==
+            EC_DATAGRAM_TIMED_OUT)
+        {
+            return fsm->retries-- > 0;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     检查批量中第i个数据报的结果。
+ * @param     fsm 主站状态机指针。
+ * @param     i 批量中的索引。
+ * @param     what 出错时输出的操作描述。
+ * @retval    非零值，如果从站已应答。
+ */
+static int ec_fsm_master_batch_check(
+    ec_fsm_master_t *fsm, /**< 主站状态机。 */
+    unsigned int i,       /**< 批量中的索引。 */
+    const char *what      /**< 操作描述。 */
+)
+{
+    ec_datagram_t *datagram = ec_fsm_master_batch_datagram(fsm, i);
+    ec_slave_t *slave = fsm->batch_slaves[i];
+
+    if (datagram->state != EC_DATAGRAM_RECEIVED)
+    {
+        EC_SLAVE_ERR(slave, "无法接收%s数据报文：", what);
+        ec_datagram_print_state(datagram);
+        return 0;
+    }
+
+    if (datagram->working_counter != 1)
+    {
+        EC_SLAVE_WARN(slave, "无法%s：", what);
+        ec_datagram_print_wc_error(datagram);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     把批量的附加数据报加入主站的数据报队列。
+ * @details   在状态机的数据报被注入时调用，参见ecrt_master_send()和IDLE线程。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_queue_batch(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    unsigned int i;
+
+    for (i = 1; i < fsm->batch_size; i++)
+    {
+        ec_master_queue_datagram(fsm->master, &fsm->batch_datagrams[i - 1]);
+    }
+}
+
+/*****************************************************************************/
+
 /**
  * @brief     开始写入DC系统时间。
- * @功能      详细描述该函数的功能，完成了什么任务。
- * @details   这是开始写入DC系统时间的函数。
+ * @功能      读取下一批DC从站的系统时间、时间偏移和传输延迟。
+ * @details   从fsm->slave开始，最多EC_FSM_MASTER_BATCH_SIZE个支持DC系统时间
+ *            的从站在同一次注入中读取，而不是逐个从站等待应答。
+ *            所有从站处理完毕后，输出DC偏移计算的耗时。
  * @param     fsm 主站状态机指针。
  * @retval    无返回值。
  */
@@ -1280,39 +1489,66 @@ void ec_fsm_master_enter_write_system_times(
 )
 {
     ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram;
+
+    fsm->batch_size = 0;
+
+    if (!master->active)
+    {
+        EC_MASTER_DBG(master, 1, "到目前为止没有收到app_time。\n");
+        goto done;
+    }
 
-    if (master->active)
+    if (fsm->slave == master->slaves)
     {
+        fsm->dc_jiffies = jiffies;
+        fsm->dc_slave_count = 0;
+    }
 
-        while (fsm->slave < master->slaves + master->slave_count)
+    while (fsm->slave < master->slaves + master->slave_count &&
+           fsm->batch_size < EC_FSM_MASTER_BATCH_SIZE)
+    {
+        if (fsm->slave->base_dc_supported && fsm->slave->has_dc_system_time)
         {
-            if (!fsm->slave->base_dc_supported || !fsm->slave->has_dc_system_time)
-            {
-                fsm->slave++;
-                continue;
-            }
-
             EC_SLAVE_DBG(fsm->slave, 1, "检查系统时间偏移。\n");
 
             // 读取DC系统时间（0x0910，64位）
             //                     间隔（64位）
             //     和时间偏移（0x0920，64位）
             //   和接收延迟（0x0928，32位）
-            ec_datagram_fprd(fsm->datagram, fsm->slave->station_address,
-                             0x0910, 28);
-            ec_datagram_zero(fsm->datagram);
-            fsm->datagram->device_index = fsm->slave->device_index;
-            fsm->retries = EC_FSM_RETRIES;
-            fsm->state = ec_fsm_master_state_dc_read_offset;
-            return;
+            datagram = ec_fsm_master_batch_datagram(fsm, fsm->batch_size);
+            if (ec_datagram_fprd(datagram, fsm->slave->station_address,
+                                 0x0910, 28))
+            {
+                EC_SLAVE_ERR(fsm->slave, "无法分配DC时间数据报文。\n");
+                break;
+            }
+            ec_datagram_zero(datagram);
+            datagram->device_index = fsm->slave->device_index;
+            fsm->batch_slaves[fsm->batch_size++] = fsm->slave;
         }
-        master->dc_offset_valid = 1;
+        fsm->slave++;
     }
-    else
+
+    if (fsm->batch_size)
     {
-        EC_MASTER_DBG(master, 1, "到目前为止没有收到app_time。\n");
+        fsm->dc_slave_count += fsm->batch_size;
+        fsm->retries = EC_FSM_RETRIES;
+        fsm->state = ec_fsm_master_state_dc_read_offset;
+        return;
+    }
+
+    master->dc_offset_valid = 1;
+    if (fsm->dc_slave_count)
+    {
+        EC_MASTER_INFO(master, "%u个从站的DC系统时间偏移计算完成，"
+                               "耗时 %lu 毫秒。\n",
+                       fsm->dc_slave_count,
+                       (jiffies - fsm->dc_jiffies) * 1000 / HZ);
+        fsm->dc_slave_count = 0;
     }
 
+done:
     // 扫描和设置系统时间完成
     ec_master_request_op(master);
     ec_fsm_master_restart(fsm);
@@ -1324,20 +1560,19 @@ void ec_fsm_master_enter_write_system_times(
  * @brief     配置32位时间偏移量。
  * @功能      详细描述该函数的功能，完成了什么任务。
  * @details   这是配置32位时间偏移量的函数。
- * @param     fsm 主站状态机指针。
+ * @param     slave 从站。
  * @param     system_time 系统时间寄存器。
  * @param     old_offset 时间偏移寄存器。
  * @param     app_time_sent 通过读取得到的主站应用时间。
  * @retval    新的偏移量。
  */
 u64 ec_fsm_master_dc_offset32(
-    ec_fsm_master_t *fsm, /**< 主站状态机。 */
-    u64 system_time,      /**< 系统时间寄存器。 */
-    u64 old_offset,       /**< 时间偏移寄存器。 */
-    u64 app_time_sent     /**< 通过读取得到的主站应用时间。 */
+    ec_slave_t *slave, /**< 从站。 */
+    u64 system_time,   /**< 系统时间寄存器。 */
+    u64 old_offset,    /**< 时间偏移寄存器。 */
+    u64 app_time_sent  /**< 通过读取得到的主站应用时间。 */
 )
 {
-    ec_slave_t *slave = fsm->slave;
     u32 system_time32, old_offset32, new_offset;
     s32 time_diff;
 
@@ -1370,20 +1605,19 @@ u64 ec_fsm_master_dc_offset32(
  * @brief     配置64位时间偏移量。
  * @功能      详细描述该函数的功能，完成了什么任务。
  * @details   这是配置64位时间偏移量的函数。
- * @param     fsm 主站状态机指针。
+ * @param     slave 从站。
  * @param     system_time 系统时间寄存器。
  * @param     old_offset 时间偏移寄存器。
  * @param     app_time_sent 通过读取得到的主站应用时间。
  * @retval    新的偏移量。
  */
 u64 ec_fsm_master_dc_offset64(
-    ec_fsm_master_t *fsm, /**< 主站状态机。 */
-    u64 system_time,      /**< 系统时间寄存器。 */
-    u64 old_offset,       /**< 时间偏移寄存器。 */
-    u64 app_time_sent     /**< 通过读取得到的主站应用时间。 */
+    ec_slave_t *slave, /**< 从站。 */
+    u64 system_time,   /**< 系统时间寄存器。 */
+    u64 old_offset,    /**< 时间偏移寄存器。 */
+    u64 app_time_sent  /**< 通过读取得到的主站应用时间。 */
 )
 {
-    ec_slave_t *slave = fsm->slave;
     u64 new_offset;
     s64 time_diff;
 
@@ -1412,7 +1646,8 @@ u64 ec_fsm_master_dc_offset64(
 
 /**
  * @brief	主状态：DC读取偏移量。
- * @作用	该函数用于读取并设置从站的DC时间偏移量和传输延迟。
+ * @作用	为批量中的每个从站计算DC时间偏移量，并在同一次注入中写入
+ *          所有需要更改的时间偏移量和传输延迟。
  * @param	fsm 主状态机指针。
  * @retval	无。
  */
@@ -1420,78 +1655,80 @@ void ec_fsm_master_state_dc_read_offset(
     ec_fsm_master_t *fsm /**< 主状态机指针。 */
 )
 {
-    ec_datagram_t *datagram = fsm->datagram;
-    ec_slave_t *slave = fsm->slave;
     ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram;
+    ec_slave_t *slave;
+    unsigned int i, count = 0;
     u64 system_time, old_offset, new_offset;
     u32 old_delay;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
+    if (ec_fsm_master_batch_retry(fsm))
         return;
 
-    if (datagram->state != EC_DATAGRAM_RECEIVED)
-    {
-        EC_SLAVE_ERR(slave, "无法接收到DC时间数据报文：");
-        ec_datagram_print_state(datagram);
-        fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
-        return;
-    }
-
-    if (datagram->working_counter != 1)
-    {
-        EC_SLAVE_WARN(slave, "无法获取DC时间：");
-        ec_datagram_print_wc_error(datagram);
-        fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
-        return;
-    }
-
     if (unlikely(!master->dc_ref_time))
     {
         EC_MASTER_WARN(master, "未收到应用时间，中止DC时间偏移计算。\n");
+        fsm->batch_size = 0;
         // 扫描和设置系统时间完成
         ec_master_request_op(master);
         ec_fsm_master_restart(fsm);
         return;
     }
 
-    system_time = EC_READ_U64(datagram->data);     // 0x0910
-    old_offset = EC_READ_U64(datagram->data + 16); // 0x0920
-    old_delay = EC_READ_U32(datagram->data + 24);  // 0x0928
-
-    if (slave->base_dc_range == EC_DC_32)
+    for (i = 0; i < fsm->batch_size; i++)
     {
-        new_offset = ec_fsm_master_dc_offset32(fsm,
-                                               system_time, old_offset, datagram->app_time_sent);
-    }
-    else
-    {
-        new_offset = ec_fsm_master_dc_offset64(fsm,
-                                               system_time, old_offset, datagram->app_time_sent);
-    }
+        if (!ec_fsm_master_batch_check(fsm, i, "获取DC时间"))
+            continue;
 
-    if (new_offset != old_offset && slave->current_state >= EC_SLAVE_STATE_SAFEOP)
-    {
-        // 从站已经处于激活状态；改变系统时间偏移量可能会导致问题。
-        // 在这种情况下保持偏移量不变，让正常的周期同步过程逐渐调整到正确的时间。
-        EC_SLAVE_DBG(slave, 1, "从站正在运行；忽略DC偏移量的更改。\n");
-        new_offset = old_offset;
+        datagram = ec_fsm_master_batch_datagram(fsm, i);
+        slave = fsm->batch_slaves[i];
+
+        system_time = EC_READ_U64(datagram->data);     // 0x0910
+        old_offset = EC_READ_U64(datagram->data + 16); // 0x0920
+        old_delay = EC_READ_U32(datagram->data + 24);  // 0x0928
+
+        if (slave->base_dc_range == EC_DC_32)
+        {
+            new_offset = ec_fsm_master_dc_offset32(slave,
+                                                   system_time, old_offset, datagram->app_time_sent);
+        }
+        else
+        {
+            new_offset = ec_fsm_master_dc_offset64(slave,
+                                                   system_time, old_offset, datagram->app_time_sent);
+        }
+
+        if (new_offset != old_offset && slave->current_state >= EC_SLAVE_STATE_SAFEOP)
+        {
+            // 从站已经处于激活状态；改变系统时间偏移量可能会导致问题。
+            // 在这种情况下保持偏移量不变，让正常的周期同步过程逐渐调整到正确的时间。
+            EC_SLAVE_DBG(slave, 1, "从站正在运行；忽略DC偏移量的更改。\n");
+            new_offset = old_offset;
+        }
+
+        if (new_offset == old_offset && slave->transmission_delay == old_delay)
+        {
+            // 偏移量未改变；跳过写操作以避免可能的问题
+            continue;
+        }
+
+        // 设置DC系统时间偏移量和传输延迟（count <= i，读取的数据已使用）
+        datagram = ec_fsm_master_batch_datagram(fsm, count);
+        ec_datagram_fpwr(datagram, slave->station_address, 0x0920, 12);
+        EC_WRITE_U64(datagram->data, new_offset);
+        EC_WRITE_U32(datagram->data + 8, slave->transmission_delay);
+        datagram->device_index = slave->device_index;
+        fsm->batch_slaves[count++] = slave;
     }
 
-    if (new_offset == old_offset && slave->transmission_delay == old_delay)
+    fsm->batch_size = count;
+
+    if (!count)
     {
-        // 偏移量未改变；跳过写操作以避免可能的问题
-        fsm->slave++;
         ec_fsm_master_enter_write_system_times(fsm);
         return;
     }
 
-    // 设置DC系统时间偏移量和传输延迟
-    ec_datagram_fpwr(datagram, slave->station_address, 0x0920, 12);
-    EC_WRITE_U64(datagram->data, new_offset);
-    EC_WRITE_U32(datagram->data + 8, slave->transmission_delay);
-    fsm->datagram->device_index = slave->device_index;
     fsm->retries = EC_FSM_RETRIES;
     fsm->state = ec_fsm_master_state_dc_write_offset;
 }
@@ -1500,7 +1737,7 @@ void ec_fsm_master_state_dc_read_offset(
 
 /**
  * @brief	主站状态：DC写入偏移量。
- * @作用	该函数用于设置从站的DC系统时间偏移量。
+ * @作用	检查批量写入的DC系统时间偏移量，并为尚未运行的从站重置DC滤波器。
  * @param	fsm 主站状态机指针。
  * @retval	无。
  */
@@ -1508,88 +1745,509 @@ void ec_fsm_master_state_dc_write_offset(
     ec_fsm_master_t *fsm /**< 主站状态机指针。 */
 )
 {
-    ec_datagram_t *datagram = fsm->datagram;
-    ec_slave_t *slave = fsm->slave;
+    ec_datagram_t *datagram;
+    ec_slave_t *slave;
+    unsigned int i, count = 0;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
+    if (ec_fsm_master_batch_retry(fsm))
         return;
 
-    if (datagram->state != EC_DATAGRAM_RECEIVED)
+    for (i = 0; i < fsm->batch_size; i++)
+    {
+        if (!ec_fsm_master_batch_check(fsm, i, "设置DC系统时间偏移量"))
+            continue;
+
+        slave = fsm->batch_slaves[i];
+
+        // 在更改偏移量后重置DC滤波器
+        if (slave->current_state >= EC_SLAVE_STATE_SAFEOP)
+        {
+            EC_SLAVE_DBG(slave, 1, "从站正在运行；不重置DC滤波器。\n");
+            continue;
+        }
+
+        datagram = ec_fsm_master_batch_datagram(fsm, count);
+        ec_datagram_fpwr(datagram, slave->station_address, 0x0930, 2);
+        EC_WRITE_U16(datagram->data, 0x1000);
+        datagram->device_index = slave->device_index;
+        fsm->batch_slaves[count++] = slave;
+    }
+
+    fsm->batch_size = count;
+
+    if (!count)
     {
-        EC_SLAVE_ERR(slave,
-                     "无法接收到DC系统时间偏移量数据报文：");
-        ec_datagram_print_state(datagram);
-        fsm->slave++;
         ec_fsm_master_enter_write_system_times(fsm);
         return;
     }
 
-    if (datagram->working_counter != 1)
+    fsm->retries = EC_FSM_RETRIES;
+    fsm->state = ec_fsm_master_state_dc_reset_filter;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief	主站状态：DC时钟重置滤波器。
+ * @作用	检查批量重置DC滤波器的结果，然后处理下一批从站。
+ * @param	fsm 主站状态机。
+ * @retval	无
+ */
+void ec_fsm_master_state_dc_reset_filter(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    unsigned int i;
+
+    if (ec_fsm_master_batch_retry(fsm))
+        return;
+
+    for (i = 0; i < fsm->batch_size; i++)
     {
-        EC_SLAVE_ERR(slave, "无法设置DC系统时间偏移量：");
-        ec_datagram_print_wc_error(datagram);
-        fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
+        ec_fsm_master_batch_check(fsm, i, "重置DC滤波器");
+    }
+
+    ec_fsm_master_enter_write_system_times(fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     检查从站是否在当前的分组状态转换中。
+ * @param     fsm 主站状态机指针。
+ * @param     slave 从站。
+ * @retval    非零值，如果从站等待分组转换到fsm->group_state。
+ */
+static int ec_fsm_master_group_member(
+    const ec_fsm_master_t *fsm, /**< 主站状态机。 */
+    const ec_slave_t *slave     /**< 从站。 */
+)
+{
+    return slave->al_group == EC_AL_GROUP_READY &&
+           slave->requested_state == fsm->group_state;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     主站动作：开始分组状态转换。
+ * @功能      当所有分组中的从站都完成了配置时，一起请求目标状态。
+ * @details   已经到达目标状态或出错的从站退出分组。只要还有从站在配置，
+ *            就继续等待。总线上只有一个设备并且所有从站都等待同一状态时，
+ *            使用一个广播写入，否则把FPWR数据报打包到批量中。
+ * @param     fsm 主站状态机指针。
+ * @retval    非零值，如果开始了分组状态转换。
+ */
+int ec_fsm_master_action_group(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_master_t *master = fsm->master;
+    ec_slave_t *slave;
+    unsigned int ready = 0, configuring = 0;
+
+    for (slave = master->slaves;
+         slave < master->slaves + master->slave_count;
+         slave++)
+    {
+        if (slave->al_group == EC_AL_GROUP_NONE)
+        {
+            continue;
+        }
+
+        if (slave->error_flag ||
+            slave->current_state == slave->requested_state)
+        {
+            slave->al_group = EC_AL_GROUP_NONE;
+            continue;
+        }
+
+        if (slave->al_group == EC_AL_GROUP_MEMBER)
+        {
+            configuring++;
+            continue;
+        }
+
+        if (!ready)
+        {
+            fsm->group_state = slave->requested_state;
+        }
+        if (slave->requested_state == fsm->group_state)
+        {
+            ready++;
+        }
+    }
+
+    if (!ready || configuring)
+    {
+        return 0;
+    }
+
+    if (master->debug_level)
+    {
+        char state_str[EC_STATE_STRING_SIZE];
+        ec_state_string(fsm->group_state, state_str, 0);
+        EC_MASTER_DBG(master, 1, "分组请求%u个从站进入%s。\n",
+                      ready, state_str);
+    }
+
+    fsm->idle = 0;
+    fsm->group_count = ready;
+    fsm->group_broadcast = ready == master->slave_count &&
+                           ec_master_num_devices(master) == 1;
+    fsm->group_jiffies = jiffies;
+    fsm->slave = master->slaves;
+    ec_fsm_master_enter_group_write(fsm);
+    return 1;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     写入下一批从站的AL控制寄存器。
+ * @details   所有从站都写入后，开始检查AL状态。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_enter_group_write(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram;
+
+    fsm->batch_size = 0;
+
+    if (fsm->group_broadcast)
+    {
+        ec_datagram_bwr(fsm->datagram, 0x0120, 2);
+        EC_WRITE_U16(fsm->datagram->data, fsm->group_state);
+        fsm->datagram->device_index = EC_DEVICE_MAIN;
+        fsm->retries = EC_FSM_RETRIES;
+        fsm->state = ec_fsm_master_state_group_write;
         return;
     }
 
-    // 在更改偏移量后重置DC滤波器
-    if (slave->current_state >= EC_SLAVE_STATE_SAFEOP)
+    while (fsm->slave < master->slaves + master->slave_count &&
+           fsm->batch_size < EC_FSM_MASTER_BATCH_SIZE)
     {
-        EC_SLAVE_DBG(slave, 1, "从站正在运行；不重置DC滤波器。\n");
+        if (ec_fsm_master_group_member(fsm, fsm->slave))
+        {
+            datagram = ec_fsm_master_batch_datagram(fsm, fsm->batch_size);
+            if (ec_datagram_fpwr(datagram, fsm->slave->station_address,
+                                 0x0120, 2))
+            {
+                EC_SLAVE_ERR(fsm->slave, "无法分配AL控制数据报文。\n");
+                break;
+            }
+            EC_WRITE_U16(datagram->data, fsm->group_state);
+            datagram->device_index = fsm->slave->device_index;
+            fsm->batch_slaves[fsm->batch_size++] = fsm->slave;
+        }
         fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
     }
-    else
+
+    if (fsm->batch_size)
     {
-        ec_datagram_fpwr(datagram, slave->station_address, 0x0930, 2);
-        EC_WRITE_U16(datagram->data, 0x1000);
-        fsm->datagram->device_index = slave->device_index;
         fsm->retries = EC_FSM_RETRIES;
-        fsm->state = ec_fsm_master_state_dc_reset_filter;
+        fsm->state = ec_fsm_master_state_group_write;
+        return;
     }
-}
 
+    fsm->slave = master->slaves;
+    ec_fsm_master_enter_group_read(fsm);
+}
 
 /*****************************************************************************/
 
 /**
- * @brief	主站状态：DC时钟重置滤波器。
- * @作用	执行主站状态机的DC时钟重置滤波器操作。
- * @param	fsm 主站状态机。
- * @retval	无
+ * @brief     主站状态：分组写入AL控制寄存器。
+ * @details   广播写入的工作计数器不等于从站数时，改为逐个从站写入。
+ *            写入失败的从站退出分组，由从站状态机单独处理。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
  */
-void ec_fsm_master_state_dc_reset_filter(
+void ec_fsm_master_state_group_write(
     ec_fsm_master_t *fsm /**< 主站状态机。 */
 )
 {
+    ec_master_t *master = fsm->master;
     ec_datagram_t *datagram = fsm->datagram;
-    ec_slave_t *slave = fsm->slave;
+    unsigned int i;
 
-    if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
+    if (fsm->group_broadcast)
+    {
+        if (datagram->state == EC_DATAGRAM_TIMED_OUT && fsm->retries--)
+            return;
+
+        fsm->group_broadcast = 0;
+        if (datagram->state != EC_DATAGRAM_RECEIVED ||
+            datagram->working_counter != master->slave_count)
+        {
+            EC_MASTER_WARN(master, "广播AL控制失败，逐个请求状态。\n");
+            fsm->slave = master->slaves;
+            ec_fsm_master_enter_group_write(fsm);
+            return;
+        }
+
+        fsm->slave = master->slaves;
+        ec_fsm_master_enter_group_read(fsm);
         return;
+    }
 
-    if (datagram->state != EC_DATAGRAM_RECEIVED)
+    if (ec_fsm_master_batch_retry(fsm))
+        return;
+
+    for (i = 0; i < fsm->batch_size; i++)
     {
-        EC_SLAVE_ERR(slave,
-                     "无法接收到DC时钟重置滤波器数据报文：");
-        ec_datagram_print_state(datagram);
+        if (!ec_fsm_master_batch_check(fsm, i, "请求AL状态"))
+        {
+            fsm->batch_slaves[i]->al_group = EC_AL_GROUP_NONE;
+        }
+    }
+
+    ec_fsm_master_enter_group_write(fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     读取下一批从站的AL状态。
+ * @details   一轮检查结束后，如果还有从站未到达目标状态并且没有超时，
+ *            从第一个从站开始下一轮。超时的从站退出分组，由从站状态机
+ *            单独处理。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_enter_group_read(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram;
+    ec_slave_t *slave;
+    unsigned int pending = 0;
+
+    fsm->batch_size = 0;
+
+    while (fsm->slave < master->slaves + master->slave_count &&
+           fsm->batch_size < EC_FSM_MASTER_BATCH_SIZE)
+    {
+        if (ec_fsm_master_group_member(fsm, fsm->slave))
+        {
+            datagram = ec_fsm_master_batch_datagram(fsm, fsm->batch_size);
+            if (ec_datagram_fprd(datagram, fsm->slave->station_address,
+                                 0x0130, 2))
+            {
+                EC_SLAVE_ERR(fsm->slave, "无法分配AL状态数据报文。\n");
+                break;
+            }
+            ec_datagram_zero(datagram);
+            datagram->device_index = fsm->slave->device_index;
+            fsm->batch_slaves[fsm->batch_size++] = fsm->slave;
+        }
         fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
+    }
+
+    if (fsm->batch_size)
+    {
+        fsm->retries = EC_FSM_RETRIES;
+        fsm->state = ec_fsm_master_state_group_read;
         return;
     }
 
-    if (datagram->working_counter != 1)
+    // 一轮检查结束
+    for (slave = master->slaves;
+         slave < master->slaves + master->slave_count;
+         slave++)
     {
-        EC_SLAVE_ERR(slave, "无法重置DC滤波器：");
-        ec_datagram_print_wc_error(datagram);
+        if (ec_fsm_master_group_member(fsm, slave))
+        {
+            pending++;
+        }
+    }
+
+    if (pending &&
+        time_after(jiffies, fsm->group_jiffies + EC_AL_GROUP_TIMEOUT * HZ))
+    {
+        for (slave = master->slaves;
+             slave < master->slaves + master->slave_count;
+             slave++)
+        {
+            if (ec_fsm_master_group_member(fsm, slave))
+            {
+                EC_SLAVE_WARN(slave, "分组状态转换超时，单独处理。\n");
+                slave->al_group = EC_AL_GROUP_NONE;
+            }
+        }
+        pending = 0;
+    }
+
+    if (pending)
+    {
+        fsm->slave = master->slaves;
+        ec_fsm_master_enter_group_read(fsm);
+        return;
+    }
+
+    EC_MASTER_DBG(master, 1, "%u个从站的分组状态转换结束，耗时 %lu 毫秒。\n",
+                  fsm->group_count,
+                  (jiffies - fsm->group_jiffies) * 1000 / HZ);
+    ec_fsm_master_restart(fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     主站状态：分组读取AL状态。
+ * @details   到达目标状态的从站离开分组。拒绝状态转换（设置了错误位）或
+ *            无法读取的从站也离开分组，由从站状态机确认错误并单独处理。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_state_group_read(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_datagram_t *datagram;
+    ec_slave_t *slave;
+    unsigned int i;
+    uint8_t state;
+
+    if (ec_fsm_master_batch_retry(fsm))
+        return;
+
+    for (i = 0; i < fsm->batch_size; i++)
+    {
+        slave = fsm->batch_slaves[i];
+
+        if (!ec_fsm_master_batch_check(fsm, i, "读取AL状态"))
+        {
+            slave->al_group = EC_AL_GROUP_NONE;
+            continue;
+        }
+
+        datagram = ec_fsm_master_batch_datagram(fsm, i);
+        state = EC_READ_U8(datagram->data);
+        ec_slave_set_al_status(slave, state);
+
+        if (state & EC_SLAVE_STATE_ACK_ERR)
+        {
+            EC_SLAVE_WARN(slave, "分组状态转换被拒绝，单独处理。\n");
+            slave->al_group = EC_AL_GROUP_NONE;
+        }
+        else if ((state & EC_SLAVE_STATE_MASK) == fsm->group_state)
+        {
+            slave->al_group = EC_AL_GROUP_NONE;
+        }
+    }
+
+    ec_fsm_master_enter_group_read(fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     主站动作：开始读取所有从站的错误计数器。
+ * @功能      到达采样间隔时，开始一次总线健康采样。
+ * @details   采样只在空闲动作中开始，优先级低于状态查询、配置和SII写入。
+ * @param     fsm 主站状态机指针。
+ * @retval    非零值，如果开始了采样。
+ */
+int ec_fsm_master_action_crc_monitor(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_master_t *master = fsm->master;
+
+    if (!master->slave_count || !ec_crc_monitor_due(&master->crc_monitor))
+    {
+        return 0;
+    }
+
+    ec_crc_monitor_start(&master->crc_monitor);
+    fsm->slave = master->slaves;
+    ec_fsm_master_enter_crc_read(fsm);
+    return 1;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     读取并清零下一批从站的错误计数器（0x0300 - 0x0313）。
+ * @details   FPRW数据报读出计数器，同时写入零把它们清零，因此读取的值
+ *            就是上一次采样以来的增量，饱和的计数器也能重新开始计数。
+ *            所有从站都读取后，结束本次采样。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_enter_crc_read(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_master_t *master = fsm->master;
+    ec_datagram_t *datagram;
+
+    fsm->batch_size = 0;
+
+    while (fsm->slave < master->slaves + master->slave_count &&
+           fsm->batch_size < EC_FSM_MASTER_BATCH_SIZE)
+    {
+        datagram = ec_fsm_master_batch_datagram(fsm, fsm->batch_size);
+        if (ec_datagram_fprw(datagram, fsm->slave->station_address,
+                             0x0300, EC_CRC_MONITOR_REG_SIZE))
+        {
+            EC_SLAVE_ERR(fsm->slave, "无法分配错误计数器数据报文。\n");
+            break;
+        }
+        ec_datagram_zero(datagram);
+        datagram->device_index = fsm->slave->device_index;
+        fsm->batch_slaves[fsm->batch_size++] = fsm->slave;
         fsm->slave++;
-        ec_fsm_master_enter_write_system_times(fsm);
+    }
+
+    if (fsm->batch_size)
+    {
+        fsm->retries = EC_FSM_RETRIES;
+        fsm->state = ec_fsm_master_state_crc_read;
         return;
     }
 
-    fsm->slave++;
-    ec_fsm_master_enter_write_system_times(fsm);
+    ec_crc_monitor_done(&master->crc_monitor);
+    ec_fsm_master_restart(fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief     主站状态：读取错误计数器。
+ * @details   没有应答的从站在本次采样中被跳过，不输出错误，
+ *            状态查询会处理不再应答的从站。
+ * @param     fsm 主站状态机指针。
+ * @retval    无返回值。
+ */
+void ec_fsm_master_state_crc_read(
+    ec_fsm_master_t *fsm /**< 主站状态机。 */
+)
+{
+    ec_datagram_t *datagram;
+    unsigned int i;
+
+    if (ec_fsm_master_batch_retry(fsm))
+        return;
+
+    for (i = 0; i < fsm->batch_size; i++)
+    {
+        datagram = ec_fsm_master_batch_datagram(fsm, i);
+        if (datagram->state == EC_DATAGRAM_RECEIVED &&
+            datagram->working_counter == 1)
+        {
+            ec_crc_counters_update(&fsm->batch_slaves[i]->crc_counters,
+                                   datagram->data);
+        }
+    }
+
+    ec_fsm_master_enter_crc_read(fsm);
 }
 
 /*****************************************************************************/
@@ -41,6 +41,15 @@
 
 /*****************************************************************************/
 
+/** 主站状态机一次注入的最大数据报数量（包括状态机的数据报）。
+ *
+ * 用于批量计算DC系统时间偏移。32个读取数据报（每个28字节数据）
+ * 可以放在一个以太网帧中。
+ */
+#define EC_FSM_MASTER_BATCH_SIZE 32
+
+/*****************************************************************************/
+
 /** SII写入请求。
  */
 typedef struct
@@ -76,6 +85,15 @@ struct ec_fsm_master
     ec_slave_t *slave;                                  /**< 当前从站 */
     ec_sii_write_request_t *sii_request;                /**< SII写入请求 */
     off_t sii_index;                                    /**< SII写入请求数据的索引 */
+    ec_datagram_t batch_datagrams[EC_FSM_MASTER_BATCH_SIZE - 1]; /**< 与状态机数据报一起注入的附加数据报 */
+    ec_slave_t *batch_slaves[EC_FSM_MASTER_BATCH_SIZE]; /**< 批量中每个数据报的从站 */
+    unsigned int batch_size;                            /**< 批量中的数据报数量，0表示不使用批量 */
+    unsigned long dc_jiffies;                           /**< DC偏移计算开始时间 */
+    unsigned int dc_slave_count;                        /**< 已处理DC偏移的从站数 */
+    ec_slave_state_t group_state;                       /**< 分组转换的目标状态 */
+    unsigned int group_broadcast;                       /**< 用一个广播写入请求状态 */
+    unsigned int group_count;                           /**< 分组转换的从站数 */
+    unsigned long group_jiffies;                        /**< 分组转换开始时间 */
 
     ec_fsm_reboot_t fsm_reboot; /**< 从站重启状态机 */
     ec_fsm_sii_t fsm_sii;       /**< SII状态机 */
@@ -90,6 +108,7 @@ void ec_fsm_master_reset(ec_fsm_master_t *);
 
 int ec_fsm_master_exec(ec_fsm_master_t *);
 int ec_fsm_master_idle(const ec_fsm_master_t *);
+void ec_fsm_master_queue_batch(ec_fsm_master_t *);
 
 /*****************************************************************************/
 
@@ -222,6 +222,7 @@ int ec_fsm_slave_exec(
     if (datagram_used)
     {
         datagram->device_index = fsm->slave->device_index;
+        datagram->sched_class = ec_fsm_slave_sched_class(fsm);
         fsm->datagram = datagram;
     }
     else
@@ -440,6 +441,12 @@ int ec_fsm_slave_action_config(
         return 1;
     }
 
+    if (slave->al_group == EC_AL_GROUP_READY)
+    {
+        // 等待主站的分组状态转换
+        return 0;
+    }
+
     // 从站是否需要进行配置？
     if (slave->current_state != slave->requested_state || slave->force_config)
     {
@@ -558,6 +565,31 @@ void ec_fsm_slave_state_config(
 
 /*****************************************************************************/
 
+/**
+ * @brief 尝试从字典缓存建立从站的对象字典。
+ *
+ * @return 非零值，如果字典已从缓存建立。
+ *
+ * @details 同类型的从站已上传过字典时，直接复制缓存的字典，省去SDO信息的邮箱交换。
+ */
+static int ec_fsm_slave_dict_from_cache(
+    ec_fsm_slave_t *fsm /**< 从站状态机 */
+)
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (ec_dict_cache_apply(&slave->master->dict_cache, slave))
+    {
+        return 0;
+    }
+
+    slave->sdo_dictionary_fetched = 1;
+    ec_slave_attach_pdo_names(slave);
+    return 1;
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 检查是否存在待处理的SDO字典读取请求。
  *
@@ -617,6 +649,16 @@ int ec_fsm_slave_action_process_dict(
             return 1;
         }
 
+        if (ec_fsm_slave_dict_from_cache(fsm))
+        {
+            EC_SLAVE_DBG(slave, 1, "字典请求由缓存完成。\n");
+            request->state = EC_INT_REQUEST_SUCCESS;
+            wake_up_all(&slave->master->request_queue);
+            fsm->dict_request = NULL;
+            fsm->state = ec_fsm_slave_state_ready;
+            return 1;
+        }
+
         if (slave->current_state & EC_SLAVE_STATE_ACK_ERR)
         {
             EC_SLAVE_WARN(slave, "中止字典请求，从站错误标志已设置。\n");
@@ -657,6 +699,11 @@ int ec_fsm_slave_action_process_dict(
         return 0;
     }
 
+    if (ec_fsm_slave_dict_from_cache(fsm))
+    {
+        return 0;
+    }
+
     fsm->dict_request = &fsm->int_dict_request;
     fsm->int_dict_request.state = EC_INT_REQUEST_BUSY;
 
@@ -716,6 +763,9 @@ void ec_fsm_slave_state_dict_request(
     // 字典请求完成
     slave->sdo_dictionary_fetched = 1;
 
+    // 供同类型的其他从站使用
+    ec_dict_cache_store(&slave->master->dict_cache, slave);
+
     // 附加PDO名称到字典
     ec_slave_attach_pdo_names(slave);
 
@@ -830,6 +880,45 @@ int ec_fsm_slave_is_ready(
     return fsm->state == ec_fsm_slave_state_ready;
 }
 
+/*****************************************************************************/
+
+/**
+ * @brief 获取状态机当前数据报的调度类别。
+ *
+ * @param fsm 从站状态机
+ * @return 正在处理的请求对应的类别，扫描和配置属于状态机类别。
+ */
+ec_sched_class_t ec_fsm_slave_sched_class(
+    const ec_fsm_slave_t *fsm /**< 从站状态机 */
+)
+{
+    if (fsm->state == ec_fsm_slave_state_sdo_request ||
+        fsm->state == ec_fsm_slave_state_soe_request ||
+        fsm->state == ec_fsm_slave_state_dict_request)
+    {
+        return EC_SCHED_COE;
+    }
+    if (fsm->state == ec_fsm_slave_state_foe_request)
+    {
+        return EC_SCHED_FOE;
+    }
+#ifdef EC_EOE
+    if (fsm->state == ec_fsm_slave_state_eoe_request)
+    {
+        return EC_SCHED_EOE;
+    }
+#endif
+    if (fsm->state == ec_fsm_slave_state_mbg_request)
+    {
+        return EC_SCHED_MBG;
+    }
+    if (fsm->state == ec_fsm_slave_state_reg_request)
+    {
+        return EC_SCHED_REG;
+    }
+    return EC_SCHED_FSM;
+}
+
 /******************************************************************************
  * Slave state machine
  *****************************************************************************/
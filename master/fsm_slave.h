@@ -53,6 +53,7 @@
 #include "fsm_mbox_gateway.h"
 #include "fsm_slave_config.h"
 #include "fsm_slave_scan.h"
+#include "scheduler.h"
 
 /*****************************************************************************/
 
@@ -101,6 +102,7 @@ int ec_fsm_slave_exec(ec_fsm_slave_t *, ec_datagram_t *); // 执行从站的有
 void ec_fsm_slave_set_ready(ec_fsm_slave_t *); // 设置从站的有限状态机为准备就绪状态
 int ec_fsm_slave_set_unready(ec_fsm_slave_t *); // 设置从站的有限状态机为未准备就绪状态
 int ec_fsm_slave_is_ready(const ec_fsm_slave_t *); // 检查从站的有限状态机是否准备就绪
+ec_sched_class_t ec_fsm_slave_sched_class(const ec_fsm_slave_t *); // 当前数据报的调度类别
 #endif
 
 
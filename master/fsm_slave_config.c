@@ -104,8 +104,11 @@ void ec_fsm_slave_config_enter_watchdog_divider(ec_fsm_slave_config_t *, ec_data
 void ec_fsm_slave_config_enter_watchdog(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_pdo_sync(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_fmmu(ec_fsm_slave_config_t *, ec_datagram_t *);
+void ec_fsm_slave_config_status_fmmu(ec_fsm_slave_config_t *, ec_datagram_t *,
+                                     unsigned int);
 void ec_fsm_slave_config_enter_dc_cycle(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_safeop(ec_fsm_slave_config_t *, ec_datagram_t *);
+int ec_fsm_slave_config_enter_group(ec_fsm_slave_config_t *, ec_slave_state_t);
 void ec_fsm_slave_config_enter_soe_conf_safeop(ec_fsm_slave_config_t *, ec_datagram_t *);
 void ec_fsm_slave_config_enter_op(ec_fsm_slave_config_t *, ec_datagram_t *);
 
@@ -363,6 +366,8 @@ void ec_fsm_slave_config_state_init(
     ec_datagram_fpwr(datagram, slave->station_address,
                      0x0600, EC_FMMU_PAGE_SIZE * slave->base_fmmu_count);
     ec_datagram_zero(datagram);
+    ec_fsm_slave_config_status_fmmu(fsm, datagram,
+                                    slave->config ? slave->config->used_fmmus : 0);
     fsm->retries = EC_FSM_RETRIES;
     fsm->state = ec_fsm_slave_config_state_clear_fmmus;
 
@@ -411,6 +416,8 @@ void ec_fsm_slave_config_state_clear_fmmus(
         return;
     }
 
+    fsm->slave->status_mapped = fsm->status_fmmu;
+
     ec_fsm_slave_config_enter_clear_sync(fsm, datagram);
 }
 
@@ -1741,6 +1748,37 @@ void ec_fsm_slave_config_state_pdo_sync(
 
 /*****************************************************************************/
 
+/**
+@brief 在FMMU配置数据报中加入状态域的FMMU。
+@param fsm 从站状态机
+@param datagram 已填充FMMU页面的数据报
+@param used_fmmus 从站配置使用的FMMU数量
+@return 无
+@details
+在写入之前从站的状态映射视为无效，写入成功后再根据status_fmmu设置。
+*/
+void ec_fsm_slave_config_status_fmmu(
+    ec_fsm_slave_config_t *fsm, /**< 从站状态机 */
+    ec_datagram_t *datagram,    /**< 使用的数据报 */
+    unsigned int used_fmmus     /**< 已使用的FMMU数量 */
+)
+{
+    ec_slave_t *slave = fsm->slave;
+    int index = ec_status_domain_fmmu(&slave->master->status_domain,
+                                      slave, used_fmmus);
+
+    slave->status_mapped = 0;
+    fsm->status_fmmu = index >= 0;
+
+    if (fsm->status_fmmu)
+    {
+        ec_status_domain_fmmu_page(slave,
+                                   datagram->data + EC_FMMU_PAGE_SIZE * index);
+    }
+}
+
+/*****************************************************************************/
+
 /**
 @brief 检查是否需要配置FMMU。
 @param fsm 从站状态机
@@ -1820,6 +1858,7 @@ void ec_fsm_slave_config_enter_fmmu(
         ec_fmmu_config_page(fmmu, sync,
                             datagram->data + EC_FMMU_PAGE_SIZE * i);
     }
+    ec_fsm_slave_config_status_fmmu(fsm, datagram, slave->config->used_fmmus);
 
     fsm->retries = EC_FSM_RETRIES;
     fsm->state = ec_fsm_slave_config_state_fmmu;
@@ -1880,6 +1919,8 @@ void ec_fsm_slave_config_state_fmmu(
         return;
     }
 
+    slave->status_mapped = fsm->status_fmmu;
+
     ec_fsm_slave_config_enter_dc_cycle(fsm, datagram);
 }
 
@@ -2361,6 +2402,9 @@ void ec_fsm_slave_config_enter_safeop(
     ec_datagram_t *datagram     /**< 使用的数据报 */
 )
 {
+    if (ec_fsm_slave_config_enter_group(fsm, EC_SLAVE_STATE_SAFEOP))
+        return;
+
     fsm->state = ec_fsm_slave_config_state_safeop;
     ec_fsm_change_start(fsm->fsm_change, fsm->slave, EC_SLAVE_STATE_SAFEOP);
     ec_fsm_change_exec(fsm->fsm_change, datagram); // 立即执行
@@ -2368,6 +2412,38 @@ void ec_fsm_slave_config_enter_safeop(
 
 /*****************************************************************************/
 
+/**
+@brief 把最后一次状态转换交给主站的分组转换。
+@param fsm 从站状态机
+@param state 下一个状态
+@return 如果转换交给了主站，返回非零值。
+@details
+只有从站属于分组转换并且\a state 是请求的状态时才交给主站。配置在这里
+成功结束，主站状态机写入AL控制寄存器并检查结果；被拒绝或超时的从站退出
+分组，由从站状态机单独处理。
+*/
+
+int ec_fsm_slave_config_enter_group(
+    ec_fsm_slave_config_t *fsm, /**< 从站状态机 */
+    ec_slave_state_t state      /**< 下一个状态 */
+)
+{
+    ec_slave_t *slave = fsm->slave;
+
+    if (slave->al_group != EC_AL_GROUP_MEMBER ||
+        slave->requested_state != state)
+    {
+        return 0;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "等待分组状态转换。\n");
+    slave->al_group = EC_AL_GROUP_READY;
+    fsm->state = ec_fsm_slave_config_state_end;
+    return 1;
+}
+
+/*****************************************************************************/
+
 /**
 @brief 从站配置状态：SAFEOP。
 @param fsm 从站状态机
@@ -2569,6 +2645,9 @@ void ec_fsm_slave_config_enter_op(
     ec_datagram_t *datagram     /**< 使用的数据报 */
 )
 {
+    if (ec_fsm_slave_config_enter_group(fsm, EC_SLAVE_STATE_OP))
+        return;
+
     // 将状态设置为OP
     fsm->state = ec_fsm_slave_config_state_op;
     ec_fsm_change_start(fsm->fsm_change, fsm->slave, EC_SLAVE_STATE_OP);
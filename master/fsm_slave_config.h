@@ -69,6 +69,7 @@ struct ec_fsm_slave_config
     unsigned long last_diff_ms;                              /**< 用于同步报告。 */
     unsigned long jiffies_start;                             /**< 用于超时计算。 */
     unsigned int take_time;                                  /**< 在接收数据报后存储jiffies。 */
+    unsigned int status_fmmu;                                /**< FMMU数据报包含状态域的映射。 */
 };
 
 /*****************************************************************************/
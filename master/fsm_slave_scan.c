@@ -437,7 +437,7 @@ void ec_fsm_slave_scan_state_state(
         return;
     }
 
-    slave->current_state = EC_READ_U8(fsm->datagram->data);
+    ec_slave_set_al_status(slave, EC_READ_U8(fsm->datagram->data));
     if (slave->current_state & EC_SLAVE_STATE_ACK_ERR)
     {
         char state_str[EC_STATE_STRING_SIZE];
@@ -71,6 +71,9 @@
 /** 维护的统计速率间隔数。 */
 #define EC_RATE_COUNT 3
 
+/** 热路径直方图的桶数（以2为底的对数刻度）。 */
+#define EC_HIST_BUCKETS 32
+
 /******************************************************************************
  * EtherCAT协议
  *****************************************************************************/
@@ -248,6 +251,23 @@ extern const char *ec_device_names[2]; // 仅主设备和备份设备！
 
 /*****************************************************************************/
 
+/** 主站热路径直方图。
+ */
+typedef enum
+{
+    EC_HIST_SEND,           /**< ecrt_master_send()的耗时 [ns]。 */
+    EC_HIST_RECEIVE,        /**< ecrt_master_receive()的耗时（轮询和分发）[ns]。 */
+    EC_HIST_ROUND_TRIP,     /**< 数据报往返时间 [ns]。 */
+    EC_HIST_HW_ROUND_TRIP,  /**< 网卡时间戳测量的往返时间 [ns]。 */
+    EC_HIST_FRAMES,         /**< 每周期发送的帧数。 */
+    EC_HIST_BYTES,          /**< 每周期发送的字节数。 */
+    EC_HIST_CYCLIC_LATENCY, /**< 周期引擎的唤醒延迟 [ns]。 */
+    EC_HIST_CYCLIC_EXEC,    /**< 周期引擎每个周期的执行时间 [ns]。 */
+    EC_HIST_COUNT           /**< 直方图数量。 */
+} ec_hist_index_t;
+
+/*****************************************************************************/
+
 /** 打印EtherCAT特定信息到syslog的便捷宏。
  *
  * 这将使用带有前缀“EtherCAT：”的\a fmt打印消息。
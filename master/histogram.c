@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   主站热路径直方图。
+*/
+
+/*****************************************************************************/
+
+#include <linux/string.h>
+
+#include "histogram.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief 清空直方图。
+ * @param hist 直方图。
+ */
+void ec_histogram_clear(
+    ec_histogram_t *hist /**< 直方图 */
+)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 计算自基线以来的直方图。
+ * @param dst 结果。
+ * @param live 当前直方图。
+ * @param base 上次复位时保存的基线。
+ * @details 复位时不修改写入端的计数器，而是保存一份基线，读取时再相减，
+ * 这样写入端始终不需要加锁。最大值无法相减，复位时直接清零（见
+ * ec_master_reset_histograms()）。
+ */
+void ec_histogram_diff(
+    ec_histogram_t *dst,        /**< 结果 */
+    const ec_histogram_t *live, /**< 当前直方图 */
+    const ec_histogram_t *base  /**< 基线 */
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_HIST_BUCKETS; i++)
+    {
+        dst->buckets[i] = live->buckets[i] - base->buckets[i];
+    }
+    dst->count = live->count - base->count;
+    dst->sum = live->sum - base->sum;
+    dst->max = live->max;
+}
+
+/*****************************************************************************/
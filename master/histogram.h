@@ -0,0 +1,156 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   主站热路径直方图。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_HISTOGRAM_H__
+#define __EC_HISTOGRAM_H__
+
+#include <linux/types.h>
+#include <linux/bitops.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#ifdef EC_HAVE_CYCLES
+#include <linux/timex.h>
+#endif
+
+#include "globals.h"
+
+/*****************************************************************************/
+
+/** 以2为底的对数刻度直方图。
+ *
+ * 桶0统计值0，桶i（i > 0）统计范围[2^(i-1), 2^i)内的值，超出范围的值计入
+ * 最后一个桶。
+ *
+ * 直方图只由一个上下文写入（调用ecrt_master_send()/ecrt_master_receive()的
+ * 上下文，二者不会并发执行），因此写入端不需要锁。读取端不加锁复制，
+ * 可能看到正在进行的单次更新，这对统计来说可以接受。
+ */
+typedef struct
+{
+    u32 buckets[EC_HIST_BUCKETS]; /**< 各桶的计数。 */
+    u64 count;                    /**< 样本数。 */
+    u64 sum;                      /**< 样本之和。 */
+    u32 max;                      /**< 最大样本值。 */
+} ec_histogram_t;
+
+/*****************************************************************************/
+
+void ec_histogram_clear(ec_histogram_t *);
+void ec_histogram_diff(ec_histogram_t *, const ec_histogram_t *,
+                       const ec_histogram_t *);
+
+/*****************************************************************************/
+
+/**
+ * @brief 向直方图添加一个样本。
+ * @param hist 直方图。
+ * @param value 样本值。
+ */
+static inline void ec_histogram_add(
+    ec_histogram_t *hist, /**< 直方图 */
+    u32 value             /**< 样本值 */
+)
+{
+    unsigned int bucket = fls(value);
+
+    if (unlikely(bucket >= EC_HIST_BUCKETS))
+    {
+        bucket = EC_HIST_BUCKETS - 1;
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max)
+    {
+        hist->max = value;
+    }
+}
+
+/*****************************************************************************/
+
+#ifdef EC_HAVE_CYCLES
+typedef cycles_t ec_hist_time_t; /**< 直方图时间戳类型。 */
+#else
+typedef u64 ec_hist_time_t; /**< 直方图时间戳类型。 */
+#endif
+
+/**
+ * @brief 获取直方图时间戳。
+ * @return 有周期计数器时为CPU周期，否则为单调时钟纳秒。
+ */
+static inline ec_hist_time_t ec_hist_now(void)
+{
+#ifdef EC_HAVE_CYCLES
+    return get_cycles();
+#else
+    return ktime_to_ns(ktime_get());
+#endif
+}
+
+#ifdef EC_HAVE_CYCLES
+/**
+ * @brief 把CPU周期数转换为纳秒。
+ * @param cycles CPU周期数。
+ * @return 纳秒（饱和到32位）。
+ */
+static inline u32 ec_hist_cycles_to_ns(cycles_t cycles)
+{
+    u64 ns = div_u64((u64)cycles * 1000000ULL, cpu_khz);
+
+    return ns > U32_MAX ? U32_MAX : (u32)ns;
+}
+#endif
+
+/**
+ * @brief 计算从给定时间戳到现在经过的纳秒数。
+ * @param start 起始时间戳（见ec_hist_now()）。
+ * @return 经过的纳秒数（饱和到32位）。
+ */
+static inline u32 ec_hist_elapsed_ns(ec_hist_time_t start)
+{
+#ifdef EC_HAVE_CYCLES
+    return ec_hist_cycles_to_ns(get_cycles() - start);
+#else
+    u64 ns = ktime_to_ns(ktime_get()) - start;
+
+    return ns > U32_MAX ? U32_MAX : (u32)ns;
+#endif
+}
+
+/*****************************************************************************/
+
+#endif
@@ -36,6 +36,7 @@
 
 #include <linux/module.h>
 #include <linux/vmalloc.h>
+#include <linux/jhash.h>
 
 #include "master.h"
 #include "slave_config.h"
@@ -100,6 +101,271 @@ static void ec_ioctl_strcpy(
 
 /*****************************************************************************/
 
+/**
+ * @brief 填写从站信息。
+ *
+ * @param data 要填写的ioctl结构。
+ * @param slave EtherCAT从站。
+ *
+ * @details EC_IOCTL_SLAVE和EC_IOCTL_SNAPSHOT共用。
+ */
+static void ec_ioctl_fill_slave(
+    ec_ioctl_slave_t *data, /**< 要填写的ioctl结构。 */
+    const ec_slave_t *slave /**< EtherCAT从站。 */
+)
+{
+    int i;
+
+    data->device_index = slave->device_index;
+    data->alias = slave->effective_alias;
+    if (slave->sii_image)
+    {
+        data->vendor_id = slave->sii_image->sii.vendor_id;
+        data->product_code = slave->sii_image->sii.product_code;
+        data->revision_number = slave->sii_image->sii.revision_number;
+        data->serial_number = slave->sii_image->sii.serial_number;
+        data->boot_rx_mailbox_offset = slave->sii_image->sii.boot_rx_mailbox_offset;
+        data->boot_rx_mailbox_size = slave->sii_image->sii.boot_rx_mailbox_size;
+        data->boot_tx_mailbox_offset = slave->sii_image->sii.boot_tx_mailbox_offset;
+        data->boot_tx_mailbox_size = slave->sii_image->sii.boot_tx_mailbox_size;
+        data->std_rx_mailbox_offset = slave->sii_image->sii.std_rx_mailbox_offset;
+        data->std_rx_mailbox_size = slave->sii_image->sii.std_rx_mailbox_size;
+        data->std_tx_mailbox_offset = slave->sii_image->sii.std_tx_mailbox_offset;
+        data->std_tx_mailbox_size = slave->sii_image->sii.std_tx_mailbox_size;
+        data->mailbox_protocols = slave->sii_image->sii.mailbox_protocols;
+        data->has_general_category = slave->sii_image->sii.has_general;
+        data->coe_details = slave->sii_image->sii.coe_details;
+        data->general_flags = slave->sii_image->sii.general_flags;
+        data->current_on_ebus = slave->sii_image->sii.current_on_ebus;
+        data->sync_count = slave->sii_image->sii.sync_count;
+        data->sii_nwords = slave->sii_image->nwords;
+        ec_ioctl_strcpy(data->group, slave->sii_image->sii.group);
+        ec_ioctl_strcpy(data->image, slave->sii_image->sii.image);
+        ec_ioctl_strcpy(data->order, slave->sii_image->sii.order);
+        ec_ioctl_strcpy(data->name, slave->sii_image->sii.name);
+    }
+    else
+    {
+        data->vendor_id = 0x00000000;
+        data->product_code = 0x00000000;
+        data->revision_number = 0x00000000;
+        data->serial_number = 0x00000000;
+        data->boot_rx_mailbox_offset = 0x0000;
+        data->boot_rx_mailbox_size = 0x0000;
+        data->boot_tx_mailbox_offset = 0x0000;
+        data->boot_tx_mailbox_size = 0x0000;
+        data->std_rx_mailbox_offset = 0x0000;
+        data->std_rx_mailbox_size = 0x0000;
+        data->std_tx_mailbox_offset = 0x0000;
+        data->std_tx_mailbox_size = 0x0000;
+        data->mailbox_protocols = 0;
+        data->has_general_category = 0;
+        data->coe_details.enable_pdo_assign = 0;
+        data->coe_details.enable_pdo_configuration = 0;
+        data->coe_details.enable_sdo = 0;
+        data->coe_details.enable_sdo_complete_access = 0;
+        data->coe_details.enable_sdo_info = 0;
+        data->coe_details.enable_upload_at_startup = 0;
+        data->general_flags.enable_not_lrw = 0;
+        data->general_flags.enable_safeop = 0;
+        data->sync_count = 0;
+        data->sii_nwords = 0;
+        ec_ioctl_strcpy(data->group, "");
+        ec_ioctl_strcpy(data->image, "");
+        ec_ioctl_strcpy(data->order, "");
+        ec_ioctl_strcpy(data->name, "");
+    }
+
+    for (i = 0; i < EC_MAX_PORTS; i++)
+    {
+        data->ports[i].desc = slave->ports[i].desc;
+        data->ports[i].link.link_up = slave->ports[i].link.link_up;
+        data->ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
+        data->ports[i].link.signal_detected =
+            slave->ports[i].link.signal_detected;
+        data->ports[i].link.bypassed = slave->ports[i].link.bypassed;
+        data->ports[i].receive_time = slave->ports[i].receive_time;
+        if (slave->ports[i].next_slave)
+        {
+            data->ports[i].next_slave =
+                slave->ports[i].next_slave->ring_position;
+        }
+        else
+        {
+            data->ports[i].next_slave = 0xffff;
+        }
+        data->ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
+    }
+    data->upstream_port = slave->upstream_port;
+    data->fmmu_bit = slave->base_fmmu_bit_operation;
+    data->dc_supported = slave->base_dc_supported;
+    data->dc_range = slave->base_dc_range;
+    data->has_dc_system_time = slave->has_dc_system_time;
+    data->transmission_delay = slave->transmission_delay;
+    data->al_state = slave->current_state;
+    data->error_flag = slave->error_flag;
+    data->scan_required = slave->scan_required;
+    data->sdo_count = ec_slave_sdo_count(slave);
+    data->ready = ec_fsm_slave_is_ready(&slave->fsm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写从站同步管理器信息。
+ */
+static void ec_ioctl_fill_slave_sync(
+    ec_ioctl_slave_sync_t *data, /**< 要填写的ioctl结构。 */
+    const ec_sync_t *sync        /**< 同步管理器。 */
+)
+{
+    data->physical_start_address = sync->physical_start_address;
+    data->default_size = sync->default_length;
+    data->control_register = sync->control_register;
+    data->enable = sync->enable;
+    data->pdo_count = ec_pdo_list_count(&sync->pdos);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写从站同步管理器PDO信息。
+ */
+static void ec_ioctl_fill_slave_sync_pdo(
+    ec_ioctl_slave_sync_pdo_t *data, /**< 要填写的ioctl结构。 */
+    const ec_pdo_t *pdo              /**< PDO。 */
+)
+{
+    data->index = pdo->index;
+    data->entry_count = ec_pdo_entry_count(pdo);
+    ec_ioctl_strcpy(data->name, pdo->name);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写从站同步管理器PDO条目信息。
+ */
+static void ec_ioctl_fill_slave_sync_pdo_entry(
+    ec_ioctl_slave_sync_pdo_entry_t *data, /**< 要填写的ioctl结构。 */
+    const ec_pdo_entry_t *entry            /**< PDO条目。 */
+)
+{
+    data->index = entry->index;
+    data->subindex = entry->subindex;
+    data->bit_length = entry->bit_length;
+    ec_ioctl_strcpy(data->name, entry->name);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写域信息。
+ */
+static void ec_ioctl_fill_domain(
+    ec_ioctl_domain_t *data,  /**< 要填写的ioctl结构。 */
+    const ec_domain_t *domain /**< EtherCAT域。 */
+)
+{
+    unsigned int dev_idx;
+
+    data->data_size = domain->data_size;
+    data->logical_base_address = domain->logical_base_address;
+    for (dev_idx = EC_DEVICE_MAIN;
+         dev_idx < ec_master_num_devices(domain->master); dev_idx++)
+    {
+        data->working_counter[dev_idx] = domain->working_counter[dev_idx];
+    }
+    data->expected_working_counter = domain->expected_working_counter;
+    data->fmmu_count = ec_domain_fmmu_count(domain);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写域FMMU信息。
+ */
+static void ec_ioctl_fill_domain_fmmu(
+    ec_ioctl_domain_fmmu_t *data, /**< 要填写的ioctl结构。 */
+    const ec_fmmu_config_t *fmmu  /**< FMMU配置。 */
+)
+{
+    data->slave_config_alias = fmmu->sc->alias;
+    data->slave_config_position = fmmu->sc->position;
+    data->sync_index = fmmu->sync_index;
+    data->dir = fmmu->dir;
+    data->logical_address = fmmu->domain->logical_base_address + fmmu->logical_domain_offset;
+    data->data_size = fmmu->data_size;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写从站配置信息。
+ */
+static void ec_ioctl_fill_config(
+    ec_ioctl_config_t *data,     /**< 要填写的ioctl结构。 */
+    const ec_slave_config_t *sc  /**< 从站配置。 */
+)
+{
+    uint8_t i;
+
+    data->alias = sc->alias;
+    data->position = sc->position;
+    data->vendor_id = sc->vendor_id;
+    data->product_code = sc->product_code;
+    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++)
+    {
+        data->syncs[i].dir = sc->sync_configs[i].dir;
+        data->syncs[i].watchdog_mode = sc->sync_configs[i].watchdog_mode;
+        data->syncs[i].pdo_count =
+            ec_pdo_list_count(&sc->sync_configs[i].pdos);
+    }
+    data->watchdog_divider = sc->watchdog_divider;
+    data->watchdog_intervals = sc->watchdog_intervals;
+    data->sdo_count = ec_slave_config_sdo_count(sc);
+    data->idn_count = ec_slave_config_idn_count(sc);
+    data->slave_position = sc->slave ? sc->slave->ring_position : -1;
+    data->dc_assign_activate = sc->dc_assign_activate;
+    for (i = 0; i < EC_SYNC_SIGNAL_COUNT; i++)
+    {
+        data->dc_sync[i] = sc->dc_sync[i];
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写从站配置的PDO信息。
+ */
+static void ec_ioctl_fill_config_pdo(
+    ec_ioctl_config_pdo_t *data, /**< 要填写的ioctl结构。 */
+    const ec_pdo_t *pdo          /**< PDO。 */
+)
+{
+    data->index = pdo->index;
+    data->entry_count = ec_pdo_entry_count(pdo);
+    ec_ioctl_strcpy(data->name, pdo->name);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 填写从站配置的PDO条目信息。
+ */
+static void ec_ioctl_fill_config_pdo_entry(
+    ec_ioctl_config_pdo_entry_t *data, /**< 要填写的ioctl结构。 */
+    const ec_pdo_entry_t *entry        /**< PDO条目。 */
+)
+{
+    data->index = entry->index;
+    data->subindex = entry->subindex;
+    data->bit_length = entry->bit_length;
+    ec_ioctl_strcpy(data->name, entry->name);
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 获取模块信息。
  *
@@ -188,6 +454,10 @@ static ATTRIBUTES int ec_ioctl_master(
         io.devices[dev_idx].tx_bytes = device->tx_bytes;
         io.devices[dev_idx].rx_bytes = device->rx_bytes;
         io.devices[dev_idx].tx_errors = device->tx_errors;
+        io.devices[dev_idx].rtt_samples = device->rtt.samples;
+        io.devices[dev_idx].rtt_ns = device->rtt.srtt_ns;
+        io.devices[dev_idx].rtt_var_ns = device->rtt.rttvar_ns;
+        io.devices[dev_idx].rtt_peak_ns = device->rtt.peak_ns;
         for (j = 0; j < EC_RATE_COUNT; j++)
         {
             io.devices[dev_idx].tx_frame_rates[j] =
@@ -227,14 +497,15 @@ static ATTRIBUTES int ec_ioctl_master(
     io.ref_clock =
         master->dc_ref_clock ? master->dc_ref_clock->ring_position : 0xffff;
 
-    if (master->pcap_data)
+    if (master->pcap.mem)
     {
-        io.pcap_size = sizeof(pcap_hdr_t) + pcap_size;
+        io.pcap_size = sizeof(pcap_hdr_t) + master->pcap.header->data_size;
     }
     else
     {
         io.pcap_size = 0;
     }
+    io.emerg_map_size = master->emerg_journal.mem_size;
 
     if (copy_to_user((void __user *)arg, &io, sizeof(io)))
     {
@@ -263,7 +534,6 @@ static ATTRIBUTES int ec_ioctl_slave(
 {
     ec_ioctl_slave_t data;
     const ec_slave_t *slave;
-    int i;
 
     if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
     {
@@ -281,97 +551,7 @@ static ATTRIBUTES int ec_ioctl_slave(
         return -EINVAL;
     }
 
-    data.device_index = slave->device_index;
-    data.alias = slave->effective_alias;
-    if (slave->sii_image)
-    {
-        data.vendor_id = slave->sii_image->sii.vendor_id;
-        data.product_code = slave->sii_image->sii.product_code;
-        data.revision_number = slave->sii_image->sii.revision_number;
-        data.serial_number = slave->sii_image->sii.serial_number;
-        data.boot_rx_mailbox_offset = slave->sii_image->sii.boot_rx_mailbox_offset;
-        data.boot_rx_mailbox_size = slave->sii_image->sii.boot_rx_mailbox_size;
-        data.boot_tx_mailbox_offset = slave->sii_image->sii.boot_tx_mailbox_offset;
-        data.boot_tx_mailbox_size = slave->sii_image->sii.boot_tx_mailbox_size;
-        data.std_rx_mailbox_offset = slave->sii_image->sii.std_rx_mailbox_offset;
-        data.std_rx_mailbox_size = slave->sii_image->sii.std_rx_mailbox_size;
-        data.std_tx_mailbox_offset = slave->sii_image->sii.std_tx_mailbox_offset;
-        data.std_tx_mailbox_size = slave->sii_image->sii.std_tx_mailbox_size;
-        data.mailbox_protocols = slave->sii_image->sii.mailbox_protocols;
-        data.has_general_category = slave->sii_image->sii.has_general;
-        data.coe_details = slave->sii_image->sii.coe_details;
-        data.general_flags = slave->sii_image->sii.general_flags;
-        data.current_on_ebus = slave->sii_image->sii.current_on_ebus;
-        data.sync_count = slave->sii_image->sii.sync_count;
-        data.sii_nwords = slave->sii_image->nwords;
-        ec_ioctl_strcpy(data.group, slave->sii_image->sii.group);
-        ec_ioctl_strcpy(data.image, slave->sii_image->sii.image);
-        ec_ioctl_strcpy(data.order, slave->sii_image->sii.order);
-        ec_ioctl_strcpy(data.name, slave->sii_image->sii.name);
-    }
-    else
-    {
-        data.vendor_id = 0x00000000;
-        data.product_code = 0x00000000;
-        data.revision_number = 0x00000000;
-        data.serial_number = 0x00000000;
-        data.boot_rx_mailbox_offset = 0x0000;
-        data.boot_rx_mailbox_size = 0x0000;
-        data.boot_tx_mailbox_offset = 0x0000;
-        data.boot_tx_mailbox_size = 0x0000;
-        data.std_rx_mailbox_offset = 0x0000;
-        data.std_rx_mailbox_size = 0x0000;
-        data.std_tx_mailbox_offset = 0x0000;
-        data.std_tx_mailbox_size = 0x0000;
-        data.mailbox_protocols = 0;
-        data.has_general_category = 0;
-        data.coe_details.enable_pdo_assign = 0;
-        data.coe_details.enable_pdo_configuration = 0;
-        data.coe_details.enable_sdo = 0;
-        data.coe_details.enable_sdo_complete_access = 0;
-        data.coe_details.enable_sdo_info = 0;
-        data.coe_details.enable_upload_at_startup = 0;
-        data.general_flags.enable_not_lrw = 0;
-        data.general_flags.enable_safeop = 0;
-        data.sync_count = 0;
-        data.sii_nwords = 0;
-        ec_ioctl_strcpy(data.group, "");
-        ec_ioctl_strcpy(data.image, "");
-        ec_ioctl_strcpy(data.order, "");
-        ec_ioctl_strcpy(data.name, "");
-    }
-
-    for (i = 0; i < EC_MAX_PORTS; i++)
-    {
-        data.ports[i].desc = slave->ports[i].desc;
-        data.ports[i].link.link_up = slave->ports[i].link.link_up;
-        data.ports[i].link.loop_closed = slave->ports[i].link.loop_closed;
-        data.ports[i].link.signal_detected =
-            slave->ports[i].link.signal_detected;
-        data.ports[i].link.bypassed = slave->ports[i].link.bypassed;
-        data.ports[i].receive_time = slave->ports[i].receive_time;
-        if (slave->ports[i].next_slave)
-        {
-            data.ports[i].next_slave =
-                slave->ports[i].next_slave->ring_position;
-        }
-        else
-        {
-            data.ports[i].next_slave = 0xffff;
-        }
-        data.ports[i].delay_to_next_dc = slave->ports[i].delay_to_next_dc;
-    }
-    data.upstream_port = slave->upstream_port;
-    data.fmmu_bit = slave->base_fmmu_bit_operation;
-    data.dc_supported = slave->base_dc_supported;
-    data.dc_range = slave->base_dc_range;
-    data.has_dc_system_time = slave->has_dc_system_time;
-    data.transmission_delay = slave->transmission_delay;
-    data.al_state = slave->current_state;
-    data.error_flag = slave->error_flag;
-    data.scan_required = slave->scan_required;
-    data.sdo_count = ec_slave_sdo_count(slave);
-    data.ready = ec_fsm_slave_is_ready(&slave->fsm);
+    ec_ioctl_fill_slave(&data, slave);
 
     ec_lock_up(&master->master_sem);
 
@@ -431,11 +611,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync(
 
         sync = &slave->sii_image->sii.syncs[data.sync_index];
 
-        data.physical_start_address = sync->physical_start_address;
-        data.default_size = sync->default_length;
-        data.control_register = sync->control_register;
-        data.enable = sync->enable;
-        data.pdo_count = ec_pdo_list_count(&sync->pdos);
+        ec_ioctl_fill_slave_sync(&data, sync);
     }
     else
     {
@@ -525,9 +701,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo(
             return -EINVAL;
         }
 
-        data.index = pdo->index;
-        data.entry_count = ec_pdo_entry_count(pdo);
-        ec_ioctl_strcpy(data.name, pdo->name);
+        ec_ioctl_fill_slave_sync_pdo(&data, pdo);
     }
     else
     {
@@ -626,10 +800,7 @@ static ATTRIBUTES int ec_ioctl_slave_sync_pdo_entry(
             return -EINVAL;
         }
 
-        data.index = entry->index;
-        data.subindex = entry->subindex;
-        data.bit_length = entry->bit_length;
-        ec_ioctl_strcpy(data.name, entry->name);
+        ec_ioctl_fill_slave_sync_pdo_entry(&data, entry);
     }
     else
     {
@@ -673,7 +844,6 @@ static ATTRIBUTES int ec_ioctl_domain(
 {
     ec_ioctl_domain_t data;
     const ec_domain_t *domain;
-    unsigned int dev_idx;
 
     if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
     {
@@ -690,15 +860,7 @@ static ATTRIBUTES int ec_ioctl_domain(
         return -EINVAL;
     }
 
-    data.data_size = domain->data_size;
-    data.logical_base_address = domain->logical_base_address;
-    for (dev_idx = EC_DEVICE_MAIN;
-         dev_idx < ec_master_num_devices(domain->master); dev_idx++)
-    {
-        data.working_counter[dev_idx] = domain->working_counter[dev_idx];
-    }
-    data.expected_working_counter = domain->expected_working_counter;
-    data.fmmu_count = ec_domain_fmmu_count(domain);
+    ec_ioctl_fill_domain(&data, domain);
 
     ec_lock_up(&master->master_sem);
 
@@ -758,12 +920,7 @@ static ATTRIBUTES int ec_ioctl_domain_fmmu(
         return -EINVAL;
     }
 
-    data.slave_config_alias = fmmu->sc->alias;
-    data.slave_config_position = fmmu->sc->position;
-    data.sync_index = fmmu->sync_index;
-    data.dir = fmmu->dir;
-    data.logical_address = fmmu->domain->logical_base_address + fmmu->logical_domain_offset;
-    data.data_size = fmmu->data_size;
+    ec_ioctl_fill_domain_fmmu(&data, fmmu);
 
     ec_lock_up(&master->master_sem);
 
@@ -835,146 +992,345 @@ static ATTRIBUTES int ec_ioctl_domain_data(
 /*****************************************************************************/
 
 /**
-
-@brief 获取pcap数据。
-
-@param master EtherCAT主站。
-
-@param arg 用于存储结果的用户空间地址。
-
-@return 成功时返回零，否则返回负错误代码。
-
-@details
-
-检查是否支持pcap数据。
-从用户空间复制数据到内核空间。
-锁定主站信号量，以避免中断。
-获取pcap数据大小和总大小。
-检查数据大小是否足够。
-填充pcap头并将其复制到用户内存。
-将pcap数据复制到用户内存。
-如果请求了重置数据，则重置pcap当前数据位置。
-解锁主站信号量。
-*/
+ * @brief 获取pcap数据。
+ *
+ * @param master EtherCAT主站。
+ * @param arg 用于存储结果的用户空间地址。
+ * @return 成功时返回零，否则返回负错误代码。
+ *
+ * @details 将捕获环中自上次复位以来仍然有效的记录转换为pcap格式
+ * （纳秒时间戳）复制到用户内存，直到用户缓冲区写满。如果请求了复位，
+ * 下次只返回此后捕获的帧。读取不会影响捕获，连续读取请使用mmap()映射
+ * 捕获环（见EC_IOCTL_MMAP_PCAP）。
+ */
 static ATTRIBUTES int ec_ioctl_pcap_data(
-ec_master_t *master, /< EtherCAT主站。 */
-void *arg /< 用于存储结果的用户空间地址。 */
+    ec_master_t *master, /**< EtherCAT主站。 */
+    void *arg            /**< 用于存储结果的用户空间地址。 */
 )
 {
-ec_ioctl_pcap_data_t data;
-pcap_hdr_t pcaphdr;
-size_t data_size;
-size_t total_size;
-void *curr_data;
-// 检查是否支持pcap数据
-if (!master->pcap_data)
-{
-return -EOPNOTSUPP;
-}
+    ec_ioctl_pcap_data_t data;
+    ec_pcap_ring_t *ring = &master->pcap;
+    pcap_hdr_t pcaphdr;
+    pcaprec_hdr_t rechdr;
+    ec_pcap_record_t rec;
+    uint8_t *frame;
+    size_t offset;
+    u32 pos, next;
+    int ret = 0;
 
-// 从用户空间复制数据到内核空间
-if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
-{
-return -EFAULT;
-}
+    // 检查是否支持pcap数据
+    if (!ring->mem)
+    {
+        return -EOPNOTSUPP;
+    }
 
-// 锁定主站信号量，以避免中断
-if (ec_lock_down_interruptible(&master->master_sem))
-return -EINTR;
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
 
-curr_data = master->pcap_curr_data;
-data_size = curr_data - master->pcap_data;
-total_size = sizeof(pcap_hdr_t) + data_size;
+    if (data.data_size < sizeof(pcap_hdr_t))
+    {
+        EC_MASTER_ERR(master, "Pcap数据大小太小 %u/%zu！\n",
+                      data.data_size, sizeof(pcap_hdr_t));
+        return -EFAULT;
+    }
 
-// 检查数据大小是否足够
-if (data.data_size < sizeof(pcap_hdr_t))
-{
-ec_lock_up(&master->master_sem);
-EC_MASTER_ERR(master, "Pcap数据大小太小 %u/%zu！\n",
-data.data_size, sizeof(pcap_hdr_t));
-return -EFAULT;
-}
-if (data.data_size > total_size)
-{
-data.data_size = total_size;
-}
+    frame = kmalloc(EC_PCAP_MAX_CAPLEN, GFP_KERNEL);
+    if (!frame)
+    {
+        return -ENOMEM;
+    }
 
-// 填充pcap头并将其复制到用户内存
-pcaphdr.magic_number = 0xa1b2c3d4;
-pcaphdr.version_major = 2;
-pcaphdr.version_minor = 4;
-pcaphdr.thiszone = 0;
-pcaphdr.sigfigs = 0;
-pcaphdr.snaplen = 65535;
-pcaphdr.network = 1;
-if (copy_to_user((void __user *)data.target, &pcaphdr,
-sizeof(pcap_hdr_t)))
-{
-ec_lock_up(&master->master_sem);
-return -EFAULT;
-}
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        kfree(frame);
+        return -EINTR;
+    }
 
-// 复制pcap数据，直到请求的大小；同时复制更新后的数据大小
-if ((data_size > 0) &&
-(copy_to_user((void __user *)(data.target + sizeof(pcap_hdr_t)),
-master->pcap_data, data.data_size - sizeof(pcap_hdr_t)) ||
-copy_to_user((void __user *)arg, &data, sizeof(data))))
-{
-ec_lock_up(&master->master_sem);
-return -EFAULT;
-}
+    // 填充pcap头（纳秒时间戳格式）并将其复制到用户内存
+    pcaphdr.magic_number = 0xa1b23c4d;
+    pcaphdr.version_major = 2;
+    pcaphdr.version_minor = 4;
+    pcaphdr.thiszone = 0;
+    pcaphdr.sigfigs = 0;
+    pcaphdr.snaplen = ring->header->snaplen ? ring->header->snaplen : 65535;
+    pcaphdr.network = 1;
+    if (copy_to_user((void __user *)data.target, &pcaphdr, sizeof(pcaphdr)))
+    {
+        ret = -EFAULT;
+        goto out;
+    }
+    offset = sizeof(pcaphdr);
 
-// 是否删除已复制的数据？
-// 注意：将删除未复制的任何数据
-if (data.reset_data)
-{
-master->pcap_curr_data = master->pcap_data;
-}
+    // 逐条转换记录，直到用户缓冲区写满
+    pos = ring->read_pos;
+    next = pos;
+    while (ec_pcap_ring_fetch(ring, &next, &rec, frame))
+    {
+        if (offset + sizeof(rechdr) + rec.caplen > data.data_size)
+        {
+            break;
+        }
 
-ec_lock_up(&master->master_sem);
-return 0;
-}
+        rechdr.ts_sec = div_u64_rem(rec.timestamp, NSEC_PER_SEC,
+                                    &rechdr.ts_usec);
+        rechdr.incl_len = rec.caplen;
+        rechdr.orig_len = rec.origlen;
+        if (copy_to_user((void __user *)(data.target + offset), &rechdr,
+                         sizeof(rechdr)) ||
+            copy_to_user((void __user *)(data.target + offset + sizeof(rechdr)),
+                         frame, rec.caplen))
+        {
+            ret = -EFAULT;
+            goto out;
+        }
+        offset += sizeof(rechdr) + rec.caplen;
+        pos = next;
+    }
 
-/*****************************************************************************/
+    data.data_size = offset;
+    if (copy_to_user((void __user *)arg, &data, sizeof(data)))
+    {
+        ret = -EFAULT;
+        goto out;
+    }
 
-/**
-@brief 设置主控制器的调试级别。
-@param master EtherCAT主控制器。
-@param arg ioctl()参数。
-@return 成功返回零，否则返回负错误代码。
-@details
-- 调用ec_master_debug_level()函数设置主控制器的调试级别。
-*/
-static ATTRIBUTES int ec_ioctl_master_debug(
-    ec_master_t *master, /**< EtherCAT主控制器。 */
-    void *arg            /**< ioctl()参数。 */
-)
-{
-    return ec_master_debug_level(master, (unsigned long)arg);
+    // 是否跳过已复制的数据？
+    if (data.reset_data)
+    {
+        ring->read_pos = pos;
+    }
+
+out:
+    ec_lock_up(&master->master_sem);
+    kfree(frame);
+    return ret;
 }
 
 /*****************************************************************************/
 
 /**
-@brief 发起总线扫描。
-@return 总是返回零（成功）。
-@details
-- 将master->fsm.rescan_required设置为1，表示需要进行总线扫描。
-*/
-static ATTRIBUTES int ec_ioctl_master_rescan(
-    ec_master_t *master, /**< EtherCAT主控制器。 */
-    void *arg            /**< ioctl()参数。 */
+ * @brief 读取或设置pcap捕获过滤器。
+ *
+ * @param master EtherCAT主站。
+ * @param arg 用户空间地址。
+ * @param ctx 文件句柄的上下文。
+ * @return 成功时返回零，否则返回负错误代码。
+ *
+ * @details 过滤器由捕获路径不加锁读取，更改在下一帧生效。
+ */
+static ATTRIBUTES int ec_ioctl_pcap_filter(
+    ec_master_t *master,    /**< EtherCAT主站。 */
+    void *arg,              /**< 用户空间地址。 */
+    ec_ioctl_context_t *ctx /**< 文件句柄的上下文。 */
 )
 {
-    master->fsm.rescan_required = 1;
+    ec_ioctl_pcap_filter_t io;
+    ec_pcap_ring_t *ring = &master->pcap;
+
+    if (!ring->mem)
+    {
+        return -EOPNOTSUPP;
+    }
+
+    if (copy_from_user(&io, (void __user *)arg, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    if (io.set)
+    {
+        if (!ctx->writable)
+        {
+            return -EPERM;
+        }
+
+        ring->type_mask = io.type_mask;
+        ring->address = io.address;
+        ring->address_filter = io.address_filter;
+        ring->header->snaplen = io.snaplen;
+    }
+
+    io.snaplen = ring->header->snaplen;
+    io.type_mask = ring->type_mask;
+    io.address = ring->address;
+    io.address_filter = ring->address_filter;
+
+    if (copy_to_user((void __user *)arg, &io, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
     return 0;
 }
 
 /*****************************************************************************/
 
 /**
-@brief 设置从站状态。
-@return 成功返回零，否则返回负错误代码。
+ * @brief 配置过程数据记录器。
+ *
+ * @param master EtherCAT主站。
+ * @param arg 用户空间地址。
+ * @param ctx 文件句柄的上下文。
+ * @return 成功时返回零，否则返回负错误代码。
+ *
+ * @details 通道数为0时停止记录。成功时返回记录环的映射大小，记录环可以
+ * 通过mmap()映射（见EC_IOCTL_MMAP_SCOPE）。
+ */
+static ATTRIBUTES int ec_ioctl_scope(
+    ec_master_t *master,    /**< EtherCAT主站。 */
+    void *arg,              /**< 用户空间地址。 */
+    ec_ioctl_context_t *ctx /**< 文件句柄的上下文。 */
+)
+{
+    ec_ioctl_scope_t *io;
+    int ret;
+
+    if (!ctx->writable)
+    {
+        return -EPERM;
+    }
+
+    io = kmalloc(sizeof(*io), GFP_KERNEL);
+    if (!io)
+    {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(io, (void __user *)arg, sizeof(*io)))
+    {
+        kfree(io);
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        kfree(io);
+        return -EINTR;
+    }
+
+    ret = ec_scope_configure(&master->scope, io);
+    io->map_size = master->scope.mem_size;
+
+    ec_lock_up(&master->master_sem);
+
+    if (!ret && copy_to_user((void __user *)arg, io, sizeof(*io)))
+    {
+        ret = -EFAULT;
+    }
+
+    kfree(io);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 获取主站热路径直方图。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@param ctx 私有数据结构。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 读取自上次复位以来的直方图，不需要获取主站锁。
+- 如果请求复位，需要写权限，复位在读取之后进行。
+*/
+static ATTRIBUTES int ec_ioctl_master_histograms(
+    ec_master_t *master,     /**< EtherCAT主控制器。 */
+    void *arg,               /**< ioctl()参数。 */
+    ec_ioctl_context_t *ctx  /**< 私有数据结构。 */
+)
+{
+    ec_ioctl_master_histograms_t *data;
+    ec_histogram_t hist[EC_HIST_COUNT];
+    unsigned int i;
+    int ret = 0;
+
+    data = kzalloc(sizeof(*data), GFP_KERNEL);
+    if (!data)
+    {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(data, (void __user *)arg, sizeof(*data)))
+    {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    if (data->reset && !ctx->writable)
+    {
+        ret = -EPERM;
+        goto out_free;
+    }
+
+    ec_master_get_histograms(master, hist);
+
+    for (i = 0; i < EC_HIST_COUNT; i++)
+    {
+        memcpy(data->hist[i].buckets, hist[i].buckets,
+               sizeof(data->hist[i].buckets));
+        data->hist[i].count = hist[i].count;
+        data->hist[i].sum = hist[i].sum;
+        data->hist[i].max = hist[i].max;
+    }
+
+    if (data->reset)
+    {
+        ec_master_reset_histograms(master);
+    }
+
+    if (copy_to_user((void __user *)arg, data, sizeof(*data)))
+    {
+        ret = -EFAULT;
+    }
+
+out_free:
+    kfree(data);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 设置主控制器的调试级别。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 调用ec_master_debug_level()函数设置主控制器的调试级别。
+*/
+static ATTRIBUTES int ec_ioctl_master_debug(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    return ec_master_debug_level(master, (unsigned long)arg);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 发起总线扫描。
+@return 总是返回零（成功）。
+@details
+- 将master->fsm.rescan_required设置为1，表示需要进行总线扫描。
+*/
+static ATTRIBUTES int ec_ioctl_master_rescan(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    master->fsm.rescan_required = 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 设置从站状态。
+@return 成功返回零，否则返回负错误代码。
 @details
 - 从用户空间复制数据到ec_ioctl_slave_state_t结构体变量data。
 - 如果复制失败，返回-EFAULT。
@@ -1245,145 +1601,1303 @@ static ATTRIBUTES int ec_ioctl_slave_sdo_entry(
 /*****************************************************************************/
 
 /**
-@brief 上传SDO。
-@param master EtherCAT主控制器。
-@param arg ioctl()参数。
-@return 成功返回零，否则返回负错误代码。
-@details
-- 从用户空间复制数据到ec_ioctl_slave_sdo_upload_t结构体变量data。
-- 如果复制失败，返回-EFAULT。
-- 使用kmalloc()函数分配内存给target。
-- 如果内存分配失败，打印错误信息并返回-ENOMEM。
-- 如果complete_access为真，则调用ecrt_master_sdo_upload_complete()函数进行完整的SDO上传。
-- 否则，调用ecrt_master_sdo_upload()函数进行SDO上传。
-- 如果上传成功，将上传的数据复制到用户空间的data.target中。
-- 释放target的内存。
-- 如果复制失败，返回-EFAULT。
-- 将data复制到用户空间的arg中。
-- 返回上传的结果。
-*/
-static ATTRIBUTES int ec_ioctl_slave_sdo_upload(
+@brief 一次导出从站的整个SDO字典。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 计算整个字典打包后所需的大小并写入data_size。
+- 如果用户缓冲区足够大，写入每个SDO记录（ec_ioctl_sdo_export_sdo_t）
+  及其条目记录（ec_ioctl_sdo_export_entry_t），否则不写入任何记录。
+- 整个过程只获取一次master_sem，代替逐个SDO和条目的ioctl调用。
+*/
+static ATTRIBUTES int ec_ioctl_slave_sdo_dict_export(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_slave_sdo_dict_export_t data;
+    const ec_slave_t *slave;
+    uint8_t *buf = NULL;
+    unsigned int sdo_count, entry_count;
+    size_t size;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    if (!(slave = ec_master_find_slave_const(
+              master, 0, data.slave_position)))
+    {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_ERR(master, "从站 %u 不存在！\n",
+                      data.slave_position);
+        return -EINVAL;
+    }
+
+    size = ec_dict_pack(slave, NULL, &sdo_count, &entry_count);
+    data.data_size = size;
+    data.sdo_count = 0;
+    data.entry_count = 0;
+
+    if (size && data.buffer && data.buffer_size >= size)
+    {
+        if (!(buf = vmalloc(size)))
+        {
+            ec_lock_up(&master->master_sem);
+            return -ENOMEM;
+        }
+
+        ec_dict_pack(slave, buf, NULL, NULL);
+        data.sdo_count = sdo_count;
+        data.entry_count = entry_count;
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if (buf)
+    {
+        int ret = copy_to_user((void __user *)data.buffer, buf, size);
+        vfree(buf);
+        if (ret)
+            return -EFAULT;
+    }
+
+    if (copy_to_user((void __user *)arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 读取一个字典缓存条目。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 总是返回缓存条目总数。
+- 位置有效时返回条目的从站类型和大小，缓冲区足够大时同时复制打包的字典。
+*/
+static ATTRIBUTES int ec_ioctl_dict_cache_get(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_dict_cache_t data;
+    const ec_dict_cache_entry_t *entry;
+    uint8_t *buf = NULL;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    data.entry_count = master->dict_cache.count;
+    data.data_size = 0;
+    data.sdo_count = 0;
+
+    if ((entry = ec_dict_cache_get(&master->dict_cache, data.position)))
+    {
+        data.vendor_id = entry->vendor_id;
+        data.product_code = entry->product_code;
+        data.revision_number = entry->revision_number;
+        data.data_size = entry->size;
+
+        if (data.buffer && data.buffer_size >= entry->size)
+        {
+            if (!(buf = vmalloc(entry->size)))
+            {
+                ec_lock_up(&master->master_sem);
+                return -ENOMEM;
+            }
+            memcpy(buf, entry->data, entry->size);
+            data.sdo_count = entry->sdo_count;
+        }
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if (buf)
+    {
+        int ret = copy_to_user((void __user *)data.buffer, buf,
+                               data.data_size);
+        vfree(buf);
+        if (ret)
+            return -EFAULT;
+    }
+
+    if (copy_to_user((void __user *)arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 向字典缓存添加一个条目。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details 用于在模块加载后恢复保存在磁盘上的字典。已存在的同类型条目被替换。
+*/
+static ATTRIBUTES int ec_ioctl_dict_cache_add(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_dict_cache_t data;
+    uint8_t *buf;
+    int ret;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (!data.data_size || data.data_size > EC_DICT_CACHE_MAX_SIZE ||
+        !data.buffer)
+    {
+        return -EINVAL;
+    }
+
+    if (!(buf = vmalloc(data.data_size)))
+    {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(buf, (void __user *)data.buffer, data.data_size))
+    {
+        vfree(buf);
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        vfree(buf);
+        return -EINTR;
+    }
+
+    ret = ec_dict_cache_add(&master->dict_cache, data.vendor_id,
+                            data.product_code, data.revision_number,
+                            buf, data.data_size);
+
+    ec_lock_up(&master->master_sem);
+
+    if (ret)
+    {
+        vfree(buf);
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 清空字典缓存。
+@param master EtherCAT主控制器。
+@return 成功返回零，否则返回负错误代码。
+@details 已建立的从站字典不受影响。
+*/
+static ATTRIBUTES int ec_ioctl_dict_cache_clear(
+    ec_master_t *master /**< EtherCAT主控制器。 */
+)
+{
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    ec_dict_cache_clear(&master->dict_cache);
+
+    ec_lock_up(&master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 遍历快照中的所有对象。
+@param master EtherCAT主控制器。
+@param buf 快照缓冲区，头部的节偏移量已填好；为NULL时只计数。
+@param count 各节的记录计数，调用前清零。
+@details 调用者必须持有master_sem，并且在计数和填写之间不能释放。
+*/
+static void ec_ioctl_snapshot_walk(
+    const ec_master_t *master, /**< EtherCAT主控制器。 */
+    uint8_t *buf,              /**< 快照缓冲区。 */
+    uint32_t *count            /**< 各节的记录计数。 */
+)
+{
+    const ec_snapshot_header_t *header = (const ec_snapshot_header_t *)buf;
+    const ec_slave_t *slave;
+    const ec_sync_t *sync;
+    const ec_slave_config_t *sc;
+    const ec_domain_t *domain;
+    const ec_fmmu_config_t *fmmu;
+    const ec_pdo_t *pdo;
+    const ec_pdo_entry_t *entry;
+    unsigned int i, j, k, l;
+
+/** 取得某一节的下一条记录，只计数时为NULL。 */
+#define EC_SNAPSHOT_NEXT(type, section) \
+    (buf ? (type *)(buf + header->sections[section].offset) + \
+               count[section]++ \
+         : (count[section]++, (type *)NULL))
+
+    for (i = 0; i < master->slave_count; i++)
+    {
+        ec_ioctl_slave_t *s;
+
+        slave = master->slaves + i;
+        if ((s = EC_SNAPSHOT_NEXT(ec_ioctl_slave_t, EC_SNAPSHOT_SLAVES)))
+        {
+            s->position = slave->ring_position;
+            ec_ioctl_fill_slave(s, slave);
+        }
+
+        if (!slave->sii_image)
+            continue;
+
+        for (j = 0; j < slave->sii_image->sii.sync_count; j++)
+        {
+            ec_ioctl_slave_sync_t *y;
+
+            sync = &slave->sii_image->sii.syncs[j];
+            if ((y = EC_SNAPSHOT_NEXT(ec_ioctl_slave_sync_t,
+                                      EC_SNAPSHOT_SYNCS)))
+            {
+                y->slave_position = slave->ring_position;
+                y->sync_index = j;
+                ec_ioctl_fill_slave_sync(y, sync);
+            }
+
+            k = 0;
+            list_for_each_entry(pdo, &sync->pdos.list, list)
+            {
+                ec_ioctl_slave_sync_pdo_t *p;
+
+                if ((p = EC_SNAPSHOT_NEXT(ec_ioctl_slave_sync_pdo_t,
+                                          EC_SNAPSHOT_PDOS)))
+                {
+                    p->slave_position = slave->ring_position;
+                    p->sync_index = j;
+                    p->pdo_pos = k;
+                    ec_ioctl_fill_slave_sync_pdo(p, pdo);
+                }
+
+                l = 0;
+                list_for_each_entry(entry, &pdo->entries, list)
+                {
+                    ec_ioctl_slave_sync_pdo_entry_t *e;
+
+                    if ((e = EC_SNAPSHOT_NEXT(
+                             ec_ioctl_slave_sync_pdo_entry_t,
+                             EC_SNAPSHOT_ENTRIES)))
+                    {
+                        e->slave_position = slave->ring_position;
+                        e->sync_index = j;
+                        e->pdo_pos = k;
+                        e->entry_pos = l;
+                        ec_ioctl_fill_slave_sync_pdo_entry(e, entry);
+                    }
+                    l++;
+                }
+                k++;
+            }
+        }
+    }
+
+    for (i = 0; i < ec_master_config_count(master); i++)
+    {
+        ec_ioctl_config_t *c;
+
+        sc = ec_master_get_config_const(master, i);
+        if ((c = EC_SNAPSHOT_NEXT(ec_ioctl_config_t, EC_SNAPSHOT_CONFIGS)))
+        {
+            c->config_index = i;
+            ec_ioctl_fill_config(c, sc);
+        }
+
+        for (j = 0; j < EC_MAX_SYNC_MANAGERS; j++)
+        {
+            k = 0;
+            list_for_each_entry(pdo, &sc->sync_configs[j].pdos.list, list)
+            {
+                ec_ioctl_config_pdo_t *p;
+
+                if ((p = EC_SNAPSHOT_NEXT(ec_ioctl_config_pdo_t,
+                                          EC_SNAPSHOT_CONFIG_PDOS)))
+                {
+                    p->config_index = i;
+                    p->sync_index = j;
+                    p->pdo_pos = k;
+                    ec_ioctl_fill_config_pdo(p, pdo);
+                }
+
+                l = 0;
+                list_for_each_entry(entry, &pdo->entries, list)
+                {
+                    ec_ioctl_config_pdo_entry_t *e;
+
+                    if ((e = EC_SNAPSHOT_NEXT(ec_ioctl_config_pdo_entry_t,
+                                              EC_SNAPSHOT_CONFIG_ENTRIES)))
+                    {
+                        e->config_index = i;
+                        e->sync_index = j;
+                        e->pdo_pos = k;
+                        e->entry_pos = l;
+                        ec_ioctl_fill_config_pdo_entry(e, entry);
+                    }
+                    l++;
+                }
+                k++;
+            }
+        }
+    }
+
+    for (i = 0; i < ec_master_domain_count(master); i++)
+    {
+        ec_ioctl_domain_t *d;
+
+        domain = ec_master_find_domain_const(master, i);
+        if ((d = EC_SNAPSHOT_NEXT(ec_ioctl_domain_t, EC_SNAPSHOT_DOMAINS)))
+        {
+            d->index = i;
+            ec_ioctl_fill_domain(d, domain);
+        }
+
+        j = 0;
+        list_for_each_entry(fmmu, &domain->fmmu_configs, list)
+        {
+            ec_ioctl_domain_fmmu_t *f;
+
+            if ((f = EC_SNAPSHOT_NEXT(ec_ioctl_domain_fmmu_t,
+                                      EC_SNAPSHOT_FMMUS)))
+            {
+                f->domain_index = i;
+                f->fmmu_index = j;
+                ec_ioctl_fill_domain_fmmu(f, fmmu);
+            }
+            j++;
+        }
+    }
+
+#undef EC_SNAPSHOT_NEXT
+}
+
+/*****************************************************************************/
+
+/**
+@brief 读取拓扑和状态的批量快照。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 在一次持有master_sem期间打包所有从站、同步管理器、PDO、条目、配置、
+  域和FMMU，代替逐个对象的ioctl。
+- 快照内容（域的工作计数器除外）的散列值与上一次不同时递增代数。
+- 调用者的代数与当前代数相同时不复制；缓冲区为NULL或不足时只返回所需大小。
+*/
+static ATTRIBUTES int ec_ioctl_snapshot(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    static const uint32_t record_size[EC_SNAPSHOT_SECTION_COUNT] = {
+        sizeof(ec_ioctl_slave_t),
+        sizeof(ec_ioctl_slave_sync_t),
+        sizeof(ec_ioctl_slave_sync_pdo_t),
+        sizeof(ec_ioctl_slave_sync_pdo_entry_t),
+        sizeof(ec_ioctl_config_t),
+        sizeof(ec_ioctl_config_pdo_t),
+        sizeof(ec_ioctl_config_pdo_entry_t),
+        sizeof(ec_ioctl_domain_fmmu_t),
+        sizeof(ec_ioctl_domain_t)};
+    ec_ioctl_snapshot_t data;
+    ec_snapshot_header_t *header;
+    uint32_t count[EC_SNAPSHOT_SECTION_COUNT];
+    uint32_t hashed, hash;
+    uint8_t *buf;
+    size_t size;
+    unsigned int i;
+    int ret = 0;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+        return -EINTR;
+
+    memset(count, 0, sizeof(count));
+    ec_ioctl_snapshot_walk(master, NULL, count);
+
+    size = ALIGN(sizeof(ec_snapshot_header_t), 8);
+    for (i = 0; i < EC_SNAPSHOT_SECTION_COUNT; i++)
+    {
+        size = ALIGN(size + (size_t)count[i] * record_size[i], 8);
+    }
+
+    if (!(buf = vzalloc(size)))
+    {
+        ec_lock_up(&master->master_sem);
+        return -ENOMEM;
+    }
+
+    header = (ec_snapshot_header_t *)buf;
+    header->magic = EC_SNAPSHOT_MAGIC;
+    header->version = EC_SNAPSHOT_VERSION;
+    header->section_count = EC_SNAPSHOT_SECTION_COUNT;
+    size = ALIGN(sizeof(ec_snapshot_header_t), 8);
+    for (i = 0; i < EC_SNAPSHOT_SECTION_COUNT; i++)
+    {
+        header->sections[i].offset = size;
+        header->sections[i].count = count[i];
+        header->sections[i].record_size = record_size[i];
+        size = ALIGN(size + (size_t)count[i] * record_size[i], 8);
+    }
+
+    memset(count, 0, sizeof(count));
+    ec_ioctl_snapshot_walk(master, buf, count);
+
+    // 域放在最后一节，工作计数器不参与散列，只以域的数量作为初值
+    hashed = header->sections[EC_SNAPSHOT_DOMAINS].offset -
+             header->sections[0].offset;
+    hash = jhash(buf + header->sections[0].offset, hashed,
+                 header->sections[EC_SNAPSHOT_DOMAINS].count);
+    if (!master->snapshot_generation || hash != master->snapshot_hash)
+    {
+        master->snapshot_hash = hash;
+        if (!++master->snapshot_generation)
+            master->snapshot_generation = 1;
+    }
+    header->generation = master->snapshot_generation;
+
+    ec_lock_up(&master->master_sem);
+
+    data.current_generation = header->generation;
+    data.data_size = size;
+    data.copied = 0;
+
+    if (data.generation != data.current_generation && data.buffer &&
+        data.buffer_size >= size)
+    {
+        if (copy_to_user((void __user *)data.buffer, buf, size))
+            ret = -EFAULT;
+        else
+            data.copied = 1;
+    }
+
+    vfree(buf);
+    if (ret)
+        return ret;
+
+    if (copy_to_user((void __user *)arg, &data, sizeof(data)))
+        return -EFAULT;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 上传SDO。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 从用户空间复制数据到ec_ioctl_slave_sdo_upload_t结构体变量data。
+- 如果复制失败，返回-EFAULT。
+- 使用kmalloc()函数分配内存给target。
+- 如果内存分配失败，打印错误信息并返回-ENOMEM。
+- 如果complete_access为真，则调用ecrt_master_sdo_upload_complete()函数进行完整的SDO上传。
+- 否则，调用ecrt_master_sdo_upload()函数进行SDO上传。
+- 如果上传成功，将上传的数据复制到用户空间的data.target中。
+- 释放target的内存。
+- 如果复制失败，返回-EFAULT。
+- 将data复制到用户空间的arg中。
+- 返回上传的结果。
+*/
+static ATTRIBUTES int ec_ioctl_slave_sdo_upload(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_slave_sdo_upload_t data;
+    uint8_t *target;
+    int ret;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (!(target = kmalloc(data.target_size, GFP_KERNEL)))
+    {
+        EC_MASTER_ERR(master, "分配 %zu 字节用于SDO上传失败。\n",
+                      data.target_size);
+        return -ENOMEM;
+    }
+
+    if (data.complete_access)
+    {
+        ret = ecrt_master_sdo_upload_complete(master, data.slave_position,
+                                              data.sdo_index, target, data.target_size,
+                                              &data.data_size, &data.abort_code);
+    }
+    else
+    {
+        ret = ecrt_master_sdo_upload(master, data.slave_position,
+                                     data.sdo_index, data.sdo_entry_subindex, target,
+                                     data.target_size, &data.data_size, &data.abort_code);
+    }
+
+    if (!ret)
+    {
+        if (copy_to_user((void __user *)data.target,
+                         target, data.data_size))
+        {
+            kfree(target);
+            return -EFAULT;
+        }
+    }
+
+    kfree(target);
+
+    if (__copy_to_user((void __user *)arg, &data, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 下载SDO。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details
+- 从用户空间复制数据到ec_ioctl_slave_sdo_download_t结构体变量data。
+- 如果复制失败，返回-EFAULT。
+- 使用kmalloc()函数分配内存给sdo_data。
+- 如果内存分配失败，打印错误信息并返回-ENOMEM。
+- 从用户空间复制SDO数据到sdo_data。
+- 如果复制失败，释放sdo_data的内存并返回-EFAULT。
+- 如果complete_access为真，则调用ecrt_master_sdo_download_complete()函数进行完整的SDO下载。
+- 否则，调用ecrt_master_sdo_download()函数进行SDO下载。
+- 释放sdo_data的内存。
+- 如果复制失败，将retval设置为-EFAULT。
+- 将data复制到用户空间的arg中。
+- 返回retval。
+*/
+static ATTRIBUTES int ec_ioctl_slave_sdo_download(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_slave_sdo_download_t data;
+    uint8_t *sdo_data;
+    int retval;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (!(sdo_data = kmalloc(data.data_size, GFP_KERNEL)))
+    {
+        EC_MASTER_ERR(master, "分配 %zu 字节用于SDO下载失败。\n",
+                      data.data_size);
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(sdo_data, (const void __user *)data.data, data.data_size))
+    {
+        kfree(sdo_data);
+        return -EFAULT;
+    }
+
+    if (data.complete_access)
+    {
+        retval = ecrt_master_sdo_download_complete(master, data.slave_position,
+                                                   data.sdo_index, sdo_data, data.data_size, &data.abort_code);
+    }
+    else
+    {
+        retval = ecrt_master_sdo_download(master, data.slave_position,
+                                          data.sdo_index, data.sdo_entry_subindex, sdo_data,
+                                          data.data_size, &data.abort_code);
+    }
+
+    kfree(sdo_data);
+
+    if (__copy_to_user((void __user *)arg, &data, sizeof(data)))
+    {
+        retval = -EFAULT;
+    }
+
+    return retval;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 批量执行SDO上传/下载。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@param ctx 文件句柄的私有数据结构。
+@return 成功返回零，否则返回负错误代码。
+@details 操作和下载数据一次性复制到内核，交给ecrt_master_sdo_batch()并行
+处理，然后把上传的数据和每个操作的结果复制回用户空间。包含下载操作时需要
+写权限。
+*/
+static ATTRIBUTES int ec_ioctl_sdo_batch(
+    ec_master_t *master,    /**< EtherCAT主控制器。 */
+    void *arg,              /**< ioctl()参数。 */
+    ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。 */
+)
+{
+    ec_ioctl_sdo_batch_t data;
+    ec_sdo_batch_item_t *items;
+    uint8_t **user_data;
+    uint8_t *buffer = NULL;
+    size_t total = 0, offset = 0;
+    unsigned int i;
+    int retval;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (!data.count || data.count > EC_SDO_BATCH_MAX_ITEMS)
+    {
+        return -EINVAL;
+    }
+
+    if (!(items = vmalloc(data.count * sizeof(*items))))
+    {
+        return -ENOMEM;
+    }
+
+    if (!(user_data = vmalloc(data.count * sizeof(*user_data))))
+    {
+        vfree(items);
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(items, (void __user *)data.items,
+                       data.count * sizeof(*items)))
+    {
+        retval = -EFAULT;
+        goto out_free;
+    }
+
+    for (i = 0; i < data.count; i++)
+    {
+        if (items[i].dir == EC_DIR_OUTPUT && !ctx->writable)
+        {
+            retval = -EPERM;
+            goto out_free;
+        }
+        if (items[i].data_size > EC_SDO_BATCH_MAX_DATA - total)
+        {
+            EC_MASTER_ERR(master, "批量SDO数据超过%u字节。\n",
+                          EC_SDO_BATCH_MAX_DATA);
+            retval = -EINVAL;
+            goto out_free;
+        }
+        total += items[i].data_size;
+    }
+
+    if (total && !(buffer = vmalloc(total)))
+    {
+        retval = -ENOMEM;
+        goto out_free;
+    }
+
+    // 把每个操作的数据指针换成内核缓冲区中的位置
+    for (i = 0; i < data.count; i++)
+    {
+        user_data[i] = items[i].data;
+        items[i].data = buffer + offset;
+        if (items[i].dir == EC_DIR_OUTPUT &&
+            copy_from_user(items[i].data, (void __user *)user_data[i],
+                           items[i].data_size))
+        {
+            retval = -EFAULT;
+            goto out_free;
+        }
+        offset += items[i].data_size;
+    }
+
+    retval = ecrt_master_sdo_batch(master, items, data.count);
+    if (retval < 0)
+    {
+        goto out_free;
+    }
+    data.failed = retval;
+    retval = 0;
+
+    for (i = 0; i < data.count; i++)
+    {
+        if (items[i].dir != EC_DIR_OUTPUT && items[i].result_size &&
+            copy_to_user((void __user *)user_data[i], items[i].data,
+                         items[i].result_size))
+        {
+            retval = -EFAULT;
+            goto out_free;
+        }
+        items[i].data = user_data[i];
+    }
+
+    if (copy_to_user((void __user *)data.items, items,
+                     data.count * sizeof(*items)) ||
+        copy_to_user((void __user *)arg, &data, sizeof(data)))
+    {
+        retval = -EFAULT;
+    }
+
+out_free:
+    if (buffer)
+    {
+        vfree(buffer);
+    }
+    vfree(user_data);
+    vfree(items);
+    return retval;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 为一组从站配置请求AL状态。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回0，否则返回负的错误代码。
+@details 把配置索引转换为从站配置，然后交给ecrt_master_request_state()。
+*/
+static ATTRIBUTES int ec_ioctl_request_state(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_request_state_t data;
+    ec_slave_config_t **configs;
+    uint32_t *indices;
+    unsigned int i;
+    int ret = 0;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (!data.count || data.count > ec_master_config_count(master))
+    {
+        return -EINVAL;
+    }
+
+    if (!(indices = vmalloc(data.count * sizeof(*indices))))
+    {
+        return -ENOMEM;
+    }
+
+    if (!(configs = vmalloc(data.count * sizeof(*configs))))
+    {
+        vfree(indices);
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(indices, (void __user *)data.config_indices,
+                       data.count * sizeof(*indices)))
+    {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        ret = -EINTR;
+        goto out_free;
+    }
+
+    for (i = 0; i < data.count; i++)
+    {
+        if (!(configs[i] = ec_master_get_config(master, indices[i])))
+        {
+            ret = -ENOENT;
+            break;
+        }
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if (!ret)
+    {
+        ret = ecrt_master_request_state(master, configs, data.count,
+                                        data.al_state);
+    }
+
+out_free:
+    vfree(configs);
+    vfree(indices);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 读取总线健康监视的错误计数器。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回0，否则返回负的错误代码。
+@details 一次复制所有从站的累计值和最近一次采样的增量。
+*/
+static ATTRIBUTES int ec_ioctl_crc_monitor(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_crc_monitor_t data;
+    ec_ioctl_crc_slave_t *entries = NULL, *entry;
+    const ec_crc_counters_t *counters;
+    unsigned int i, port, j;
+    int ret = 0;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    // 不按用户空间给出的数量分配，条目数不会超过从站数
+    data.max_slaves = min(data.max_slaves, master->slave_count);
+
+    if (data.max_slaves && !(entries = vmalloc(
+                                 data.max_slaves * sizeof(*entries))))
+    {
+        return -ENOMEM;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        ret = -EINTR;
+        goto out_free;
+    }
+
+    data.slave_count = min(data.max_slaves, master->slave_count);
+    data.interval_ms = master->crc_monitor.interval_ms;
+    data.sweeps = master->crc_monitor.sweeps;
+    data.sweep_interval_us =
+        jiffies_to_usecs(master->crc_monitor.sweep_interval);
+
+    for (i = 0; i < data.slave_count; i++)
+    {
+        counters = &master->slaves[i].crc_counters;
+        entry = &entries[i];
+
+        for (port = 0; port < EC_MAX_PORTS; port++)
+        {
+            for (j = 0; j < EC_CRC_IDX_COUNT; j++)
+            {
+                entry->total[port][j] = counters->total[port][j];
+                entry->delta[port][j] = counters->delta[port][j];
+            }
+            entry->saturated[port] = counters->saturated[port];
+        }
+        entry->epu_total = counters->epu_total;
+        entry->pdi_total = counters->pdi_total;
+        entry->epu_delta = counters->epu_delta;
+        entry->pdi_delta = counters->pdi_delta;
+        entry->valid = counters->valid;
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if ((data.slave_count &&
+         copy_to_user((void __user *)data.slaves, entries,
+                      data.slave_count * sizeof(*entries))) ||
+        copy_to_user((void __user *)arg, &data, sizeof(data)))
+    {
+        ret = -EFAULT;
+    }
+
+out_free:
+    if (entries)
+    {
+        vfree(entries);
+    }
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 设置总线健康监视的采样间隔。
+@param master EtherCAT主控制器。
+@param arg 采样间隔（毫秒），0表示停用。
+@return 成功返回0，否则返回负的错误代码。
+*/
+static ATTRIBUTES int ec_ioctl_crc_monitor_interval(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        return -EINTR;
+    }
+
+    ec_crc_monitor_set_interval(&master->crc_monitor, (unsigned long)arg);
+
+    ec_lock_up(&master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 读取非周期数据报调度的统计。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+@details 统计由实时上下文更新，读取时不加锁。
+*/
+static ATTRIBUTES int ec_ioctl_sched(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_sched_t *data;
+    const ec_sched_t *sched = &master->sched;
+    unsigned int i;
+    int ret = 0;
+
+    BUILD_BUG_ON(EC_SCHED_COUNT != EC_IOCTL_SCHED_CLASSES);
+
+    data = kzalloc(sizeof(*data), GFP_KERNEL);
+    if (!data)
+    {
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < EC_SCHED_COUNT; i++)
+    {
+        data->classes[i].datagrams = sched->stats[i].datagrams;
+        data->classes[i].bytes = sched->stats[i].bytes;
+        data->classes[i].deferred = sched->stats[i].deferred;
+        data->classes[i].timeouts = sched->stats[i].timeouts;
+        data->classes[i].max_wait_us = sched->stats[i].max_wait_us;
+        data->classes[i].weight = i < EC_SCHED_QUEUES ? sched->weights[i] : 0;
+    }
+    data->send_interval = master->send_interval;
+    data->budget = master->max_queue_size;
+
+    if (copy_to_user((void __user *)arg, data, sizeof(*data)))
+    {
+        ret = -EFAULT;
+    }
+
+    kfree(data);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 设置非周期数据报调度类别的权重。
+@param master EtherCAT主控制器。
+@param arg ioctl()参数。
+@return 成功返回零，否则返回负错误代码。
+*/
+static ATTRIBUTES int ec_ioctl_sched_weight(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_sched_weight_t data;
+    int ret;
+
+    if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
+    {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        return -EINTR;
+    }
+
+    ret = ec_sched_set_weight(&master->sched, data.sched_class, data.weight);
+
+    ec_lock_up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 读取一个主站线程的亲和性和调度参数。
+ * @param master EtherCAT主控制器。
+ * @param arg ioctl()参数。
+ * @return 成功返回零，否则返回负错误代码。
+ */
+static ATTRIBUTES int ec_ioctl_thread(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_ioctl_thread_t *data;
+    const ec_thread_param_t *param;
+    struct task_struct *task;
+    int ret = 0;
+
+    BUILD_BUG_ON(EC_THREAD_COUNT != EC_IOCTL_THREADS);
+
+    data = kzalloc(sizeof(*data), GFP_KERNEL);
+    if (!data)
+    {
+        return -ENOMEM;
+    }
+
+    if (copy_from_user(data, (void __user *)arg, sizeof(*data)))
+    {
+        ret = -EFAULT;
+        goto out_free;
+    }
+
+    if (data->thread >= EC_THREAD_COUNT)
+    {
+        ret = -EINVAL;
+        goto out_free;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        ret = -EINTR;
+        goto out_free;
+    }
+
+    param = &master->thread_params[data->thread];
+    snprintf(data->cpus, sizeof(data->cpus), "%*pbl",
+             cpumask_pr_args(&param->cpus));
+    data->policy = param->policy;
+    data->priority = param->priority;
+
+    task = ec_master_thread_task(master, data->thread);
+    data->pid = task ? task_pid_nr(task) : 0;
+    data->cpu = task ? task_cpu(task) : -1;
+
+    ec_lock_up(&master->master_sem);
+
+    if (copy_to_user((void __user *)arg, data, sizeof(*data)))
+    {
+        ret = -EFAULT;
+    }
+
+out_free:
+    kfree(data);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 设置一个主站线程的亲和性和调度参数。
+ * @details 参数保留到线程的下一次启动。周期引擎的参数例外：只能在引擎
+ *          运行时设置（否则返回-ESRCH），并且只在本次运行中有效，下一次
+ *          启动时使用ecrt_master_cyclic_start()的配置。
+ * @param master EtherCAT主控制器。
+ * @param arg ioctl()参数。
+ * @return 成功返回零，否则返回负错误代码。
+ */
+static ATTRIBUTES int ec_ioctl_thread_set(
     ec_master_t *master, /**< EtherCAT主控制器。 */
     void *arg            /**< ioctl()参数。 */
 )
 {
-    ec_ioctl_slave_sdo_upload_t data;
-    uint8_t *target;
+    ec_ioctl_thread_t data;
+    ec_thread_param_t *param;
     int ret;
 
     if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
     {
         return -EFAULT;
     }
+    data.cpus[sizeof(data.cpus) - 1] = 0;
 
-    if (!(target = kmalloc(data.target_size, GFP_KERNEL)))
+    // cpumask_t可能很大，不放在栈上
+    param = kmalloc(sizeof(*param), GFP_KERNEL);
+    if (!param)
     {
-        EC_MASTER_ERR(master, "分配 %zu 字节用于SDO上传失败。\n",
-                      data.target_size);
         return -ENOMEM;
     }
 
-    if (data.complete_access)
-    {
-        ret = ecrt_master_sdo_upload_complete(master, data.slave_position,
-                                              data.sdo_index, target, data.target_size,
-                                              &data.data_size, &data.abort_code);
-    }
-    else
+    ret = cpulist_parse(data.cpus, &param->cpus);
+    if (ret)
     {
-        ret = ecrt_master_sdo_upload(master, data.slave_position,
-                                     data.sdo_index, data.sdo_entry_subindex, target,
-                                     data.target_size, &data.data_size, &data.abort_code);
+        goto out_free;
     }
+    param->policy = data.policy;
+    param->priority = data.priority;
 
-    if (!ret)
+    if (ec_lock_down_interruptible(&master->master_sem))
     {
-        if (copy_to_user((void __user *)data.target,
-                         target, data.data_size))
-        {
-            kfree(target);
-            return -EFAULT;
-        }
+        ret = -EINTR;
+        goto out_free;
     }
 
-    kfree(target);
+    ret = ec_master_thread_set_param(master, data.thread, param);
 
-    if (__copy_to_user((void __user *)arg, &data, sizeof(data)))
-    {
-        return -EFAULT;
-    }
+    ec_lock_up(&master->master_sem);
 
+out_free:
+    kfree(param);
     return ret;
 }
 
 /*****************************************************************************/
 
 /**
-@brief 下载SDO。
-@param master EtherCAT主控制器。
-@param arg ioctl()参数。
-@return 成功返回零，否则返回负错误代码。
-@details
-- 从用户空间复制数据到ec_ioctl_slave_sdo_download_t结构体变量data。
-- 如果复制失败，返回-EFAULT。
-- 使用kmalloc()函数分配内存给sdo_data。
-- 如果内存分配失败，打印错误信息并返回-ENOMEM。
-- 从用户空间复制SDO数据到sdo_data。
-- 如果复制失败，释放sdo_data的内存并返回-EFAULT。
-- 如果complete_access为真，则调用ecrt_master_sdo_download_complete()函数进行完整的SDO下载。
-- 否则，调用ecrt_master_sdo_download()函数进行SDO下载。
-- 释放sdo_data的内存。
-- 如果复制失败，将retval设置为-EFAULT。
-- 将data复制到用户空间的arg中。
-- 返回retval。
-*/
-static ATTRIBUTES int ec_ioctl_slave_sdo_download(
+ * @brief 启动周期引擎。
+ * @details 用户空间没有回调函数，应用程序用EC_IOCTL_CYCLIC_WAIT等待每个周期。
+ * @param master EtherCAT主控制器。
+ * @param arg ioctl()参数。
+ * @return 成功返回零，否则返回负错误代码。
+ */
+static ATTRIBUTES int ec_ioctl_cyclic_start(
     ec_master_t *master, /**< EtherCAT主控制器。 */
     void *arg            /**< ioctl()参数。 */
 )
 {
-    ec_ioctl_slave_sdo_download_t data;
-    uint8_t *sdo_data;
-    int retval;
+    ec_ioctl_cyclic_t data;
+    ec_cyclic_config_t config;
+    int ret;
 
     if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
     {
         return -EFAULT;
     }
 
-    if (!(sdo_data = kmalloc(data.data_size, GFP_KERNEL)))
+    memset(&config, 0, sizeof(config));
+    config.period_ns = data.period_ns;
+    config.sync0_offset_ns = data.sync0_offset_ns;
+    config.cpu = data.cpu;
+    config.priority = data.priority;
+    config.dc_sync = data.dc_sync ? 1 : 0;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
     {
-        EC_MASTER_ERR(master, "分配 %zu 字节用于SDO下载失败。\n",
-                      data.data_size);
-        return -ENOMEM;
+        return -EINTR;
     }
 
-    if (copy_from_user(sdo_data, (const void __user *)data.data, data.data_size))
+    ret = ecrt_master_cyclic_start(master, &config);
+
+    ec_lock_up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 停止周期引擎。
+ * @param master EtherCAT主控制器。
+ * @return 成功返回零，否则返回负错误代码。
+ */
+static ATTRIBUTES int ec_ioctl_cyclic_stop(
+    ec_master_t *master /**< EtherCAT主控制器。 */
+)
+{
+    int ret;
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        return -EINTR;
+    }
+
+    ret = ecrt_master_cyclic_stop(master);
+
+    ec_lock_up(&master->master_sem);
+    return ret;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 等待周期引擎的下一个周期。
+ * @param master EtherCAT主控制器。
+ * @param arg ioctl()参数。
+ * @return 成功返回零，否则返回负错误代码。
+ */
+static ATTRIBUTES int ec_ioctl_cyclic_wait(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+#ifdef EC_IOCTL_RTDM
+    // 在Linux等待队列上睡眠，不能在实时上下文中使用
+    return -EOPNOTSUPP;
+#else
+    uint64_t cycle;
+    int ret;
+
+    if (copy_from_user(&cycle, (void __user *)arg, sizeof(cycle)))
     {
-        kfree(sdo_data);
         return -EFAULT;
     }
 
-    if (data.complete_access)
+    ret = ecrt_master_cyclic_wait(master, &cycle);
+    if (ret)
     {
-        retval = ecrt_master_sdo_download_complete(master, data.slave_position,
-                                                   data.sdo_index, sdo_data, data.data_size, &data.abort_code);
+        return ret;
     }
-    else
+
+    if (copy_to_user((void __user *)arg, &cycle, sizeof(cycle)))
     {
-        retval = ecrt_master_sdo_download(master, data.slave_position,
-                                          data.sdo_index, data.sdo_entry_subindex, sdo_data,
-                                          data.data_size, &data.abort_code);
+        return -EFAULT;
     }
 
-    kfree(sdo_data);
+    return 0;
+#endif
+}
 
-    if (__copy_to_user((void __user *)arg, &data, sizeof(data)))
+/*****************************************************************************/
+
+/**
+ * @brief 读取周期引擎的状态。
+ * @param master EtherCAT主控制器。
+ * @param arg ioctl()参数。
+ * @return 成功返回零，否则返回负错误代码。
+ */
+static ATTRIBUTES int ec_ioctl_cyclic_state(
+    ec_master_t *master, /**< EtherCAT主控制器。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_cyclic_state_t state;
+
+    memset(&state, 0, sizeof(state));
+    ecrt_master_cyclic_state(master, &state);
+
+    if (copy_to_user((void __user *)arg, &state, sizeof(state)))
     {
-        retval = -EFAULT;
+        return -EFAULT;
     }
 
-    return retval;
+    return 0;
 }
 
 /*****************************************************************************/
@@ -1962,7 +3476,6 @@ static ATTRIBUTES int ec_ioctl_config(
 {
     ec_ioctl_config_t data;
     const ec_slave_config_t *sc;
-    uint8_t i;
 
     if (copy_from_user(&data, (void __user *)arg, sizeof(data)))
     {
@@ -1981,27 +3494,7 @@ static ATTRIBUTES int ec_ioctl_config(
         return -EINVAL;
     }
 
-    data.alias = sc->alias;
-    data.position = sc->position;
-    data.vendor_id = sc->vendor_id;
-    data.product_code = sc->product_code;
-    for (i = 0; i < EC_MAX_SYNC_MANAGERS; i++)
-    {
-        data.syncs[i].dir = sc->sync_configs[i].dir;
-        data.syncs[i].watchdog_mode = sc->sync_configs[i].watchdog_mode;
-        data.syncs[i].pdo_count =
-            ec_pdo_list_count(&sc->sync_configs[i].pdos);
-    }
-    data.watchdog_divider = sc->watchdog_divider;
-    data.watchdog_intervals = sc->watchdog_intervals;
-    data.sdo_count = ec_slave_config_sdo_count(sc);
-    data.idn_count = ec_slave_config_idn_count(sc);
-    data.slave_position = sc->slave ? sc->slave->ring_position : -1;
-    data.dc_assign_activate = sc->dc_assign_activate;
-    for (i = 0; i < EC_SYNC_SIGNAL_COUNT; i++)
-    {
-        data.dc_sync[i] = sc->dc_sync[i];
-    }
+    ec_ioctl_fill_config(&data, sc);
 
     ec_lock_up(&master->master_sem);
 
@@ -2074,9 +3567,7 @@ static ATTRIBUTES int ec_ioctl_config_pdo(
         return -EINVAL;
     }
 
-    data.index = pdo->index;
-    data.entry_count = ec_pdo_entry_count(pdo);
-    ec_ioctl_strcpy(data.name, pdo->name);
+    ec_ioctl_fill_config_pdo(&data, pdo);
 
     ec_lock_up(&master->master_sem);
 
@@ -2160,10 +3651,7 @@ static ATTRIBUTES int ec_ioctl_config_pdo_entry(
         return -EINVAL;
     }
 
-    data.index = entry->index;
-    data.subindex = entry->subindex;
-    data.bit_length = entry->bit_length;
-    ec_ioctl_strcpy(data.name, entry->name);
+    ec_ioctl_fill_config_pdo_entry(&data, entry);
 
     ec_lock_up(&master->master_sem);
 
@@ -3364,6 +4852,69 @@ static ATTRIBUTES int ec_ioctl_master_link_state(
 
 /*****************************************************************************/
 
+/**
+@brief 获取设备的往返时间估计。
+@param master EtherCAT主机。
+@param arg ioctl()参数。
+@param ctx 文件句柄的私有数据结构。
+@return 成功时返回零，否则返回负错误代码。
+*/
+static ATTRIBUTES int ec_ioctl_master_rtt_state(
+    ec_master_t *master,    /**< EtherCAT主机。 */
+    void *arg,              /**< ioctl()参数。 */
+    ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。 */
+)
+{
+    ec_ioctl_rtt_state_t ioctl;
+    ec_master_rtt_state_t state;
+    int ret;
+
+    if (copy_from_user(&ioctl, (void __user *)arg, sizeof(ioctl)))
+    {
+        return -EFAULT;
+    }
+
+    ret = ecrt_master_rtt_state(master, ioctl.dev_idx, &state);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (copy_to_user((void __user *)ioctl.state, &state, sizeof(state)))
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 获取冗余环的状态。
+@param master EtherCAT主机。
+@param arg ioctl()参数。
+@return 成功时返回零，否则返回负错误代码。
+*/
+static ATTRIBUTES int ec_ioctl_master_redundancy_state(
+    ec_master_t *master, /**< EtherCAT主机。 */
+    void *arg            /**< ioctl()参数。 */
+)
+{
+    ec_master_redundancy_state_t state;
+
+    ecrt_master_redundancy_state(master, &state);
+
+    if (copy_to_user((void __user *)arg, &state, sizeof(state)))
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /**
 @brief 设置主机DC应用时间。
 @param master EtherCAT主机。
@@ -3482,32 +5033,69 @@ static ATTRIBUTES int ec_ioctl_sync_slaves(
         return -EPERM;
     }
 
-    ecrt_master_sync_slave_clocks(master);
+    ecrt_master_sync_slave_clocks(master);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 获取参考时钟的系统时间。
+@param master EtherCAT主机。
+@param arg ioctl()参数。
+@param ctx 文件句柄的私有数据结构。
+@return 成功时返回零，否则返回负错误代码。
+@details
+- 检查是否有请求。
+- 获取参考时钟的系统时间。
+- 如果返回值不为零，返回该错误代码。
+- 从内核空间复制数据到用户空间。
+- 返回零。
+*/
+static ATTRIBUTES int ec_ioctl_ref_clock_time(
+    ec_master_t *master,    /**< EtherCAT主机。 */
+    void *arg,              /**< ioctl()参数。 */
+    ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。 */
+)
+{
+    uint32_t time;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+    {
+        return -EPERM;
+    }
+
+    ret = ecrt_master_reference_clock_time(master, &time);
+    if (ret)
+    {
+        return ret;
+    }
+
+    if (copy_to_user((void __user *)arg, &time, sizeof(time)))
+    {
+        return -EFAULT;
+    }
+
     return 0;
 }
 
 /*****************************************************************************/
 
 /**
-@brief 获取参考时钟的系统时间。
+@brief 获取携带参考时钟时间的帧的硬件时间戳。
 @param master EtherCAT主机。
 @param arg ioctl()参数。
 @param ctx 文件句柄的私有数据结构。
 @return 成功时返回零，否则返回负错误代码。
-@details
-- 检查是否有请求。
-- 获取参考时钟的系统时间。
-- 如果返回值不为零，返回该错误代码。
-- 从内核空间复制数据到用户空间。
-- 返回零。
 */
-static ATTRIBUTES int ec_ioctl_ref_clock_time(
+static ATTRIBUTES int ec_ioctl_ref_clock_timestamps(
     ec_master_t *master,    /**< EtherCAT主机。 */
     void *arg,              /**< ioctl()参数。 */
     ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。 */
 )
 {
-    uint32_t time;
+    ec_ioctl_hw_timestamps_t data;
     int ret;
 
     if (unlikely(!ctx->requested))
@@ -3515,13 +5103,14 @@ static ATTRIBUTES int ec_ioctl_ref_clock_time(
         return -EPERM;
     }
 
-    ret = ecrt_master_reference_clock_time(master, &time);
+    ret = ecrt_master_reference_clock_timestamps(master, &data.sent_ns,
+                                                 &data.received_ns);
     if (ret)
     {
         return ret;
     }
 
-    if (copy_to_user((void __user *)arg, &time, sizeof(time)))
+    if (copy_to_user((void __user *)arg, &data, sizeof(data)))
     {
         return -EFAULT;
     }
@@ -4667,10 +6256,7 @@ static ATTRIBUTES int ec_ioctl_sc_create_sdo_request(
         return -ENOENT;
     }
 
-    list_for_each_entry(req, &sc->sdo_requests, list)
-    {
-        data.request_index++;
-    }
+    data.request_index = sc->sdo_request_table.count;
 
     ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
 
@@ -4741,10 +6327,7 @@ static ATTRIBUTES int ec_ioctl_sc_create_foe_request(
         return -ENOENT;
     }
 
-    list_for_each_entry(req, &sc->foe_requests, list)
-    {
-        data.request_index++;
-    }
+    data.request_index = sc->foe_request_table.count;
 
     ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
 
@@ -4814,10 +6397,7 @@ static ATTRIBUTES int ec_ioctl_sc_create_reg_request(
         return -ENOENT;
     }
 
-    list_for_each_entry(reg, &sc->reg_requests, list)
-    {
-        io.request_index++;
-    }
+    io.request_index = sc->reg_request_table.count;
 
     ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
 
@@ -4887,10 +6467,7 @@ static ATTRIBUTES int ec_ioctl_sc_create_voe_handler(
         return -ENOENT;
     }
 
-    list_for_each_entry(voe, &sc->voe_handlers, list)
-    {
-        data.voe_index++;
-    }
+    data.voe_index = sc->voe_handler_table.count;
 
     ec_lock_up(&master->master_sem); /** \todo sc could be invalidated */
 
@@ -5482,6 +7059,8 @@ static ATTRIBUTES int ec_ioctl_sdo_request_read(
     }
 
     ecrt_sdo_request_read(req);
+    ec_req_shm_issue(&master->req_shm, data.config_index, EC_REQ_SHM_SDO,
+                     data.request_index);
     return 0;
 }
 
@@ -5546,6 +7125,8 @@ static ATTRIBUTES int ec_ioctl_sdo_request_write(
 
     req->data_size = data.size;
     ecrt_sdo_request_write(req);
+    ec_req_shm_issue(&master->req_shm, data.config_index, EC_REQ_SHM_SDO,
+                     data.request_index);
     return 0;
 }
 
@@ -5793,6 +7374,8 @@ static ATTRIBUTES int ec_ioctl_foe_request_read(
     }
 
     ecrt_foe_request_read(req);
+    ec_req_shm_issue(&master->req_shm, data.config_index, EC_REQ_SHM_FOE,
+                     data.request_index);
     return 0;
 }
 
@@ -5850,6 +7433,8 @@ static ATTRIBUTES int ec_ioctl_foe_request_write(
     }
 
     ecrt_foe_request_write(req, data.size);
+    ec_req_shm_issue(&master->req_shm, data.config_index, EC_REQ_SHM_FOE,
+                     data.request_index);
     return 0;
 }
 
@@ -6083,6 +7668,8 @@ static ATTRIBUTES int ec_ioctl_reg_request_write(
     }
 
     ecrt_reg_request_write(reg, io.address, io.transfer_size);
+    ec_req_shm_issue(&master->req_shm, io.config_index, EC_REQ_SHM_REG,
+                     io.request_index);
     return 0;
 }
 
@@ -6142,6 +7729,8 @@ static ATTRIBUTES int ec_ioctl_reg_request_read(
     }
 
     ecrt_reg_request_read(reg, io.address, io.transfer_size);
+    ec_req_shm_issue(&master->req_shm, io.config_index, EC_REQ_SHM_REG,
+                     io.request_index);
     return 0;
 }
 
@@ -6208,6 +7797,8 @@ static ATTRIBUTES int ec_ioctl_reg_request_readwrite(
     }
 
     ecrt_reg_request_readwrite(reg, io.address, io.transfer_size);
+    ec_req_shm_issue(&master->req_shm, io.config_index, EC_REQ_SHM_REG,
+                     io.request_index);
     return 0;
 }
 
@@ -6601,6 +8192,73 @@ static ATTRIBUTES int ec_ioctl_voe_data(
 
 /*****************************************************************************/
 
+/**
+@brief 建立异步请求的共享状态区域。
+@param master EtherCAT主机。
+@param arg ioctl()参数。
+@param ctx 文件句柄的私有数据结构。
+@return 成功时返回零，否则返回负错误代码。
+@details 区域只能在主站激活后建立，之后可以通过mmap()只读映射
+（EC_IOCTL_MMAP_REQ_SHM）。区域已建立时只更新完成通知的eventfd。
+*/
+static ATTRIBUTES int ec_ioctl_req_shm(
+    ec_master_t *master,    /**< EtherCAT主机。 */
+    void *arg,              /**< ioctl()参数。 */
+    ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。 */
+)
+{
+    ec_ioctl_req_shm_t io;
+    int ret;
+
+    if (unlikely(!ctx->requested))
+    {
+        return -EPERM;
+    }
+
+    if (copy_from_user(&io, (void __user *)arg, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        return -EINTR;
+    }
+
+    if (!master->active)
+    {
+        ec_lock_up(&master->master_sem);
+        return -EAGAIN;
+    }
+
+    ret = ec_req_shm_setup(&master->req_shm);
+    if (!ret)
+    {
+        ret = ec_req_shm_set_eventfd(&master->req_shm, io.eventfd);
+    }
+    if (!ret)
+    {
+        io.map_size = master->req_shm.mem_size;
+        io.slot_count = master->req_shm.header->slot_count;
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    if (ret)
+    {
+        return ret;
+    }
+
+    if (copy_to_user((void __user *)arg, &io, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /**
 @brief 通过FoE从从站读取文件。
 @param master：EtherCAT主站。
@@ -7154,6 +8812,159 @@ static ATTRIBUTES int ec_ioctl_mbox_gateway(
 
 /*****************************************************************************/
 
+/**
+@brief 提交异步邮箱网关请求。
+@param master EtherCAT主站。
+@param arg ioctl()参数。
+@param ctx 文件句柄的私有数据结构。
+@return 成功返回0，否则返回负的错误代码。
+@details 请求排队后立即返回请求ID，结果通过EC_IOCTL_MBG_COMPLETE收集。
+应答会写回提交时的用户空间缓冲区。
+*/
+static ATTRIBUTES int ec_ioctl_mbg_submit(
+    ec_master_t *master,    /**< EtherCAT主站。*/
+    void *arg,              /**< ioctl()参数。*/
+    ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。*/
+)
+{
+    ec_ioctl_mbg_submit_t io;
+    ec_mbg_async_t *async;
+    int ret;
+
+    if (copy_from_user(&io, (void __user *)arg, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    if (io.data_size < EC_MBOX_HEADER_SIZE || io.data_size > io.buff_size)
+    {
+        return -EINVAL;
+    }
+
+    if (!(async = ec_mbg_async_alloc()))
+    {
+        return -ENOMEM;
+    }
+
+    ret = ec_mbg_request_alloc(&async->req, io.buff_size);
+    if (ret)
+    {
+        ec_mbg_async_free(async);
+        return ret;
+    }
+
+    if (copy_from_user(async->req.data, (void __user *)io.data, io.data_size))
+    {
+        ec_mbg_async_free(async);
+        return -EFAULT;
+    }
+    async->req.data_size = io.data_size;
+    async->target = (void __user *)io.data;
+    async->buff_size = io.buff_size;
+
+    ret = ec_master_mbg_submit(master, &ctx->mbg, async);
+    if (ret)
+    {
+        ec_mbg_async_free(async);
+        return ret;
+    }
+
+    // 从这里开始请求归队列所有，只能通过EC_IOCTL_MBG_COMPLETE取走
+    io.id = async->id;
+
+    if (copy_to_user((void __user *)arg, &io, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 收集已完成的异步邮箱网关请求。
+@param master EtherCAT主站。
+@param arg ioctl()参数。
+@param ctx 文件句柄的私有数据结构。
+@return 成功返回0，否则返回负的错误代码。
+@details 按完成顺序最多取走\a max_count 个结果，并把应答数据复制到提交时的
+缓冲区。设置\a wait 且没有已完成的请求时，等待直到至少一个请求完成；
+没有未完成的请求时立即返回。
+*/
+static ATTRIBUTES int ec_ioctl_mbg_complete(
+    ec_master_t *master,    /**< EtherCAT主站。*/
+    void *arg,              /**< ioctl()参数。*/
+    ec_ioctl_context_t *ctx /**< 文件句柄的私有数据结构。*/
+)
+{
+    ec_ioctl_mbg_complete_t io;
+    ec_ioctl_mbg_result_t result;
+    ec_mbg_async_t *async;
+
+    if (copy_from_user(&io, (void __user *)arg, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    if (io.wait && ec_mbg_queue_outstanding(&ctx->mbg))
+    {
+        if (wait_event_interruptible(master->request_queue,
+                                     ec_mbg_queue_done(&ctx->mbg)))
+        {
+            return -EINTR;
+        }
+    }
+
+    io.count = 0;
+    while (io.count < io.max_count &&
+           (async = ec_mbg_queue_pop_done(&ctx->mbg)))
+    {
+        result.id = async->id;
+        result.data_size = 0;
+
+        if (async->req.state != EC_INT_REQUEST_SUCCESS)
+        {
+            result.error = async->req.error_code ?
+                               -async->req.error_code : -EIO;
+        }
+        else if (async->req.data_size > async->buff_size)
+        {
+            result.error = -EOVERFLOW;
+        }
+        else if (copy_to_user(async->target, async->req.data,
+                              async->req.data_size))
+        {
+            result.error = -EFAULT;
+        }
+        else
+        {
+            result.error = 0;
+            result.data_size = async->req.data_size;
+        }
+
+        ec_mbg_async_free(async);
+
+        if (copy_to_user((void __user *)(io.results + io.count),
+                         &result, sizeof(result)))
+        {
+            return -EFAULT;
+        }
+        io.count++;
+    }
+
+    io.outstanding = ec_mbg_queue_outstanding(&ctx->mbg);
+
+    if (copy_to_user((void __user *)arg, &io, sizeof(io)))
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /** 
 @brief 使用的ioctl()函数。
 */
@@ -7221,6 +9032,40 @@ long EC_IOCTL(
     case EC_IOCTL_PCAP_DATA:
         ret = ec_ioctl_pcap_data(master, arg);
         break;
+    case EC_IOCTL_MASTER_HISTOGRAMS:
+        ret = ec_ioctl_master_histograms(master, arg, ctx);
+        break;
+    case EC_IOCTL_PCAP_FILTER:
+        ret = ec_ioctl_pcap_filter(master, arg, ctx);
+        break;
+    case EC_IOCTL_SCOPE:
+        ret = ec_ioctl_scope(master, arg, ctx);
+        break;
+    case EC_IOCTL_SLAVE_SDO_DICT_EXPORT:
+        ret = ec_ioctl_slave_sdo_dict_export(master, arg);
+        break;
+    case EC_IOCTL_DICT_CACHE_GET:
+        ret = ec_ioctl_dict_cache_get(master, arg);
+        break;
+    case EC_IOCTL_DICT_CACHE_ADD:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_dict_cache_add(master, arg);
+        break;
+    case EC_IOCTL_DICT_CACHE_CLEAR:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_dict_cache_clear(master);
+        break;
+    case EC_IOCTL_SNAPSHOT:
+        ret = ec_ioctl_snapshot(master, arg);
+        break;
     case EC_IOCTL_MASTER_DEBUG:
         if (!ctx->writable)
         {
@@ -7270,6 +9115,72 @@ long EC_IOCTL(
         }
         ret = ec_ioctl_slave_sdo_download(master, arg);
         break;
+    case EC_IOCTL_SDO_BATCH:
+        ret = ec_ioctl_sdo_batch(master, arg, ctx);
+        break;
+    case EC_IOCTL_REQUEST_STATE:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_request_state(master, arg);
+        break;
+    case EC_IOCTL_CRC_MONITOR:
+        ret = ec_ioctl_crc_monitor(master, arg);
+        break;
+    case EC_IOCTL_CRC_MONITOR_INTERVAL:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_crc_monitor_interval(master, arg);
+        break;
+    case EC_IOCTL_SCHED:
+        ret = ec_ioctl_sched(master, arg);
+        break;
+    case EC_IOCTL_SCHED_WEIGHT:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_sched_weight(master, arg);
+        break;
+    case EC_IOCTL_THREAD:
+        ret = ec_ioctl_thread(master, arg);
+        break;
+    case EC_IOCTL_THREAD_SET:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_thread_set(master, arg);
+        break;
+    case EC_IOCTL_CYCLIC_START:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_cyclic_start(master, arg);
+        break;
+    case EC_IOCTL_CYCLIC_STOP:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_cyclic_stop(master);
+        break;
+    case EC_IOCTL_CYCLIC_WAIT:
+        ret = ec_ioctl_cyclic_wait(master, arg);
+        break;
+    case EC_IOCTL_CYCLIC_STATE:
+        ret = ec_ioctl_cyclic_state(master, arg);
+        break;
     case EC_IOCTL_SLAVE_SII_READ:
         ret = ec_ioctl_slave_sii_read(master, arg);
         break;
@@ -7456,6 +9367,12 @@ long EC_IOCTL(
     case EC_IOCTL_MASTER_LINK_STATE:
         ret = ec_ioctl_master_link_state(master, arg, ctx);
         break;
+    case EC_IOCTL_MASTER_RTT_STATE:
+        ret = ec_ioctl_master_rtt_state(master, arg, ctx);
+        break;
+    case EC_IOCTL_MASTER_REDUNDANCY_STATE:
+        ret = ec_ioctl_master_redundancy_state(master, arg);
+        break;
     case EC_IOCTL_APP_TIME:
         if (!ctx->writable)
         {
@@ -7496,6 +9413,9 @@ long EC_IOCTL(
         }
         ret = ec_ioctl_ref_clock_time(master, arg, ctx);
         break;
+    case EC_IOCTL_REF_CLOCK_TIMESTAMPS:
+        ret = ec_ioctl_ref_clock_timestamps(master, arg, ctx);
+        break;
     case EC_IOCTL_64_REF_CLK_TIME_QUEUE:
         if (!ctx->writable)
         {
@@ -7887,6 +9807,14 @@ long EC_IOCTL(
     case EC_IOCTL_VOE_DATA:
         ret = ec_ioctl_voe_data(master, arg, ctx);
         break;
+    case EC_IOCTL_REQ_SHM:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_req_shm(master, arg, ctx);
+        break;
     case EC_IOCTL_SET_SEND_INTERVAL:
         if (!ctx->writable)
         {
@@ -7924,6 +9852,17 @@ long EC_IOCTL(
         }
         ret = ec_ioctl_mbox_gateway(master, arg, ctx);
         break;
+    case EC_IOCTL_MBG_SUBMIT:
+        if (!ctx->writable)
+        {
+            ret = -EPERM;
+            break;
+        }
+        ret = ec_ioctl_mbg_submit(master, arg, ctx);
+        break;
+    case EC_IOCTL_MBG_COMPLETE:
+        ret = ec_ioctl_mbg_complete(master, arg, ctx);
+        break;
     default:
         ret = -ENOTTY;
         break;
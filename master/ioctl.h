@@ -56,7 +56,7 @@
  *
  * 在更改ioctl接口时递增该值！
  */
-#define EC_IOCTL_VERSION_MAGIC 36
+#define EC_IOCTL_VERSION_MAGIC 57
 
 // 命令行工具
 #define EC_IOCTL_MODULE EC_IOR(0x00, ec_ioctl_module_t)  // 模块IOCTL
@@ -191,6 +191,51 @@
 // 邮箱网关
 #define EC_IOCTL_MBOX_GATEWAY EC_IOWR(0x73, ec_ioctl_mbox_gateway_t)  // 邮箱网关
 
+#define EC_IOCTL_MASTER_HISTOGRAMS EC_IOWR(0x74, ec_ioctl_master_histograms_t)  // 主站热路径直方图
+#define EC_IOCTL_PCAP_FILTER EC_IOWR(0x75, ec_ioctl_pcap_filter_t)  // PCAP捕获过滤器
+#define EC_IOCTL_SCOPE EC_IOWR(0x76, ec_ioctl_scope_t)  // 过程数据记录器
+#define EC_IOCTL_SLAVE_SDO_DICT_EXPORT EC_IOWR(0x77, ec_ioctl_slave_sdo_dict_export_t)  // 导出整个SDO字典
+#define EC_IOCTL_DICT_CACHE_GET EC_IOWR(0x78, ec_ioctl_dict_cache_t)  // 读取字典缓存条目
+#define EC_IOCTL_DICT_CACHE_ADD EC_IOW(0x79, ec_ioctl_dict_cache_t)  // 添加字典缓存条目
+#define EC_IOCTL_DICT_CACHE_CLEAR EC_IO(0x7a)  // 清空字典缓存
+#define EC_IOCTL_REQ_SHM EC_IOWR(0x7b, ec_ioctl_req_shm_t)  // 异步请求的共享状态区域
+#define EC_IOCTL_SNAPSHOT EC_IOWR(0x7c, ec_ioctl_snapshot_t)  // 拓扑和状态的批量快照
+#define EC_IOCTL_MBG_SUBMIT EC_IOWR(0x7d, ec_ioctl_mbg_submit_t)  // 提交异步邮箱网关请求
+#define EC_IOCTL_MBG_COMPLETE EC_IOWR(0x7e, ec_ioctl_mbg_complete_t)  // 收集已完成的邮箱网关请求
+#define EC_IOCTL_SDO_BATCH EC_IOWR(0x7f, ec_ioctl_sdo_batch_t)  // 批量SDO上传/下载
+#define EC_IOCTL_REQUEST_STATE EC_IOW(0x80, ec_ioctl_request_state_t)  // 为一组从站配置请求状态
+#define EC_IOCTL_CRC_MONITOR EC_IOWR(0x81, ec_ioctl_crc_monitor_t)  // 读取所有从站的错误计数器
+#define EC_IOCTL_CRC_MONITOR_INTERVAL EC_IO(0x82)  // 设置错误计数器的采样间隔
+#define EC_IOCTL_MASTER_RTT_STATE EC_IOWR(0x83, ec_ioctl_rtt_state_t)  // 设备的往返时间估计
+#define EC_IOCTL_REF_CLOCK_TIMESTAMPS EC_IOR(0x84, ec_ioctl_hw_timestamps_t)  // 参考时钟帧的硬件时间戳
+#define EC_IOCTL_SCHED EC_IOR(0x85, ec_ioctl_sched_t)  // 非周期数据报调度的统计
+#define EC_IOCTL_SCHED_WEIGHT EC_IOW(0x86, ec_ioctl_sched_weight_t)  // 设置调度类别的权重
+#define EC_IOCTL_MASTER_REDUNDANCY_STATE EC_IOR(0x87, ec_master_redundancy_state_t)  // 冗余环的状态
+#define EC_IOCTL_THREAD EC_IOWR(0x88, ec_ioctl_thread_t)  // 主站线程的亲和性和调度参数
+#define EC_IOCTL_THREAD_SET EC_IOW(0x89, ec_ioctl_thread_t)  // 设置主站线程的亲和性和调度参数
+#define EC_IOCTL_CYCLIC_START EC_IOW(0x8A, ec_ioctl_cyclic_t)  // 启动周期引擎
+#define EC_IOCTL_CYCLIC_STOP EC_IO(0x8B)  // 停止周期引擎
+#define EC_IOCTL_CYCLIC_WAIT EC_IOWR(0x8C, uint64_t)  // 等待周期引擎的下一个周期
+#define EC_IOCTL_CYCLIC_STATE EC_IOR(0x8D, ec_cyclic_state_t)  // 周期引擎的状态
+
+/*****************************************************************************/
+
+/** mmap()偏移量的区域划分。
+ *
+ * 偏移量的高位选择映射的区域，低位是区域内的偏移量。区域0是过程数据，
+ * 保持与旧版本兼容。
+ */
+#define EC_IOCTL_MMAP_REGION_SHIFT 28
+#define EC_IOCTL_MMAP_REGION_SIZE (1UL << EC_IOCTL_MMAP_REGION_SHIFT)
+#define EC_IOCTL_MMAP_OFFSET(region) \
+    ((unsigned long) (region) << EC_IOCTL_MMAP_REGION_SHIFT)
+
+#define EC_IOCTL_MMAP_PROCESS_DATA 0  // 过程数据（读写）
+#define EC_IOCTL_MMAP_PCAP 1  // pcap捕获环（只读）
+#define EC_IOCTL_MMAP_SCOPE 2  // 过程数据记录环（只读）
+#define EC_IOCTL_MMAP_REQ_SHM 3  // 异步请求的共享状态区域（只读）
+#define EC_IOCTL_MMAP_EMERG 4  // CoE紧急消息日志（只读）
+
 /*****************************************************************************/
 
 #define EC_IOCTL_STRING_SIZE 64  // 字符串大小
@@ -230,6 +275,10 @@ typedef struct
         int32_t rx_frame_rates[EC_RATE_COUNT];  // 接收帧速率
         int32_t tx_byte_rates[EC_RATE_COUNT];  // 发送字节速率
         int32_t rx_byte_rates[EC_RATE_COUNT];  // 接收字节速率
+        uint32_t rtt_samples;  // 往返时间的采样数
+        uint32_t rtt_ns;  // 平滑后的往返时间
+        uint32_t rtt_var_ns;  // 往返时间的平均偏差
+        uint32_t rtt_peak_ns;  // 往返时间的衰减峰值
     } devices[EC_MAX_NUM_DEVICES];  // 设备列表
     uint32_t num_devices;  // 设备数量
     uint64_t tx_count;  // 总发送计数
@@ -245,6 +294,7 @@ typedef struct
     uint64_t dc_ref_time;  // DC参考时间
     uint16_t ref_clock;  // 参考时钟
     uint32_t pcap_size;  // PCAP文件大小
+    uint32_t emerg_map_size;  // CoE紧急消息日志映射区域的大小
 } ec_ioctl_master_t;
 
 /*****************************************************************************/
@@ -403,6 +453,161 @@ typedef struct
 
 /*****************************************************************************/
 
+typedef struct
+{
+    // 输入
+    uint8_t set;  // 非零时应用下列设置，否则只读取当前设置
+
+    // 输入/输出
+    uint32_t snaplen;  // 每帧最多捕获的字节数，0表示完整帧
+    uint32_t type_mask;  // 按数据报类型过滤的位掩码（1 << 类型），0表示不过滤
+    uint8_t address_filter;  // 非零时按从站地址过滤
+    uint16_t address;  // 配置的站点地址，匹配FPRD/FPWR/FPRW/FRMW数据报
+} ec_ioctl_pcap_filter_t;
+
+/*****************************************************************************/
+
+/** pcap捕获环的魔数（"ECPC"）。 */
+#define EC_PCAP_RING_MAGIC 0x45435043
+
+/** pcap捕获环的布局版本。 */
+#define EC_PCAP_RING_VERSION 2
+
+/** pcap捕获环的头部，位于映射区域的起始位置。
+ *
+ * 写入端（主站的发送/接收上下文）是唯一的生产者，读取端通过mmap()只读
+ * 访问。位置是以字节计的32位递增计数，在数据区内的偏移量为
+ * 位置 & (data_size - 1)。生产者覆盖旧记录之前先推进\a tail，写入新记录
+ * 之后再推进\a head（中间有写内存屏障）。读取端复制一条记录后重新读取
+ * \a tail，如果记录位置已落后于\a tail，则该记录已被覆盖，应丢弃。
+ */
+typedef struct
+{
+    uint32_t magic;  // EC_PCAP_RING_MAGIC
+    uint32_t version;  // EC_PCAP_RING_VERSION
+    uint32_t data_offset;  // 数据区在映射区域中的偏移量
+    uint32_t data_size;  // 数据区大小（2的幂）
+    uint32_t head;  // 生产者位置：下一条记录的写入位置
+    uint32_t tail;  // 最早的有效记录的位置
+    uint32_t snaplen;  // 当前快照长度，0表示完整帧
+    uint32_t filtered;  // 被过滤器丢弃的帧数
+} ec_pcap_ring_header_t;
+
+/** pcap记录标志。 */
+#define EC_PCAP_FLAG_TX 0x01  // 发送的帧（否则为接收的帧）
+#define EC_PCAP_FLAG_PAD 0x80  // 填充记录，用于跳过数据区末尾的空间
+
+/** pcap记录的对齐字节数。 */
+#define EC_PCAP_RECORD_ALIGN 8
+
+/** pcap捕获环中一条记录的头部，后跟\a caplen字节的帧数据。
+ *
+ * 如果数据区末尾剩余的空间不足以容纳一个记录头，则生产者隐式跳过这段
+ * 空间，不写入填充记录。
+ */
+typedef struct
+{
+    uint32_t size;  // 记录总长度（含头部，按EC_PCAP_RECORD_ALIGN对齐）
+    uint16_t caplen;  // 捕获的字节数
+    uint16_t origlen;  // 原始帧长度
+    uint64_t timestamp;  // 时间戳 [ns，自UNIX纪元起]
+    uint8_t device;  // 设备索引（ec_device_index_t）
+    uint8_t flags;  // EC_PCAP_FLAG_*
+    uint8_t reserved[6];  // 保留
+} ec_pcap_record_t;
+
+/*****************************************************************************/
+
+/** 过程数据记录器的最大通道数。 */
+#define EC_SCOPE_MAX_CHANNELS 32
+
+/** 过程数据记录器的触发边沿。 */
+#define EC_SCOPE_EDGE_RISING 0  // 上升沿：值从低于阈值变为不低于阈值
+#define EC_SCOPE_EDGE_FALLING 1  // 下降沿：值从高于阈值变为不高于阈值
+
+typedef struct
+{
+    uint32_t domain_index;  // 域索引
+    uint32_t offset;  // 域内的字节偏移量
+    uint8_t bit_position;  // 起始位（0-7）
+    uint8_t bit_length;  // 位长度（1-64）
+} ec_ioctl_scope_channel_t;
+
+typedef struct
+{
+    // 输入
+    uint32_t channel_count;  // 通道数，0表示停止记录
+    ec_ioctl_scope_channel_t channels[EC_SCOPE_MAX_CHANNELS];  // 通道
+    uint32_t depth;  // 记录环可容纳的采样数（向上取整为2的幂）
+    uint8_t trigger_enable;  // 启用触发检测
+    uint8_t trigger_channel;  // 触发通道
+    uint8_t trigger_edge;  // EC_SCOPE_EDGE_*
+    uint8_t trigger_signed;  // 按有符号数比较触发通道的值
+    int64_t trigger_level;  // 触发阈值
+
+    // 输出
+    uint32_t map_size;  // 记录环的映射大小
+} ec_ioctl_scope_t;
+
+/** 过程数据记录环的魔数（"ECSC"）。 */
+#define EC_SCOPE_RING_MAGIC 0x45435343
+
+/** 过程数据记录环的布局版本。 */
+#define EC_SCOPE_RING_VERSION 1
+
+/** 过程数据记录环的头部，位于映射区域的起始位置。
+ *
+ * 每次处理采样域（第一个通道所在的域）时写入一个采样。采样大小固定，
+ * 序号为n的采样位于数据区的(n & (depth - 1)) * sample_size处。生产者写完
+ * 采样后才递增\a head，因此读取端复制序号为n的采样后，如果\a head - n
+ * 仍小于\a depth，则该采样未被覆盖。
+ */
+typedef struct
+{
+    uint32_t magic;  // EC_SCOPE_RING_MAGIC
+    uint32_t version;  // EC_SCOPE_RING_VERSION
+    uint32_t data_offset;  // 数据区在映射区域中的偏移量
+    uint32_t depth;  // 记录环可容纳的采样数（2的幂）
+    uint32_t sample_size;  // 每个采样的字节数
+    uint32_t channel_count;  // 通道数
+    uint32_t head;  // 已写入的采样数（下一个采样的序号）
+    uint32_t trigger_count;  // 触发次数
+    uint32_t trigger_seq;  // 最近一次触发的采样序号
+} ec_scope_ring_header_t;
+
+/** 采样标志。 */
+#define EC_SCOPE_FLAG_TRIGGER 0x01  // 该采样满足触发条件
+
+/** 过程数据记录环中的一个采样，后跟channel_count个uint64_t原始值
+ * （按通道位长度零扩展）。
+ */
+typedef struct
+{
+    uint32_t seq;  // 采样序号
+    uint32_t flags;  // EC_SCOPE_FLAG_*
+    uint64_t timestamp;  // 时间戳 [ns，自UNIX纪元起]
+    uint64_t app_time;  // 应用程序时间（ecrt_master_application_time()）
+} ec_scope_sample_t;
+
+/*****************************************************************************/
+
+typedef struct
+{
+    // 输入
+    uint8_t reset;  // 读取后复位直方图
+
+    // 输出
+    struct
+    {
+        uint32_t buckets[EC_HIST_BUCKETS];  // 以2为底的对数桶计数
+        uint64_t count;  // 样本数
+        uint64_t sum;  // 样本之和
+        uint32_t max;  // 最大样本值
+    } hist[EC_HIST_COUNT];  // 见ec_hist_index_t
+} ec_ioctl_master_histograms_t;
+
+/*****************************************************************************/
+
 typedef struct
 {
     // 输入
@@ -476,6 +681,67 @@ typedef struct
 
 /*****************************************************************************/
 
+/** EC_IOCTL_SDO_BATCH中所有操作的数据总大小的上限。
+ */
+#define EC_SDO_BATCH_MAX_DATA (4 * 1024 * 1024)
+
+typedef struct
+{
+    // 输入
+    ec_sdo_batch_item_t *items;  // 操作数组，结果写回其中
+    uint32_t count;  // 操作数
+
+    // 输出
+    uint32_t failed;  // 失败的操作数
+} ec_ioctl_sdo_batch_t;
+
+/*****************************************************************************/
+
+typedef struct
+{
+    // 输入
+    uint32_t *config_indices;  // 从站配置索引数组
+    uint32_t count;  // 从站配置数
+    uint8_t al_state;  // 请求的AL状态
+} ec_ioctl_request_state_t;
+
+/*****************************************************************************/
+
+/** 错误计数器的索引，见ec_ioctl_crc_slave_t。
+ */
+#define EC_CRC_IDX_RX 0  // 无效帧计数器（0x0300 + 2 * 端口）
+#define EC_CRC_IDX_PHY 1  // RX错误计数器（0x0301 + 2 * 端口）
+#define EC_CRC_IDX_FWD 2  // 转发的RX错误计数器（0x0308 + 端口）
+#define EC_CRC_IDX_LOST_LINK 3  // 链路丢失计数器（0x0310 + 端口）
+#define EC_CRC_IDX_COUNT 4
+
+typedef struct
+{
+    uint32_t total[EC_MAX_PORTS][EC_CRC_IDX_COUNT];  // 累计值
+    uint32_t delta[EC_MAX_PORTS][EC_CRC_IDX_COUNT];  // 最近一次采样的增量
+    uint8_t saturated[EC_MAX_PORTS];  // 最近一次采样中饱和的计数器（位掩码）
+    uint32_t epu_total;  // 累计的处理单元错误（0x030C）
+    uint32_t pdi_total;  // 累计的PDI错误（0x030D）
+    uint32_t epu_delta;  // 最近一次处理单元错误的增量
+    uint32_t pdi_delta;  // 最近一次PDI错误的增量
+    uint8_t valid;  // 至少读取过一次
+} ec_ioctl_crc_slave_t;
+
+typedef struct
+{
+    // 输入
+    ec_ioctl_crc_slave_t *slaves;  // 每个从站一个条目
+    uint32_t max_slaves;  // 数组的条目数
+
+    // 输出
+    uint32_t slave_count;  // 写入的条目数
+    uint32_t interval_ms;  // 采样间隔，0表示停用
+    uint32_t sweeps;  // 完成的采样次数
+    uint32_t sweep_interval_us;  // 增量对应的时间，用于计算速率
+} ec_ioctl_crc_monitor_t;
+
+/*****************************************************************************/
+
 typedef struct
 {
     // 输入
@@ -921,6 +1187,94 @@ typedef struct
 
 /*****************************************************************************/
 
+typedef struct
+{
+    // 输入
+    uint32_t dev_idx;  // 设备索引
+
+    // 输出
+    ec_master_rtt_state_t *state;  // 往返时间估计指针
+} ec_ioctl_rtt_state_t;
+
+/*****************************************************************************/
+
+typedef struct
+{
+    // 输出
+    uint64_t sent_ns;  // 网卡的发送时间戳
+    uint64_t received_ns;  // 网卡的接收时间戳
+} ec_ioctl_hw_timestamps_t;
+
+/*****************************************************************************/
+
+/** 调度类别的数量，顺序与主站的ec_sched_class_t相同：状态机、CoE、EoE、
+ * FoE、邮箱网关、寄存器、周期。
+ */
+#define EC_IOCTL_SCHED_CLASSES 7
+
+typedef struct
+{
+    uint64_t datagrams;  // 发送的数据报数
+    uint64_t bytes;  // 发送的字节数（包括数据报头）
+    uint64_t deferred;  // 因字节预算不足推迟的次数
+    uint64_t timeouts;  // 等待超时而丢弃的数据报数
+    uint32_t max_wait_us;  // 最长等待时间（微秒）
+    uint32_t weight;  // 权重，周期类别为0
+} ec_ioctl_sched_class_t;
+
+typedef struct
+{
+    // 输出
+    ec_ioctl_sched_class_t classes[EC_IOCTL_SCHED_CLASSES];  // 各类别
+    uint32_t send_interval;  // 发送间隔（微秒）
+    uint32_t budget;  // 每个周期的字节预算
+} ec_ioctl_sched_t;
+
+typedef struct
+{
+    // 输入
+    uint32_t sched_class;  // 类别
+    uint32_t weight;  // 权重，至少为1
+} ec_ioctl_sched_weight_t;
+
+/*****************************************************************************/
+
+/** 线程类型的数量，顺序与主站的ec_thread_type_t相同：空闲/运行线程、
+ * EoE线程、周期引擎的线程。
+ */
+#define EC_IOCTL_THREADS 3
+
+/** CPU列表字符串的最大长度。
+ */
+#define EC_IOCTL_CPU_LIST_SIZE 128
+
+typedef struct
+{
+    // 输入
+    uint32_t thread;  // 线程类型
+    // 输入/输出
+    char cpus[EC_IOCTL_CPU_LIST_SIZE];  // 允许运行的CPU列表，例如 "2-3"
+    int32_t policy;  // 调度策略（SCHED_OTHER、SCHED_FIFO或SCHED_RR）
+    int32_t priority;  // 实时优先级，SCHED_OTHER时为nice值
+    // 输出
+    int32_t pid;  // 线程ID，0表示线程没有运行
+    int32_t cpu;  // 线程最近运行的CPU
+} ec_ioctl_thread_t;
+
+/*****************************************************************************/
+
+typedef struct
+{
+    // 输入
+    uint32_t period_ns;  // 周期（纳秒）
+    int32_t sync0_offset_ns;  // 相对于SYNC0事件的相位（纳秒）
+    int32_t cpu;  // 绑定的CPU，-1表示不绑定
+    int32_t priority;  // SCHED_FIFO优先级
+    uint8_t dc_sync;  // 每个周期同步分布式时钟
+} ec_ioctl_cyclic_t;
+
+/*****************************************************************************/
+
 typedef struct
 {
     // 输入
@@ -929,6 +1283,248 @@ typedef struct
 
 /*****************************************************************************/
 
+/** 导出缓冲区中的SDO记录。
+ *
+ * 后面紧跟 \a entry_count 个 ec_ioctl_sdo_export_entry_t。
+ */
+typedef struct
+{
+    uint16_t sdo_index;  // SDO索引
+    uint8_t object_code;  // 对象码
+    uint8_t max_subindex;  // 最大子索引
+    uint16_t entry_count;  // 后续条目记录数
+    uint16_t reserved;
+    int8_t name[EC_IOCTL_STRING_SIZE];  // 名称
+} ec_ioctl_sdo_export_sdo_t;
+
+/** 导出缓冲区中的SDO条目记录。
+ */
+typedef struct
+{
+    uint8_t subindex;  // 子索引
+    uint8_t read_access[EC_SDO_ENTRY_ACCESS_COUNT];  // 读访问权限
+    uint8_t write_access[EC_SDO_ENTRY_ACCESS_COUNT];  // 写访问权限
+    uint16_t data_type;  // 数据类型
+    uint16_t bit_length;  // 位长度
+    int8_t description[EC_IOCTL_STRING_SIZE];  // 描述
+} ec_ioctl_sdo_export_entry_t;
+
+typedef struct
+{
+    // 输入
+    uint16_t slave_position;  // 从站位置
+    uint32_t buffer_size;  // 缓冲区大小
+    uint8_t *buffer;  // 缓冲区，可以为NULL以只查询所需大小
+
+    // 输出
+    uint32_t data_size;  // 整个字典所需的字节数
+    uint32_t sdo_count;  // 已写入的SDO记录数，缓冲区不足时为零
+    uint32_t entry_count;  // 已写入的条目记录数
+} ec_ioctl_slave_sdo_dict_export_t;
+
+/*****************************************************************************/
+
+/** 字典缓存条目的最大大小。 */
+#define EC_DICT_CACHE_MAX_SIZE (16 * 1024 * 1024)
+
+typedef struct
+{
+    // 输入
+    uint32_t position;  // 条目位置（GET）
+    uint32_t buffer_size;  // 缓冲区大小（GET）
+    uint8_t *buffer;  // 打包的字典，格式同EC_IOCTL_SLAVE_SDO_DICT_EXPORT
+
+    // 输入（ADD）/输出（GET）
+    uint32_t vendor_id;  // 厂商ID
+    uint32_t product_code;  // 产品代码
+    uint32_t revision_number;  // 修订号
+    uint32_t data_size;  // 打包的字典大小
+
+    // 输出
+    uint32_t entry_count;  // 缓存条目总数
+    uint32_t sdo_count;  // 已复制的SDO数量，缓冲区不足时为零
+} ec_ioctl_dict_cache_t;
+
+/*****************************************************************************/
+
+typedef struct
+{
+    // 输入
+    int32_t eventfd;  // 请求完成时通知的eventfd，-1表示不通知
+
+    // 输出
+    uint32_t map_size;  // 共享状态区域的映射大小
+    uint32_t slot_count;  // 状态槽数量
+} ec_ioctl_req_shm_t;
+
+/** 异步请求共享状态区域的魔数（"ECRQ"）。 */
+#define EC_REQ_SHM_MAGIC 0x45435251
+
+/** 异步请求共享状态区域的布局版本。 */
+#define EC_REQ_SHM_VERSION 1
+
+/** 状态槽对应的请求类型。 */
+#define EC_REQ_SHM_SDO 0  // ec_sdo_request_t
+#define EC_REQ_SHM_FOE 1  // ec_foe_request_t
+#define EC_REQ_SHM_REG 2  // ec_reg_request_t
+
+/** 状态槽标志。 */
+#define EC_REQ_SHM_FLAG_INLINE 0x01  // 数据已复制到槽的数据区
+
+/** 共享状态区域的头部，位于映射区域的起始位置。
+ *
+ * 区域在主站激活后由EC_IOCTL_REQ_SHM建立，每个SDO、FoE和寄存器请求
+ * 对应一个状态槽，停用主站时释放。
+ */
+typedef struct
+{
+    uint32_t magic;  // EC_REQ_SHM_MAGIC
+    uint32_t version;  // EC_REQ_SHM_VERSION
+    uint32_t slot_offset;  // 第一个状态槽在映射区域中的偏移量
+    uint32_t slot_count;  // 状态槽数量
+    uint32_t completions;  // 已发布的完成次数
+} ec_req_shm_header_t;
+
+/** 一个异步请求的状态槽。
+ *
+ * 内核在发起请求的ioctl中递增\a issued。请求结束后，主站在执行从站
+ * 状态机时写入结果和数据，再把\a completed设置为发起时的\a issued
+ * （中间有写内存屏障）。因此\a completed不等于\a issued时请求仍在进行，
+ * 相等时\a state及其他结果字段有效。
+ */
+typedef struct
+{
+    uint32_t config_index;  // 从站配置索引
+    uint32_t request_index;  // 请求在该类型中的索引
+    uint8_t type;  // EC_REQ_SHM_*
+    uint8_t flags;  // EC_REQ_SHM_FLAG_*
+    uint16_t reserved;  // 保留
+    uint32_t issued;  // 发起次数
+    uint32_t completed;  // 最近一次已发布结果对应的发起次数
+    uint32_t state;  // ec_request_state_t
+    uint32_t data_offset;  // 数据区在映射区域中的偏移量
+    uint32_t data_capacity;  // 数据区大小，0表示数据总是通过ioctl读取
+    uint32_t data_size;  // 读取到的数据大小
+    uint32_t progress;  // FoE传输进度
+    uint32_t abort_code;  // SDO中止码或FoE结果（ec_foe_error_t）
+    uint32_t error_code;  // FoE错误码
+} ec_req_shm_slot_t;
+
+/*****************************************************************************/
+
+#define EC_SNAPSHOT_MAGIC 0x45435353  // "ECSS"
+#define EC_SNAPSHOT_VERSION 1
+
+/** 快照的节。
+ *
+ * 每一节是相应单对象ioctl所用结构的数组，输入字段已经填好。同步管理器、
+ * PDO和条目按（从站，同步管理器，PDO）的顺序排列，各层的数量分别由上一层
+ * 记录的sync_count、pdo_count和entry_count给出；配置的PDO和条目同理。
+ * FMMU按域的顺序排列。
+ *
+ * 代数在快照内容变化时递增，但域的工作计数器每个周期都在变化，不参与比较。
+ */
+#define EC_SNAPSHOT_SLAVES 0  // ec_ioctl_slave_t
+#define EC_SNAPSHOT_SYNCS 1  // ec_ioctl_slave_sync_t
+#define EC_SNAPSHOT_PDOS 2  // ec_ioctl_slave_sync_pdo_t
+#define EC_SNAPSHOT_ENTRIES 3  // ec_ioctl_slave_sync_pdo_entry_t
+#define EC_SNAPSHOT_CONFIGS 4  // ec_ioctl_config_t
+#define EC_SNAPSHOT_CONFIG_PDOS 5  // ec_ioctl_config_pdo_t
+#define EC_SNAPSHOT_CONFIG_ENTRIES 6  // ec_ioctl_config_pdo_entry_t
+#define EC_SNAPSHOT_FMMUS 7  // ec_ioctl_domain_fmmu_t
+#define EC_SNAPSHOT_DOMAINS 8  // ec_ioctl_domain_t
+#define EC_SNAPSHOT_SECTION_COUNT 9  // 节数量
+
+/** 快照缓冲区的头部。
+ */
+typedef struct
+{
+    uint32_t magic;  // EC_SNAPSHOT_MAGIC
+    uint32_t version;  // EC_SNAPSHOT_VERSION
+    uint32_t generation;  // 快照代数
+    uint32_t section_count;  // 节数量
+    struct
+    {
+        uint32_t offset;  // 节在缓冲区中的偏移量
+        uint32_t count;  // 记录数
+        uint32_t record_size;  // 每条记录的大小
+    } sections[EC_SNAPSHOT_SECTION_COUNT];  // 各节
+} ec_snapshot_header_t;
+
+typedef struct
+{
+    // 输入
+    uint32_t generation;  // 调用者已有快照的代数，0表示总是复制
+    uint32_t buffer_size;  // 缓冲区大小
+    uint8_t *buffer;  // 缓冲区，可以为NULL以只查询所需大小
+
+    // 输出
+    uint32_t current_generation;  // 当前快照代数
+    uint32_t data_size;  // 快照所需的字节数
+    uint8_t copied;  // 快照已复制到缓冲区
+} ec_ioctl_snapshot_t;
+
+/*****************************************************************************/
+
+/** 事件记录的类型。
+ *
+ * 事件通过对主站字符设备的read()读取，每次读取返回整数条ec_event_t记录。
+ * 没有新记录时read()阻塞（O_NONBLOCK时返回EAGAIN），poll()在有新记录时
+ * 报告可读。每个文件句柄从打开时开始接收事件。
+ */
+#define EC_EVENT_OVERFLOW 0  // 读取太慢：value为丢失的记录数
+#define EC_EVENT_LINK 1  // 设备链路变化：index为设备索引，value为链路状态
+#define EC_EVENT_AL_STATE 2  // 从站AL状态变化：index为从站位置，value为新状态，data[0]为旧状态
+#define EC_EVENT_WKC 3  // 域工作计数器变化：index为域索引，value为当前值，data[0..1]为期望值
+#define EC_EVENT_REDUNDANCY 4  // 冗余链路切换：index为域索引，value非零表示冗余链路正在使用
+#define EC_EVENT_TIMEOUT 5  // 数据报超时：value为超时的数据报数量
+#define EC_EVENT_EMERGENCY 6  // CoE紧急消息：index为从站位置，value为错误代码，data为消息
+#define EC_EVENT_RING 7  // 冗余环状态变化：value非零表示环断开，data为当时的周期数（uint64）
+
+/** 一条事件记录。
+ *
+ * 频繁的事件会被合并：工作计数器变化和数据报超时每秒最多报告一次，
+ * \a count 为期间合并的次数。
+ */
+typedef struct
+{
+    uint32_t seq;  // 序号
+    uint16_t type;  // EC_EVENT_*
+    uint16_t count;  // 合并的事件数
+    uint64_t timestamp;  // 单调时钟时间（纳秒）
+    uint32_t index;  // 设备索引、从站位置或域索引
+    uint32_t value;  // 事件值
+    uint8_t data[8];  // 附加数据（多字节值为小端序）
+} ec_event_t;
+
+/*****************************************************************************/
+
+/** CoE紧急消息日志的魔数（"ECEJ"）。 */
+#define EC_EMERG_JOURNAL_MAGIC 0x4543454A
+
+/** CoE紧急消息日志的布局版本。 */
+#define EC_EMERG_JOURNAL_VERSION 1
+
+/** CoE紧急消息日志的头部，位于映射区域的起始位置。
+ *
+ * 头部之后是\a entry_count 条ec_emergency_t记录（2的幂），序号为n的消息
+ * 位于记录n & (entry_count - 1)。生产者可以有多个：每个生产者原子地分配
+ * 一个序号，写入期间把记录的\a seq 设为n - 1，写入完成后（写内存屏障）
+ * 设为n，然后把\a head 推进到n + 1（如果它还更小）。读取端复制记录前后
+ * 各读一次\a seq，两次都等于期望的序号时记录有效；\a seq 更大表示记录
+ * 已被覆盖，更小表示尚未写入完成。
+ */
+typedef struct
+{
+    uint32_t magic;  // EC_EMERG_JOURNAL_MAGIC
+    uint32_t version;  // EC_EMERG_JOURNAL_VERSION
+    uint32_t entry_offset;  // 记录在映射区域中的偏移量
+    uint32_t entry_count;  // 记录数（2的幂）
+    uint32_t head;  // 已写入完成的最大序号加一
+} ec_emerg_journal_header_t;
+
+/*****************************************************************************/
+
 typedef struct
 {
     // 输入/输出
@@ -939,8 +1535,51 @@ typedef struct
 
 /*****************************************************************************/
 
+/** 异步邮箱网关请求。
+ *
+ * 提交后立即返回请求ID；从站的应答在完成时写回\a data 指向的缓冲区
+ * （最多\a buff_size 字节），因此该缓冲区必须保持有效，直到通过
+ * EC_IOCTL_MBG_COMPLETE 收到该请求的结果。每个从站同时只能有一个未完成
+ * 的请求，否则返回-EBUSY。
+ */
+typedef struct
+{
+    // 输入
+    uint8_t *data;  // 请求数据，完成后存放应答数据
+    size_t data_size;  // 请求数据大小
+    size_t buff_size;  // 缓冲区大小
+
+    // 输出
+    uint32_t id;  // 请求ID
+} ec_ioctl_mbg_submit_t;
+
+/** 已完成的异步邮箱网关请求的结果。
+ */
+typedef struct
+{
+    uint32_t id;  // 请求ID
+    int32_t error;  // 0或负的错误代码
+    uint32_t data_size;  // 写回缓冲区的应答数据大小
+} ec_ioctl_mbg_result_t;
+
+typedef struct
+{
+    // 输入
+    ec_ioctl_mbg_result_t *results;  // 结果数组
+    uint32_t max_count;  // 结果数组的长度
+    uint8_t wait;  // 没有已完成的请求时等待
+
+    // 输出
+    uint32_t count;  // 写入的结果数
+    uint32_t outstanding;  // 仍未完成的请求数
+} ec_ioctl_mbg_complete_t;
+
+/*****************************************************************************/
+
 #ifdef __KERNEL__
 
+#include "mbox_gateway_request.h"
+
 /** 文件句柄的上下文数据结构。
  */
 typedef struct
@@ -949,6 +1588,7 @@ typedef struct
     unsigned int requested;   /**< 主站通过此文件句柄请求。 */
     uint8_t *process_data;    /**< 进程数据区域。 */
     size_t process_data_size; /**< \a process_data 的大小。 */
+    ec_mbg_queue_t mbg;       /**< 异步邮箱网关请求。 */
 } ec_ioctl_context_t;
 
 long ec_ioctl(ec_master_t *, ec_ioctl_context_t *, unsigned int,
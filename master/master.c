@@ -45,6 +45,7 @@
 #include <linux/version.h>
 #include <linux/hrtimer.h>
 #include <linux/vmalloc.h>
+#include <linux/math64.h>
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
 #include <linux/sched/types.h>  // struct sched_param
@@ -127,6 +128,10 @@ static int ec_master_operation_thread(void *);
 static int ec_master_eoe_thread(void *);
 #endif
 
+/** 从模块参数初始化线程参数。
+ */
+static void ec_master_init_thread_params(ec_master_t *);
+
 /** 查找主站的DC参考时钟。
  */
 void ec_master_find_dc_ref_clock(ec_master_t *);
@@ -224,6 +229,8 @@ int ec_master_init(ec_master_t *master,
 
     INIT_LIST_HEAD(&master->configs);
     INIT_LIST_HEAD(&master->domains);
+    ec_ptr_table_init(&master->config_table);
+    ec_ptr_table_init(&master->domain_table);
     INIT_LIST_HEAD(&master->sii_images);
 
     master->app_time = 0ULL;
@@ -247,6 +254,9 @@ int ec_master_init(ec_master_t *master,
 
     master->ext_ring_idx_rt = 0;
     master->ext_ring_idx_fsm = 0;
+    ec_sched_init(&master->sched, sched_weights, sched_weight_count);
+    ec_master_init_thread_params(master);
+    ec_cyclic_init(&master->cyclic);
     master->rt_slave_requests = 0;
     master->rt_slaves_available = 0;
 
@@ -271,16 +281,55 @@ int ec_master_init(ec_master_t *master,
     master->stats.unmatched = 0;
     master->stats.output_jiffies = 0;
 
-    // 设置pcap调试
-    if (pcap_size > 0)
+    for (i = 0; i < EC_HIST_COUNT; i++)
     {
-        master->pcap_data = vmalloc(pcap_size);
+        ec_histogram_clear(&master->hist[i]);
+        ec_histogram_clear(&master->hist_base[i]);
     }
-    else
+
+    // 分配CoE紧急消息日志
+    ret = ec_emerg_journal_init(&master->emerg_journal, emerg_journal_size);
+    if (ret < 0)
+    {
+        EC_MASTER_ERR(master, "分配CoE紧急消息日志失败。\n");
+        return ret;
+    }
+
+    // 分配状态域
+    ret = ec_status_domain_init(&master->status_domain, status_domain_enable);
+    if (ret < 0)
+    {
+        EC_MASTER_ERR(master, "分配状态域失败。\n");
+        ec_emerg_journal_clear(&master->emerg_journal);
+        return ret;
+    }
+
+    // 设置pcap捕获环
+    if (ec_pcap_ring_init(&master->pcap, pcap_size))
     {
-        master->pcap_data = NULL;
+        EC_MASTER_WARN(master, "分配pcap捕获环失败，不捕获帧。\n");
     }
-    master->pcap_curr_data = master->pcap_data;
+
+    ec_scope_init(&master->scope, master);
+    ec_crc_monitor_init(&master->crc_monitor, crc_monitor_interval);
+
+#ifdef EC_HAVE_CYCLES
+    master->adaptive_timeout = adaptive_timeout;
+#else
+    master->adaptive_timeout = 0;
+    if (adaptive_timeout)
+    {
+        EC_MASTER_WARN(master, "没有周期计数器，不使用自适应超时。\n");
+    }
+#endif
+    master->redundancy_fast = redundancy_fast;
+    memset(&master->ring, 0, sizeof(master->ring));
+    ec_dict_cache_init(&master->dict_cache);
+    ec_req_shm_init(&master->req_shm, master);
+    master->snapshot_generation = 0;
+    master->snapshot_hash = 0;
+    ec_event_ring_init(&master->events);
+    master->cycle_count = 0;
 
     master->thread = NULL;
 
@@ -316,6 +365,7 @@ int ec_master_init(ec_master_t *master,
     // 初始化状态机数据报
     ec_datagram_init(&master->fsm_datagram);
     snprintf(master->fsm_datagram.name, EC_DATAGRAM_NAME_SIZE, "master-fsm");
+    master->fsm_datagram.sched_class = EC_SCHED_FSM;
     ret = ec_datagram_prealloc(&master->fsm_datagram, EC_MAX_DATA_SIZE);
     if (ret < 0)
     {
@@ -464,6 +514,8 @@ out_clear_devices:
     {
         ec_device_clear(&master->devices[dev_idx - 1]);
     }
+    ec_status_domain_clear(&master->status_domain);
+    ec_emerg_journal_clear(&master->emerg_journal);
     return ret;
 }
 
@@ -521,12 +573,12 @@ void ec_master_clear(
         ec_device_clear(&master->devices[dev_idx]);
     }
 
-    if (master->pcap_data)
-    {
-        vfree(master->pcap_data);
-        master->pcap_data = NULL;
-        master->pcap_curr_data = NULL;
-    }
+    ec_pcap_ring_clear(&master->pcap);
+    ec_scope_clear(&master->scope);
+    ec_dict_cache_clear(&master->dict_cache);
+    ec_req_shm_clear(&master->req_shm);
+    ec_status_domain_clear(&master->status_domain);
+    ec_emerg_journal_clear(&master->emerg_journal);
 }
 
 /*****************************************************************************/
@@ -574,6 +626,7 @@ void ec_master_clear_slave_configs(ec_master_t *master)
     ec_slave_config_t *sc, *next;
 
     master->dc_ref_config = NULL;
+    ec_ptr_table_clear(&master->config_table);
 
     list_for_each_entry_safe(sc, next, &master->configs, list)
     {
@@ -752,6 +805,8 @@ void ec_master_clear_domains(ec_master_t *master)
 {
     ec_domain_t *domain, *next;
 
+    ec_ptr_table_clear(&master->domain_table);
+
     list_for_each_entry_safe(domain, next, &master->domains, list)
     {
         list_del(&domain->list);
@@ -774,6 +829,7 @@ void ec_master_clear_config(
 )
 {
     ec_lock_down(&master->master_sem);
+    ec_req_shm_disable(&master->req_shm);
     ec_master_clear_domains(master);
     ec_master_clear_slave_configs(master);
     ec_lock_up(&master->master_sem);
@@ -820,6 +876,255 @@ void ec_master_internal_receive_cb(
 */
 /*****************************************************************************/
 
+/* 优先级更改的兼容性 */
+/**
+ * @brief   设置进程的普通优先级。
+ * @param   p       指向进程结构的指针。
+ * @param   nice    优先级值。
+ * @retval  None.
+ */
+static inline void set_normal_priority(struct task_struct *p, int nice)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+    sched_set_normal(p, nice);
+#else
+    struct sched_param param = {.sched_priority = 0};
+    sched_setscheduler(p, SCHED_NORMAL, &param);
+    set_user_nice(p, nice);
+#endif
+}
+
+/*****************************************************************************/
+
+/** 线程类型的名称，用于日志。
+ */
+static const char *ec_thread_names[EC_THREAD_COUNT] = {"主站", "EoE", "周期"};
+
+/*****************************************************************************/
+
+/**
+ * @brief 解析调度策略的名称。
+ * @param name 策略名称（normal、fifo或rr），NULL表示normal。
+ * @return 调度策略，名称无效时返回-EINVAL。
+ */
+static int ec_thread_parse_policy(
+    const char *name /**< 策略名称。 */
+)
+{
+    if (!name || !*name || !strcmp(name, "normal"))
+    {
+        return SCHED_NORMAL;
+    }
+    if (!strcmp(name, "fifo"))
+    {
+        return SCHED_FIFO;
+    }
+    if (!strcmp(name, "rr"))
+    {
+        return SCHED_RR;
+    }
+    return -EINVAL;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 检查线程参数。
+ * @param param 线程参数。
+ * @retval 0 参数有效。
+ * @retval -EINVAL 策略或优先级无效，或者没有在线的CPU。
+ */
+static int ec_thread_param_check(
+    const ec_thread_param_t *param /**< 线程参数。 */
+)
+{
+    if (!cpumask_intersects(&param->cpus, cpu_online_mask))
+    {
+        return -EINVAL;
+    }
+
+    switch (param->policy)
+    {
+    case SCHED_NORMAL:
+        return param->priority >= -20 && param->priority <= 19 ? 0 : -EINVAL;
+    case SCHED_FIFO:
+    case SCHED_RR:
+        return param->priority >= 1 && param->priority <= 99 ? 0 : -EINVAL;
+    default:
+        return -EINVAL;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 从模块参数初始化线程参数。
+ * @details 没有给出或无效的参数使用默认值：所有CPU，SCHED_NORMAL，nice 0。
+ * @param master EtherCAT主站。
+ * @retval 无。
+ */
+static void ec_master_init_thread_params(
+    ec_master_t *master /**< EtherCAT主站。 */
+)
+{
+    // 周期线程的参数由ecrt_master_cyclic_start()给出
+    const char *cpus[EC_THREAD_COUNT] = {
+        thread_cpus[master->index], eoe_thread_cpus[master->index], NULL};
+    const char *policy[EC_THREAD_COUNT] = {
+        thread_policy[master->index], eoe_thread_policy[master->index], NULL};
+    const int priority[EC_THREAD_COUNT] = {
+        thread_priority[master->index], eoe_thread_priority[master->index], 0};
+    ec_thread_param_t *param;
+    unsigned int i;
+
+    for (i = 0; i < EC_THREAD_COUNT; i++)
+    {
+        param = &master->thread_params[i];
+
+        cpumask_copy(&param->cpus, cpu_possible_mask);
+        param->policy = ec_thread_parse_policy(policy[i]);
+        param->priority = priority[i];
+
+        if ((cpus[i] && cpulist_parse(cpus[i], &param->cpus)) ||
+            ec_thread_param_check(param))
+        {
+            EC_MASTER_WARN(master, "%s线程的参数无效，使用默认值。\n",
+                           ec_thread_names[i]);
+            cpumask_copy(&param->cpus, cpu_possible_mask);
+            param->policy = SCHED_NORMAL;
+            param->priority = 0;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 把线程参数应用到一个线程。
+ * @param task 线程。
+ * @param param 线程参数。
+ * @retval 0 成功。
+ * @retval <0 错误代码。
+ */
+int ec_master_thread_apply(
+    struct task_struct *task,      /**< 线程。 */
+    const ec_thread_param_t *param /**< 线程参数。 */
+)
+{
+    int ret;
+
+    ret = set_cpus_allowed_ptr(task, &param->cpus);
+    if (ret)
+    {
+        return ret;
+    }
+
+    if (param->policy == SCHED_NORMAL)
+    {
+        set_normal_priority(task, param->priority);
+        return 0;
+    }
+
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+    {
+        struct sched_attr attr = {
+            .size = sizeof(attr),
+            .sched_policy = param->policy,
+            .sched_priority = param->priority,
+        };
+        return sched_setattr_nocheck(task, &attr);
+    }
+#else
+    {
+        struct sched_param sp = {.sched_priority = param->priority};
+        return sched_setscheduler(task, param->policy, &sp);
+    }
+#endif
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回一种类型的正在运行的线程。
+ * @param master EtherCAT主站。
+ * @param type 线程类型。
+ * @return 线程，没有运行时为NULL。
+ */
+struct task_struct *ec_master_thread_task(
+    ec_master_t *master,  /**< EtherCAT主站。 */
+    ec_thread_type_t type /**< 线程类型。 */
+)
+{
+    switch (type)
+    {
+    case EC_THREAD_MASTER:
+        return master->thread;
+#ifdef EC_EOE
+    case EC_THREAD_EOE:
+        return master->eoe_thread;
+#endif
+    case EC_THREAD_CYCLIC:
+        return master->cyclic.thread;
+    default:
+        return NULL;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 设置一种线程的参数。
+ * @details 参数在线程下一次启动时生效，正在运行的线程立即更新。周期引擎
+ *          每次启动时从应用程序的配置获得参数，因此它的参数只能在运行时
+ *          修改，并且只在本次运行中有效。
+ * @param master EtherCAT主站。
+ * @param type 线程类型。
+ * @param param 新的线程参数。
+ * @retval 0 成功。
+ * @retval <0 错误代码。
+ */
+int ec_master_thread_set_param(
+    ec_master_t *master,           /**< EtherCAT主站。 */
+    ec_thread_type_t type,         /**< 线程类型。 */
+    const ec_thread_param_t *param /**< 新的线程参数。 */
+)
+{
+    struct task_struct *task;
+    int ret;
+
+    if (type >= EC_THREAD_COUNT)
+    {
+        return -EINVAL;
+    }
+
+    if (type == EC_THREAD_CYCLIC && !master->cyclic.thread)
+    {
+        EC_MASTER_ERR(master, "周期引擎没有运行，参数只能在运行时修改。\n");
+        return -ESRCH;
+    }
+
+    ret = ec_thread_param_check(param);
+    if (ret)
+    {
+        return ret;
+    }
+
+    master->thread_params[type] = *param;
+
+    task = ec_master_thread_task(master, type);
+    if (task)
+    {
+        ret = ec_master_thread_apply(task, param);
+    }
+
+    EC_MASTER_INFO(master, "%s线程：CPU %*pbl，策略 %d，优先级 %d。\n",
+                   ec_thread_names[type], cpumask_pr_args(&param->cpus),
+                   param->policy, param->priority);
+    return ret;
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 启动主站线程。
  *
@@ -837,8 +1142,10 @@ int ec_master_thread_start(
     const char *name            /**< 线程名称 */
 )
 {
+    int ret;
+
     EC_MASTER_INFO(master, "启动%s线程。\n", name);
-    master->thread = kthread_run(thread_func, master, name);
+    master->thread = kthread_create(thread_func, master, name);
     if (IS_ERR(master->thread))
     {
         int err = (int)PTR_ERR(master->thread);
@@ -847,6 +1154,16 @@ int ec_master_thread_start(
         return err;
     }
 
+    // 在线程第一次运行之前设置亲和性和优先级
+    ret = ec_master_thread_apply(master->thread,
+                                 &master->thread_params[EC_THREAD_MASTER]);
+    if (ret)
+    {
+        EC_MASTER_WARN(master, "无法设置%s线程的调度参数（错误代码 %i）。\n",
+                       name, ret);
+    }
+    wake_up_process(master->thread);
+
     return 0;
 }
 */
@@ -1097,10 +1414,34 @@ void ec_master_leave_operation_phase(
 
 /*****************************************************************************/
 
+/**
+ * @brief 计算外部数据报在环中的等待时间。
+ *
+ * @param datagram 外部数据报。
+ * @return 从ec_master_get_external_datagram()到现在的时间（微秒）。
+ */
+static u32 ec_master_external_wait_us(
+    const ec_datagram_t *datagram /**< 外部数据报 */
+)
+{
+#ifdef EC_HAVE_CYCLES
+    return (u32) div_u64((u64) (get_cycles() - datagram->cycles_sent),
+                         cpu_khz / 1000);
+#else
+    return jiffies_to_usecs(jiffies - datagram->jiffies_sent);
+#endif
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 注入适合于数据报队列的外部数据报的函数。
  *
- * 此函数用于注入适合于数据报队列的外部数据报。
+ * 环中的数据报按类别（见ec_sched_class_t）以差额轮询的方式调度：
+ * 每一轮中，每个有等待数据报的类别获得与权重成正比的字节额度，并按环中
+ * 的顺序发送额度内的数据报。所有类别共用的字节预算是max_queue_size减去
+ * 已经排队的周期数据报，所以非周期数据报不会把周期帧推迟到发送间隔之后。
+ * 超出预算的类别推迟到下一周期，剩余的额度保留。
  *
  * @param master EtherCAT主站。
  * @return 无。
@@ -1109,105 +1450,167 @@ void ec_master_inject_external_datagrams(
     ec_master_t *master /**< EtherCAT主站 */
 )
 {
+    ec_sched_t *sched = &master->sched;
     ec_datagram_t *datagram;
-    size_t queue_size = 0, new_queue_size = 0;
+    size_t queue_size = 0, budget, size;
+    unsigned int pending[EC_SCHED_QUEUES] = {};
+    unsigned int blocked = 0, progress, idx, k;
+    ec_sched_class_t c;
 #if DEBUG_INJECT
     unsigned int datagram_count = 0;
 #endif
 
-    if (master->ext_ring_idx_rt == master->ext_ring_idx_fsm)
-    {
-        // 没有需要注入的数据报
-        return;
-    }
-
     list_for_each_entry(datagram, &master->datagram_queue, queue)
     {
         if (datagram->state == EC_DATAGRAM_QUEUED)
         {
-            queue_size += datagram->data_size;
+            size = ec_sched_size(datagram);
+            queue_size += size;
+            ec_sched_account(sched, datagram->sched_class, size, 0);
         }
     }
 
+    // 跳过环开头已经注入的数据报
+    while (master->ext_ring_idx_rt != master->ext_ring_idx_fsm &&
+           master->ext_datagram_ring[master->ext_ring_idx_rt].state !=
+               EC_DATAGRAM_INIT)
+    {
+        master->ext_ring_idx_rt =
+            (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
+    }
+
+    if (master->ext_ring_idx_rt == master->ext_ring_idx_fsm)
+    {
+        // 没有需要注入的数据报
+        return;
+    }
+
+    budget = queue_size < master->max_queue_size ?
+                 master->max_queue_size - queue_size : 0;
+
 #if DEBUG_INJECT
     EC_MASTER_DBG(master, 1, "正在注入数据报，queue_size=%zu\n",
                   queue_size);
 #endif
 
-    while (master->ext_ring_idx_rt != master->ext_ring_idx_fsm)
+    for (idx = master->ext_ring_idx_rt; idx != master->ext_ring_idx_fsm;
+         idx = (idx + 1) % EC_EXT_RING_SIZE)
     {
-        datagram = &master->ext_datagram_ring[master->ext_ring_idx_rt];
-
+        datagram = &master->ext_datagram_ring[idx];
         if (datagram->state != EC_DATAGRAM_INIT)
         {
-            // 跳过数据报
-            master->ext_ring_idx_rt =
-                (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
             continue;
         }
 
-        new_queue_size = queue_size + datagram->data_size;
-        if (new_queue_size <= master->max_queue_size)
-        {
-#if DEBUG_INJECT
-            EC_MASTER_DBG(master, 1, "正在注入数据报 %s，大小为%zu，queue_size=%zu\n",
-                          datagram->name,
-                          datagram->data_size, new_queue_size);
-            datagram_count++;
-#endif
-#ifdef EC_HAVE_CYCLES
-            datagram->cycles_sent = 0;
-#endif
-            datagram->jiffies_sent = 0;
-            ec_master_queue_datagram(master, datagram);
-            queue_size = new_queue_size;
-        }
-        else if (datagram->data_size > master->max_queue_size)
+        if (ec_sched_size(datagram) > master->max_queue_size)
         {
             datagram->state = EC_DATAGRAM_ERROR;
             EC_MASTER_ERR(master, "外部数据报 %s 太大，大小为%zu，最大队列大小为%zu\n",
                           datagram->name, datagram->data_size,
                           master->max_queue_size);
+            continue;
         }
-        else
-        { // 数据报无法在当前周期内容纳
-#ifdef EC_HAVE_CYCLES
-            cycles_t cycles_now = get_cycles();
 
-            if (cycles_now - datagram->cycles_sent > ext_injection_timeout_cycles)
-#else
-            if (jiffies - datagram->jiffies_sent > ext_injection_timeout_jiffies)
-#endif
+        pending[datagram->sched_class]++;
+    }
+
+    do
+    {
+        progress = 0;
+
+        for (k = 0; k < EC_SCHED_QUEUES; k++)
+        {
+            c = (sched->next + k) % EC_SCHED_QUEUES;
+            if (!pending[c] || (blocked & (1 << c)))
             {
-#if defined EC_RT_SYSLOG || DEBUG_INJECT
-                unsigned int time_us;
-#endif
+                continue;
+            }
 
-                datagram->state = EC_DATAGRAM_ERROR;
+            sched->deficit[c] += ec_sched_quantum(sched, c);
+            progress = 1;
 
-#if defined EC_RT_SYSLOG || DEBUG_INJECT
-#ifdef EC_HAVE_CYCLES
-                time_us = (unsigned int)((cycles_now - datagram->cycles_sent) * 1000LL) / cpu_khz;
-#else
-                time_us = (unsigned int)((jiffies - datagram->jiffies_sent) * 1000000 / HZ);
+            for (idx = master->ext_ring_idx_rt;
+                 idx != master->ext_ring_idx_fsm;
+                 idx = (idx + 1) % EC_EXT_RING_SIZE)
+            {
+                datagram = &master->ext_datagram_ring[idx];
+                if (datagram->state != EC_DATAGRAM_INIT ||
+                    datagram->sched_class != c)
+                {
+                    continue;
+                }
+
+                size = ec_sched_size(datagram);
+                if (size > sched->deficit[c])
+                {
+                    break;
+                }
+                if (size > budget)
+                {
+                    // 数据报无法在当前周期内容纳
+                    blocked |= 1 << c;
+                    sched->stats[c].deferred++;
+                    break;
+                }
+
+#if DEBUG_INJECT
+                EC_MASTER_DBG(master, 1, "正在注入数据报 %s，大小为%zu，剩余预算%zu\n",
+                              datagram->name, datagram->data_size,
+                              budget - size);
+                datagram_count++;
 #endif
-                EC_MASTER_ERR(master, "超时 %u 微秒：注入外部数据报 %s，大小为%zu，最大队列大小为%zu\n",
-                              time_us, datagram->name,
-                              datagram->data_size, master->max_queue_size);
+                ec_sched_account(sched, c, size,
+                                 ec_master_external_wait_us(datagram));
+#ifdef EC_HAVE_CYCLES
+                datagram->cycles_sent = 0;
 #endif
+                datagram->jiffies_sent = 0;
+                ec_master_queue_datagram(master, datagram);
+                sched->deficit[c] -= size;
+                budget -= size;
+                pending[c]--;
             }
-            else
+
+            if (!pending[c])
             {
-#if DEBUG_INJECT
-                EC_MASTER_DBG(master, 1, "延迟注入外部数据报 %s，大小为%u，queue_size=%u\n",
-                              datagram->name, datagram->data_size, queue_size);
-#endif
-                break;
+                sched->deficit[c] = 0;
             }
         }
+    } while (progress);
 
-        master->ext_ring_idx_rt =
-            (master->ext_ring_idx_rt + 1) % EC_EXT_RING_SIZE;
+    sched->next = (sched->next + 1) % EC_SCHED_QUEUES;
+
+    // 推迟的数据报等待太久时丢弃
+    for (idx = master->ext_ring_idx_rt; idx != master->ext_ring_idx_fsm;
+         idx = (idx + 1) % EC_EXT_RING_SIZE)
+    {
+        datagram = &master->ext_datagram_ring[idx];
+        if (datagram->state != EC_DATAGRAM_INIT)
+        {
+            continue;
+        }
+
+#ifdef EC_HAVE_CYCLES
+        if (get_cycles() - datagram->cycles_sent > ext_injection_timeout_cycles)
+#else
+        if (jiffies - datagram->jiffies_sent > ext_injection_timeout_jiffies)
+#endif
+        {
+            datagram->state = EC_DATAGRAM_ERROR;
+            sched->stats[datagram->sched_class].timeouts++;
+#if defined EC_RT_SYSLOG || DEBUG_INJECT
+            EC_MASTER_ERR(master, "超时 %u 微秒：注入外部数据报 %s，大小为%zu，最大队列大小为%zu\n",
+                          ec_master_external_wait_us(datagram), datagram->name,
+                          datagram->data_size, master->max_queue_size);
+#endif
+        }
+#if DEBUG_INJECT
+        else
+        {
+            EC_MASTER_DBG(master, 1, "延迟注入外部数据报 %s，大小为%zu\n",
+                          datagram->name, datagram->data_size);
+        }
+#endif
     }
 
 #if DEBUG_INJECT
@@ -1380,7 +1783,7 @@ size_t ec_master_send_datagrams(
     unsigned long jiffies_sent;
     unsigned int frame_count, more_datagrams_waiting;
     struct list_head sent_datagrams;
-    size_t sent_bytes = 0;
+    size_t sent_bytes = 0, frame_size;
     uint8_t last_index;
 
 #ifdef EC_HAVE_CYCLES
@@ -1457,7 +1860,9 @@ size_t ec_master_send_datagrams(
             cur_data += EC_DATAGRAM_HEADER_SIZE;
 
             // EtherCAT数据报数据
-            memcpy(cur_data, datagram->data, datagram->data_size);
+            memcpy(cur_data,
+                   datagram->tx_data ? datagram->tx_data : datagram->data,
+                   datagram->data_size);
             cur_data += datagram->data_size;
 
             // EtherCAT数据报尾部
@@ -1485,7 +1890,8 @@ size_t ec_master_send_datagrams(
         ec_device_send(&master->devices[device_index],
                        cur_data - frame_data);
         /* 前导码和帧间隙 */
-        sent_bytes += ETH_HLEN + cur_data - frame_data + ETH_FCS_LEN + 20;
+        frame_size = ETH_HLEN + cur_data - frame_data + ETH_FCS_LEN + 20;
+        sent_bytes += frame_size;
 #ifdef EC_HAVE_CYCLES
         cycles_sent = get_cycles();
 #endif
@@ -1500,6 +1906,8 @@ size_t ec_master_send_datagrams(
 #endif
             datagram->jiffies_sent = jiffies_sent;
             datagram->app_time_sent = master->app_time;
+            datagram->frame_size = frame_size;
+            datagram->tx_slot = master->devices[device_index].tx_ring_index;
             list_del_init(&datagram->sent); // 清空已发送数据报的列表
         }
 
@@ -1547,6 +1955,11 @@ void ec_master_receive_datagrams(
     const uint8_t *cur_data;
     ec_datagram_t *datagram;
     ec_slave_t *slave;
+#ifdef EC_HAVE_CYCLES
+    u32 rtt_ns;
+    int rtt_sampled = 0;
+#endif
+    int ring_counted = 0;
 
     if (unlikely(size < EC_FRAME_HEADER_SIZE))
     {
@@ -1818,6 +2231,58 @@ void ec_master_receive_datagrams(
         datagram->jiffies_received =
             master->devices[EC_DEVICE_MAIN].jiffies_poll;
 
+#ifdef EC_HAVE_CYCLES
+        rtt_ns = ec_hist_cycles_to_ns(datagram->cycles_received -
+                                      datagram->cycles_sent);
+        ec_histogram_add(&master->hist[EC_HIST_ROUND_TRIP], rtt_ns);
+
+        // 每帧一个采样
+        if (!rtt_sampled)
+        {
+            ec_rtt_add(&master->devices[datagram->device_index].rtt,
+                       rtt_ns, datagram->frame_size);
+            rtt_sampled = 1;
+        }
+#else
+        ec_histogram_add(&master->hist[EC_HIST_ROUND_TRIP],
+                         jiffies_to_usecs(datagram->jiffies_received -
+                                          datagram->jiffies_sent) * 1000U);
+#endif
+
+        // 冗余环：每帧记录一次帧在哪个设备上返回
+        if (!ring_counted && ec_master_num_devices(master) > 1)
+        {
+            if (device == &master->devices[datagram->device_index])
+            {
+                master->ring.looped++;
+            }
+            else
+            {
+                master->ring.crossed++;
+            }
+            ring_counted = 1;
+        }
+
+        // 硬件时间戳只在同一个网卡的时钟上可比
+        if (device == &master->devices[datagram->device_index])
+        {
+            datagram->hw_ns_sent = device->hw_tx_ns[datagram->tx_slot];
+            datagram->hw_ns_received = device->hw_rx_ns;
+        }
+        else
+        {
+            datagram->hw_ns_sent = 0;
+            datagram->hw_ns_received = 0;
+        }
+        if (datagram->hw_ns_sent && datagram->hw_ns_received &&
+            datagram->hw_ns_received > datagram->hw_ns_sent)
+        {
+            u64 hw_rtt = datagram->hw_ns_received - datagram->hw_ns_sent;
+
+            ec_histogram_add(&master->hist[EC_HIST_HW_ROUND_TRIP],
+                             hw_rtt > U32_MAX ? U32_MAX : (u32)hw_rtt);
+        }
+
         barrier(); /* 重排序可能导致竞争条件 */
 
         // 出队接收到的数据报
@@ -1849,6 +2314,9 @@ void ec_master_output_stats(
             {
                 EC_MASTER_WARN(master, "%u个数据报超时！\n",
                                master->stats.timeouts);
+                ec_event_ring_post(&master->events, EC_EVENT_TIMEOUT,
+                                   min(master->stats.timeouts, 0xffffU), 0,
+                                   master->stats.timeouts, NULL, 0);
                 master->stats.timeouts = 0;
             }
             if (master->stats.corrupted)
@@ -1869,6 +2337,52 @@ void ec_master_output_stats(
 
 /*****************************************************************************/
 
+/**
+ * @brief 获取自上次复位以来的热路径直方图。
+ *
+ * @param master EtherCAT主站。
+ * @param hist 输出数组（EC_HIST_COUNT个）。
+ * @return 无。
+ * @details 不加锁读取，写入端（发送/接收路径）不受影响。
+ */
+void ec_master_get_histograms(
+    ec_master_t *master, /**< EtherCAT主站 */
+    ec_histogram_t *hist /**< 输出数组 */
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_HIST_COUNT; i++)
+    {
+        ec_histogram_diff(&hist[i], &master->hist[i], &master->hist_base[i]);
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 复位热路径直方图。
+ *
+ * @param master EtherCAT主站。
+ * @return 无。
+ * @details 保存当前计数作为基线，并清零最大值。写入端的计数器不被修改，
+ * 因此复位可以与发送/接收路径并发执行。
+ */
+void ec_master_reset_histograms(
+    ec_master_t *master /**< EtherCAT主站 */
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_HIST_COUNT; i++)
+    {
+        master->hist_base[i] = master->hist[i];
+        master->hist[i].max = 0;
+    }
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 清除常见设备统计信息。
  *
@@ -2061,26 +2575,6 @@ void ec_master_nanosleep(const unsigned long nsecs)
 
 /*****************************************************************************/
 
-/* 优先级更改的兼容性 */
-/**
- * @brief   设置进程的普通优先级。
- * @param   p       指向进程结构的指针。
- * @param   nice    优先级值。
- * @retval  None.
- */
-static inline void set_normal_priority(struct task_struct *p, int nice)
-{
-#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
-    sched_set_normal(p, nice);
-#else
-    struct sched_param param = {.sched_priority = 0};
-    sched_setscheduler(p, SCHED_NORMAL, &param);
-    set_user_nice(p, nice);
-#endif
-}
-
-/*****************************************************************************/
-
 /**
  * @brief 执行从站有限状态机（FSM）。
  *
@@ -2241,10 +2735,13 @@ static int ec_master_idle_thread(void *priv_data)
         if (fsm_exec)
         {
             ec_master_queue_datagram(master, &master->fsm_datagram);
+            ec_fsm_master_queue_batch(&master->fsm);
         }
         sent_bytes = ecrt_master_send(master);
         ec_lock_up(&master->io_sem);
 
+        ec_event_ring_wake(&master->events);
+
         if (ec_fsm_master_idle(&master->fsm))
         {
 #ifdef EC_USE_HRTIMER
@@ -2313,9 +2810,18 @@ static int ec_master_operation_thread(void *priv_data)
                 ec_master_exec_slave_fsms(master);
             }
 
+            // 发布已结束的应用程序请求
+            if (master->req_shm.enabled)
+            {
+                ec_req_shm_publish(&master->req_shm);
+            }
+
             ec_lock_up(&master->master_sem);
         }
 
+        // 唤醒事件读者（实时上下文不能唤醒）
+        ec_event_ring_wake(&master->events);
+
 #ifdef EC_USE_HRTIMER
         // 操作线程不应该比发送RT线程更快
         ec_master_nanosleep(master->send_interval * 1000);
@@ -2370,7 +2876,7 @@ return;
 
 EC_MASTER_INFO(master, "启动EoE线程。\n");
 
-master->eoe_thread = kthread_run(ec_master_eoe_thread, master,
+master->eoe_thread = kthread_create(ec_master_eoe_thread, master,
 "EtherCAT-EoE");
 if (IS_ERR(master->eoe_thread))
 {
@@ -2381,7 +2887,12 @@ master->eoe_thread = NULL;
 return;
 }
 
-set_normal_priority(master->eoe_thread, 0);
+if (ec_master_thread_apply(master->eoe_thread,
+                           &master->thread_params[EC_THREAD_EOE]))
+{
+EC_MASTER_WARN(master, "无法设置EoE线程的调度参数。\n");
+}
+wake_up_process(master->eoe_thread);
 }
 
 /*****************************************************************************/
@@ -2703,49 +3214,24 @@ unsigned int ec_master_config_count(
     const ec_master_t *master /**< EtherCAT主站 */
 )
 {
-    const ec_slave_config_t *sc;
-    unsigned int count = 0;
-
-    list_for_each_entry(sc, &master->configs, list)
-    {
-        count++;
-    }
-
-    return count;
+    return master->config_table.count;
 }
 
 /*****************************************************************************/
 
-/**
- * @brief 通用的ec_master_get_config()和ec_master_get_config_const()的实现。
- * @param pos 列表位置。
- * @return 从站配置或NULL。
- */
-#define EC_FIND_CONFIG                                  \
-    do                                                  \
-    {                                                   \
-        list_for_each_entry(sc, &master->configs, list) \
-        {                                               \
-            if (pos--)                                  \
-                continue;                               \
-            return sc;                                  \
-        }                                               \
-        return NULL;                                    \
-    } while (0)
-
 /**
  * @brief 根据列表中的位置获取从站配置。
  * @param master EtherCAT主站。
  * @param pos 列表位置。
  * @return 从站配置或NULL。
+ * @details 通过索引表查找，耗时与配置数量无关。
  */
 ec_slave_config_t *ec_master_get_config(
     const ec_master_t *master, /**< EtherCAT主站 */
     unsigned int pos           /**< 列表位置 */
 )
 {
-    ec_slave_config_t *sc;
-    EC_FIND_CONFIG;
+    return ec_ptr_table_get(&master->config_table, pos);
 }
 
 /**
@@ -2759,8 +3245,7 @@ const ec_slave_config_t *ec_master_get_config_const(
     unsigned int pos           /**< 列表位置 */
 )
 {
-    const ec_slave_config_t *sc;
-    EC_FIND_CONFIG;
+    return ec_ptr_table_get(&master->config_table, pos);
 }
 
 
@@ -2775,50 +3260,24 @@ unsigned int ec_master_domain_count(
     const ec_master_t *master /**< EtherCAT主站 */
 )
 {
-    const ec_domain_t *domain;
-    unsigned int count = 0;
-
-    list_for_each_entry(domain, &master->domains, list)
-    {
-        count++;
-    }
-
-    return count;
+    return master->domain_table.count;
 }
 
 /*****************************************************************************/
 
-/**
- * @brief 通用的ec_master_find_domain()和ec_master_find_domain_const()的实现。
- * @param index 域索引。
- * @return 域指针，如果找不到则返回NULL。
- */
-#define EC_FIND_DOMAIN                                      \
-    do                                                      \
-    {                                                       \
-        list_for_each_entry(domain, &master->domains, list) \
-        {                                                   \
-            if (index--)                                    \
-                continue;                                   \
-            return domain;                                  \
-        }                                                   \
-                                                            \
-        return NULL;                                        \
-    } while (0)
-
 /**
  * @brief 根据列表中的位置获取域。
  * @param master EtherCAT主站。
  * @param index 域索引。
  * @return 域指针，如果找不到则返回NULL。
+ * @details 通过索引表查找，耗时与域数量无关。
  */
 ec_domain_t *ec_master_find_domain(
     ec_master_t *master, /**< EtherCAT主站 */
     unsigned int index   /**< 域索引 */
 )
 {
-    ec_domain_t *domain;
-    EC_FIND_DOMAIN;
+    return ec_ptr_table_get(&master->domain_table, index);
 }
 
 /**
@@ -2832,8 +3291,7 @@ const ec_domain_t *ec_master_find_domain_const(
     unsigned int index         /**< 域索引 */
 )
 {
-    const ec_domain_t *domain;
-    EC_FIND_DOMAIN;
+    return ec_ptr_table_get(&master->domain_table, index);
 }
 
 
@@ -3144,13 +3602,13 @@ void ec_master_request_op(
 
     EC_MASTER_DBG(master, 1, "请求OP状态...\n");
 
-    // 为所有配置的从站请求OP状态
+    // 为所有配置的从站请求OP状态，最后一次转换一起进行
     for (i = 0; i < master->slave_count; i++)
     {
         slave = master->slaves + i;
         if (slave->config)
         {
-            ec_slave_request_state(slave, EC_SLAVE_STATE_OP);
+            ec_slave_request_group_state(slave, EC_SLAVE_STATE_OP);
         }
     }
 
@@ -3158,7 +3616,7 @@ void ec_master_request_op(
     // 总是将DC参考时钟设置为OP状态
     if (master->dc_ref_clock)
     {
-        ec_slave_request_state(master->dc_ref_clock, EC_SLAVE_STATE_OP);
+        ec_slave_request_group_state(master->dc_ref_clock, EC_SLAVE_STATE_OP);
     }
 #endif
 }
@@ -3251,6 +3709,7 @@ ec_domain_t *ecrt_master_create_domain_err(
 {
     ec_domain_t *domain, *last_domain;
     unsigned int index;
+    int ret;
 
     EC_MASTER_DBG(master, 1, "ecrt_master_create_domain(master = 0x%p)\n",
                   master);
@@ -3275,6 +3734,16 @@ ec_domain_t *ecrt_master_create_domain_err(
     }
 
     ec_domain_init(domain, master, index);
+
+    ret = ec_ptr_table_append(&master->domain_table, domain);
+    if (ret)
+    {
+        ec_lock_up(&master->master_sem);
+        ec_domain_clear(domain);
+        kfree(domain);
+        return ERR_PTR(ret);
+    }
+
     list_add_tail(&domain->list, &master->domains);
 
     ec_lock_up(&master->master_sem);
@@ -3474,6 +3943,7 @@ void ecrt_master_deactivate(ec_master_t *master)
         return;
     }
 
+    ecrt_master_cyclic_stop(master);
     ec_master_thread_stop(master);
 #ifdef EC_EOE
     ec_master_eoe_stop(master);
@@ -3535,14 +4005,23 @@ size_t ecrt_master_send(ec_master_t *master)
     ec_datagram_t *datagram, *n;
     ec_device_index_t dev_idx;
     size_t sent_bytes = 0;
+    ec_hist_time_t start = ec_hist_now();
+    u64 tx_count = master->device_stats.tx_count;
+    u64 tx_bytes = master->device_stats.tx_bytes;
+
+    master->cycle_count++;
 
     if (master->injection_seq_rt != master->injection_seq_fsm)
     {
         // 注入主站FSM生成的数据报文
         ec_master_queue_datagram(master, &master->fsm_datagram);
+        ec_fsm_master_queue_batch(&master->fsm);
         master->injection_seq_rt = master->injection_seq_fsm;
     }
 
+    // 用一个数据报读取所有从站的AL状态
+    ec_status_domain_queue(&master->status_domain, master);
+
     ec_master_inject_external_datagrams(master);
 
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
@@ -3579,11 +4058,80 @@ size_t ecrt_master_send(ec_master_t *master)
                          ec_master_send_datagrams(master, dev_idx));
     }
 
+    ec_histogram_add(&master->hist[EC_HIST_FRAMES],
+                     (u32)(master->device_stats.tx_count - tx_count));
+    ec_histogram_add(&master->hist[EC_HIST_BYTES],
+                     (u32)(master->device_stats.tx_bytes - tx_bytes));
+    ec_histogram_add(&master->hist[EC_HIST_SEND], ec_hist_elapsed_ns(start));
+
     return sent_bytes;
 }
 
 /*****************************************************************************/
 
+/**
+ * @brief 根据本周期接收的帧更新冗余环的状态。
+ *
+ * 只要有一个帧在发送它的设备上返回，环就是断开的；所有帧都在另一个设备
+ * 上返回时，环是闭合的。没有收到帧时状态不变。状态变化时发布一个事件，
+ * 附加数据是当时的周期数。
+ *
+ * @param master EtherCAT主站对象指针。
+ */
+static void ec_master_update_ring_state(
+    ec_master_t *master /**< EtherCAT主站 */
+)
+{
+    ec_ring_state_t *ring = &master->ring;
+    unsigned int open;
+    u8 data[8];
+
+    if (ring->looped)
+    {
+        open = 1;
+    }
+    else if (ring->crossed)
+    {
+        open = 0;
+    }
+    else
+    {
+        return;
+    }
+
+    ring->looped = 0;
+    ring->crossed = 0;
+
+    if (open == ring->open)
+    {
+        return;
+    }
+
+    ring->open = open;
+    ring->switchovers++;
+    ring->last_cycle = master->cycle_count;
+    ring->last_ns = ktime_to_ns(ktime_get());
+
+    EC_WRITE_U64(data, master->cycle_count);
+    ec_event_ring_post(&master->events, EC_EVENT_RING, 1, 0, open,
+                       data, sizeof(data));
+
+#ifdef EC_RT_SYSLOG
+    if (open)
+    {
+        EC_MASTER_WARN(master, "冗余环在周期 %llu 断开！\n",
+                       (unsigned long long)master->cycle_count);
+    }
+    else
+    {
+        EC_MASTER_INFO(master, "冗余环在周期 %llu 重新闭合。\n",
+                       (unsigned long long)master->cycle_count);
+    }
+#endif
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 接收EtherCAT主站的数据报文。
  *
@@ -3595,6 +4143,11 @@ void ecrt_master_receive(ec_master_t *master)
 {
     unsigned int dev_idx;
     ec_datagram_t *datagram, *next;
+    ec_hist_time_t start = ec_hist_now();
+#ifdef EC_HAVE_CYCLES
+    cycles_t datagram_timeout;
+    u32 timeout_ns;
+#endif
 
     // 接收数据报文
     for (dev_idx = EC_DEVICE_MAIN; dev_idx < ec_master_num_devices(master);
@@ -3604,6 +4157,11 @@ void ecrt_master_receive(ec_master_t *master)
     }
     ec_master_update_device_stats(master);
 
+    if (ec_master_num_devices(master) > 1)
+    {
+        ec_master_update_ring_state(master);
+    }
+
     // 移除所有超时的数据报文
     list_for_each_entry_safe(datagram, next, &master->datagram_queue, queue)
     {
@@ -3611,9 +4169,23 @@ void ecrt_master_receive(ec_master_t *master)
             continue;
 
 #ifdef EC_HAVE_CYCLES
+        if (master->adaptive_timeout)
+        {
+            timeout_ns = ec_rtt_timeout_ns(
+                &master->devices[datagram->device_index].rtt,
+                ec_rtt_class(datagram), datagram->frame_size,
+                EC_IO_TIMEOUT * NSEC_PER_USEC);
+            datagram_timeout =
+                (cycles_t)(timeout_ns / 1000) * (cpu_khz / 1000);
+        }
+        else
+        {
+            datagram_timeout = timeout_cycles;
+        }
+
         if (master->devices[EC_DEVICE_MAIN].cycles_poll -
                 datagram->cycles_sent >
-            timeout_cycles)
+            datagram_timeout)
         {
 #else
         if (master->devices[EC_DEVICE_MAIN].jiffies_poll -
@@ -3646,6 +4218,8 @@ void ecrt_master_receive(ec_master_t *master)
 #endif /* RT_SYSLOG */
         }
     }
+
+    ec_histogram_add(&master->hist[EC_HIST_RECEIVE], ec_hist_elapsed_ns(start));
 }
 
 /*****************************************************************************/
@@ -3693,6 +4267,7 @@ ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
 {
     ec_slave_config_t *sc;
     unsigned int found = 0;
+    int ret;
 
     EC_MASTER_DBG(master, 1, "ecrt_master_slave_config(master = 0x%p,"
                              " alias = %u, position = %u, vendor_id = 0x%08x,"
@@ -3735,6 +4310,15 @@ ec_slave_config_t *ecrt_master_slave_config_err(ec_master_t *master,
 
         ec_lock_down(&master->master_sem);
 
+        ret = ec_ptr_table_append(&master->config_table, sc);
+        if (ret)
+        {
+            ec_lock_up(&master->master_sem);
+            ec_slave_config_clear(sc);
+            kfree(sc);
+            return ERR_PTR(ret);
+        }
+
         // 尝试找到指定的从站
         ec_slave_config_attach(sc);
         ec_slave_config_load_default_sync_config(sc);
@@ -3969,24 +4553,81 @@ void ecrt_master_state(const ec_master_t *master, ec_master_state_t *state)
 /*****************************************************************************/
 
 /**
- * @brief 获取EtherCAT主站指定设备索引的链路状态。
+ * @brief 获取EtherCAT主站指定设备索引的链路状态。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param dev_idx 设备索引。
+ * @param state 用于存储链路状态的结构体指针。
+ * @return 返回0表示成功，返回负值表示错误。
+ */
+int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
+                           ec_master_link_state_t *state)
+{
+    if (dev_idx >= ec_master_num_devices(master))
+    {
+        return -EINVAL;
+    }
+
+    state->slaves_responding = master->fsm.slaves_responding[dev_idx];
+    state->al_states = master->fsm.slave_states[dev_idx];
+    state->link_up = master->devices[dev_idx].link_state;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 获取冗余环的状态。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param state 用于存储状态的结构体指针。
+ * @return 返回0表示成功。
+ */
+int ecrt_master_redundancy_state(const ec_master_t *master,
+                                 ec_master_redundancy_state_t *state)
+{
+    state->ring_open = master->ring.open ? 1 : 0;
+    state->switchovers = master->ring.switchovers;
+    state->last_cycle = master->ring.last_cycle;
+    state->last_time_ns = master->ring.last_ns;
+    state->shared_tx = master->redundancy_fast ? 1 : 0;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 获取EtherCAT主站指定设备的往返时间估计。
  *
  * @param master EtherCAT主站对象指针。
  * @param dev_idx 设备索引。
- * @param state 用于存储链路状态的结构体指针。
+ * @param state 用于存储往返时间估计的结构体指针。
  * @return 返回0表示成功，返回负值表示错误。
  */
-int ecrt_master_link_state(const ec_master_t *master, unsigned int dev_idx,
-                           ec_master_link_state_t *state)
+int ecrt_master_rtt_state(const ec_master_t *master, unsigned int dev_idx,
+                          ec_master_rtt_state_t *state)
 {
+    const ec_rtt_t *rtt;
+    u32 max_ns = EC_IO_TIMEOUT * NSEC_PER_USEC;
+
     if (dev_idx >= ec_master_num_devices(master))
     {
         return -EINVAL;
     }
 
-    state->slaves_responding = master->fsm.slaves_responding[dev_idx];
-    state->al_states = master->fsm.slave_states[dev_idx];
-    state->link_up = master->devices[dev_idx].link_state;
+    rtt = &master->devices[dev_idx].rtt;
+    state->samples = rtt->samples;
+    state->rtt_ns = rtt->srtt_ns;
+    state->rtt_var_ns = rtt->rttvar_ns;
+    state->rtt_peak_ns = rtt->peak_ns;
+    state->last_rtt_ns = rtt->last_ns;
+    state->last_frame_size = rtt->last_frame_size;
+    state->cyclic_timeout_ns = ec_rtt_timeout_ns(rtt, EC_RTT_CLASS_CYCLIC,
+                                                 rtt->last_frame_size, max_ns);
+    state->mailbox_timeout_ns = ec_rtt_timeout_ns(rtt, EC_RTT_CLASS_MAILBOX,
+                                                  rtt->last_frame_size, max_ns);
+    state->adaptive = master->adaptive_timeout ? 1 : 0;
 
     return 0;
 }
@@ -4045,6 +4686,42 @@ int ecrt_master_reference_clock_time(ec_master_t *master, uint32_t *time)
 
 /*****************************************************************************/
 
+/**
+ * @brief 获取携带参考时钟时间的帧的硬件时间戳。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param sent_ns 用于存储发送时间的指针。
+ * @param received_ns 用于存储接收时间的指针。
+ * @return 返回0表示成功，返回负值表示错误。
+ */
+int ecrt_master_reference_clock_timestamps(ec_master_t *master,
+                                           uint64_t *sent_ns,
+                                           uint64_t *received_ns)
+{
+    if (!master->dc_ref_clock)
+    {
+        return -ENXIO;
+    }
+
+    if (master->sync_datagram.state != EC_DATAGRAM_RECEIVED)
+    {
+        return -EIO;
+    }
+
+    if (!master->sync_datagram.hw_ns_sent ||
+        !master->sync_datagram.hw_ns_received)
+    {
+        return -ENODATA;
+    }
+
+    *sent_ns = master->sync_datagram.hw_ns_sent;
+    *received_ns = master->sync_datagram.hw_ns_received;
+
+    return 0;
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 同步EtherCAT主站的参考时钟。
  *
@@ -4609,6 +5286,212 @@ int ecrt_master_sdo_upload_complete(ec_master_t *master, uint16_t slave_position
 
 /*****************************************************************************/
 
+/**
+ * @brief 统计批量SDO请求中处于指定状态的请求数。
+ *
+ * @param requests 请求数组。
+ * @param count 请求数。
+ * @param state 请求状态。
+ * @return 处于\a state 的请求数。
+ */
+static unsigned int ec_master_sdo_batch_count(
+    const ec_sdo_request_t *requests, unsigned int count,
+    ec_internal_request_state_t state)
+{
+    unsigned int i, n = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        if (requests[i].state == state)
+        {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 并行执行一批SDO上传/下载操作。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param items 操作数组。
+ * @param count 操作数。
+ * @return 失败的操作数，参数错误时返回负值。
+ *
+ * 所有请求一次性排入各自从站的SDO请求队列。从站状态机每次只处理一个
+ * 请求，因此同一从站的操作按顺序执行，而不同从站的操作在同一周期内并行
+ * 执行。被信号中断时，尚未开始的请求被撤回（错误代码-EINTR），正在处理
+ * 的请求仍然等待完成。
+ */
+int ecrt_master_sdo_batch(ec_master_t *master, ec_sdo_batch_item_t *items,
+                          unsigned int count)
+{
+    ec_sdo_request_t *requests;
+    ec_sdo_batch_item_t *item;
+    ec_sdo_request_t *req;
+    ec_slave_t *slave;
+    unsigned int i, failed = 0;
+    int ret;
+
+    EC_MASTER_DBG(master, 1, "%s(master = 0x%p, items = 0x%p, count = %u)\n",
+                  __func__, master, items, count);
+
+    if (!count)
+    {
+        return 0;
+    }
+
+    if (count > EC_SDO_BATCH_MAX_ITEMS)
+    {
+        EC_MASTER_ERR(master, "批量SDO操作过多（%u）！\n", count);
+        return -EINVAL;
+    }
+
+    if (!(requests = vmalloc(count * sizeof(ec_sdo_request_t))))
+    {
+        EC_MASTER_ERR(master, "无法分配批量SDO请求的内存。\n");
+        return -ENOMEM;
+    }
+
+    // 准备请求
+    for (i = 0; i < count; i++)
+    {
+        item = &items[i];
+        req = &requests[i];
+
+        ec_sdo_request_init(req);
+        ecrt_sdo_request_index(req, item->index, item->subindex);
+        item->result_size = 0;
+        item->abort_code = 0;
+        item->error = 0;
+
+        if (item->dir == EC_DIR_OUTPUT)
+        {
+            if (!item->data_size)
+            {
+                item->error = -EINVAL;
+                continue;
+            }
+            ret = ec_sdo_request_alloc(req, item->data_size);
+            if (ret)
+            {
+                item->error = ret;
+                continue;
+            }
+            memcpy(req->data, item->data, item->data_size);
+            req->data_size = item->data_size;
+            ecrt_sdo_request_write(req);
+        }
+        else
+        {
+            ecrt_sdo_request_read(req);
+        }
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        ret = -EINTR;
+        goto out_clear;
+    }
+
+    // 调度请求
+    for (i = 0; i < count; i++)
+    {
+        req = &requests[i];
+        if (req->state != EC_INT_REQUEST_QUEUED)
+        {
+            continue;
+        }
+
+        if (!(slave = ec_master_find_slave(master, 0,
+                                           items[i].slave_position)))
+        {
+            EC_MASTER_ERR(master, "从站 %u 不存在！\n",
+                          items[i].slave_position);
+            req->state = EC_INT_REQUEST_FAILURE;
+            items[i].error = -EINVAL;
+            continue;
+        }
+
+        list_add_tail(&req->list, &slave->sdo_requests);
+    }
+
+    ec_lock_up(&master->master_sem);
+
+    // 等待FSM处理
+    if (wait_event_interruptible(master->request_queue,
+                                 !ec_master_sdo_batch_count(requests, count,
+                                                            EC_INT_REQUEST_QUEUED)))
+    {
+        // 被信号中断：撤回尚未开始的请求
+        ec_lock_down(&master->master_sem);
+        for (i = 0; i < count; i++)
+        {
+            if (requests[i].state == EC_INT_REQUEST_QUEUED)
+            {
+                list_del(&requests[i].list);
+                requests[i].state = EC_INT_REQUEST_FAILURE;
+                items[i].error = -EINTR;
+            }
+        }
+        ec_lock_up(&master->master_sem);
+    }
+
+    // 等待正在处理的请求完成
+    wait_event(master->request_queue,
+               !ec_master_sdo_batch_count(requests, count,
+                                          EC_INT_REQUEST_BUSY));
+
+    // 收集结果
+    for (i = 0; i < count; i++)
+    {
+        item = &items[i];
+        req = &requests[i];
+
+        if (item->error)
+        {
+            failed++;
+            continue;
+        }
+
+        item->abort_code = req->abort_code;
+
+        if (req->state != EC_INT_REQUEST_SUCCESS)
+        {
+            item->error = req->errno ? -req->errno : -EIO;
+            failed++;
+        }
+        else if (item->dir != EC_DIR_OUTPUT)
+        {
+            if (req->data_size > item->data_size)
+            {
+                item->error = -EOVERFLOW;
+                failed++;
+            }
+            else
+            {
+                memcpy(item->data, req->data, req->data_size);
+                item->result_size = req->data_size;
+            }
+        }
+    }
+
+    ret = failed;
+
+out_clear:
+    for (i = 0; i < count; i++)
+    {
+        ec_sdo_request_clear(&requests[i]);
+    }
+    vfree(requests);
+    return ret;
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 向EtherCAT主站写入IDN数据。
  *
@@ -4860,6 +5743,11 @@ void ecrt_master_exec_slave_requests(ec_master_t *master)
         (master->phase == EC_OPERATION))
     {
         ec_master_exec_slave_fsms(master);
+
+        if (master->req_shm.enabled)
+        {
+            ec_req_shm_publish(&master->req_shm);
+        }
     }
 
     ec_lock_up(&master->master_sem);
@@ -4867,6 +5755,23 @@ void ecrt_master_exec_slave_requests(ec_master_t *master)
 
 /*****************************************************************************/
 
+/**
+ * @brief 从紧急消息日志中批量读取CoE紧急消息。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param seq 读取序号，读取后前进。
+ * @param entries 目标数组。
+ * @param count 目标数组的容量。
+ * @return 读取的消息数。
+ */
+int ecrt_master_emerg_read(ec_master_t *master, uint32_t *seq,
+                           ec_emergency_t *entries, unsigned int count)
+{
+    return ec_emerg_journal_read(&master->emerg_journal, seq, entries, count);
+}
+
+/*****************************************************************************/
+
 #ifdef EC_EOE
 
 /**
@@ -5690,6 +6595,117 @@ int ec_master_mbox_gateway(ec_master_t *master, uint8_t *data,
 
 /*****************************************************************************/
 
+/**
+ * @brief 异步提交邮箱网关请求。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param queue 文件句柄的请求队列。
+ * @param async 已包含请求数据的异步请求。
+ * @return 返回0表示成功，此时\a async 归\a queue 所有；返回负值表示错误。
+ *
+ * 请求排入从站的邮箱网关队列后立即返回，完成时唤醒master->request_queue。
+ * 每个从站同时只允许一个未完成的请求，因此不同从站的请求可以并行处理，
+ * 同一从站的请求则由调用者排队。主站对象字典请求（从站地址0）直接完成。
+ */
+int ec_master_mbg_submit(ec_master_t *master, ec_mbg_queue_t *queue,
+                         ec_mbg_async_t *async)
+{
+    uint16_t slave_posn;
+    ec_slave_t *slave;
+    int ret;
+
+    slave_posn = EC_READ_U16(async->req.data + 2);
+
+    if (slave_posn == 0)
+    {
+        size_t data_size = async->req.data_size;
+
+        ret = ec_master_obj_dict(master, async->req.data, &data_size,
+                                 async->req.mem_size);
+        if (ret)
+        {
+            return ret;
+        }
+        async->req.data_size = data_size;
+        async->req.state = EC_INT_REQUEST_SUCCESS;
+        ec_mbg_queue_add(queue, async);
+        wake_up_all(&master->request_queue);
+        return 0;
+    }
+
+    if (slave_posn < EC_MBG_SLAVE_ADDR_OFFSET)
+    {
+        EC_MASTER_ERR(master, "邮箱网关：无效的从站偏移地址 %u！\n", slave_posn);
+        return -EINVAL;
+    }
+    slave_posn -= EC_MBG_SLAVE_ADDR_OFFSET;
+
+    ec_mbg_request_run(&async->req);
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        return -EINTR;
+    }
+
+    if (!(slave = ec_master_find_slave(master, 0, slave_posn)))
+    {
+        ec_lock_up(&master->master_sem);
+        EC_MASTER_ERR(master, "从站 %u 不存在！\n", slave_posn);
+        return -EINVAL;
+    }
+
+    // 每个从站只允许一个未完成的请求
+    if (!list_empty(&slave->mbg_requests) || slave->fsm.mbg_request)
+    {
+        ec_lock_up(&master->master_sem);
+        return -EBUSY;
+    }
+
+    EC_SLAVE_DBG(slave, 1, "调度异步邮箱网关请求。\n");
+
+    ec_mbg_queue_add(queue, async);
+    list_add_tail(&async->req.list, &slave->mbg_requests);
+
+    ec_lock_up(&master->master_sem);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放文件句柄的所有异步邮箱网关请求。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param queue 文件句柄的请求队列。
+ *
+ * 尚在排队的请求被撤回；正在处理的请求不可中断，等待其完成后再释放。
+ */
+void ec_master_mbg_queue_clear(ec_master_t *master, ec_mbg_queue_t *queue)
+{
+    ec_mbg_async_t *async, *next;
+
+    ec_lock_down(&master->master_sem);
+    list_for_each_entry(async, &queue->requests, list)
+    {
+        if (async->req.state == EC_INT_REQUEST_QUEUED)
+        {
+            list_del_init(&async->req.list);
+            async->req.state = EC_INT_REQUEST_FAILURE;
+        }
+    }
+    ec_lock_up(&master->master_sem);
+
+    list_for_each_entry_safe(async, next, &queue->requests, list)
+    {
+        wait_event(master->request_queue,
+                   async->req.state != EC_INT_REQUEST_BUSY);
+        list_del(&async->list);
+        ec_mbg_async_free(async);
+    }
+}
+
+/*****************************************************************************/
+
 /**
  * @brief 重置EtherCAT主站。
  *
@@ -5709,6 +6725,54 @@ void ecrt_master_reset(ec_master_t *master)
 }
 
 
+/*****************************************************************************/
+
+/**
+ * @brief 为一组从站配置同时请求AL状态。
+ *
+ * @param master EtherCAT主站对象指针。
+ * @param configs 从站配置数组。
+ * @param count 从站配置数。
+ * @param state 请求的AL状态。
+ * @return 成功返回0，否则返回负的错误代码。
+ *
+ * 所有请求在持有master_sem时一起设置，主站状态机不会看到只设置了一部分的
+ * 组。进入SAFEOP或OP时，最后一次状态转换由主站状态机一起执行。
+ */
+int ecrt_master_request_state(ec_master_t *master,
+                              ec_slave_config_t *const *configs,
+                              unsigned int count, ec_al_state_t state)
+{
+    unsigned int i;
+
+    EC_MASTER_DBG(master, 1, "%s(master = 0x%p, configs = 0x%p, count = %u,"
+                             " state = 0x%02X)\n",
+                  __func__, master, configs, count, state);
+
+    if (state != EC_AL_STATE_INIT && state != EC_AL_STATE_PREOP &&
+        state != EC_AL_STATE_SAFEOP && state != EC_AL_STATE_OP)
+    {
+        EC_MASTER_ERR(master, "无效的AL状态0x%02X！\n", state);
+        return -EINVAL;
+    }
+
+    if (ec_lock_down_interruptible(&master->master_sem))
+    {
+        return -EINTR;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (configs[i]->slave)
+        {
+            ec_slave_request_group_state(configs[i]->slave, state);
+        }
+    }
+
+    ec_lock_up(&master->master_sem);
+    return 0;
+}
+
 /*****************************************************************************/
 
 /** \cond */
@@ -5728,11 +6792,14 @@ EXPORT_SYMBOL(ecrt_master_slave_config);
 EXPORT_SYMBOL(ecrt_master_select_reference_clock);
 EXPORT_SYMBOL(ecrt_master_state);
 EXPORT_SYMBOL(ecrt_master_link_state);
+EXPORT_SYMBOL(ecrt_master_rtt_state);
+EXPORT_SYMBOL(ecrt_master_redundancy_state);
 EXPORT_SYMBOL(ecrt_master_application_time);
 EXPORT_SYMBOL(ecrt_master_sync_reference_clock);
 EXPORT_SYMBOL(ecrt_master_sync_reference_clock_to);
 EXPORT_SYMBOL(ecrt_master_sync_slave_clocks);
 EXPORT_SYMBOL(ecrt_master_reference_clock_time);
+EXPORT_SYMBOL(ecrt_master_reference_clock_timestamps);
 EXPORT_SYMBOL(ecrt_master_64bit_reference_clock_time_queue);
 EXPORT_SYMBOL(ecrt_master_64bit_reference_clock_time);
 EXPORT_SYMBOL(ecrt_master_sync_monitor_queue);
@@ -5741,10 +6808,13 @@ EXPORT_SYMBOL(ecrt_master_sdo_download);
 EXPORT_SYMBOL(ecrt_master_sdo_download_complete);
 EXPORT_SYMBOL(ecrt_master_sdo_upload);
 EXPORT_SYMBOL(ecrt_master_sdo_upload_complete);
+EXPORT_SYMBOL(ecrt_master_sdo_batch);
+EXPORT_SYMBOL(ecrt_master_request_state);
 EXPORT_SYMBOL(ecrt_master_write_idn);
 EXPORT_SYMBOL(ecrt_master_read_idn);
 EXPORT_SYMBOL(ecrt_master_rt_slave_requests);
 EXPORT_SYMBOL(ecrt_master_exec_slave_requests);
+EXPORT_SYMBOL(ecrt_master_emerg_read);
 #ifdef EC_EOE
 EXPORT_SYMBOL(ecrt_master_eoe_addif);
 EXPORT_SYMBOL(ecrt_master_eoe_delif);
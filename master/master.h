@@ -36,6 +36,7 @@
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/kthread.h>
+#include <linux/cpumask.h>
 
 #include "device.h"
 #include "domain.h"
@@ -43,6 +44,16 @@
 #include "fsm_master.h"
 #include "locks.h"
 #include "cdev.h"
+#include "histogram.h"
+#include "pcap.h"
+#include "ptr_table.h"
+#include "dict_cache.h"
+#include "req_shm.h"
+#include "event.h"
+#include "emerg_journal.h"
+#include "status_domain.h"
+#include "scheduler.h"
+#include "cyclic.h"
 
 #ifdef EC_RTDM
 #include "rtdm.h"
@@ -144,6 +155,47 @@ typedef struct
 
 /*****************************************************************************/
 
+/** 冗余环的状态。
+ *
+ * 环闭合时，从一个设备发送的帧经过所有从站后在另一个设备上返回。电缆断开
+ * 后，断点两侧最后的从站关闭端口并把帧送回，所以帧在发送它的设备上返回。
+ * 这在断开后的第一个周期就能看到，不需要额外读取寄存器。
+ */
+typedef struct
+{
+    unsigned int open;        /**< 环断开。 */
+    unsigned int looped;      /**< 本周期在发送设备上返回的帧数。 */
+    unsigned int crossed;     /**< 本周期在另一个设备上返回的帧数。 */
+    unsigned int switchovers; /**< 环状态变化的次数。 */
+    u64 last_cycle;           /**< 最近一次变化时的周期数。 */
+    u64 last_ns;              /**< 最近一次变化的单调时钟时间（纳秒）。 */
+} ec_ring_state_t;
+
+/*****************************************************************************/
+
+/** 主站线程的类型。
+ *
+ * 空闲线程和运行线程不会同时运行，使用相同的参数。
+ */
+typedef enum
+{
+    EC_THREAD_MASTER, /**< 空闲/运行线程。 */
+    EC_THREAD_EOE,    /**< EoE线程。 */
+    EC_THREAD_CYCLIC, /**< 周期引擎的线程。 */
+    EC_THREAD_COUNT   /**< 线程类型的数量。 */
+} ec_thread_type_t;
+
+/** 主站线程的CPU亲和性和调度参数。
+ */
+typedef struct
+{
+    cpumask_t cpus; /**< 允许运行的CPU。 */
+    int policy;     /**< 调度策略（SCHED_NORMAL、SCHED_FIFO或SCHED_RR）。 */
+    int priority;   /**< 实时优先级（1-99），SCHED_NORMAL时为nice值。 */
+} ec_thread_param_t;
+
+/*****************************************************************************/
+
 /** 设备统计信息。
  */
 typedef struct
@@ -217,6 +269,8 @@ struct ec_master
     /* 应用程序应用的配置。 */
     struct list_head configs; /**< 从站配置列表。 */
     struct list_head domains; /**< 域列表。 */
+    ec_ptr_table_t config_table; /**< 按索引访问的从站配置。 */
+    ec_ptr_table_t domain_table; /**< 按索引访问的域。 */
 
     /* 在总线扫描期间应用的配置。 */
     struct list_head sii_images; /**< 从站SII映像列表。 */
@@ -252,6 +306,7 @@ struct ec_master
     unsigned int ext_ring_idx_fsm;                     /**< FSM端的外部数据报文环索引。 */
     unsigned int send_interval;                        /**< 两次调用ecrt_master_send()之间的间隔。 */
     size_t max_queue_size;                             /**< 数据报文队列的最大大小 */
+    ec_sched_t sched;                                  /**< 外部数据报文环的调度器。 */
     unsigned int rt_slave_requests;                    /**< 如果\a True，则从站请求将由应用程序的实时上下文中的ecrt_master_exec_requests()调用处理。 */
     unsigned int rt_slaves_available;                  /**< 如果\a True，则从站请求可以由应用程序的实时上下文中的ecrt_master_exec_requests()调用处理。
                                                          否则，主站当前正在配置从站 */
@@ -261,11 +316,27 @@ struct ec_master
 
     unsigned int debug_level; /**< 主站调试级别。 */
     ec_stats_t stats;         /**< 循环统计信息。 */
-
-    void *pcap_data;      /**< pcap调试输出内存指针 */
-    void *pcap_curr_data; /**< pcap调试输出当前内存指针 */
+    ec_histogram_t hist[EC_HIST_COUNT];      /**< 热路径直方图。 */
+    ec_histogram_t hist_base[EC_HIST_COUNT]; /**< 上次复位时的直方图基线。 */
+
+    ec_pcap_ring_t pcap; /**< pcap捕获环。 */
+    ec_scope_t scope;    /**< 过程数据记录器。 */
+    ec_dict_cache_t dict_cache; /**< 按从站类型共享的对象字典缓存。 */
+    ec_req_shm_t req_shm; /**< 异步请求的共享状态区域。 */
+    uint32_t snapshot_generation; /**< 快照代数，快照内容变化时递增。 */
+    uint32_t snapshot_hash;       /**< 上一次快照内容的散列值。 */
+    ec_event_ring_t events;       /**< 通过字符设备读取的事件。 */
+    ec_emerg_journal_t emerg_journal; /**< 所有从站的CoE紧急消息。 */
+    ec_status_domain_t status_domain; /**< 所有从站的AL状态。 */
+    ec_crc_monitor_t crc_monitor;     /**< ESC错误计数器的总线健康监视。 */
+    unsigned int adaptive_timeout;    /**< 根据往返时间估计数据报超时。 */
+    unsigned int redundancy_fast;     /**< 备份数据报直接发送主数据报的数据。 */
+    ec_ring_state_t ring;             /**< 冗余环的状态。 */
+    u64 cycle_count;              /**< ecrt_master_send()的调用次数。 */
 
     struct task_struct *thread; /**< 主站线程。 */
+    ec_thread_param_t thread_params[EC_THREAD_COUNT]; /**< 线程参数。 */
+    ec_cyclic_t cyclic;         /**< 周期引擎。 */
 
 #ifdef EC_EOE
     struct task_struct *eoe_thread; /**< EoE线程。 */
@@ -313,6 +384,12 @@ void ec_master_leave_idle_phase(ec_master_t *);
 int ec_master_enter_operation_phase(ec_master_t *);
 void ec_master_leave_operation_phase(ec_master_t *);
 
+// 线程
+int ec_master_thread_apply(struct task_struct *, const ec_thread_param_t *);
+int ec_master_thread_set_param(ec_master_t *, ec_thread_type_t,
+                               const ec_thread_param_t *);
+struct task_struct *ec_master_thread_task(ec_master_t *, ec_thread_type_t);
+
 #ifdef EC_EOE
 // EoE
 void ec_master_eoe_start(ec_master_t *);
@@ -333,6 +410,8 @@ ec_slave_t *ec_master_find_slave(ec_master_t *, uint16_t, uint16_t);
 const ec_slave_t *ec_master_find_slave_const(const ec_master_t *, uint16_t,
                                              uint16_t);
 void ec_master_output_stats(ec_master_t *);
+void ec_master_get_histograms(ec_master_t *, ec_histogram_t *);
+void ec_master_reset_histograms(ec_master_t *);
 #ifdef EC_EOE
 void ec_master_clear_eoe_handlers(ec_master_t *, unsigned int);
 #endif
@@ -362,6 +441,8 @@ int ec_master_eoe_process(ec_master_t *);
 
 int ec_master_mbox_gateway(ec_master_t *master, uint8_t *data,
                            size_t *data_size, size_t buff_size);
+int ec_master_mbg_submit(ec_master_t *, ec_mbg_queue_t *, ec_mbg_async_t *);
+void ec_master_mbg_queue_clear(ec_master_t *, ec_mbg_queue_t *);
 
 int ec_master_debug_level(ec_master_t *, unsigned int);
 
@@ -386,6 +467,20 @@ extern unsigned int eoe_count;        // 见module.c
 extern bool eoe_autocreate;           // 见module.c
 #endif
 extern unsigned long pcap_size; // 见module.c
+extern unsigned int emerg_journal_size; // 见module.c
+extern bool status_domain_enable;       // 见module.c
+extern unsigned int crc_monitor_interval; // 见module.c
+extern bool adaptive_timeout;             // 见module.c
+extern bool hw_timestamps;                // 见module.c
+extern bool redundancy_fast;              // 见module.c
+extern unsigned int sched_weights[EC_SCHED_QUEUES]; // 见module.c
+extern unsigned int sched_weight_count;             // 见module.c
+extern char *thread_cpus[];                         // 见module.c
+extern char *thread_policy[];                       // 见module.c
+extern int thread_priority[];                       // 见module.c
+extern char *eoe_thread_cpus[];                     // 见module.c
+extern char *eoe_thread_policy[];                   // 见module.c
+extern int eoe_thread_priority[];                   // 见module.c
 
 /*****************************************************************************/
 
@@ -180,3 +180,165 @@ void ec_mbg_request_run(
 }
 
 /*****************************************************************************/
+
+/**
+@brief 分配异步邮箱网关请求。
+@return 新的请求，内存不足时返回NULL。
+*/
+ec_mbg_async_t *ec_mbg_async_alloc(void)
+{
+    ec_mbg_async_t *async;
+
+    if (!(async = kmalloc(sizeof(ec_mbg_async_t), GFP_KERNEL)))
+    {
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&async->list);
+    ec_mbg_request_init(&async->req);
+    async->id = 0;
+    async->target = NULL;
+    async->buff_size = 0;
+    return async;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 释放异步邮箱网关请求。
+@param async 异步请求，不能再位于任何链表中。
+*/
+void ec_mbg_async_free(
+    ec_mbg_async_t *async /**< 异步请求。 */
+)
+{
+    ec_mbg_request_clear(&async->req);
+    kfree(async);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 初始化文件句柄的异步请求队列。
+@param queue 请求队列。
+*/
+void ec_mbg_queue_init(
+    ec_mbg_queue_t *queue /**< 请求队列。 */
+)
+{
+    INIT_LIST_HEAD(&queue->requests);
+    spin_lock_init(&queue->lock);
+    queue->next_id = 1;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 为请求分配ID并加入队列。
+@param queue 请求队列。
+@param async 异步请求。
+@details ID从1开始递增，回绕时跳过0。
+*/
+void ec_mbg_queue_add(
+    ec_mbg_queue_t *queue, /**< 请求队列。 */
+    ec_mbg_async_t *async  /**< 异步请求。 */
+)
+{
+    spin_lock(&queue->lock);
+    async->id = queue->next_id++;
+    if (!queue->next_id)
+    {
+        queue->next_id = 1;
+    }
+    list_add_tail(&async->list, &queue->requests);
+    spin_unlock(&queue->lock);
+}
+
+/*****************************************************************************/
+
+/** 请求是否已经完成（成功或失败）。
+ */
+static int ec_mbg_async_done(const ec_mbg_async_t *async)
+{
+    return async->req.state == EC_INT_REQUEST_SUCCESS ||
+           async->req.state == EC_INT_REQUEST_FAILURE;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 检查队列中是否有已完成的请求。
+@param queue 请求队列。
+@return 有已完成的请求时返回非零。
+*/
+int ec_mbg_queue_done(
+    ec_mbg_queue_t *queue /**< 请求队列。 */
+)
+{
+    ec_mbg_async_t *async;
+    int done = 0;
+
+    spin_lock(&queue->lock);
+    list_for_each_entry(async, &queue->requests, list)
+    {
+        if (ec_mbg_async_done(async))
+        {
+            done = 1;
+            break;
+        }
+    }
+    spin_unlock(&queue->lock);
+    return done;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 队列中的请求数（包括已完成但尚未取走的请求）。
+@param queue 请求队列。
+@return 请求数。
+*/
+unsigned int ec_mbg_queue_outstanding(
+    ec_mbg_queue_t *queue /**< 请求队列。 */
+)
+{
+    ec_mbg_async_t *async;
+    unsigned int count = 0;
+
+    spin_lock(&queue->lock);
+    list_for_each_entry(async, &queue->requests, list)
+    {
+        count++;
+    }
+    spin_unlock(&queue->lock);
+    return count;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 取出最早完成的请求。
+@param queue 请求队列。
+@return 已完成的请求（已从队列中移除），没有时返回NULL。
+*/
+ec_mbg_async_t *ec_mbg_queue_pop_done(
+    ec_mbg_queue_t *queue /**< 请求队列。 */
+)
+{
+    ec_mbg_async_t *async;
+
+    spin_lock(&queue->lock);
+    list_for_each_entry(async, &queue->requests, list)
+    {
+        if (ec_mbg_async_done(async))
+        {
+            list_del_init(&async->list);
+            spin_unlock(&queue->lock);
+            return async;
+        }
+    }
+    spin_unlock(&queue->lock);
+    return NULL;
+}
+
+/*****************************************************************************/
@@ -38,6 +38,7 @@
 #define __EC_MBG_REQUEST_H__
 
 #include <linux/list.h>
+#include <linux/spinlock.h>
 
 #include "globals.h"
 
@@ -57,6 +58,29 @@ typedef struct
     uint16_t error_code;               /**< MBox网关错误代码。 */
     uint8_t mbox_type;                 /**< 缓存的MBox类型。 */
 } ec_mbg_request_t;
+
+/*****************************************************************************/
+
+/** 通过文件句柄异步提交的邮箱网关请求。
+ */
+typedef struct
+{
+    struct list_head list; /**< ec_mbg_queue_t中的链表项。 */
+    ec_mbg_request_t req;  /**< 邮箱网关请求。 */
+    uint32_t id;           /**< 请求ID。 */
+    void __user *target;   /**< 存放应答的用户空间缓冲区。 */
+    size_t buff_size;      /**< \a target 的大小。 */
+} ec_mbg_async_t;
+
+/** 文件句柄的异步邮箱网关请求队列。
+ */
+typedef struct
+{
+    struct list_head requests; /**< 已提交的请求（ec_mbg_async_t）。 */
+    spinlock_t lock;           /**< 保护\a requests 。 */
+    uint32_t next_id;          /**< 下一个请求ID。 */
+} ec_mbg_queue_t;
+
 /*****************************************************************************/
 
 void ec_mbg_request_init(ec_mbg_request_t *);
@@ -66,6 +90,15 @@ int ec_mbg_request_alloc(ec_mbg_request_t *, size_t);
 int ec_mbg_request_copy_data(ec_mbg_request_t *, const uint8_t *, size_t);
 void ec_mbg_request_run(ec_mbg_request_t *);
 
+ec_mbg_async_t *ec_mbg_async_alloc(void);
+void ec_mbg_async_free(ec_mbg_async_t *);
+
+void ec_mbg_queue_init(ec_mbg_queue_t *);
+void ec_mbg_queue_add(ec_mbg_queue_t *, ec_mbg_async_t *);
+int ec_mbg_queue_done(ec_mbg_queue_t *);
+unsigned int ec_mbg_queue_outstanding(ec_mbg_queue_t *);
+ec_mbg_async_t *ec_mbg_queue_pop_done(ec_mbg_queue_t *);
+
 /*****************************************************************************/
 
 #endif
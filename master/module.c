@@ -65,6 +65,21 @@ bool eoe_autocreate = 1;       /**< EOE接口自动创建模式。 */
 #endif
 static unsigned int debug_level; /**< 调试级别参数。 */
 unsigned long pcap_size;         /**< Pcap缓冲区大小（字节）。 */
+unsigned int emerg_journal_size = EC_EMERG_JOURNAL_DEFAULT_SIZE;
+                                 /**< CoE紧急消息日志的记录数。 */
+bool status_domain_enable;       /**< 通过状态域监视AL状态。 */
+unsigned int crc_monitor_interval; /**< 错误计数器的采样间隔（毫秒）。 */
+bool adaptive_timeout;           /**< 根据往返时间估计数据报超时。 */
+bool hw_timestamps;              /**< 向驱动请求硬件时间戳。 */
+bool redundancy_fast;            /**< 优化的冗余模式。 */
+unsigned int sched_weights[EC_SCHED_QUEUES]; /**< 非周期数据报类别的权重。 */
+unsigned int sched_weight_count;             /**< 设置了的权重数。 */
+char *thread_cpus[MAX_MASTERS];        /**< 主站线程的CPU列表。 */
+char *thread_policy[MAX_MASTERS];      /**< 主站线程的调度策略。 */
+int thread_priority[MAX_MASTERS];      /**< 主站线程的优先级。 */
+char *eoe_thread_cpus[MAX_MASTERS];    /**< EoE线程的CPU列表。 */
+char *eoe_thread_policy[MAX_MASTERS];  /**< EoE线程的调度策略。 */
+int eoe_thread_priority[MAX_MASTERS];  /**< EoE线程的优先级。 */
 
 static ec_master_t *masters; /**< 主站数组。 */
 static ec_lock_t master_sem; /**< 主站信号量。 */
@@ -99,6 +114,32 @@ module_param_named(debug_level, debug_level, uint, S_IRUGO);
 MODULE_PARM_DESC(debug_level, "调试级别");
 module_param_named(pcap_size, pcap_size, ulong, S_IRUGO);
 MODULE_PARM_DESC(pcap_size, "Pcap缓冲区大小");
+module_param_named(emerg_journal_size, emerg_journal_size, uint, S_IRUGO);
+MODULE_PARM_DESC(emerg_journal_size, "CoE紧急消息日志的记录数");
+module_param_named(status_domain, status_domain_enable, bool, S_IRUGO);
+MODULE_PARM_DESC(status_domain, "用一个逻辑数据报监视所有从站的AL状态");
+module_param_named(crc_monitor_interval, crc_monitor_interval, uint, S_IRUGO);
+MODULE_PARM_DESC(crc_monitor_interval, "错误计数器的采样间隔（毫秒），0表示停用");
+module_param_named(adaptive_timeout, adaptive_timeout, bool, S_IRUGO);
+MODULE_PARM_DESC(adaptive_timeout, "根据测量的往返时间计算数据报超时（需要周期计数器）");
+module_param_named(hw_timestamps, hw_timestamps, bool, S_IRUGO);
+MODULE_PARM_DESC(hw_timestamps, "向支持的网卡驱动请求硬件收发时间戳");
+module_param_named(redundancy_fast, redundancy_fast, bool, S_IRUGO);
+MODULE_PARM_DESC(redundancy_fast, "冗余模式下备份帧直接使用主数据报的数据，不再逐周期复制");
+module_param_array(sched_weights, uint, &sched_weight_count, S_IRUGO);
+MODULE_PARM_DESC(sched_weights, "非周期数据报的调度权重（状态机,CoE,EoE,FoE,邮箱网关,寄存器）");
+module_param_array(thread_cpus, charp, NULL, S_IRUGO);
+MODULE_PARM_DESC(thread_cpus, "每个主站的空闲/运行线程允许运行的CPU列表（例如2或2-3）");
+module_param_array(thread_policy, charp, NULL, S_IRUGO);
+MODULE_PARM_DESC(thread_policy, "每个主站的空闲/运行线程的调度策略（normal、fifo或rr）");
+module_param_array(thread_priority, int, NULL, S_IRUGO);
+MODULE_PARM_DESC(thread_priority, "每个主站的空闲/运行线程的实时优先级（1-99），normal时为nice值");
+module_param_array(eoe_thread_cpus, charp, NULL, S_IRUGO);
+MODULE_PARM_DESC(eoe_thread_cpus, "每个主站的EoE线程允许运行的CPU列表");
+module_param_array(eoe_thread_policy, charp, NULL, S_IRUGO);
+MODULE_PARM_DESC(eoe_thread_policy, "每个主站的EoE线程的调度策略（normal、fifo或rr）");
+module_param_array(eoe_thread_priority, int, NULL, S_IRUGO);
+MODULE_PARM_DESC(eoe_thread_priority, "每个主站的EoE线程的实时优先级（1-99），normal时为nice值");
 
 /** \endcond */
 
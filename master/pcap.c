@@ -0,0 +1,384 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   pcap捕获环。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/if_ether.h>
+
+#include "datagram.h"
+#include "pcap.h"
+
+/*****************************************************************************/
+
+/** 读取由生产者并发更新的位置，防止编译器缓存该值。
+ */
+static inline u32 ec_pcap_ring_load(const u32 *pos)
+{
+    return *(const volatile u32 *) pos;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化捕获环。
+ * @param ring 捕获环。
+ * @param size 请求的数据区大小（字节），0表示不捕获。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 数据区大小向下取整为2的幂，并限制在EC_PCAP_RING_MIN_SIZE和
+ * EC_PCAP_RING_MAX_SIZE之间。头部占用一整页，使数据区页对齐。
+ */
+int ec_pcap_ring_init(
+    ec_pcap_ring_t *ring, /**< 捕获环 */
+    size_t size           /**< 数据区大小 */
+)
+{
+    ec_pcap_ring_header_t *header;
+
+    memset(ring, 0, sizeof(*ring));
+
+    if (!size)
+    {
+        return 0;
+    }
+
+    size = clamp_t(size_t, size, EC_PCAP_RING_MIN_SIZE,
+                   EC_PCAP_RING_MAX_SIZE);
+    size = rounddown_pow_of_two(size);
+
+    ring->mem_size = PAGE_SIZE + size;
+    ring->mem = vmalloc_user(ring->mem_size);
+    if (!ring->mem)
+    {
+        ring->mem_size = 0;
+        return -ENOMEM;
+    }
+
+    header = ring->mem;
+    header->magic = EC_PCAP_RING_MAGIC;
+    header->version = EC_PCAP_RING_VERSION;
+    header->data_offset = PAGE_SIZE;
+    header->data_size = size;
+
+    ring->header = header;
+    ring->data = (uint8_t *) ring->mem + PAGE_SIZE;
+    ring->mask = size - 1;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放捕获环。
+ * @param ring 捕获环。
+ */
+void ec_pcap_ring_clear(
+    ec_pcap_ring_t *ring /**< 捕获环 */
+)
+{
+    if (ring->mem)
+    {
+        vfree(ring->mem);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 检查帧是否通过过滤器。
+ * @param ring 捕获环。
+ * @param frame 以太网帧。
+ * @param size 帧长度。
+ * @return 帧中任一数据报匹配时返回非零。
+ */
+static int ec_pcap_ring_match(
+    const ec_pcap_ring_t *ring, /**< 捕获环 */
+    const uint8_t *frame,       /**< 以太网帧 */
+    size_t size                 /**< 帧长度 */
+)
+{
+    const uint8_t *cur, *end = frame + size;
+    uint8_t type;
+    uint16_t len_field;
+
+    if (likely(!ring->type_mask && !ring->address_filter))
+    {
+        return 1;
+    }
+
+    cur = frame + ETH_HLEN + EC_FRAME_HEADER_SIZE;
+    while (cur + EC_DATAGRAM_HEADER_SIZE <= end)
+    {
+        type = EC_READ_U8(cur);
+        len_field = EC_READ_U16(cur + 6);
+
+        if ((!ring->type_mask ||
+             (type < 32 && (ring->type_mask & (1 << type)))) &&
+            (!ring->address_filter ||
+             ((type == EC_DATAGRAM_FPRD || type == EC_DATAGRAM_FPWR ||
+               type == EC_DATAGRAM_FPRW || type == EC_DATAGRAM_FRMW) &&
+              EC_READ_U16(cur + 2) == ring->address)))
+        {
+            return 1;
+        }
+
+        if (!(len_field & 0x8000))
+        {
+            break;
+        }
+        cur += EC_DATAGRAM_HEADER_SIZE + (len_field & 0x07FF) +
+               EC_DATAGRAM_FOOTER_SIZE;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回指定位置的记录占用的字节数。
+ * @param ring 捕获环。
+ * @param pos 记录位置。
+ * @return 记录长度（隐式跳过的空间也视为一条记录）。
+ */
+static u32 ec_pcap_ring_record_size(
+    const ec_pcap_ring_t *ring, /**< 捕获环 */
+    u32 pos                     /**< 记录位置 */
+)
+{
+    u32 off = pos & ring->mask;
+    u32 room = ring->mask + 1 - off;
+
+    if (room < sizeof(ec_pcap_record_t))
+    {
+        return room;
+    }
+    return ((const ec_pcap_record_t *) (ring->data + off))->size;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 为写入到指定位置腾出空间。
+ * @param ring 捕获环。
+ * @param end 写入结束的位置。
+ * @details 推进tail，直到[tail, end)不超过数据区大小。新的tail在覆盖数据
+ * 之前对读取端可见。
+ */
+static void ec_pcap_ring_reserve(
+    ec_pcap_ring_t *ring, /**< 捕获环 */
+    u32 end               /**< 写入结束的位置 */
+)
+{
+    ec_pcap_ring_header_t *header = ring->header;
+    u32 tail = header->tail;
+
+    if (end - tail <= ring->mask + 1)
+    {
+        return;
+    }
+
+    while (end - tail > ring->mask + 1)
+    {
+        tail += ec_pcap_ring_record_size(ring, tail);
+    }
+
+    header->tail = tail;
+    smp_wmb();
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 将一帧写入捕获环。
+ * @param ring 捕获环。
+ * @param dev_idx 设备索引。
+ * @param tx 非零表示发送的帧。
+ * @param timestamp 时间戳 [ns]。
+ * @param data 以太网帧。
+ * @param size 帧长度。
+ * @details 只能由主站的发送/接收上下文调用。写满后覆盖最早的记录，
+ * 因此捕获永远不会停止；读取端根据tail检测被覆盖的记录。
+ */
+void ec_pcap_ring_record(
+    ec_pcap_ring_t *ring,      /**< 捕获环 */
+    ec_device_index_t dev_idx, /**< 设备索引 */
+    int tx,                    /**< 发送的帧 */
+    u64 timestamp,             /**< 时间戳 [ns] */
+    const void *data,          /**< 以太网帧 */
+    size_t size                /**< 帧长度 */
+)
+{
+    ec_pcap_ring_header_t *header = ring->header;
+    ec_pcap_record_t *rec;
+    u32 caplen, need, head, off, room;
+
+    if (!ec_pcap_ring_match(ring, data, size))
+    {
+        header->filtered++;
+        return;
+    }
+
+    caplen = min_t(size_t, size, EC_PCAP_MAX_CAPLEN);
+    if (header->snaplen && caplen > header->snaplen)
+    {
+        caplen = header->snaplen;
+    }
+
+    need = ALIGN(sizeof(ec_pcap_record_t) + caplen, EC_PCAP_RECORD_ALIGN);
+    head = header->head;
+    off = head & ring->mask;
+    room = ring->mask + 1 - off;
+
+    if (room < need)
+    {
+        // 数据区末尾空间不足：填充到末尾，从头开始写
+        ec_pcap_ring_reserve(ring, head + room);
+        if (room >= sizeof(ec_pcap_record_t))
+        {
+            rec = (ec_pcap_record_t *) (ring->data + off);
+            memset(rec, 0, sizeof(*rec));
+            rec->size = room;
+            rec->flags = EC_PCAP_FLAG_PAD;
+        }
+        head += room;
+        off = 0;
+    }
+
+    ec_pcap_ring_reserve(ring, head + need);
+
+    rec = (ec_pcap_record_t *) (ring->data + off);
+    rec->size = need;
+    rec->caplen = caplen;
+    rec->origlen = min_t(size_t, size, 0xffff);
+    rec->timestamp = timestamp;
+    rec->device = dev_idx;
+    rec->flags = tx ? EC_PCAP_FLAG_TX : 0;
+    memset(rec->reserved, 0, sizeof(rec->reserved));
+    memcpy(rec + 1, data, caplen);
+
+    // 记录内容必须在新的head之前对读取端可见
+    smp_wmb();
+    header->head = head + need;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 从捕获环读取下一条记录。
+ * @param ring 捕获环。
+ * @param pos 读取位置，成功时推进到下一条记录。
+ * @param rec 记录头的目标。
+ * @param data 帧数据的目标（至少EC_PCAP_MAX_CAPLEN字节）。
+ * @return 读到记录时返回1，没有新记录时返回0。
+ * @details 供内核中的读取端使用，可以与生产者并发执行。如果读取位置的记录
+ * 已被覆盖，则从最早的有效记录继续读取。
+ */
+int ec_pcap_ring_fetch(
+    const ec_pcap_ring_t *ring, /**< 捕获环 */
+    u32 *pos,                   /**< 读取位置 */
+    ec_pcap_record_t *rec,      /**< 记录头 */
+    uint8_t *data               /**< 帧数据 */
+)
+{
+    const ec_pcap_ring_header_t *header = ring->header;
+    u32 p = *pos, head, off, room;
+
+    while (1)
+    {
+        head = ec_pcap_ring_load(&header->head);
+        smp_rmb();
+        if ((s32) (p - ec_pcap_ring_load(&header->tail)) < 0)
+        {
+            p = ec_pcap_ring_load(&header->tail);
+        }
+        if (p == head)
+        {
+            *pos = p;
+            return 0;
+        }
+
+        off = p & ring->mask;
+        room = ring->mask + 1 - off;
+        if (room < sizeof(ec_pcap_record_t))
+        {
+            p += room;
+            continue;
+        }
+
+        memcpy(rec, ring->data + off, sizeof(*rec));
+        memcpy(data, ring->data + off + sizeof(*rec),
+               min_t(u32, rec->caplen, EC_PCAP_MAX_CAPLEN));
+
+        // 复制期间记录被覆盖？
+        smp_rmb();
+        if ((s32) (p - ec_pcap_ring_load(&header->tail)) < 0)
+        {
+            continue;
+        }
+
+        p += rec->size;
+        if (!(rec->flags & EC_PCAP_FLAG_PAD))
+        {
+            *pos = p;
+            return 1;
+        }
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回映射到用户空间的页面。
+ * @param ring 捕获环。
+ * @param offset 区域内的偏移量。
+ * @return 页面，偏移量无效时返回NULL。
+ */
+struct page *ec_pcap_ring_page(
+    const ec_pcap_ring_t *ring, /**< 捕获环 */
+    unsigned long offset        /**< 区域内的偏移量 */
+)
+{
+    if (!ring->mem || offset >= ring->mem_size)
+    {
+        return NULL;
+    }
+    return vmalloc_to_page((uint8_t *) ring->mem + offset);
+}
+
+/*****************************************************************************/
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   pcap捕获环。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_PCAP_H__
+#define __EC_PCAP_H__
+
+#include <linux/types.h>
+#include <linux/mm.h>
+
+#include "globals.h"
+#include "ioctl.h"
+
+/*****************************************************************************/
+
+/** 每帧最多捕获的字节数（包括可能的VLAN标签）。 */
+#define EC_PCAP_MAX_CAPLEN 2048
+
+/** 捕获环数据区的最小大小。 */
+#define EC_PCAP_RING_MIN_SIZE (16 * 1024)
+
+/** 捕获环数据区的最大大小。
+ *
+ * 头部页和数据区必须放在一个mmap区域（EC_IOCTL_MMAP_REGION_SIZE）内，
+ * 数据区大小又是2的幂，因此最多为区域大小的一半。
+ */
+#define EC_PCAP_RING_MAX_SIZE (EC_IOCTL_MMAP_REGION_SIZE / 2)
+
+/*****************************************************************************/
+
+/** pcap捕获环。
+ *
+ * 捕获环由一个页对齐的头部（ec_pcap_ring_header_t）和一个大小为2的幂的
+ * 数据区组成，整体可以通过mmap()只读映射到用户空间（见
+ * EC_IOCTL_MMAP_PCAP）。帧由主站的发送/接收上下文写入，二者不会并发执行，
+ * 因此环只有一个生产者，写入端不需要锁。数据区写满后覆盖最早的记录。
+ */
+typedef struct
+{
+    void *mem;                     /**< vmalloc_user()分配的内存。 */
+    size_t mem_size;               /**< \a mem 的大小。 */
+    ec_pcap_ring_header_t *header; /**< 环头部（位于\a mem 起始处）。 */
+    uint8_t *data;                 /**< 数据区。 */
+    u32 mask;                      /**< 数据区偏移量掩码。 */
+    u32 type_mask;                 /**< 数据报类型过滤掩码，0表示不过滤。 */
+    u16 address;                   /**< 过滤的从站地址。 */
+    u8 address_filter;             /**< 按从站地址过滤。 */
+    u32 read_pos;                  /**< EC_IOCTL_PCAP_DATA的读取位置。 */
+} ec_pcap_ring_t;
+
+/*****************************************************************************/
+
+int ec_pcap_ring_init(ec_pcap_ring_t *, size_t);
+void ec_pcap_ring_clear(ec_pcap_ring_t *);
+void ec_pcap_ring_record(ec_pcap_ring_t *, ec_device_index_t, int, u64,
+                         const void *, size_t);
+int ec_pcap_ring_fetch(const ec_pcap_ring_t *, u32 *, ec_pcap_record_t *,
+                       uint8_t *);
+struct page *ec_pcap_ring_page(const ec_pcap_ring_t *, unsigned long);
+
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,168 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   按索引访问的对象指针表。
+*/
+
+/*****************************************************************************/
+
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "globals.h"
+#include "ptr_table.h"
+
+/*****************************************************************************/
+
+/** 首次分配的条目数。 */
+#define EC_PTR_TABLE_INITIAL_SIZE 8
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化指针表。
+ * @param table 指针表。
+ */
+void ec_ptr_table_init(
+    ec_ptr_table_t *table /**< 指针表。 */
+)
+{
+    table->items = NULL;
+    table->count = 0;
+    table->size = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 清除指针表。
+ * @param table 指针表。
+ * @details 只释放指针数组，不释放条目指向的对象。
+ */
+void ec_ptr_table_clear(
+    ec_ptr_table_t *table /**< 指针表。 */
+)
+{
+    kfree(table->items);
+    ec_ptr_table_init(table);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 确保还能再放入一个条目。
+ * @param table 指针表。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 容量不足时按倍数扩容。
+ */
+static int ec_ptr_table_reserve(
+    ec_ptr_table_t *table /**< 指针表。 */
+)
+{
+    if (table->count == table->size)
+    {
+        unsigned int size = table->size ?
+                                table->size * 2 : EC_PTR_TABLE_INITIAL_SIZE;
+        void **items = kmalloc(size * sizeof(void *), GFP_KERNEL);
+
+        if (!items)
+        {
+            return -ENOMEM;
+        }
+
+        if (table->count)
+        {
+            memcpy(items, table->items, table->count * sizeof(void *));
+        }
+        kfree(table->items);
+        table->items = items;
+        table->size = size;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 在表尾追加一个条目。
+ * @param table 指针表。
+ * @param item 条目。
+ * @return 成功返回0，否则返回负错误代码。
+ */
+int ec_ptr_table_append(
+    ec_ptr_table_t *table, /**< 指针表。 */
+    void *item             /**< 条目。 */
+)
+{
+    return ec_ptr_table_insert(table, table->count, item);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 在指定位置插入一个条目。
+ * @param table 指针表。
+ * @param index 插入位置，其后的条目依次后移。
+ * @param item 条目。
+ * @return 成功返回0，否则返回负错误代码。
+ */
+int ec_ptr_table_insert(
+    ec_ptr_table_t *table, /**< 指针表。 */
+    unsigned int index,    /**< 插入位置。 */
+    void *item             /**< 条目。 */
+)
+{
+    int ret;
+
+    if (index > table->count)
+    {
+        return -EINVAL;
+    }
+
+    ret = ec_ptr_table_reserve(table);
+    if (ret)
+    {
+        return ret;
+    }
+
+    if (index < table->count)
+    {
+        memmove(table->items + index + 1, table->items + index,
+                (table->count - index) * sizeof(void *));
+    }
+
+    table->items[index] = item;
+    table->count++;
+    return 0;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   按索引访问的对象指针表。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_PTR_TABLE_H__
+#define __EC_PTR_TABLE_H__
+
+#include <linux/types.h>
+#include <linux/compiler.h>
+
+/*****************************************************************************/
+
+/** 对象指针表。
+ *
+ * 与对象链表并行维护，使应用程序接口按索引查找域、从站配置和请求时
+ * 不必遍历链表。条目只在创建对象时追加（调用者持有master_sem），并与
+ * 链表一起整体清除，因此索引与链表中的位置一致。
+ *
+ * 扩容会替换指针数组，所以追加不能与无锁的查找并发。应用程序只在激活
+ * 之前创建对象，激活之后表即不再变化，实时路径上的查找是安全的。
+ */
+typedef struct
+{
+    void **items;       /**< 指针数组。 */
+    unsigned int count; /**< 已使用的条目数。 */
+    unsigned int size;  /**< 已分配的条目数。 */
+} ec_ptr_table_t;
+
+/*****************************************************************************/
+
+void ec_ptr_table_init(ec_ptr_table_t *);
+void ec_ptr_table_clear(ec_ptr_table_t *);
+int ec_ptr_table_append(ec_ptr_table_t *, void *);
+int ec_ptr_table_insert(ec_ptr_table_t *, unsigned int, void *);
+
+/*****************************************************************************/
+
+/**
+ * @brief 按索引获取条目。
+ * @param table 指针表。
+ * @param index 索引。
+ * @return 条目，索引越界时返回NULL。
+ */
+static inline void *ec_ptr_table_get(
+    const ec_ptr_table_t *table, /**< 指针表。 */
+    unsigned int index           /**< 索引。 */
+)
+{
+    return likely(index < table->count) ? table->items[index] : NULL;
+}
+
+/*****************************************************************************/
+
+#endif
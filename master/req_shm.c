@@ -0,0 +1,573 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   异步请求的共享状态区域。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/version.h>
+#ifdef CONFIG_EVENTFD
+#include <linux/eventfd.h>
+#endif
+
+#include "master.h"
+#include "slave_config.h"
+#include "sdo_request.h"
+#include "foe_request.h"
+#include "reg_request.h"
+#include "req_shm.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化共享状态区域。
+ * @param shm 共享状态区域。
+ * @param master 所属主站。
+ */
+void ec_req_shm_init(
+    ec_req_shm_t *shm,  /**< 共享状态区域 */
+    ec_master_t *master /**< 所属主站 */
+)
+{
+    memset(shm, 0, sizeof(*shm));
+    shm->master = master;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放共享状态区域。
+ * @param shm 共享状态区域。
+ */
+void ec_req_shm_clear(
+    ec_req_shm_t *shm /**< 共享状态区域 */
+)
+{
+    ec_req_shm_disable(shm);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放区域及完成通知。
+ * @param shm 共享状态区域。
+ * @details 必须在释放从站配置之前调用。已映射的页面在用户空间解除映射
+ * 之前保持有效。调用者必须持有master_sem。
+ */
+void ec_req_shm_disable(
+    ec_req_shm_t *shm /**< 共享状态区域 */
+)
+{
+    shm->enabled = 0;
+
+    ec_req_shm_set_eventfd(shm, -1);
+
+    if (shm->mem)
+    {
+        vfree(shm->mem);
+        shm->mem = NULL;
+    }
+    shm->mem_size = 0;
+    shm->header = NULL;
+    shm->slots = NULL;
+
+    kfree(shm->entries);
+    shm->entries = NULL;
+    kfree(shm->configs);
+    shm->configs = NULL;
+    shm->config_count = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 设置或取消完成通知。
+ * @param shm 共享状态区域。
+ * @param fd 用户空间的eventfd，负数表示取消通知。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 调用者必须持有master_sem。
+ */
+int ec_req_shm_set_eventfd(
+    ec_req_shm_t *shm, /**< 共享状态区域 */
+    int fd             /**< eventfd */
+)
+{
+#ifdef CONFIG_EVENTFD
+    struct eventfd_ctx *ctx = NULL;
+
+    if (fd >= 0)
+    {
+        ctx = eventfd_ctx_fdget(fd);
+        if (IS_ERR(ctx))
+        {
+            return PTR_ERR(ctx);
+        }
+    }
+
+    if (shm->eventfd)
+    {
+        eventfd_ctx_put(shm->eventfd);
+    }
+    shm->eventfd = ctx;
+    return 0;
+#else
+    return fd >= 0 ? -EOPNOTSUPP : 0;
+#endif
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回状态槽数据区的大小。
+ * @param size 请求的数据内存大小。
+ * @param total 已分配的数据区总大小，成功时增加。
+ * @return 数据区大小，超出上限时为0。
+ */
+static size_t ec_req_shm_data_capacity(
+    size_t size,  /**< 请求的数据内存大小 */
+    size_t *total /**< 已分配的数据区总大小 */
+)
+{
+    size = ALIGN(size, 8);
+    if (*total + size > EC_REQ_SHM_MAX_DATA)
+    {
+        return 0;
+    }
+    *total += size;
+    return size;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化一个状态槽。
+ * @param shm 共享状态区域。
+ * @param slot 状态槽序号。
+ * @param type 请求类型（EC_REQ_SHM_*）。
+ * @param config_index 从站配置索引。
+ * @param request_index 请求在该类型中的索引。
+ * @param req 内核请求。
+ * @param state 请求的内部状态。
+ * @param data_offset 数据区在区域中的偏移量，0表示没有数据区。
+ * @param data_capacity 数据区大小。
+ */
+static void ec_req_shm_slot_init(
+    ec_req_shm_t *shm,                 /**< 共享状态区域 */
+    unsigned int slot,                 /**< 状态槽序号 */
+    u8 type,                           /**< 请求类型 */
+    unsigned int config_index,         /**< 从站配置索引 */
+    unsigned int request_index,        /**< 请求索引 */
+    void *req,                         /**< 内核请求 */
+    ec_internal_request_state_t state, /**< 内部状态 */
+    size_t data_offset,                /**< 数据区偏移量 */
+    size_t data_capacity               /**< 数据区大小 */
+)
+{
+    ec_req_shm_slot_t *s = &shm->slots[slot];
+
+    s->config_index = config_index;
+    s->request_index = request_index;
+    s->type = type;
+    s->state = ec_request_state_translation_table[state];
+    if (state == EC_INT_REQUEST_QUEUED || state == EC_INT_REQUEST_BUSY)
+    {
+        // 已经在进行中的请求在结束时发布
+        s->issued = 1;
+    }
+
+    if (data_capacity)
+    {
+        s->data_offset = data_offset;
+        s->data_capacity = data_capacity;
+        shm->entries[slot].data = (u8 *) shm->mem + data_offset;
+    }
+    shm->entries[slot].req = req;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 为所有从站配置的请求建立共享状态区域。
+ * @param shm 共享状态区域。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 每个配置按SDO请求、FoE请求、寄存器请求的顺序占用连续的
+ * 状态槽。之后创建的请求没有状态槽，只能通过ioctl()访问。SDO请求和
+ * 寄存器请求的数据区大小等于建立时请求的数据内存大小；FoE数据总是通过
+ * ioctl()读取。区域已建立时直接返回。调用者必须持有master_sem。
+ */
+int ec_req_shm_setup(
+    ec_req_shm_t *shm /**< 共享状态区域 */
+)
+{
+    ec_master_t *master = shm->master;
+    unsigned int config_count = master->config_table.count;
+    unsigned int slot_count = 0, slot, i, j;
+    size_t slot_offset, data_offset, data_size = 0, capacity;
+
+    if (shm->enabled)
+    {
+        return 0;
+    }
+
+    shm->configs = kcalloc(config_count ? config_count : 1,
+                           sizeof(*shm->configs), GFP_KERNEL);
+    if (!shm->configs)
+    {
+        return -ENOMEM;
+    }
+    shm->config_count = config_count;
+
+    // 第一遍：统计状态槽数量和数据区大小
+    for (i = 0; i < config_count; i++)
+    {
+        ec_slave_config_t *sc = ec_ptr_table_get(&master->config_table, i);
+        ec_req_shm_config_t *c = &shm->configs[i];
+
+        c->first_slot = slot_count;
+        c->sdo_count = sc->sdo_request_table.count;
+        c->foe_count = sc->foe_request_table.count;
+        c->reg_count = sc->reg_request_table.count;
+        slot_count += c->sdo_count + c->foe_count + c->reg_count;
+
+        for (j = 0; j < c->sdo_count; j++)
+        {
+            ec_sdo_request_t *req =
+                ec_ptr_table_get(&sc->sdo_request_table, j);
+            ec_req_shm_data_capacity(req->mem_size, &data_size);
+        }
+        for (j = 0; j < c->reg_count; j++)
+        {
+            ec_reg_request_t *reg =
+                ec_ptr_table_get(&sc->reg_request_table, j);
+            ec_req_shm_data_capacity(reg->mem_size, &data_size);
+        }
+    }
+
+    shm->entries = kcalloc(slot_count ? slot_count : 1,
+                           sizeof(*shm->entries), GFP_KERNEL);
+    if (!shm->entries)
+    {
+        ec_req_shm_disable(shm);
+        return -ENOMEM;
+    }
+
+    slot_offset = ALIGN(sizeof(ec_req_shm_header_t), 8);
+    data_offset = ALIGN(slot_offset +
+                        slot_count * sizeof(ec_req_shm_slot_t), 8);
+
+    shm->mem_size = PAGE_ALIGN(data_offset + data_size);
+    shm->mem = vmalloc_user(shm->mem_size);
+    if (!shm->mem)
+    {
+        ec_req_shm_disable(shm);
+        return -ENOMEM;
+    }
+
+    shm->header = shm->mem;
+    shm->header->magic = EC_REQ_SHM_MAGIC;
+    shm->header->version = EC_REQ_SHM_VERSION;
+    shm->header->slot_offset = slot_offset;
+    shm->header->slot_count = slot_count;
+    shm->slots = (ec_req_shm_slot_t *) ((u8 *) shm->mem + slot_offset);
+
+    // 第二遍：按相同的顺序初始化状态槽
+    data_size = 0;
+    slot = 0;
+    for (i = 0; i < config_count; i++)
+    {
+        ec_slave_config_t *sc = ec_ptr_table_get(&master->config_table, i);
+        const ec_req_shm_config_t *c = &shm->configs[i];
+
+        for (j = 0; j < c->sdo_count; j++, slot++)
+        {
+            ec_sdo_request_t *req =
+                ec_ptr_table_get(&sc->sdo_request_table, j);
+            size_t offset = data_offset + data_size;
+
+            capacity = ec_req_shm_data_capacity(req->mem_size, &data_size);
+            ec_req_shm_slot_init(shm, slot, EC_REQ_SHM_SDO, i, j, req,
+                                 req->state, offset, capacity);
+        }
+        for (j = 0; j < c->foe_count; j++, slot++)
+        {
+            ec_foe_request_t *req =
+                ec_ptr_table_get(&sc->foe_request_table, j);
+
+            ec_req_shm_slot_init(shm, slot, EC_REQ_SHM_FOE, i, j, req,
+                                 req->state, 0, 0);
+        }
+        for (j = 0; j < c->reg_count; j++, slot++)
+        {
+            ec_reg_request_t *reg =
+                ec_ptr_table_get(&sc->reg_request_table, j);
+            size_t offset = data_offset + data_size;
+
+            capacity = ec_req_shm_data_capacity(reg->mem_size, &data_size);
+            ec_req_shm_slot_init(shm, slot, EC_REQ_SHM_REG, i, j, reg,
+                                 reg->state, offset, capacity);
+        }
+    }
+
+    smp_wmb();
+    shm->enabled = 1;
+
+    EC_MASTER_DBG(master, 1, "请求共享状态区域：%u 个状态槽，%zu 字节。\n",
+                  slot_count, shm->mem_size);
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 记录一次请求发起。
+ * @param shm 共享状态区域。
+ * @param config_index 从站配置索引。
+ * @param type 请求类型（EC_REQ_SHM_*）。
+ * @param request_index 请求在该类型中的索引。
+ * @details 在发起请求的ioctl()中，请求进入EC_INT_REQUEST_QUEUED状态之后
+ * 调用。没有状态槽的请求被忽略。
+ */
+void ec_req_shm_issue(
+    ec_req_shm_t *shm,         /**< 共享状态区域 */
+    unsigned int config_index, /**< 从站配置索引 */
+    u8 type,                   /**< 请求类型 */
+    unsigned int request_index /**< 请求索引 */
+)
+{
+    const ec_req_shm_config_t *c;
+    unsigned int slot;
+
+    if (!shm->enabled || config_index >= shm->config_count)
+    {
+        return;
+    }
+
+    c = &shm->configs[config_index];
+    slot = c->first_slot + request_index;
+    switch (type)
+    {
+    case EC_REQ_SHM_SDO:
+        if (request_index >= c->sdo_count)
+        {
+            return;
+        }
+        break;
+    case EC_REQ_SHM_FOE:
+        if (request_index >= c->foe_count)
+        {
+            return;
+        }
+        slot += c->sdo_count;
+        break;
+    case EC_REQ_SHM_REG:
+        if (request_index >= c->reg_count)
+        {
+            return;
+        }
+        slot += c->sdo_count + c->foe_count;
+        break;
+    default:
+        return;
+    }
+
+    // 新的请求状态必须在issued之前可见，见ec_req_shm_publish()
+    smp_wmb();
+    shm->slots[slot].issued++;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 复制读取到的数据。
+ * @param shm 共享状态区域。
+ * @param slot 状态槽序号。
+ * @param data 数据。
+ * @param size 数据大小。
+ */
+static void ec_req_shm_copy(
+    ec_req_shm_t *shm,  /**< 共享状态区域 */
+    unsigned int slot,  /**< 状态槽序号 */
+    const u8 *data,     /**< 数据 */
+    size_t size         /**< 数据大小 */
+)
+{
+    ec_req_shm_slot_t *s = &shm->slots[slot];
+
+    s->data_size = size;
+    if (size <= s->data_capacity)
+    {
+        memcpy(shm->entries[slot].data, data, size);
+        s->flags |= EC_REQ_SHM_FLAG_INLINE;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 发布已结束请求的结果。
+ * @param shm 共享状态区域。
+ * @details 在主站操作线程或ecrt_master_exec_slave_requests()执行从站
+ * 状态机之后调用。
+ * 先读取issued再读取请求状态，因此在发布期间重新发起的请求不会被误认为
+ * 已结束。有请求结束时通知eventfd一次。调用者必须持有master_sem。
+ */
+void ec_req_shm_publish(
+    ec_req_shm_t *shm /**< 共享状态区域 */
+)
+{
+    unsigned int slot, count = shm->header->slot_count, done = 0;
+
+    for (slot = 0; slot < count; slot++)
+    {
+        ec_req_shm_slot_t *s = &shm->slots[slot];
+        void *req = shm->entries[slot].req;
+        ec_internal_request_state_t state;
+        u32 issued = s->issued;
+
+        if (s->completed == issued)
+        {
+            continue;
+        }
+        smp_rmb();
+
+        switch (s->type)
+        {
+        case EC_REQ_SHM_SDO:
+        {
+            ec_sdo_request_t *sdo = req;
+
+            state = sdo->state;
+            if (state != EC_INT_REQUEST_SUCCESS &&
+                state != EC_INT_REQUEST_FAILURE)
+            {
+                continue;
+            }
+            s->flags = 0;
+            s->data_size = 0;
+            s->abort_code = sdo->abort_code;
+            if (state == EC_INT_REQUEST_SUCCESS && sdo->dir == EC_DIR_INPUT)
+            {
+                ec_req_shm_copy(shm, slot, sdo->data, sdo->data_size);
+            }
+            break;
+        }
+        case EC_REQ_SHM_FOE:
+        {
+            ec_foe_request_t *foe = req;
+
+            state = foe->state;
+            s->progress = foe->progress;
+            if (state != EC_INT_REQUEST_SUCCESS &&
+                state != EC_INT_REQUEST_FAILURE)
+            {
+                continue;
+            }
+            s->flags = 0;
+            s->abort_code = foe->result;
+            s->error_code = foe->error_code;
+            s->data_size = state == EC_INT_REQUEST_SUCCESS &&
+                foe->dir == EC_DIR_INPUT ? foe->data_size : 0;
+            break;
+        }
+        case EC_REQ_SHM_REG:
+        {
+            ec_reg_request_t *reg = req;
+
+            state = reg->state;
+            if (state != EC_INT_REQUEST_SUCCESS &&
+                state != EC_INT_REQUEST_FAILURE)
+            {
+                continue;
+            }
+            s->flags = 0;
+            s->data_size = 0;
+            if (state == EC_INT_REQUEST_SUCCESS &&
+                (reg->dir == EC_DIR_INPUT || reg->dir == EC_DIR_BOTH))
+            {
+                ec_req_shm_copy(shm, slot, reg->data, reg->transfer_size);
+            }
+            break;
+        }
+        default:
+            continue;
+        }
+
+        s->state = ec_request_state_translation_table[state];
+        // 结果必须在completed之前对读取端可见
+        smp_wmb();
+        s->completed = issued;
+        done++;
+    }
+
+    if (!done)
+    {
+        return;
+    }
+
+    shm->header->completions += done;
+#ifdef CONFIG_EVENTFD
+    if (shm->eventfd)
+    {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+        eventfd_signal(shm->eventfd);
+#else
+        eventfd_signal(shm->eventfd, 1);
+#endif
+    }
+#endif
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回映射到用户空间的页面。
+ * @param shm 共享状态区域。
+ * @param offset 区域内的偏移量。
+ * @return 页面，偏移量无效时返回NULL。
+ */
+struct page *ec_req_shm_page(
+    const ec_req_shm_t *shm, /**< 共享状态区域 */
+    unsigned long offset     /**< 区域内的偏移量 */
+)
+{
+    if (!shm->mem || offset >= shm->mem_size)
+    {
+        return NULL;
+    }
+    return vmalloc_to_page((u8 *) shm->mem + offset);
+}
+
+/*****************************************************************************/
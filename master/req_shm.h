@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   异步请求的共享状态区域。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_REQ_SHM_H__
+#define __EC_REQ_SHM_H__
+
+#include <linux/types.h>
+#include <linux/mm.h>
+
+#include "globals.h"
+#include "ioctl.h"
+
+/*****************************************************************************/
+
+/** 状态槽数据区的总大小上限。超出后的槽不再内联数据。 */
+#define EC_REQ_SHM_MAX_DATA (16 * 1024 * 1024)
+
+/*****************************************************************************/
+
+/** 状态槽对应的内核请求。
+ */
+typedef struct
+{
+    void *req;     /**< 请求（类型由状态槽决定）。 */
+    u8 *data;      /**< 状态槽的数据区。 */
+} ec_req_shm_entry_t;
+
+/** 一个从站配置在共享区域中的状态槽范围。
+ */
+typedef struct
+{
+    unsigned int first_slot; /**< 第一个状态槽。 */
+    unsigned int sdo_count;  /**< SDO请求数。 */
+    unsigned int foe_count;  /**< FoE请求数。 */
+    unsigned int reg_count;  /**< 寄存器请求数。 */
+} ec_req_shm_config_t;
+
+/** 异步请求的共享状态区域。
+ *
+ * 用户空间应用程序通过mmap()只读映射该区域（见EC_IOCTL_MMAP_REQ_SHM），
+ * 用普通的内存读取代替每次轮询请求状态的ioctl()。主站每次执行从站
+ * 状态机后发布已结束请求的结果，并可以通过eventfd通知应用程序。
+ */
+typedef struct
+{
+    ec_master_t *master;            /**< 所属主站。 */
+    void *mem;                      /**< vmalloc_user()分配的内存。 */
+    size_t mem_size;                /**< \a mem 的大小。 */
+    ec_req_shm_header_t *header;    /**< 区域头部。 */
+    ec_req_shm_slot_t *slots;       /**< 状态槽。 */
+    ec_req_shm_entry_t *entries;    /**< 每个状态槽对应的请求。 */
+    ec_req_shm_config_t *configs;   /**< 按配置索引的状态槽范围。 */
+    unsigned int config_count;      /**< \a configs 的数量。 */
+    struct eventfd_ctx *eventfd;    /**< 完成通知，可以为NULL。 */
+    int enabled;                    /**< 区域已建立。 */
+} ec_req_shm_t;
+
+/*****************************************************************************/
+
+void ec_req_shm_init(ec_req_shm_t *, ec_master_t *);
+void ec_req_shm_clear(ec_req_shm_t *);
+int ec_req_shm_setup(ec_req_shm_t *);
+int ec_req_shm_set_eventfd(ec_req_shm_t *, int);
+void ec_req_shm_disable(ec_req_shm_t *);
+void ec_req_shm_issue(ec_req_shm_t *, unsigned int, u8, unsigned int);
+void ec_req_shm_publish(ec_req_shm_t *);
+struct page *ec_req_shm_page(const ec_req_shm_t *, unsigned long);
+
+/*****************************************************************************/
+
+#endif
@@ -0,0 +1,166 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   数据报往返时间的估计和自适应超时。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+
+#include "rtt.h"
+
+/*****************************************************************************/
+
+/** 各类别超时中平均偏差的倍数。
+ */
+static const unsigned int ec_rtt_var_factor[EC_RTT_CLASS_COUNT] = {4, 8};
+
+/** 各类别超时的附加余量（纳秒），用于覆盖轮询的抖动。
+ */
+static const u32 ec_rtt_margin_ns[EC_RTT_CLASS_COUNT] = {10000, 50000};
+
+/*****************************************************************************/
+
+/**
+@brief 计算帧的传输时间。
+@param frame_size 帧长度（字节）。
+@return 传输时间（纳秒）。
+*/
+static inline u32 ec_rtt_wire_ns(
+    size_t frame_size /**< 帧长度（字节）。 */
+)
+{
+    return (u32)frame_size * EC_RTT_NS_PER_BYTE;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 初始化往返时间估计。
+@param rtt 往返时间估计。
+*/
+void ec_rtt_init(
+    ec_rtt_t *rtt /**< 往返时间估计。 */
+)
+{
+    rtt->samples = 0;
+    rtt->srtt_ns = 0;
+    rtt->rttvar_ns = 0;
+    rtt->peak_ns = 0;
+    rtt->last_ns = 0;
+    rtt->last_frame_size = 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 加入一个往返时间的采样。
+@param rtt 往返时间估计。
+@param sample_ns 测量的往返时间（纳秒）。
+@param frame_size 帧长度（字节）。
+@details 平滑值的权重为1/8，平均偏差的权重为1/4。峰值每次采样衰减1/64。
+*/
+void ec_rtt_add(
+    ec_rtt_t *rtt,    /**< 往返时间估计。 */
+    u32 sample_ns,    /**< 测量的往返时间（纳秒）。 */
+    size_t frame_size /**< 帧长度（字节）。 */
+)
+{
+    u32 wire_ns = ec_rtt_wire_ns(frame_size);
+    u32 base_ns = sample_ns > wire_ns ? sample_ns - wire_ns : 0;
+    s32 err;
+
+    rtt->last_ns = sample_ns;
+    rtt->last_frame_size = frame_size;
+
+    if (!rtt->samples)
+    {
+        rtt->srtt_ns = base_ns;
+        rtt->rttvar_ns = base_ns / 2;
+        rtt->peak_ns = base_ns;
+        rtt->samples = 1;
+        return;
+    }
+
+    err = (s32)(base_ns - rtt->srtt_ns);
+    rtt->srtt_ns += err / 8;
+    rtt->rttvar_ns += ((s32)abs(err) - (s32)rtt->rttvar_ns) / 4;
+
+    rtt->peak_ns -= rtt->peak_ns / 64;
+    if (base_ns > rtt->peak_ns)
+    {
+        rtt->peak_ns = base_ns;
+    }
+
+    if (rtt->samples < UINT_MAX)
+    {
+        rtt->samples++;
+    }
+}
+
+/*****************************************************************************/
+
+/**
+@brief 计算一个数据报的自适应超时。
+@param rtt 往返时间估计。
+@param class 数据报的超时类别。
+@param frame_size 数据报所在帧的长度（字节）。
+@param max_ns 固定的超时，作为上限。
+@return 超时（纳秒）。
+@details 超时为平滑值加上偏差的倍数、传输时间和余量。邮箱类别至少等待
+         峰值。采样不足时返回固定的超时。
+*/
+u32 ec_rtt_timeout_ns(
+    const ec_rtt_t *rtt,  /**< 往返时间估计。 */
+    ec_rtt_class_t class, /**< 数据报的超时类别。 */
+    size_t frame_size,    /**< 帧长度（字节）。 */
+    u32 max_ns            /**< 固定的超时。 */
+)
+{
+    u32 timeout_ns;
+
+    if (rtt->samples < EC_RTT_MIN_SAMPLES)
+    {
+        return max_ns;
+    }
+
+    timeout_ns = rtt->srtt_ns + ec_rtt_var_factor[class] * rtt->rttvar_ns;
+    if (class == EC_RTT_CLASS_MAILBOX && timeout_ns < rtt->peak_ns)
+    {
+        timeout_ns = rtt->peak_ns;
+    }
+    timeout_ns += ec_rtt_wire_ns(frame_size) + ec_rtt_margin_ns[class];
+
+    return min(timeout_ns, max_ns);
+}
+
+/*****************************************************************************/
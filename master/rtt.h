@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   数据报往返时间的估计和自适应超时。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_RTT_H__
+#define __EC_RTT_H__
+
+#include <linux/types.h>
+
+#include "datagram.h"
+
+/*****************************************************************************/
+
+/** 估计值可用于自适应超时之前需要的采样数。
+ */
+#define EC_RTT_MIN_SAMPLES 16
+
+/** 每字节帧长度的传输时间（纳秒，100 Mbit/s）。
+ */
+#define EC_RTT_NS_PER_BYTE 80
+
+/** 数据报的超时类别。
+ */
+typedef enum
+{
+    EC_RTT_CLASS_CYCLIC,  /**< 过程数据（逻辑寻址）的数据报。 */
+    EC_RTT_CLASS_MAILBOX, /**< 邮箱和其他非周期的数据报。 */
+    EC_RTT_CLASS_COUNT    /**< 类别数量。 */
+} ec_rtt_class_t;
+
+/** 一个设备的往返时间估计。
+ *
+ * 所有时间都减去了帧的传输时间，这样不同长度的帧可以共用一个估计。
+ * 平滑值和平均偏差按照TCP的方式（RFC 6298）计算，峰值缓慢衰减。
+ */
+typedef struct
+{
+    unsigned int samples; /**< 采样数。 */
+    u32 srtt_ns;          /**< 平滑后的往返时间。 */
+    u32 rttvar_ns;        /**< 往返时间的平均偏差。 */
+    u32 peak_ns;          /**< 衰减的峰值。 */
+    u32 last_ns;          /**< 最近一次采样（包括传输时间）。 */
+    size_t last_frame_size; /**< 最近一次采样的帧长度（字节）。 */
+} ec_rtt_t;
+
+/*****************************************************************************/
+
+void ec_rtt_init(ec_rtt_t *);
+void ec_rtt_add(ec_rtt_t *, u32, size_t);
+u32 ec_rtt_timeout_ns(const ec_rtt_t *, ec_rtt_class_t, size_t, u32);
+
+/*****************************************************************************/
+
+/**
+@brief 获取数据报的超时类别。
+@param datagram 数据报。
+@return 逻辑寻址的数据报属于周期类别，其他的属于邮箱类别。
+*/
+static inline ec_rtt_class_t ec_rtt_class(
+    const ec_datagram_t *datagram /**< 数据报。 */
+)
+{
+    switch (datagram->type)
+    {
+    case EC_DATAGRAM_LRD:
+    case EC_DATAGRAM_LWR:
+    case EC_DATAGRAM_LRW:
+        return EC_RTT_CLASS_CYCLIC;
+    default:
+        return EC_RTT_CLASS_MAILBOX;
+    }
+}
+
+/*****************************************************************************/
+
+#endif
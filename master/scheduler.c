@@ -0,0 +1,130 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   非周期数据报的加权调度（差额轮询）。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+
+#include "scheduler.h"
+
+/*****************************************************************************/
+
+/** 默认权重。
+ */
+static const unsigned int ec_sched_default_weights[EC_SCHED_QUEUES] =
+    EC_SCHED_DEFAULT_WEIGHTS;
+
+/*****************************************************************************/
+
+/**
+@brief 初始化调度器。
+@param sched 调度器。
+@param weights 权重数组（模块参数），可以为NULL。
+@param count 数组中设置了的权重数，其余类别使用默认权重。
+*/
+void ec_sched_init(
+    ec_sched_t *sched,            /**< 调度器。 */
+    const unsigned int *weights,  /**< 权重数组。 */
+    unsigned int count            /**< 设置了的权重数。 */
+)
+{
+    unsigned int i;
+
+    for (i = 0; i < EC_SCHED_QUEUES; i++)
+    {
+        sched->weights[i] = ec_sched_default_weights[i];
+        if (weights && i < count && weights[i])
+        {
+            sched->weights[i] = weights[i];
+        }
+        sched->deficit[i] = 0;
+    }
+
+    sched->next = 0;
+    memset(sched->stats, 0, sizeof(sched->stats));
+}
+
+/*****************************************************************************/
+
+/**
+@brief 设置一个类别的权重。
+@param sched 调度器。
+@param sched_class 类别。
+@param weight 权重，至少为1。
+@return 成功返回0，类别或权重无效时返回-EINVAL。
+*/
+int ec_sched_set_weight(
+    ec_sched_t *sched,        /**< 调度器。 */
+    unsigned int sched_class, /**< 类别。 */
+    unsigned int weight       /**< 权重。 */
+)
+{
+    if (sched_class >= EC_SCHED_QUEUES || !weight)
+    {
+        return -EINVAL;
+    }
+
+    sched->weights[sched_class] = weight;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 统计一个发送的数据报。
+@param sched 调度器。
+@param sched_class 数据报的类别。
+@param size 占用的字节数，见ec_sched_size()。
+@param wait_us 在环中的等待时间（微秒）。
+*/
+void ec_sched_account(
+    ec_sched_t *sched,            /**< 调度器。 */
+    ec_sched_class_t sched_class, /**< 类别。 */
+    size_t size,                  /**< 字节数。 */
+    u32 wait_us                   /**< 等待时间。 */
+)
+{
+    ec_sched_stats_t *stats = &sched->stats[sched_class];
+
+    stats->datagrams++;
+    stats->bytes += size;
+    if (wait_us > stats->max_wait_us)
+    {
+        stats->max_wait_us = wait_us;
+    }
+}
+
+/*****************************************************************************/
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   非周期数据报的加权调度（差额轮询）。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_SCHEDULER_H__
+#define __EC_SCHEDULER_H__
+
+#include <linux/types.h>
+
+#include "globals.h"
+#include "datagram.h"
+
+/*****************************************************************************/
+
+/** 每个权重单位在一轮中获得的字节数。
+ */
+#define EC_SCHED_QUANTUM 256
+
+/** 未通过模块参数设置时各类别的默认权重。
+ */
+#define EC_SCHED_DEFAULT_WEIGHTS {4, 4, 2, 1, 2, 2}
+
+/** 数据报的调度类别。
+ *
+ * 前EC_SCHED_QUEUES个类别来自外部数据报环，按权重调度。周期类别
+ * 包括应用程序排队的所有数据报，总是先发送，只用于统计。
+ */
+typedef enum
+{
+    EC_SCHED_FSM,    /**< 状态机（扫描、配置、AL状态）。 */
+    EC_SCHED_COE,    /**< CoE、SoE和字典请求。 */
+    EC_SCHED_EOE,    /**< EoE请求。 */
+    EC_SCHED_FOE,    /**< FoE请求。 */
+    EC_SCHED_MBG,    /**< 邮箱网关请求。 */
+    EC_SCHED_REG,    /**< 寄存器请求。 */
+    EC_SCHED_CYCLIC, /**< 应用程序的数据报。 */
+    EC_SCHED_COUNT   /**< 类别数量。 */
+} ec_sched_class_t;
+
+/** 按权重调度的类别数量。
+ */
+#define EC_SCHED_QUEUES EC_SCHED_CYCLIC
+
+/** 一个类别的统计。
+ */
+typedef struct
+{
+    u64 datagrams;   /**< 发送的数据报数。 */
+    u64 bytes;       /**< 发送的字节数（包括数据报头）。 */
+    u64 deferred;    /**< 因字节预算不足推迟到下一周期的次数。 */
+    u64 timeouts;    /**< 等待超时而丢弃的数据报数。 */
+    u32 max_wait_us; /**< 在环中的最长等待时间（微秒）。 */
+} ec_sched_stats_t;
+
+/** 外部数据报环的调度器。
+ */
+typedef struct
+{
+    unsigned int weights[EC_SCHED_QUEUES]; /**< 各类别的权重。 */
+    size_t deficit[EC_SCHED_QUEUES];       /**< 各类别剩余的字节额度。 */
+    unsigned int next;                     /**< 下一周期首先调度的类别。 */
+    ec_sched_stats_t stats[EC_SCHED_COUNT]; /**< 各类别的统计。 */
+} ec_sched_t;
+
+/*****************************************************************************/
+
+void ec_sched_init(ec_sched_t *, const unsigned int *, unsigned int);
+int ec_sched_set_weight(ec_sched_t *, unsigned int, unsigned int);
+void ec_sched_account(ec_sched_t *, ec_sched_class_t, size_t, u32);
+
+/*****************************************************************************/
+
+/**
+@brief 计算数据报在帧中占用的字节数。
+@param datagram 数据报。
+@return 数据、数据报头和工作计数器的长度。
+*/
+static inline size_t ec_sched_size(
+    const ec_datagram_t *datagram /**< 数据报。 */
+)
+{
+    return EC_DATAGRAM_HEADER_SIZE + datagram->data_size +
+           EC_DATAGRAM_FOOTER_SIZE;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 获取一个类别一轮中获得的字节额度。
+@param sched 调度器。
+@param sched_class 类别。
+@return 字节数。
+*/
+static inline size_t ec_sched_quantum(
+    const ec_sched_t *sched,    /**< 调度器。 */
+    ec_sched_class_t sched_class /**< 类别。 */
+)
+{
+    return sched->weights[sched_class] * EC_SCHED_QUANTUM;
+}
+
+/*****************************************************************************/
+
+#endif
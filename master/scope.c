@@ -0,0 +1,375 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   过程数据记录器。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <linux/log2.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+
+#include "master.h"
+#include "domain.h"
+#include "scope.h"
+
+/*****************************************************************************/
+
+/**
+ * @brief 初始化记录器。
+ * @param scope 记录器。
+ * @param master 所属主站。
+ */
+void ec_scope_init(
+    ec_scope_t *scope,  /**< 记录器 */
+    ec_master_t *master /**< 所属主站 */
+)
+{
+    memset(scope, 0, sizeof(*scope));
+    scope->master = master;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 释放记录器。
+ * @param scope 记录器。
+ */
+void ec_scope_clear(
+    ec_scope_t *scope /**< 记录器 */
+)
+{
+    ec_scope_disable(scope);
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 停止记录并释放记录环。
+ * @param scope 记录器。
+ * @details 等待正在进行的采样结束后才释放内存。已映射的页面在用户空间
+ * 解除映射之前保持有效。调用者必须持有master_sem，或者确保不会并发配置。
+ */
+void ec_scope_disable(
+    ec_scope_t *scope /**< 记录器 */
+)
+{
+    if (scope->enabled)
+    {
+        scope->enabled = 0;
+        smp_mb();
+        while (scope->busy)
+        {
+            msleep(1);
+        }
+    }
+
+    if (scope->domain)
+    {
+        scope->domain->scope = NULL;
+        scope->domain = NULL;
+    }
+
+    if (scope->mem)
+    {
+        vfree(scope->mem);
+        scope->mem = NULL;
+    }
+    scope->mem_size = 0;
+    scope->header = NULL;
+    scope->data = NULL;
+    scope->channel_count = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 配置并启动记录器。
+ * @param scope 记录器。
+ * @param io 配置。
+ * @return 成功返回0，否则返回负错误代码。
+ * @details 通道数为0时只停止记录。通道引用的域必须已经激活，即过程数据
+ * 内存已经分配。调用者必须持有master_sem。
+ */
+int ec_scope_configure(
+    ec_scope_t *scope,          /**< 记录器 */
+    const ec_ioctl_scope_t *io  /**< 配置 */
+)
+{
+    ec_scope_ring_header_t *header;
+    ec_domain_t *sample_domain = NULL;
+    unsigned int i;
+    u32 depth, sample_size;
+
+    ec_scope_disable(scope);
+
+    if (!io->channel_count)
+    {
+        return 0;
+    }
+
+    if (io->channel_count > EC_SCOPE_MAX_CHANNELS ||
+        (io->trigger_enable && (io->trigger_channel >= io->channel_count ||
+                                io->trigger_edge > EC_SCOPE_EDGE_FALLING)))
+    {
+        return -EINVAL;
+    }
+
+    for (i = 0; i < io->channel_count; i++)
+    {
+        const ec_ioctl_scope_channel_t *ch = &io->channels[i];
+        ec_domain_t *domain;
+        size_t bytes;
+
+        domain = ec_master_find_domain(scope->master, ch->domain_index);
+        if (!domain)
+        {
+            EC_MASTER_ERR(scope->master, "记录器通道 %u：域 %u 不存在！\n",
+                          i, ch->domain_index);
+            return -ENOENT;
+        }
+
+        bytes = (ch->bit_position + ch->bit_length + 7) / 8;
+        if (!domain->data || ch->bit_position > 7 || !ch->bit_length ||
+            ch->bit_length > 64 || ch->offset + bytes > domain->data_size)
+        {
+            EC_MASTER_ERR(scope->master, "记录器通道 %u 无效（域 %u，"
+                          "偏移量 %u.%u，%u 位）！\n", i, ch->domain_index,
+                          ch->offset, ch->bit_position, ch->bit_length);
+            return -EINVAL;
+        }
+
+        scope->channels[i].data = domain->data + ch->offset;
+        scope->channels[i].bit_position = ch->bit_position;
+        scope->channels[i].bit_length = ch->bit_length;
+
+        if (!i)
+        {
+            sample_domain = domain;
+        }
+    }
+
+    sample_size = sizeof(ec_scope_sample_t) +
+                  io->channel_count * sizeof(uint64_t);
+    depth = io->depth ? io->depth : EC_SCOPE_DEFAULT_DEPTH;
+    depth = min_t(u32, depth, EC_SCOPE_MAX_SIZE / sample_size);
+    depth = depth > 1 ? rounddown_pow_of_two(depth) : 2;
+
+    scope->mem_size = PAGE_ALIGN(PAGE_SIZE + depth * sample_size);
+    scope->mem = vmalloc_user(scope->mem_size);
+    if (!scope->mem)
+    {
+        scope->mem_size = 0;
+        return -ENOMEM;
+    }
+
+    header = scope->mem;
+    header->magic = EC_SCOPE_RING_MAGIC;
+    header->version = EC_SCOPE_RING_VERSION;
+    header->data_offset = PAGE_SIZE;
+    header->depth = depth;
+    header->sample_size = sample_size;
+    header->channel_count = io->channel_count;
+
+    scope->header = header;
+    scope->data = (uint8_t *) scope->mem + PAGE_SIZE;
+    scope->mask = depth - 1;
+    scope->sample_size = sample_size;
+    scope->channel_count = io->channel_count;
+
+    scope->trigger_enable = io->trigger_enable;
+    scope->trigger_channel = io->trigger_channel;
+    scope->trigger_edge = io->trigger_edge;
+    scope->trigger_signed = io->trigger_signed;
+    scope->trigger_level = io->trigger_level;
+    scope->trigger_valid = 0;
+
+    scope->domain = sample_domain;
+    scope->enabled = 1;
+    smp_wmb();
+    sample_domain->scope = scope;
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 读取通道的当前值。
+ * @param ch 通道。
+ * @return 零扩展的原始值。
+ */
+static inline u64 ec_scope_read(
+    const ec_scope_channel_t *ch /**< 通道 */
+)
+{
+    unsigned int i, bytes;
+    u64 value = 0;
+
+    if (likely(!ch->bit_position))
+    {
+        switch (ch->bit_length)
+        {
+        case 8:
+            return EC_READ_U8(ch->data);
+        case 16:
+            return EC_READ_U16(ch->data);
+        case 32:
+            return EC_READ_U32(ch->data);
+        case 64:
+            return EC_READ_U64(ch->data);
+        }
+    }
+
+    bytes = (ch->bit_position + ch->bit_length + 7) / 8;
+    for (i = 0; i < bytes && i < 8; i++)
+    {
+        value |= (u64) ch->data[i] << (8 * i);
+    }
+    value >>= ch->bit_position;
+    if (bytes > 8)
+    {
+        value |= (u64) ch->data[8] << (64 - ch->bit_position);
+    }
+    if (ch->bit_length < 64)
+    {
+        value &= (1ULL << ch->bit_length) - 1;
+    }
+    return value;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 记录一个采样。
+ * @param scope 记录器。
+ * @details 由ecrt_domain_process()在处理采样域时调用。
+ */
+void ec_scope_sample(
+    ec_scope_t *scope /**< 记录器 */
+)
+{
+    ec_scope_ring_header_t *header;
+    ec_scope_sample_t *sample;
+    uint64_t *values;
+    unsigned int i;
+    u32 seq;
+
+    scope->busy = 1;
+    smp_mb();
+    if (unlikely(!scope->enabled))
+    {
+        goto out;
+    }
+
+    header = scope->header;
+    seq = header->head;
+    sample = (ec_scope_sample_t *)
+        (scope->data + (seq & scope->mask) * scope->sample_size);
+    values = (uint64_t *) (sample + 1);
+
+    sample->seq = seq;
+    sample->flags = 0;
+    sample->timestamp = ktime_to_ns(ktime_get_real());
+    sample->app_time = scope->master->app_time;
+
+    for (i = 0; i < scope->channel_count; i++)
+    {
+        values[i] = ec_scope_read(&scope->channels[i]);
+    }
+
+    if (scope->trigger_enable)
+    {
+        const ec_scope_channel_t *ch =
+            &scope->channels[scope->trigger_channel];
+        s64 value = values[scope->trigger_channel];
+        int hit;
+
+        if (scope->trigger_signed && ch->bit_length < 64)
+        {
+            unsigned int shift = 64 - ch->bit_length;
+            value = (s64) ((u64) value << shift) >> shift;
+        }
+
+        if (scope->trigger_edge == EC_SCOPE_EDGE_RISING)
+        {
+            hit = scope->trigger_prev < scope->trigger_level &&
+                  value >= scope->trigger_level;
+        }
+        else
+        {
+            hit = scope->trigger_prev > scope->trigger_level &&
+                  value <= scope->trigger_level;
+        }
+
+        if (scope->trigger_valid && hit)
+        {
+            sample->flags |= EC_SCOPE_FLAG_TRIGGER;
+            header->trigger_seq = seq;
+            header->trigger_count++;
+        }
+        scope->trigger_prev = value;
+        scope->trigger_valid = 1;
+    }
+
+    // 采样内容必须在新的head之前对读取端可见
+    smp_wmb();
+    header->head = seq + 1;
+
+out:
+    smp_wmb();
+    scope->busy = 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 返回映射到用户空间的页面。
+ * @param scope 记录器。
+ * @param offset 区域内的偏移量。
+ * @return 页面，偏移量无效时返回NULL。
+ */
+struct page *ec_scope_page(
+    const ec_scope_t *scope, /**< 记录器 */
+    unsigned long offset     /**< 区域内的偏移量 */
+)
+{
+    if (!scope->mem || offset >= scope->mem_size)
+    {
+        return NULL;
+    }
+    return vmalloc_to_page((uint8_t *) scope->mem + offset);
+}
+
+/*****************************************************************************/
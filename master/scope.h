@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   过程数据记录器。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_SCOPE_H__
+#define __EC_SCOPE_H__
+
+#include <linux/types.h>
+#include <linux/mm.h>
+
+#include "globals.h"
+#include "ioctl.h"
+
+/*****************************************************************************/
+
+/** 记录环的默认深度（采样数）。 */
+#define EC_SCOPE_DEFAULT_DEPTH 4096
+
+/** 记录环数据区的最大大小。 */
+#define EC_SCOPE_MAX_SIZE (64 * 1024 * 1024)
+
+/*****************************************************************************/
+
+/** 记录器通道。
+ */
+typedef struct
+{
+    const uint8_t *data; /**< 过程数据中的第一个字节。 */
+    u8 bit_position;     /**< 起始位。 */
+    u8 bit_length;       /**< 位长度。 */
+} ec_scope_channel_t;
+
+/** 过程数据记录器。
+ *
+ * 启用时，每次对采样域调用ecrt_domain_process()都会把所有通道的当前值
+ * 追加到可以mmap()只读映射的记录环中（见EC_IOCTL_MMAP_SCOPE）。禁用时
+ * 实时路径上只有一次指针判断。采样只由处理采样域的上下文写入，
+ * 因此记录环只有一个生产者。
+ */
+typedef struct
+{
+    ec_master_t *master;       /**< 所属主站。 */
+    ec_domain_t *domain;       /**< 采样域，未启用时为NULL。 */
+    ec_scope_channel_t channels[EC_SCOPE_MAX_CHANNELS]; /**< 通道。 */
+    unsigned int channel_count; /**< 通道数。 */
+
+    void *mem;                       /**< vmalloc_user()分配的内存。 */
+    size_t mem_size;                 /**< \a mem 的大小。 */
+    ec_scope_ring_header_t *header;  /**< 记录环头部。 */
+    uint8_t *data;                   /**< 数据区。 */
+    u32 mask;                        /**< 序号掩码（深度 - 1）。 */
+    u32 sample_size;                 /**< 每个采样的字节数。 */
+
+    u8 trigger_enable;  /**< 启用触发检测。 */
+    u8 trigger_channel; /**< 触发通道。 */
+    u8 trigger_edge;    /**< 触发边沿。 */
+    u8 trigger_signed;  /**< 按有符号数比较。 */
+    s64 trigger_level;  /**< 触发阈值。 */
+    s64 trigger_prev;   /**< 触发通道上一个采样的值。 */
+    u8 trigger_valid;   /**< \a trigger_prev 有效。 */
+
+    volatile int enabled; /**< 记录器已启用。 */
+    volatile int busy;    /**< 正在采样。 */
+} ec_scope_t;
+
+/*****************************************************************************/
+
+void ec_scope_init(ec_scope_t *, ec_master_t *);
+void ec_scope_clear(ec_scope_t *);
+int ec_scope_configure(ec_scope_t *, const ec_ioctl_scope_t *);
+void ec_scope_disable(ec_scope_t *);
+void ec_scope_sample(ec_scope_t *);
+struct page *ec_scope_page(const ec_scope_t *, unsigned long);
+
+/*****************************************************************************/
+
+#endif
@@ -96,6 +96,9 @@ slave->last_al_error = 0;
 slave->error_flag = 0;
 slave->force_config = 0;
 slave->reboot = 0;
+slave->status_mapped = 0;
+slave->al_group = EC_AL_GROUP_NONE;
+ec_crc_counters_init(&slave->crc_counters);
 slave->configured_rx_mailbox_offset = 0x0000;
 slave->configured_rx_mailbox_size = 0x0000;
 slave->configured_tx_mailbox_offset = 0x0000;
@@ -137,6 +140,7 @@ slave->vendor_words = NULL;
 slave->sii_image = NULL;
 
 INIT_LIST_HEAD(&slave->sdo_dictionary);
+ec_ptr_table_init(&slave->sdo_table);
 
 slave->scan_required = 1;
 slave->sdo_dictionary_fetched = 0;
@@ -337,6 +341,8 @@ void ec_slave_clear(ec_slave_t *slave)
 
     // 释放所有SDO
 
+    ec_ptr_table_clear(&slave->sdo_table);
+
     list_for_each_entry_safe(sdo, next_sdo, &slave->sdo_dictionary, list)
     {
         list_del(&sdo->list);
@@ -445,6 +451,8 @@ void ec_slave_set_dl_status(ec_slave_t *slave, uint16_t new_state)
  */
 void ec_slave_set_al_status(ec_slave_t *slave, ec_slave_state_t new_state)
 {
+    u8 prev_state = slave->current_state;
+
     if (new_state != slave->current_state)
     {
         if (slave->master->debug_level)
@@ -456,6 +464,9 @@ void ec_slave_set_al_status(ec_slave_t *slave, ec_slave_state_t new_state)
             EC_SLAVE_DBG(slave, 0, "%s -> %s。\n", old_state, cur_state);
         }
         slave->current_state = new_state;
+        ec_event_ring_post(&slave->master->events, EC_EVENT_AL_STATE, 1,
+                           slave->ring_position, new_state,
+                           &prev_state, sizeof(prev_state));
     }
 }
 
@@ -472,6 +483,29 @@ void ec_slave_request_state(ec_slave_t *slave, ec_slave_state_t state)
 {
     slave->requested_state = state;
     slave->error_flag = 0;
+    slave->al_group = EC_AL_GROUP_NONE;
+}
+
+/*****************************************************************************/
+
+/**
+ * @brief 请求从站状态，并让最后一次状态转换与其他从站一起进行。
+ * 请求从站状态，并让最后一次状态转换与其他从站一起进行。
+ *
+ * 只有SAFEOP和OP参与分组转换，其他状态与ec_slave_request_state()相同。
+ *
+ * @param slave  EtherCAT从站
+ * @param state  新的状态
+ */
+void ec_slave_request_group_state(ec_slave_t *slave, ec_slave_state_t state)
+{
+    ec_slave_request_state(slave, state);
+
+    if ((state == EC_SLAVE_STATE_SAFEOP || state == EC_SLAVE_STATE_OP) &&
+        slave->current_state != state)
+    {
+        slave->al_group = EC_AL_GROUP_MEMBER;
+    }
 }
 
 /*****************************************************************************/
@@ -874,25 +908,85 @@ void ec_slave_sdo_dict_info(const ec_slave_t *slave, unsigned int *sdo_count, un
 /*****************************************************************************/
 
 /**
- * 从字典中获取一个SDO。
- * 返回所需的SDO，如果不存在则返回NULL。
+ * 在排序的SDO指针表中查找第一个索引不小于给定索引的位置。
  *
  * @param slave  EtherCAT从站
  * @param index  SDO索引
- * @return       SDO指针，如果不存在则返回NULL
+ * @return       表中的位置，所有SDO索引都更小时返回SDO数量
  */
-ec_sdo_t *ec_slave_get_sdo(ec_slave_t *slave, uint16_t index)
+static unsigned int ec_slave_sdo_lower_bound(const ec_slave_t *slave,
+                                             uint16_t index)
 {
-    ec_sdo_t *sdo;
+    unsigned int low = 0, high = slave->sdo_table.count;
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list)
+    while (low < high)
     {
-        if (sdo->index != index)
-            continue;
-        return sdo;
+        unsigned int mid = low + (high - low) / 2;
+        const ec_sdo_t *sdo = slave->sdo_table.items[mid];
+
+        if (sdo->index < index)
+            low = mid + 1;
+        else
+            high = mid;
     }
 
-    return NULL;
+    return low;
+}
+
+/*****************************************************************************/
+
+/**
+ * 向字典中添加一个SDO。
+ * SDO按索引排序插入链表和指针表，两者的顺序始终一致，因此
+ * 按位置和按索引的查找都不必遍历链表。
+ *
+ * @param slave  EtherCAT从站
+ * @param sdo    已初始化的SDO
+ * @return       成功返回0，否则返回负错误代码
+ */
+int ec_slave_add_sdo(ec_slave_t *slave, ec_sdo_t *sdo)
+{
+    unsigned int pos;
+    int ret;
+
+    // 从站通常按升序上报，先检查表尾
+    if (!slave->sdo_table.count ||
+        ((const ec_sdo_t *)slave->sdo_table.items[
+             slave->sdo_table.count - 1])->index <= sdo->index)
+        pos = slave->sdo_table.count;
+    else
+        pos = ec_slave_sdo_lower_bound(slave, sdo->index);
+
+    ret = ec_ptr_table_insert(&slave->sdo_table, pos, sdo);
+    if (ret)
+        return ret;
+
+    if (pos + 1 < slave->sdo_table.count)
+    {
+        ec_sdo_t *next = slave->sdo_table.items[pos + 1];
+        list_add_tail(&sdo->list, &next->list);
+    }
+    else
+    {
+        list_add_tail(&sdo->list, &slave->sdo_dictionary);
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+ * 从字典中获取一个SDO。
+ * 返回所需的SDO，如果不存在则返回NULL。
+ *
+ * @param slave  EtherCAT从站
+ * @param index  SDO索引
+ * @return       SDO指针，如果不存在则返回NULL
+ */
+ec_sdo_t *ec_slave_get_sdo(ec_slave_t *slave, uint16_t index)
+{
+    return (ec_sdo_t *)ec_slave_get_sdo_const(slave, index);
 }
 
 
@@ -908,16 +1002,10 @@ ec_sdo_t *ec_slave_get_sdo(ec_slave_t *slave, uint16_t index)
  */
 const ec_sdo_t *ec_slave_get_sdo_const(const ec_slave_t *slave, uint16_t index)
 {
-    const ec_sdo_t *sdo;
+    unsigned int pos = ec_slave_sdo_lower_bound(slave, index);
+    const ec_sdo_t *sdo = ec_ptr_table_get(&slave->sdo_table, pos);
 
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list)
-    {
-        if (sdo->index != index)
-            continue;
-        return sdo;
-    }
-
-    return NULL;
+    return sdo && sdo->index == index ? sdo : NULL;
 }
 
 /*****************************************************************************/
@@ -932,16 +1020,7 @@ const ec_sdo_t *ec_slave_get_sdo_const(const ec_slave_t *slave, uint16_t index)
  */
 const ec_sdo_t *ec_slave_get_sdo_by_pos_const(const ec_slave_t *slave, uint16_t sdo_position)
 {
-    const ec_sdo_t *sdo;
-
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list)
-    {
-        if (sdo_position--)
-            continue;
-        return sdo;
-    }
-
-    return NULL;
+    return ec_ptr_table_get(&slave->sdo_table, sdo_position);
 }
 
 /*****************************************************************************/
@@ -955,15 +1034,7 @@ const ec_sdo_t *ec_slave_get_sdo_by_pos_const(const ec_slave_t *slave, uint16_t
  */
 uint16_t ec_slave_sdo_count(const ec_slave_t *slave)
 {
-    const ec_sdo_t *sdo;
-    uint16_t count = 0;
-
-    list_for_each_entry(sdo, &slave->sdo_dictionary, list)
-    {
-        count++;
-    }
-
-    return count;
+    return slave->sdo_table.count;
 }
 
 /*****************************************************************************/
@@ -47,6 +47,8 @@
 #include "sync.h"
 #include "sdo.h"
 #include "fsm_slave.h"
+#include "ptr_table.h"
+#include "crc_monitor.h"
 
 /*****************************************************************************/
 
@@ -212,6 +214,20 @@ typedef struct
 
 /*****************************************************************************/
 
+/** 从站在分组状态转换中的角色。
+ *
+ * 同时请求多个从站进入SAFEOP或OP时，各从站的配置状态机只完成到最后一次
+ * 状态转换之前，然后由主站状态机一起写入AL控制寄存器并检查结果。
+ */
+typedef enum
+{
+    EC_AL_GROUP_NONE,   /**< 不参与分组转换。 */
+    EC_AL_GROUP_MEMBER, /**< 正在配置，尚未到达最后一次转换。 */
+    EC_AL_GROUP_READY   /**< 等待主站执行分组转换。 */
+} ec_al_group_t;
+
+/*****************************************************************************/
+
 /** EtherCAT从站。
  */
 struct ec_slave
@@ -241,6 +257,9 @@ struct ec_slave
     unsigned int error_flag;               /**< 在出错后停止处理。 */
     unsigned int force_config;             /**< 强制（重新）配置。 */
     unsigned int reboot;                   /**< 请求重启 */
+    unsigned int status_mapped;            /**< AL状态已映射到状态域。 */
+    ec_al_group_t al_group;                /**< 在分组状态转换中的角色。 */
+    ec_crc_counters_t crc_counters;        /**< 总线健康监视的错误计数器。 */
     uint16_t configured_rx_mailbox_offset; /**< 配置的接收邮箱偏移。 */
     uint16_t configured_rx_mailbox_size;   /**< 配置的接收邮箱大小。 */
     uint16_t configured_tx_mailbox_offset; /**< 配置的发送邮箱偏移。 */
@@ -264,7 +283,8 @@ struct ec_slave
     uint16_t *vendor_words;    /**< SII图像的前16个字。 */
     ec_sii_image_t *sii_image; /**< 当前的完整SII图像。 */
 
-    struct list_head sdo_dictionary; /**< SDO字典列表 */
+    struct list_head sdo_dictionary; /**< SDO字典列表（按索引排序） */
+    ec_ptr_table_t sdo_table;        /**< 按索引排序的SDO指针表 */
     uint8_t scan_required;           /**< 需要扫描。 */
     uint8_t sdo_dictionary_fetched;  /**< 字典已被获取。 */
     unsigned long jiffies_preop;     /**< 从站进入PREOP的时间。 */
@@ -308,6 +328,7 @@ void ec_slave_clear(ec_slave_t *); // 清除EtherCAT从站对象
 void ec_slave_clear_sync_managers(ec_slave_t *); // 清除从站的同步管理器
 
 void ec_slave_request_state(ec_slave_t *, ec_slave_state_t); // 请求从站状态改变
+void ec_slave_request_group_state(ec_slave_t *, ec_slave_state_t); // 请求分组状态改变
 void ec_slave_set_dl_status(ec_slave_t *, uint16_t); // 设置从站的数据链路状态
 void ec_slave_set_al_status(ec_slave_t *, ec_slave_state_t); // 设置从站的应用层状态
 void ec_slave_request_reboot(ec_slave_t *); // 请求从站重启
@@ -324,6 +345,7 @@ ec_sync_t *ec_slave_get_sync(ec_slave_t *, uint8_t); // 获取从站的同步管
 
 void ec_slave_sdo_dict_info(const ec_slave_t *,
                             unsigned int *, unsigned int *); // 获取从站SDO字典信息
+int ec_slave_add_sdo(ec_slave_t *, ec_sdo_t *); // 向字典中添加SDO
 ec_sdo_t *ec_slave_get_sdo(ec_slave_t *, uint16_t); // 获取从站的SDO
 const ec_sdo_t *ec_slave_get_sdo_const(const ec_slave_t *, uint16_t); // 获取从站的SDO（const版本）
 const ec_sdo_t *ec_slave_get_sdo_by_pos_const(const ec_slave_t *, uint16_t); // 根据位置获取从站的SDO（const版本）
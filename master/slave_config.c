@@ -128,6 +128,10 @@ void ec_slave_config_init(
     INIT_LIST_HEAD(&sc->reg_requests);
     INIT_LIST_HEAD(&sc->voe_handlers);
     INIT_LIST_HEAD(&sc->soe_configs);
+    ec_ptr_table_init(&sc->sdo_request_table);
+    ec_ptr_table_init(&sc->foe_request_table);
+    ec_ptr_table_init(&sc->voe_handler_table);
+    ec_ptr_table_init(&sc->reg_request_table);
 
     ec_coe_emerg_ring_init(&sc->emerg_ring, sc);
 }
@@ -174,6 +178,11 @@ void ec_slave_config_clear(
         kfree(req);
     }
 
+    ec_ptr_table_clear(&sc->sdo_request_table);
+    ec_ptr_table_clear(&sc->foe_request_table);
+    ec_ptr_table_clear(&sc->voe_handler_table);
+    ec_ptr_table_clear(&sc->reg_request_table);
+
     // 释放所有 SDO 请求
     list_for_each_entry_safe(req, next_req, &sc->sdo_requests, list)
     {
@@ -616,16 +625,7 @@ ec_sdo_request_t *ec_slave_config_find_sdo_request(
     unsigned int pos       /**< 列表中的位置。 */
 )
 {
-    ec_sdo_request_t *req;
-
-    list_for_each_entry(req, &sc->sdo_requests, list)
-    {
-        if (pos--)
-            continue;
-        return req;
-    }
-
-    return NULL;
+    return ec_ptr_table_get(&sc->sdo_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -641,16 +641,7 @@ ec_foe_request_t *ec_slave_config_find_foe_request(
     unsigned int pos       /**< 列表中的位置。 */
 )
 {
-    ec_foe_request_t *req;
-
-    list_for_each_entry(req, &sc->foe_requests, list)
-    {
-        if (pos--)
-            continue;
-        return req;
-    }
-
-    return NULL;
+    return ec_ptr_table_get(&sc->foe_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -666,16 +657,7 @@ ec_reg_request_t *ec_slave_config_find_reg_request(
     unsigned int pos       /**< 列表中的位置。 */
 )
 {
-    ec_reg_request_t *reg;
-
-    list_for_each_entry(reg, &sc->reg_requests, list)
-    {
-        if (pos--)
-            continue;
-        return reg;
-    }
-
-    return NULL;
+    return ec_ptr_table_get(&sc->reg_request_table, pos);
 }
 
 /*****************************************************************************/
@@ -691,16 +673,7 @@ ec_voe_handler_t *ec_slave_config_find_voe_handler(
     unsigned int pos       /**< 列表中的位置。 */
 )
 {
-    ec_voe_handler_t *voe;
-
-    list_for_each_entry(voe, &sc->voe_handlers, list)
-    {
-        if (pos--)
-            continue;
-        return voe;
-    }
-
-    return NULL;
+    return ec_ptr_table_get(&sc->voe_handler_table, pos);
 }
 
 /*****************************************************************************/
@@ -1633,9 +1606,20 @@ ec_sdo_request_t *ecrt_slave_config_create_sdo_request_err(
     req->data_size = size;
 
     ec_lock_down(&sc->master->master_sem);
-    list_add_tail(&req->list, &sc->sdo_requests);
+    ret = ec_ptr_table_append(&sc->sdo_request_table, req);
+    if (!ret)
+    {
+        list_add_tail(&req->list, &sc->sdo_requests);
+    }
     ec_lock_up(&sc->master->master_sem);
 
+    if (ret)
+    {
+        ec_sdo_request_clear(req);
+        kfree(req);
+        return ERR_PTR(ret);
+    }
+
     return req;
 }
 
@@ -1726,9 +1710,20 @@ ec_foe_request_t *ecrt_slave_config_create_foe_request_err(
     req->data_size = size;
 
     ec_lock_down(&sc->master->master_sem);
-    list_add_tail(&req->list, &sc->foe_requests);
+    ret = ec_ptr_table_append(&sc->foe_request_table, req);
+    if (!ret)
+    {
+        list_add_tail(&req->list, &sc->foe_requests);
+    }
     ec_lock_up(&sc->master->master_sem);
 
+    if (ret)
+    {
+        ec_foe_request_clear(req);
+        kfree(req);
+        return ERR_PTR(ret);
+    }
+
     return req;
 }
 
@@ -1787,9 +1782,20 @@ ec_reg_request_t *ecrt_slave_config_create_reg_request_err(
     }
 
     ec_lock_down(&sc->master->master_sem);
-    list_add_tail(&reg->list, &sc->reg_requests);
+    ret = ec_ptr_table_append(&sc->reg_request_table, reg);
+    if (!ret)
+    {
+        list_add_tail(&reg->list, &sc->reg_requests);
+    }
     ec_lock_up(&sc->master->master_sem);
 
+    if (ret)
+    {
+        ec_reg_request_clear(reg);
+        kfree(reg);
+        return ERR_PTR(ret);
+    }
+
     return reg;
 }
 
@@ -1848,9 +1854,20 @@ ec_voe_handler_t *ecrt_slave_config_create_voe_handler_err(
     }
 
     ec_lock_down(&sc->master->master_sem);
-    list_add_tail(&voe->list, &sc->voe_handlers);
+    ret = ec_ptr_table_append(&sc->voe_handler_table, voe);
+    if (!ret)
+    {
+        list_add_tail(&voe->list, &sc->voe_handlers);
+    }
     ec_lock_up(&sc->master->master_sem);
 
+    if (ret)
+    {
+        ec_voe_handler_clear(voe);
+        kfree(voe);
+        return ERR_PTR(ret);
+    }
+
     return voe;
 }
 
@@ -44,6 +44,7 @@
 #include "sync_config.h"
 #include "fmmu_config.h"
 #include "coe_emerg_ring.h"
+#include "ptr_table.h"
 
 /*****************************************************************************/
 
@@ -143,6 +144,11 @@ struct ec_slave_config
         struct list_head reg_requests; /**< 寄存器请求列表。 */
         struct list_head soe_configs;  /**< SoE配置列表。 */
 
+        ec_ptr_table_t sdo_request_table; /**< 按索引访问的SDO请求。 */
+        ec_ptr_table_t foe_request_table; /**< 按索引访问的FoE请求。 */
+        ec_ptr_table_t voe_handler_table; /**< 按索引访问的VoE处理程序。 */
+        ec_ptr_table_t reg_request_table; /**< 按索引访问的寄存器请求。 */
+
         ec_coe_emerg_ring_t emerg_ring; /**< CoE紧急环形缓冲区。 */
 };
 
@@ -0,0 +1,284 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   AL状态的逻辑寻址监视（状态域）。
+*/
+
+/*****************************************************************************/
+
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/jiffies.h>
+
+#include "master.h"
+#include "slave.h"
+#include "status_domain.h"
+
+/*****************************************************************************/
+
+/** 接收到的状态在多长时间内有效（jiffies）。
+ *
+ * 应用程序或IDLE线程停止发送后，主站状态机回退到逐个轮询从站。
+ */
+#define EC_STATUS_DOMAIN_TIMEOUT (HZ / 10)
+
+/*****************************************************************************/
+
+/**
+@brief 初始化状态域。
+@param sd 状态域。
+@param enabled 是否启用。
+@return 成功返回0，否则返回负的错误代码。
+*/
+int ec_status_domain_init(
+    ec_status_domain_t *sd, /**< 状态域。 */
+    unsigned int enabled    /**< 是否启用。 */
+)
+{
+    int ret;
+
+    sd->enabled = enabled;
+    sd->size = 0;
+    sd->working_counter = 0;
+    sd->expected_wc = 0;
+    sd->valid = 0;
+    sd->current = 0;
+    sd->jiffies_received = 0;
+    memset(sd->states, 0, sizeof(sd->states));
+
+    ec_datagram_init(&sd->datagram);
+    snprintf(sd->datagram.name, EC_DATAGRAM_NAME_SIZE, "status");
+
+    if (!enabled)
+    {
+        return 0;
+    }
+
+    // 一次分配最大的数据报，之后调整大小不需要分配内存
+    ret = ec_datagram_prealloc(&sd->datagram, EC_MAX_DATA_SIZE);
+    if (ret)
+    {
+        ec_datagram_clear(&sd->datagram);
+        return ret;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 释放状态域。
+@param sd 状态域。
+*/
+void ec_status_domain_clear(
+    ec_status_domain_t *sd /**< 状态域。 */
+)
+{
+    ec_datagram_clear(&sd->datagram);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 确定从站用于状态域的FMMU。
+@param sd 状态域。
+@param slave 从站。
+@param used_fmmus 从站配置使用的FMMU数。
+@return FMMU索引，没有空闲的FMMU或未启用状态域时返回-1。
+@details 使用从站的最后一个FMMU，过程数据的FMMU从0开始分配。状态域
+只在主设备上发送，其他设备上的从站不映射。
+*/
+int ec_status_domain_fmmu(
+    const ec_status_domain_t *sd, /**< 状态域。 */
+    const ec_slave_t *slave,      /**< 从站。 */
+    unsigned int used_fmmus       /**< 从站配置使用的FMMU数。 */
+)
+{
+    if (!sd->enabled || slave->device_index != EC_DEVICE_MAIN ||
+        EC_STATUS_DOMAIN_OFFSET(slave) >= EC_MAX_DATA_SIZE ||
+        slave->base_fmmu_count <= used_fmmus)
+    {
+        return -1;
+    }
+
+    return slave->base_fmmu_count - 1;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 写入把AL状态映射到状态域的FMMU配置页。
+@param slave 从站。
+@param data FMMU配置页（EC_FMMU_PAGE_SIZE字节）。
+*/
+void ec_status_domain_fmmu_page(
+    const ec_slave_t *slave, /**< 从站。 */
+    uint8_t *data            /**< FMMU配置页。 */
+)
+{
+    EC_WRITE_U32(data, EC_STATUS_DOMAIN_ADDRESS + EC_STATUS_DOMAIN_OFFSET(slave));
+    EC_WRITE_U16(data + 4, 1);       // 大小
+    EC_WRITE_U8(data + 6, 0x00);     // 逻辑起始位
+    EC_WRITE_U8(data + 7, 0x07);     // 逻辑结束位
+    EC_WRITE_U16(data + 8, 0x0130);  // AL状态寄存器
+    EC_WRITE_U8(data + 10, 0x00);    // 物理起始位
+    EC_WRITE_U8(data + 11, 0x01);    // 读
+    EC_WRITE_U16(data + 12, 0x0001); // 使能
+    EC_WRITE_U16(data + 14, 0x0000); // 保留
+}
+
+/*****************************************************************************/
+
+/**
+@brief 取回上一次的结果并重新排队状态域数据报。
+@param sd 状态域。
+@param master EtherCAT主站。
+@details 由ecrt_master_send()调用，可以在实时上下文中执行。只访问状态域
+本身，不访问从站。
+*/
+void ec_status_domain_queue(
+    ec_status_domain_t *sd, /**< 状态域。 */
+    ec_master_t *master     /**< EtherCAT主站。 */
+)
+{
+    ec_datagram_t *datagram = &sd->datagram;
+    unsigned int size = sd->size;
+
+    if (!sd->enabled)
+    {
+        return;
+    }
+
+    switch (datagram->state)
+    {
+    case EC_DATAGRAM_QUEUED:
+    case EC_DATAGRAM_SENT:
+        // 仍在传输中
+        return;
+    case EC_DATAGRAM_RECEIVED:
+        memcpy(sd->states, datagram->data,
+               min(datagram->data_size, sizeof(sd->states)));
+        sd->working_counter = datagram->working_counter;
+        sd->jiffies_received = jiffies;
+        sd->valid = 1;
+        break;
+    default:
+        sd->valid = 0;
+        break;
+    }
+
+    if (!size)
+    {
+        return;
+    }
+
+    if (datagram->data_size != size)
+    {
+        ec_datagram_lrd(datagram, EC_STATUS_DOMAIN_ADDRESS, size);
+    }
+    ec_datagram_zero(datagram);
+    datagram->device_index = EC_DEVICE_MAIN;
+    ec_master_queue_datagram(master, datagram);
+}
+
+/*****************************************************************************/
+
+/**
+@brief 把接收到的AL状态交给从站。
+@param sd 状态域。
+@param master EtherCAT主站。
+@details 由主站状态机在持有master_sem时调用。只有所有已映射的从站都
+应答了（工作计数器等于已映射的从站数）并且数据足够新时，状态才被采用，
+状态变化立即作为事件发布。否则主站状态机回退到逐个轮询从站。
+*/
+void ec_status_domain_process(
+    ec_status_domain_t *sd, /**< 状态域。 */
+    ec_master_t *master     /**< EtherCAT主站。 */
+)
+{
+    unsigned int i, size, expected = 0;
+    ec_slave_t *slave;
+
+    sd->current = 0;
+
+    if (!sd->enabled || master->scan_busy)
+    {
+        return;
+    }
+
+    size = min(master->slave_count, (unsigned int)EC_MAX_DATA_SIZE);
+    for (i = 0; i < size; i++)
+    {
+        if (master->slaves[i].status_mapped)
+        {
+            expected++;
+        }
+    }
+    sd->size = size;
+    sd->expected_wc = expected;
+
+    if (!expected || !sd->valid || sd->working_counter != expected ||
+        time_after(jiffies, sd->jiffies_received + EC_STATUS_DOMAIN_TIMEOUT))
+    {
+        return;
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        slave = &master->slaves[i];
+        if (slave->status_mapped)
+        {
+            ec_slave_set_al_status(slave, sd->states[i]);
+        }
+    }
+
+    sd->current = 1;
+}
+
+/*****************************************************************************/
+
+/**
+@brief 检查从站的AL状态是否由状态域提供。
+@param sd 状态域。
+@param slave 从站。
+@return 如果从站的状态是当前的，返回非零。
+*/
+int ec_status_domain_covers(
+    const ec_status_domain_t *sd, /**< 状态域。 */
+    const ec_slave_t *slave       /**< 从站。 */
+)
+{
+    return sd->current && slave->status_mapped &&
+           EC_STATUS_DOMAIN_OFFSET(slave) < sd->size;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2012  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *****************************************************************************/
+
+/**
+   \file
+   AL状态的逻辑寻址监视（状态域）。
+*/
+
+/*****************************************************************************/
+
+#ifndef __EC_STATUS_DOMAIN_H__
+#define __EC_STATUS_DOMAIN_H__
+
+#include <linux/types.h>
+
+#include "globals.h"
+#include "datagram.h"
+
+/*****************************************************************************/
+
+/** 状态域在逻辑地址空间中的起始地址。
+ *
+ * 过程数据域从0开始向上分配，状态域位于地址空间的末尾，每个从站按在
+ * 主站从站数组中的索引占用一个字节。
+ */
+#define EC_STATUS_DOMAIN_ADDRESS 0xFFFF0000
+
+/*****************************************************************************/
+
+/** 从站在状态域中的字节偏移。
+ */
+#define EC_STATUS_DOMAIN_OFFSET(SLAVE) ((SLAVE) - (SLAVE)->master->slaves)
+
+/*****************************************************************************/
+
+/** 状态域。
+ *
+ * 主设备上每个从站的最后一个FMMU（如果配置不需要）把AL状态寄存器（0x0130）映射
+ * 到状态域，每次ecrt_master_send()用一个LRD数据报读取所有从站的状态。
+ * 发送路径把接收到的数据复制到\a states ，主站状态机再从这里更新从站的
+ * 状态，而不必逐个轮询从站。
+ */
+typedef struct
+{
+    unsigned int enabled;           /**< 已通过模块参数启用。 */
+    ec_datagram_t datagram;         /**< LRD数据报。 */
+    u8 states[EC_MAX_DATA_SIZE];    /**< 最近一次接收到的AL状态。 */
+    unsigned int size;              /**< 覆盖的从站数（数据报大小）。 */
+    u16 working_counter;            /**< 最近一次接收到的工作计数器。 */
+    u16 expected_wc;                /**< 已映射的从站数。 */
+    unsigned int valid;             /**< \a states 中的数据有效。 */
+    unsigned long jiffies_received; /**< 最近一次接收的时刻。 */
+    unsigned int current;           /**< 本轮状态机使用状态域的数据。 */
+} ec_status_domain_t;
+
+/*****************************************************************************/
+
+int ec_status_domain_init(ec_status_domain_t *, unsigned int);
+void ec_status_domain_clear(ec_status_domain_t *);
+
+int ec_status_domain_fmmu(const ec_status_domain_t *, const ec_slave_t *,
+                          unsigned int);
+void ec_status_domain_fmmu_page(const ec_slave_t *, uint8_t *);
+
+void ec_status_domain_queue(ec_status_domain_t *, ec_master_t *);
+void ec_status_domain_process(ec_status_domain_t *, ec_master_t *);
+int ec_status_domain_covers(const ec_status_domain_t *, const ec_slave_t *);
+
+/*****************************************************************************/
+
+#endif
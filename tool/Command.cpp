@@ -154,7 +154,10 @@ Command::Command(const string &name, const string &briefDesc):
     verbosity(Normal),
     emergency(false),
     force(false),
-    reset(false)
+    reset(false),
+    follow(false),
+    batch(false),
+    watch(false)
 {
 }
 
@@ -229,6 +232,27 @@ void Command::setReset(bool r)
 
 /*****************************************************************************/
 
+void Command::setFollow(bool f)
+{
+    follow = f;
+};
+
+/*****************************************************************************/
+
+void Command::setBatch(bool b)
+{
+    batch = b;
+};
+
+/*****************************************************************************/
+
+void Command::setWatch(bool w)
+{
+    watch = w;
+};
+
+/*****************************************************************************/
+
 void Command::setOutputFile(const string &f)
 {
     outputFile = f;
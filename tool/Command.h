@@ -116,6 +116,14 @@ class Command
         void setReset(bool);
         bool getReset() const;
 
+        void setFollow(bool);
+        bool getFollow() const;
+
+        void setBatch(bool);
+        bool getBatch() const;
+        void setWatch(bool);
+        bool getWatch() const;
+
         void setOutputFile(const string &);
         const string &getOutputFile() const;
 
@@ -164,6 +172,9 @@ class Command
         bool emergency;
         bool force;
         bool reset;
+        bool follow;
+        bool batch;
+        bool watch;
         string outputFile;
         string skin;
 
@@ -221,6 +232,27 @@ inline bool Command::getReset() const
 
 /****************************************************************************/
 
+inline bool Command::getFollow() const
+{
+    return follow;
+}
+
+/****************************************************************************/
+
+inline bool Command::getBatch() const
+{
+    return batch;
+}
+
+/****************************************************************************/
+
+inline bool Command::getWatch() const
+{
+    return watch;
+}
+
+/****************************************************************************/
+
 inline const string &Command::getOutputFile() const
 {
     return outputFile;
@@ -88,6 +88,7 @@ void CommandCStruct::execute(const StringVector &args)
             mi != masterIndices.end(); mi++) {
         MasterDevice m(*mi);
         m.open(MasterDevice::Read);
+        m.loadSnapshot();
         slaves = selectedSlaves(m);
 
         for (si = slaves.begin(); si != slaves.end(); si++) {
@@ -28,6 +28,8 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <vector>
+#include <unistd.h>
 using namespace std;
 
 #include "CommandCrc.h"
@@ -49,9 +51,39 @@ string CommandCrc::helpString(const string &binaryBaseName) const
     str
         << binaryBaseName << " " << getName() << endl
         << binaryBaseName << " " << getName() << " reset" << endl
+        << binaryBaseName << " " << getName() << " monitor <MS>" << endl
+        << binaryBaseName << " " << getName() << " --watch" << endl
         << endl
         << getBriefDescription() << endl
         << endl
+        << "Without arguments, the error registers of all slaves are read"
+        << endl
+        << "once. 'reset' clears them." << endl
+        << endl
+        << "'monitor' makes the master sweep the error counters of all" << endl
+        << "slaves every MS milliseconds in the background, using packed"
+        << endl
+        << "multi-slave frames. 0 disables the monitor (default, unless" << endl
+        << "set via the crc_monitor_interval module parameter)." << endl
+        << endl
+        << "With --watch, the accumulated counters and the rates per" << endl
+        << "second of the last sweep are printed after each sweep of the"
+        << endl
+        << "monitor. Only ports with errors are shown, unless --verbose"
+        << endl
+        << "is given. Stop with Ctrl-C." << endl
+        << endl
+        << "The monitor clears the error registers of each slave when it"
+        << endl
+        << "reads them, so that every sweep yields the errors since the"
+        << endl
+        << "last one. While it is enabled, the plain output therefore" << endl
+        << "only shows errors since the last sweep. A counter that reached"
+        << endl
+        << "its limit of 255 within one sweep is marked with 'sat'" << endl
+        << "instead of a rate, its accumulated value is a lower bound."
+        << endl
+        << endl
         << "CRC - CRC Error Counter                0x300, 0x302, 0x304, 0x306"
         << endl
         << "PHY - Physical Interface Error Counter 0x301, 0x303, 0x305, 0x307"
@@ -59,6 +91,13 @@ string CommandCrc::helpString(const string &binaryBaseName) const
         << "FWD - Forwarded RX Error Counter       0x308, 0x309, 0x30a, 0x30b"
         << endl
         << "NXT - Next slave" << endl
+        << "LST - Lost Link Counter                0x310, 0x311, 0x312, 0x313"
+        << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --watch   -w  Print the monitor's counters continuously."
+        << endl
+        << "  --verbose -v  Show all ports in watch mode." << endl
         << endl;
 
     return str.str();
@@ -72,9 +111,38 @@ void CommandCrc::execute(const StringVector &args)
 {
     bool reset = false;
 
+    if (args.size() == 2) {
+        string arg = args[0];
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+        if (arg != "monitor") {
+            stringstream err;
+            err << "Invalid argument '" << args[0] << "'!";
+            throwInvalidUsageException(err);
+        }
+
+        unsigned int interval;
+        stringstream strInterval;
+        strInterval << args[1];
+        strInterval
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> interval;
+        if (strInterval.fail()) {
+            stringstream err;
+            err << "Invalid interval '" << args[1] << "'!";
+            throwInvalidUsageException(err);
+        }
+
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::ReadWrite);
+        m.setCrcMonitorInterval(interval);
+        return;
+    }
+
     if (args.size() > 1) {
         stringstream err;
-        err << "'" << getName() << "' takes either no or 'reset' argument!";
+        err << "'" << getName() << "' takes either no, 'reset' or"
+            << " 'monitor <MS>' arguments!";
         throwInvalidUsageException(err);
     }
 
@@ -84,13 +152,27 @@ void CommandCrc::execute(const StringVector &args)
                 arg.begin(), (int (*) (int)) std::tolower);
         if (arg != "reset") {
             stringstream err;
-            err << "'" << getName() << "' takes either no or 'reset' argument!";
+            err << "'" << getName() << "' takes either no, 'reset' or"
+                << " 'monitor <MS>' arguments!";
             throwInvalidUsageException(err);
         }
 
         reset = true;
     }
 
+    if (getWatch()) {
+        if (reset) {
+            stringstream err;
+            err << "--watch can not be combined with 'reset'!";
+            throwInvalidUsageException(err);
+        }
+
+        MasterDevice m(getSingleMasterIndex());
+        m.open(MasterDevice::Read);
+        watchCounters(m);
+        return;
+    }
+
     MasterDevice m(getSingleMasterIndex());
     m.open(reset ? MasterDevice::ReadWrite : MasterDevice::Read);
 
@@ -178,3 +260,104 @@ void CommandCrc::execute(const StringVector &args)
 }
 
 /*****************************************************************************/
+
+void CommandCrc::watchCounters(MasterDevice &m)
+{
+    static const char *names[EC_CRC_IDX_COUNT] = {"CRC", "PHY", "FWD", "LST"};
+    ec_ioctl_crc_monitor_t data;
+    vector<ec_ioctl_crc_slave_t> slaves;
+    uint32_t lastSweeps;
+
+    data.slaves = NULL;
+    data.max_slaves = 0;
+    m.getCrcMonitor(&data);
+
+    if (!data.interval_ms) {
+        stringstream err;
+        err << "Error counter monitor is disabled. Enable it with '"
+            << getName() << " monitor <MS>'.";
+        throwCommandException(err);
+    }
+
+    lastSweeps = data.sweeps;
+
+    while (1) {
+        usleep(data.interval_ms * 500);
+
+        ec_ioctl_master_t master;
+        m.getMaster(&master);
+        slaves.resize(master.slave_count);
+
+        data.slaves = slaves.empty() ? NULL : &slaves[0];
+        data.max_slaves = slaves.size();
+        m.getCrcMonitor(&data);
+
+        if (!data.interval_ms) {
+            stringstream err;
+            err << "Error counter monitor was disabled.";
+            throwCommandException(err);
+        }
+
+        if (data.sweeps == lastSweeps) {
+            continue;
+        }
+        lastSweeps = data.sweeps;
+
+        cout << "Sweep " << data.sweeps << ", "
+            << data.sweep_interval_us / 1000 << " ms since last sweep"
+            << endl;
+
+        cout << "Slave Port";
+        for (unsigned int j = 0; j < EC_CRC_IDX_COUNT; j++) {
+            cout << setw(11) << names[j];
+        }
+        for (unsigned int j = 0; j < EC_CRC_IDX_COUNT; j++) {
+            cout << setw(9) << names[j] << "/s";
+        }
+        cout << endl;
+
+        for (unsigned int i = 0; i < data.slave_count; i++) {
+            const ec_ioctl_crc_slave_t &s = slaves[i];
+
+            if (!s.valid) {
+                if (getVerbosity() == Verbose) {
+                    cout << setw(5) << i << "    -  not read yet" << endl;
+                }
+                continue;
+            }
+
+            for (unsigned int port = 0; port < EC_MAX_PORTS; port++) {
+                bool errors = false;
+
+                for (unsigned int j = 0; j < EC_CRC_IDX_COUNT; j++) {
+                    if (s.total[port][j]) {
+                        errors = true;
+                    }
+                }
+
+                if (!errors && getVerbosity() != Verbose) {
+                    continue;
+                }
+
+                cout << setw(5) << i << setw(5) << port;
+                for (unsigned int j = 0; j < EC_CRC_IDX_COUNT; j++) {
+                    cout << setw(11) << s.total[port][j];
+                }
+                for (unsigned int j = 0; j < EC_CRC_IDX_COUNT; j++) {
+                    if (s.saturated[port] & (1 << j)) {
+                        cout << setw(11) << "sat";
+                        continue;
+                    }
+                    double rate = data.sweep_interval_us ?
+                        s.delta[port][j] * 1e6 / data.sweep_interval_us : 0.0;
+                    cout << setw(11) << fixed << setprecision(1) << rate;
+                }
+                cout << endl;
+            }
+        }
+
+        cout << endl;
+    }
+}
+
+/*****************************************************************************/
@@ -31,6 +31,8 @@
 #include "Command.h"
 #include "DataTypeHandler.h"
 
+class MasterDevice;
+
 /****************************************************************************/
 
 class CommandCrc:
@@ -42,6 +44,9 @@ class CommandCrc:
 
         string helpString(const string &) const;
         void execute(const StringVector &);
+
+    protected:
+        void watchCounters(MasterDevice &);
 };
 
 /****************************************************************************/
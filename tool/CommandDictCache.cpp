@@ -0,0 +1,339 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+using namespace std;
+
+#include "CommandDictCache.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Header of a saved dictionary file.
+ *
+ * Followed by data_size bytes in the EC_IOCTL_SLAVE_SDO_DICT_EXPORT format.
+ * All values are in host byte order.
+ */
+struct DictFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t product_code;
+    uint32_t revision_number;
+    uint32_t data_size;
+};
+
+static const char dictFileMagic[4] = {'E', 'C', 'O', 'D'};
+static const uint32_t dictFileVersion = 1;
+static const string dictFileSuffix = ".dict";
+
+/*****************************************************************************/
+
+CommandDictCache::CommandDictCache():
+    Command("dict_cache", "Manage the shared object dictionary cache.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandDictCache::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [list | save DIR | load PATH... | clear]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master uploads the CoE object dictionary only once per" << endl
+        << "slave type (vendor id, product code and revision number)" << endl
+        << "and builds the dictionaries of all identical slaves from" << endl
+        << "that copy." << endl
+        << endl
+        << "Actions:" << endl
+        << "  list       Show the cached slave types (default)." << endl
+        << "  save DIR   Write one file per cached type to DIR." << endl
+        << "  load PATH  Add dictionaries from files, or from all" << endl
+        << "             *" << dictFileSuffix
+        << " files in a directory." << endl
+        << "  clear      Drop all cached dictionaries. Dictionaries" << endl
+        << "             already attached to slaves are kept." << endl
+        << endl
+        << "Saved files are named <vendor>-<product>-<revision>"
+        << dictFileSuffix << endl
+        << "(hexadecimal) and use host byte order." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandDictCache::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    string action = args.size() ? args[0] : "list";
+    bool write;
+
+    if (action == "list" || action == "clear") {
+        if (args.size() > 1) {
+            stringstream err;
+            err << "'" << action << "' takes no arguments!";
+            throwInvalidUsageException(err);
+        }
+    } else if (action == "save") {
+        if (args.size() != 2) {
+            stringstream err;
+            err << "'save' takes exactly one directory!";
+            throwInvalidUsageException(err);
+        }
+    } else if (action == "load") {
+        if (args.size() < 2) {
+            stringstream err;
+            err << "'load' needs at least one file or directory!";
+            throwInvalidUsageException(err);
+        }
+    } else {
+        stringstream err;
+        err << "Invalid action '" << action << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    write = action == "load" || action == "clear";
+
+    masterIndices = getMasterIndices();
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(write ? MasterDevice::ReadWrite : MasterDevice::Read);
+
+        if (action == "list") {
+            if (masterIndices.size() > 1) {
+                cout << "Master" << m.getIndex() << endl;
+            }
+            list(m);
+        } else if (action == "save") {
+            save(m, args[1]);
+        } else if (action == "load") {
+            for (StringVector::const_iterator a = args.begin() + 1;
+                    a != args.end(); a++) {
+                load(m, *a);
+            }
+        } else {
+            m.clearDictCache();
+        }
+    }
+}
+
+/****************************************************************************/
+
+void CommandDictCache::list(MasterDevice &m)
+{
+    ec_ioctl_dict_cache_t data;
+
+    memset(&data, 0, sizeof(data));
+    m.getDictCache(&data);
+
+    for (data.position = 0; data.position < data.entry_count;
+            data.position++) {
+        m.getDictCache(&data);
+        cout << "0x" << hex << setfill('0')
+            << setw(8) << data.vendor_id << " 0x"
+            << setw(8) << data.product_code << " 0x"
+            << setw(8) << data.revision_number << " "
+            << dec << data.data_size << " bytes" << endl;
+    }
+}
+
+/****************************************************************************/
+
+void CommandDictCache::save(MasterDevice &m, const string &dir)
+{
+    ec_ioctl_dict_cache_t data;
+    vector<uint8_t> buffer;
+    DictFileHeader header;
+
+    memset(&data, 0, sizeof(data));
+    m.getDictCache(&data);
+
+    for (data.position = 0; data.position < data.entry_count;
+            data.position++) {
+        data.buffer = NULL;
+        data.buffer_size = 0;
+        m.getDictCache(&data);
+        if (!data.data_size) {
+            continue; // removed in between
+        }
+
+        buffer.resize(data.data_size);
+        data.buffer = &buffer.front();
+        data.buffer_size = buffer.size();
+        m.getDictCache(&data);
+        if (!data.sdo_count) {
+            continue; // replaced in between
+        }
+
+        stringstream path;
+        path << dir << "/" << hex << setfill('0')
+            << setw(8) << data.vendor_id << "-"
+            << setw(8) << data.product_code << "-"
+            << setw(8) << data.revision_number << dictFileSuffix;
+
+        ofstream file(path.str().c_str(), ios::out | ios::binary);
+        if (!file) {
+            stringstream err;
+            err << "Failed to open " << path.str() << " for writing!";
+            throwCommandException(err);
+        }
+
+        memcpy(header.magic, dictFileMagic, sizeof(header.magic));
+        header.version = dictFileVersion;
+        header.vendor_id = data.vendor_id;
+        header.product_code = data.product_code;
+        header.revision_number = data.revision_number;
+        header.data_size = data.data_size;
+
+        file.write((const char *) &header, sizeof(header));
+        file.write((const char *) &buffer.front(), data.data_size);
+        if (!file) {
+            stringstream err;
+            err << "Failed to write " << path.str() << "!";
+            throwCommandException(err);
+        }
+
+        cout << path.str() << endl;
+    }
+}
+
+/****************************************************************************/
+
+void CommandDictCache::load(MasterDevice &m, const string &path)
+{
+    struct stat st;
+    DIR *dir;
+    struct dirent *de;
+
+    if (stat(path.c_str(), &st)) {
+        stringstream err;
+        err << "Failed to access " << path << ": " << strerror(errno);
+        throwCommandException(err);
+    }
+
+    if (!S_ISDIR(st.st_mode)) {
+        loadFile(m, path);
+        return;
+    }
+
+    if (!(dir = opendir(path.c_str()))) {
+        stringstream err;
+        err << "Failed to open " << path << ": " << strerror(errno);
+        throwCommandException(err);
+    }
+
+    while ((de = readdir(dir))) {
+        string name(de->d_name);
+
+        if (name.size() <= dictFileSuffix.size() || name.compare(
+                    name.size() - dictFileSuffix.size(),
+                    dictFileSuffix.size(), dictFileSuffix)) {
+            continue;
+        }
+
+        try {
+            loadFile(m, path + "/" + name);
+        } catch (CommandException &e) {
+            cerr << e.what() << endl;
+        }
+    }
+
+    closedir(dir);
+}
+
+/****************************************************************************/
+
+void CommandDictCache::loadFile(MasterDevice &m, const string &path)
+{
+    ifstream file(path.c_str(), ios::in | ios::binary);
+    DictFileHeader header;
+    ec_ioctl_dict_cache_t data;
+    vector<uint8_t> buffer;
+
+    if (!file) {
+        stringstream err;
+        err << "Failed to open " << path << "!";
+        throwCommandException(err);
+    }
+
+    if (!file.read((char *) &header, sizeof(header))
+            || memcmp(header.magic, dictFileMagic, sizeof(header.magic))
+            || header.version != dictFileVersion
+            || !header.data_size
+            || header.data_size > EC_DICT_CACHE_MAX_SIZE) {
+        stringstream err;
+        err << path << " is not a dictionary file!";
+        throwCommandException(err);
+    }
+
+    buffer.resize(header.data_size);
+    if (!file.read((char *) &buffer.front(), header.data_size)) {
+        stringstream err;
+        err << path << " is truncated!";
+        throwCommandException(err);
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.vendor_id = header.vendor_id;
+    data.product_code = header.product_code;
+    data.revision_number = header.revision_number;
+    data.data_size = header.data_size;
+    data.buffer = &buffer.front();
+    data.buffer_size = buffer.size();
+
+    try {
+        m.addDictCache(&data);
+    } catch (MasterDeviceException &e) {
+        stringstream err;
+        err << path << ": " << e.what();
+        throwCommandException(err);
+    }
+
+    cout << path << endl;
+}
+
+/*****************************************************************************/
@@ -0,0 +1,171 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandEvents.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandEvents::CommandEvents():
+    Command("events", "Wait for master events and print them.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandEvents::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "Blocks until the master reports an event and prints one" << endl
+        << "line per event, until interrupted. Events are:" << endl
+        << endl
+        << "  link        Link state change of a device." << endl
+        << "  state       AL state change of a slave." << endl
+        << "  wkc         Working counter change of a domain." << endl
+        << "  redundancy  The redundant link is used or unused again."
+        << endl
+        << "  timeout     Datagrams timed out." << endl
+        << "  emergency   CoE emergency message from a slave." << endl
+        << "  ring        The redundant ring opened or closed again;" << endl
+        << "              shows the master cycle it was detected in."
+        << endl
+        << "  overflow    Events were lost because of slow reading." << endl
+        << endl
+        << "Working counter changes and timeouts are reported at most" << endl
+        << "once a second; the number in brackets is the number of" << endl
+        << "coalesced events." << endl
+        << endl
+        << "Each line starts with the CLOCK_MONOTONIC time of the event" << endl
+        << "in seconds." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandEvents::execute(const StringVector &args)
+{
+    ec_event_t events[16];
+    unsigned int i, count;
+
+    if (args.size()) {
+        stringstream err;
+        err << "'" << getName() << "' takes no arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+
+    while (1) {
+        count = m.readEvents(events, 16);
+        for (i = 0; i < count; i++) {
+            showEvent(events[i]);
+        }
+        cout << flush;
+    }
+}
+
+/****************************************************************************/
+
+void CommandEvents::showEvent(const ec_event_t &event)
+{
+    cout << event.timestamp / 1000000000 << "."
+        << setfill('0') << setw(6) << event.timestamp % 1000000000 / 1000
+        << setfill(' ') << " ";
+
+    switch (event.type) {
+        case EC_EVENT_OVERFLOW:
+            cout << "overflow " << event.value << " events lost";
+            break;
+        case EC_EVENT_LINK:
+            cout << "link " << (event.index ? "backup" : "main")
+                << " " << (event.value ? "UP" : "DOWN");
+            break;
+        case EC_EVENT_AL_STATE:
+            cout << "state slave " << event.index << " "
+                << alStateString(event.data[0]) << " -> "
+                << alStateString(event.value);
+            break;
+        case EC_EVENT_WKC:
+            cout << "wkc domain " << event.index << " " << event.value
+                << "/" << (event.data[0] | event.data[1] << 8);
+            break;
+        case EC_EVENT_REDUNDANCY:
+            cout << "redundancy domain " << event.index << " "
+                << (event.value ? "in use" : "unused");
+            break;
+        case EC_EVENT_TIMEOUT:
+            cout << "timeout " << event.value << " datagrams";
+            break;
+        case EC_EVENT_EMERGENCY:
+            cout << "emergency slave " << event.index << " code 0x"
+                << hex << setfill('0') << setw(4) << event.value
+                << " register 0x" << setw(2) << (unsigned int) event.data[2]
+                << " data";
+            for (unsigned int i = 3; i < 8; i++) {
+                cout << " " << setw(2) << (unsigned int) event.data[i];
+            }
+            cout << dec << setfill(' ');
+            break;
+        case EC_EVENT_RING:
+            {
+                uint64_t cycle = 0;
+                for (unsigned int i = 0; i < 8; i++) {
+                    cycle |= (uint64_t) event.data[i] << (8 * i);
+                }
+                cout << "ring " << (event.value ? "open" : "closed")
+                    << " cycle " << cycle;
+            }
+            break;
+        default:
+            cout << "unknown type " << event.type;
+            break;
+    }
+
+    if (event.count > 1) {
+        cout << " [" << event.count << "]";
+    }
+    cout << endl;
+}
+
+/*****************************************************************************/
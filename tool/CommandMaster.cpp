@@ -100,8 +100,19 @@ void CommandMaster::execute(const StringVector &args)
         }
 
         cout << endl
-            << "  Active: " << (data.active ? "yes" : "no") << endl
-            << "  Slaves: " << data.slave_count << endl
+            << "  Active: " << (data.active ? "yes" : "no") << endl;
+
+        ec_cyclic_state_t cyclic;
+        m.getCyclicState(&cyclic);
+        if (cyclic.running) {
+            cout << "  Cyclic engine: " << cyclic.period_ns << " ns period, "
+                << cyclic.sync0_offset_ns << " ns SYNC0 phase" << endl
+                << "    " << cyclic.cycles << " cycles, "
+                << cyclic.overruns << " overruns, "
+                << cyclic.missed << " missed" << endl;
+        }
+
+        cout << "  Slaves: " << data.slave_count << endl
             << "  Ethernet devices:" << endl;
 
         for (dev_idx = EC_DEVICE_MAIN; dev_idx < data.num_devices;
@@ -176,6 +187,27 @@ void CommandMaster::execute(const StringVector &args)
                 }
             }
             cout << setprecision(0) << endl;
+            if (data.devices[dev_idx].rtt_samples) {
+                cout << "      Round trip [us]:     "
+                    << setprecision(1) << fixed
+                    << data.devices[dev_idx].rtt_ns / 1000.0
+                    << " (deviation "
+                    << data.devices[dev_idx].rtt_var_ns / 1000.0
+                    << ", peak "
+                    << data.devices[dev_idx].rtt_peak_ns / 1000.0
+                    << ", without frame transmission time)"
+                    << setprecision(0) << endl;
+            }
+        }
+        if (data.num_devices > 1) {
+            ec_master_redundancy_state_t ring;
+            m.getRedundancyState(&ring);
+            cout << "    Ring: " << (ring.ring_open ? "OPEN" : "closed")
+                << ", " << ring.switchovers << " switchovers";
+            if (ring.switchovers) {
+                cout << ", last in cycle " << ring.last_cycle;
+            }
+            cout << (ring.shared_tx ? ", shared Tx data" : "") << endl;
         }
         unsigned int lost = data.tx_count - data.rx_count;
         if (lost == 1) {
@@ -29,7 +29,12 @@
  *
  ****************************************************************************/
 
+
 #include <iostream>
+#include <iomanip>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
 using namespace std;
 
 #include "CommandPcap.h"
@@ -37,6 +42,24 @@ using namespace std;
 
 /*****************************************************************************/
 
+/** Datagram type names, indexed by type. */
+static const char *datagramTypes[] = {
+    "NOP", "APRD", "APWR", "APRW", "FPRD", "FPWR", "FPRW", "BRD", "BWR",
+    "BRW", "LRD", "LWR", "LRW", "ARMW", "FRMW"
+};
+
+/** pcapng block types. */
+enum {
+    PcapngSectionHeader = 0x0A0D0D0A,
+    PcapngInterfaceDescription = 0x00000001,
+    PcapngEnhancedPacket = 0x00000006
+};
+
+/** Polling interval when the capture ring is empty. */
+#define FOLLOW_POLL_US 1000
+
+/*****************************************************************************/
+
 CommandPcap::CommandPcap():
     Command("pcap", "Output binary pcap capture data.")
 {
@@ -48,12 +71,41 @@ string CommandPcap::helpString(const string &binaryBaseName) const
 {
     stringstream str;
 
-    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] [FILTER...]" << endl
         << endl
         << getBriefDescription() << endl
         << endl
+        << "The master captures all sent and received frames into a" << endl
+        << "ring buffer of PCAP_SIZE_MB. When the ring is full, the" << endl
+        << "oldest frames are overwritten." << endl
+        << endl
+        << "Without --follow, the frames captured since the last reset" << endl
+        << "are written to stdout in pcap format with nanosecond" << endl
+        << "timestamps. With --follow, the ring is mapped read-only" << endl
+        << "and frames are streamed continuously in pcapng format," << endl
+        << "for example into Wireshark:" << endl
+        << endl
+        << "  " << binaryBaseName << " " << getName()
+        << " --follow | wireshark -k -i -" << endl
+        << endl
+        << "Filters are applied by the master when capturing and stay" << endl
+        << "active until changed (requires write access):" << endl
+        << "  snaplen=<bytes>   Capture at most <bytes> per frame," << endl
+        << "                    0 captures full frames." << endl
+        << "  type=<list>       Capture only frames containing one of" << endl
+        << "                    the comma-separated datagram types" << endl
+        << "                    (e. g. LRW,FPRD)." << endl
+        << "  address=<addr>    Capture only frames containing a" << endl
+        << "                    configured-address datagram (FPRD," << endl
+        << "                    FPWR, FPRW, FRMW) for station <addr>." << endl
+        << "  nofilter          Remove type and address filters." << endl
+        << endl
         << "Command-specific options:" << endl
-        << "  --reset  -r   Flushes the retrieved pcap data and continues logging." << endl
+        << "  --reset   -r  Flushes the retrieved pcap data and continues"
+        << " logging." << endl
+        << "  --follow  -F  Stream frames continuously in pcapng format."
+        << endl
         << endl;
 
     return str.str();
@@ -65,27 +117,114 @@ void CommandPcap::execute(const StringVector &args)
 {
     MasterIndexList masterIndices;
 
-    if (args.size() > 1) {
+    masterIndices = getMasterIndices();
+    if (getFollow() && masterIndices.size() != 1) {
         stringstream err;
-        err << "'" << getName() << "' takes max one argument!";
+        err << "--follow requires exactly one master!";
         throwInvalidUsageException(err);
     }
 
-    masterIndices = getMasterIndices();
     MasterIndexList::const_iterator mi;
     for (mi = masterIndices.begin();
             mi != masterIndices.end(); mi++) {
         ec_ioctl_master_t io;
         MasterDevice m(*mi);
-        m.open(MasterDevice::Read);
+        m.open(args.empty() ? MasterDevice::Read : MasterDevice::ReadWrite);
         m.getMaster(&io);
 
-        outputPcapData(m, io.pcap_size);
+        if (!io.pcap_size) {
+            throwCommandException("Pcap logging is not enabled;"
+                    " set PCAP_SIZE_MB and restart master.");
+        }
+
+        if (!args.empty()) {
+            configureFilter(m, args);
+        }
+
+        if (getFollow()) {
+            followPcapData(m);
+        } else {
+            outputPcapData(m, io.pcap_size);
+        }
     }
 }
 
 /****************************************************************************/
 
+void CommandPcap::configureFilter(
+        MasterDevice &m,
+        const StringVector &args
+        )
+{
+    ec_ioctl_pcap_filter_t filter;
+    StringVector::const_iterator ai;
+
+    filter.set = 0;
+    m.pcapFilter(&filter);
+
+    for (ai = args.begin(); ai != args.end(); ai++) {
+        string::size_type eq = ai->find('=');
+        string key = ai->substr(0, eq);
+        string value = eq == string::npos ? "" : ai->substr(eq + 1);
+        stringstream str;
+
+        if (key == "nofilter" && eq == string::npos) {
+            filter.type_mask = 0;
+            filter.address_filter = 0;
+            filter.address = 0;
+        } else if (key == "snaplen" || key == "address") {
+            unsigned int number;
+
+            str << value;
+            str >> resetiosflags(ios::basefield) // guess base from prefix
+                >> number;
+            if (value.empty() || str.fail() ||
+                    (key == "address" && number > 0xffff)) {
+                stringstream err;
+                err << "Invalid " << key << " '" << value << "'!";
+                throwInvalidUsageException(err);
+            }
+
+            if (key == "snaplen") {
+                filter.snaplen = number;
+            } else {
+                filter.address = number;
+                filter.address_filter = 1;
+            }
+        } else if (key == "type") {
+            string name;
+
+            filter.type_mask = 0;
+            str << value;
+            while (getline(str, name, ',')) {
+                unsigned int t;
+
+                for (t = 0; t < sizeof(datagramTypes) / sizeof(char *);
+                        t++) {
+                    if (strcasecmp(name.c_str(), datagramTypes[t]) == 0) {
+                        break;
+                    }
+                }
+                if (t == sizeof(datagramTypes) / sizeof(char *)) {
+                    stringstream err;
+                    err << "Invalid datagram type '" << name << "'!";
+                    throwInvalidUsageException(err);
+                }
+                filter.type_mask |= 1 << t;
+            }
+        } else {
+            stringstream err;
+            err << "Invalid filter '" << *ai << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    filter.set = 1;
+    m.pcapFilter(&filter);
+}
+
+/****************************************************************************/
+
 void CommandPcap::outputPcapData(
         MasterDevice &m,
         unsigned int pcap_size
@@ -95,10 +234,6 @@ void CommandPcap::outputPcapData(
     unsigned char pcap_reset = getReset();
     vector<unsigned char> pcap_data;
 
-    if (!pcap_size) {
-        throwCommandException("Pcap logging is not enabled; set PCAP_SIZE_MB and restart master.");
-    }
-      
     pcap_data.resize(pcap_size);
     m.getPcap(&data, pcap_reset, pcap_data.size(), pcap_data.data());
 
@@ -107,3 +242,172 @@ void CommandPcap::outputPcapData(
 }
 
 /****************************************************************************/
+
+/** Appends a pcapng option to a block.
+ */
+static void appendOption(
+        vector<uint8_t> &block,
+        uint16_t code,
+        const void *value,
+        uint16_t length
+        )
+{
+    const uint8_t *v = (const uint8_t *) value;
+
+    block.insert(block.end(), (const uint8_t *) &code,
+            (const uint8_t *) &code + 2);
+    block.insert(block.end(), (const uint8_t *) &length,
+            (const uint8_t *) &length + 2);
+    block.insert(block.end(), v, v + length);
+    block.resize((block.size() + 3) & ~3);
+}
+
+/****************************************************************************/
+
+/** Writes a pcapng block with the given type and body to stdout.
+ */
+static void writeBlock(uint32_t type, const vector<uint8_t> &body)
+{
+    uint32_t length = 12 + body.size();
+
+    cout.write((const char *) &type, 4);
+    cout.write((const char *) &length, 4);
+    cout.write((const char *) body.data(), body.size());
+    cout.write((const char *) &length, 4);
+}
+
+/****************************************************************************/
+
+void CommandPcap::followPcapData(MasterDevice &m)
+{
+    const ec_pcap_ring_header_t *header;
+    const uint8_t *data;
+    size_t pageSize = sysconf(_SC_PAGESIZE), mapSize;
+    uint32_t mask, pos;
+    vector<uint8_t> block;
+    ec_pcap_record_t rec;
+    unsigned int i;
+
+    // Map the header first to learn the size of the ring.
+    header = (const ec_pcap_ring_header_t *)
+        m.mapRegion(EC_IOCTL_MMAP_PCAP, pageSize);
+    if (header->magic != EC_PCAP_RING_MAGIC ||
+            header->version != EC_PCAP_RING_VERSION) {
+        m.unmapRegion((void *) header, pageSize);
+        throwCommandException("Unsupported pcap ring layout.");
+    }
+    mapSize = header->data_offset + header->data_size;
+    m.unmapRegion((void *) header, pageSize);
+    header = (const ec_pcap_ring_header_t *)
+        m.mapRegion(EC_IOCTL_MMAP_PCAP, mapSize);
+    data = (const uint8_t *) header + header->data_offset;
+    mask = header->data_size - 1;
+
+    // Section header: byte-order magic, version 1.0, unknown length.
+    {
+        uint32_t bom = 0x1A2B3C4D;
+        uint16_t version[2] = {1, 0};
+        int64_t sectionLength = -1;
+
+        block.clear();
+        block.insert(block.end(), (uint8_t *) &bom, (uint8_t *) &bom + 4);
+        block.insert(block.end(), (uint8_t *) version,
+                (uint8_t *) version + 4);
+        block.insert(block.end(), (uint8_t *) &sectionLength,
+                (uint8_t *) &sectionLength + 8);
+        writeBlock(PcapngSectionHeader, block);
+    }
+
+    // One interface per device, Ethernet, nanosecond resolution.
+    for (i = 0; i < 2; i++) {
+        static const char *names[] = {"main", "backup"};
+        uint16_t linkType = 1, reserved = 0;
+        uint32_t snapLen = header->snaplen ? header->snaplen : 65535;
+        uint8_t tsResol = 9;
+        uint16_t end = 0;
+
+        block.clear();
+        block.insert(block.end(), (uint8_t *) &linkType,
+                (uint8_t *) &linkType + 2);
+        block.insert(block.end(), (uint8_t *) &reserved,
+                (uint8_t *) &reserved + 2);
+        block.insert(block.end(), (uint8_t *) &snapLen,
+                (uint8_t *) &snapLen + 4);
+        appendOption(block, 2, names[i], strlen(names[i])); // if_name
+        appendOption(block, 9, &tsResol, 1); // if_tsresol
+        appendOption(block, 0, &end, 0); // opt_endofopt
+        writeBlock(PcapngInterfaceDescription, block);
+    }
+    cout.flush();
+
+    pos = *(volatile const uint32_t *) &header->tail;
+
+    while (cout.good()) {
+        uint32_t head, tail, off, room;
+        uint32_t ifIndex, tsHigh, tsLow, capLen, origLen, flags;
+        uint16_t end = 0;
+
+        head = *(volatile const uint32_t *) &header->head;
+        __sync_synchronize();
+        tail = *(volatile const uint32_t *) &header->tail;
+
+        if ((int32_t) (pos - tail) < 0) {
+            cerr << "Capture overrun, " << tail - pos
+                << " bytes of frames lost." << endl;
+            pos = tail;
+        }
+
+        if (pos == head) {
+            cout.flush();
+            usleep(FOLLOW_POLL_US);
+            continue;
+        }
+
+        off = pos & mask;
+        room = mask + 1 - off;
+        if (room < sizeof(ec_pcap_record_t)) {
+            pos += room;
+            continue;
+        }
+
+        // Copy the record, then check that it was not overwritten meanwhile.
+        memcpy(&rec, data + off, sizeof(rec));
+        if (rec.caplen > room - sizeof(rec)) {
+            rec.caplen = room - sizeof(rec);
+        }
+        block.resize(20);
+        block.insert(block.end(), data + off + sizeof(rec),
+                data + off + sizeof(rec) + rec.caplen);
+        __sync_synchronize();
+        if ((int32_t) (pos - *(volatile const uint32_t *) &header->tail)
+                < 0) {
+            continue;
+        }
+        pos += rec.size;
+
+        if (rec.flags & EC_PCAP_FLAG_PAD) {
+            continue;
+        }
+
+        // Enhanced packet block.
+        ifIndex = rec.device;
+        tsHigh = rec.timestamp >> 32;
+        tsLow = rec.timestamp;
+        capLen = rec.caplen;
+        origLen = rec.origlen;
+        memcpy(&block[0], &ifIndex, 4);
+        memcpy(&block[4], &tsHigh, 4);
+        memcpy(&block[8], &tsLow, 4);
+        memcpy(&block[12], &capLen, 4);
+        memcpy(&block[16], &origLen, 4);
+        block.resize((block.size() + 3) & ~3);
+        flags = rec.flags & EC_PCAP_FLAG_TX ? 2 : 1; // outbound : inbound
+        appendOption(block, 2, &flags, 4); // epb_flags
+        appendOption(block, 0, &end, 0); // opt_endofopt
+        writeBlock(PcapngEnhancedPacket, block);
+    }
+
+    m.unmapRegion((void *) header, mapSize);
+}
+
+/****************************************************************************/
@@ -44,7 +44,9 @@ class CommandPcap:
         void execute(const StringVector &);
 
     protected:
+        void configureFilter(MasterDevice &, const StringVector &);
         void outputPcapData(MasterDevice &, unsigned int);
+        void followPcapData(MasterDevice &);
 };
 
 /****************************************************************************/
@@ -118,6 +118,7 @@ void CommandPdos::execute(const StringVector &args)
                 mi != masterIndices.end(); mi++) {
             MasterDevice m(*mi);
             m.open(MasterDevice::Read);
+            m.loadSnapshot();
             slaves = selectedSlaves(m);
             showHeader = multiMaster || slaves.size() > 1;
 
@@ -133,6 +134,7 @@ void CommandPdos::execute(const StringVector &args)
                 mi != masterIndices.end(); mi++) {
             MasterDevice m(*mi);
             m.open(MasterDevice::Read);
+            m.loadSnapshot();
             slaves = selectedSlaves(m);
 
             for (si = slaves.begin(); si != slaves.end(); si++) {
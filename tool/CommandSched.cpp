@@ -0,0 +1,198 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+#include "CommandSched.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Class names in the order of the master's scheduling classes.
+ */
+static const char *classNames[EC_IOCTL_SCHED_CLASSES] = {
+    "fsm",
+    "coe",
+    "eoe",
+    "foe",
+    "mbg",
+    "reg",
+    "cyclic"
+};
+
+/*****************************************************************************/
+
+CommandSched::CommandSched():
+    Command("sched", "Show or tune the scheduling of non-cyclic datagrams.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandSched::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << endl
+        << binaryBaseName << " " << getName() << " weight <CLASS> <WEIGHT>"
+        << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "Datagrams of the slave state machines are scheduled per class"
+        << endl
+        << "with deficit round robin. Each cycle, the classes share the" << endl
+        << "bytes that the cyclic datagrams leave of the send interval;" << endl
+        << "a class gets WEIGHT * 256 bytes per round. A class that does"
+        << endl
+        << "not fit any more is deferred to the next cycle." << endl
+        << endl
+        << "Classes:" << endl
+        << "  fsm     Slave scan, configuration and AL state changes." << endl
+        << "  coe     SDO, SoE and dictionary requests." << endl
+        << "  eoe     Ethernet over EtherCAT." << endl
+        << "  foe     File access over EtherCAT." << endl
+        << "  mbg     Mailbox gateway requests." << endl
+        << "  reg     Register requests." << endl
+        << "  cyclic  Datagrams queued by the application (statistics"
+        << endl
+        << "          only, always sent first)." << endl
+        << endl
+        << "The initial weights can be set with the sched_weights module"
+        << endl
+        << "parameter. 'weight' changes the weight of a class at runtime."
+        << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandSched::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    ec_ioctl_sched_t data;
+
+    if (args.size()) {
+        string arg = args[0];
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+        if (arg != "weight" || args.size() != 3) {
+            stringstream err;
+            err << "'" << getName() << "' takes either no or"
+                << " 'weight <CLASS> <WEIGHT>' arguments!";
+            throwInvalidUsageException(err);
+        }
+        setWeight(args);
+        return;
+    }
+
+    masterIndices = getMasterIndices();
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(MasterDevice::Read);
+        m.getSched(&data);
+
+        if (masterIndices.size() > 1) {
+            cout << "Master" << m.getIndex() << endl;
+        }
+        showClasses(data);
+    }
+}
+
+/****************************************************************************/
+
+void CommandSched::setWeight(const StringVector &args)
+{
+    ec_ioctl_sched_weight_t data;
+    unsigned int i;
+
+    for (i = 0; i < EC_IOCTL_SCHED_CLASSES - 1; i++) {
+        if (args[1] == classNames[i]) {
+            break;
+        }
+    }
+    if (i == EC_IOCTL_SCHED_CLASSES - 1) {
+        stringstream err;
+        err << "Invalid class '" << args[1] << "'!";
+        throwInvalidUsageException(err);
+    }
+    data.sched_class = i;
+
+    stringstream strWeight;
+    strWeight << args[2];
+    strWeight >> data.weight;
+    if (strWeight.fail() || !data.weight) {
+        stringstream err;
+        err << "Invalid weight '" << args[2] << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::ReadWrite);
+    m.setSchedWeight(&data);
+}
+
+/****************************************************************************/
+
+void CommandSched::showClasses(const ec_ioctl_sched_t &data)
+{
+    cout << "Budget: " << data.budget << " bytes per cycle ("
+        << data.send_interval << " us send interval)" << endl
+        << "Class   Weight  Datagrams       Bytes  Deferred  Timeouts"
+        << "  Max wait [us]" << endl;
+
+    for (unsigned int i = 0; i < EC_IOCTL_SCHED_CLASSES; i++) {
+        const ec_ioctl_sched_class_t &c = data.classes[i];
+
+        cout << left << setw(6) << classNames[i] << right << "  "
+            << setw(6);
+        if (c.weight) {
+            cout << c.weight;
+        } else {
+            cout << "-";
+        }
+        cout << "  " << setw(9) << c.datagrams
+            << "  " << setw(10) << c.bytes
+            << "  " << setw(8) << c.deferred
+            << "  " << setw(8) << c.timeouts
+            << "  " << setw(13) << c.max_wait_us << endl;
+    }
+}
+
+/*****************************************************************************/
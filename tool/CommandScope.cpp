@@ -0,0 +1,442 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+using namespace std;
+
+#include "CommandScope.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Polling interval when no new samples are available. */
+#define SCOPE_POLL_US 1000
+
+/** Set by the signal handler to stop streaming. */
+static volatile sig_atomic_t scopeStop = 0;
+
+static void scopeSignal(int)
+{
+    scopeStop = 1;
+}
+
+/*****************************************************************************/
+
+CommandScope::CommandScope():
+    Command("scope", "Record process data entries every cycle.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandScope::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName()
+        << " [OPTIONS] <CHANNEL>... [PARAMETER...]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master samples the given channels each time the domain" << endl
+        << "of the first channel is processed by the application and" << endl
+        << "writes them into a ring buffer, which is streamed to stdout" << endl
+        << "until interrupted. The master must be activated." << endl
+        << endl
+        << "Arguments:" << endl
+        << "  CHANNEL is <domain>:<offset>[.<bit>]:<type>, where <offset>"
+        << endl
+        << "          is the byte offset of the entry in the domain's"
+        << endl
+        << "          process data (see the 'domains' command) and" << endl
+        << "          <type> is a numeric data type (see below)." << endl
+        << endl
+        << "Parameters:" << endl
+        << "  trigger=<n><op><level>  Start output when channel <n>" << endl
+        << "                          crosses <level>, '>' for a rising,"
+        << endl
+        << "                          '<' for a falling edge." << endl
+        << "  pre=<count>             Samples to output before the" << endl
+        << "                          trigger (default: 0)." << endl
+        << "  samples=<count>         Stop after <count> samples" << endl
+        << "                          (default: 0, unlimited)." << endl
+        << "  depth=<count>           Size of the ring buffer in samples"
+        << endl
+        << "                          (default: 4096)." << endl
+        << "  format=csv|binary       Output format (default: csv)." << endl
+        << "                          binary writes the raw samples:"
+        << endl
+        << "                          seq (u32), flags (u32), timestamp"
+        << endl
+        << "                          (u64), app_time (u64) and one u64"
+        << endl
+        << "                          per channel, little-endian." << endl
+        << endl
+        << "Recording stops when the command exits." << endl
+        << endl
+        << typeInfo()
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandScope::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    ec_ioctl_scope_t io;
+    ChannelVector channels;
+    StringVector::const_iterator ai;
+    string trigger;
+    unsigned int pre = 0, samples = 0;
+    bool binary = false;
+
+    memset(&io, 0, sizeof(io));
+
+    for (ai = args.begin(); ai != args.end(); ai++) {
+        string::size_type eq = ai->find('=');
+
+        if (eq == string::npos) {
+            Channel channel;
+
+            if (io.channel_count >= EC_SCOPE_MAX_CHANNELS) {
+                stringstream err;
+                err << "At most " << EC_SCOPE_MAX_CHANNELS
+                    << " channels are supported!";
+                throwInvalidUsageException(err);
+            }
+            parseChannel(*ai, &io.channels[io.channel_count], &channel);
+            channels.push_back(channel);
+            io.channel_count++;
+            continue;
+        }
+
+        string key = ai->substr(0, eq), value = ai->substr(eq + 1);
+        if (key == "trigger") {
+            trigger = value;
+        } else if (key == "pre") {
+            pre = parseNumber(key, value);
+        } else if (key == "samples") {
+            samples = parseNumber(key, value);
+        } else if (key == "depth") {
+            io.depth = parseNumber(key, value);
+        } else if (key == "format" && (value == "csv" || value == "binary")) {
+            binary = value == "binary";
+        } else {
+            stringstream err;
+            err << "Invalid parameter '" << *ai << "'!";
+            throwInvalidUsageException(err);
+        }
+    }
+
+    if (!io.channel_count) {
+        stringstream err;
+        err << "'" << getName() << "' needs at least one channel!";
+        throwInvalidUsageException(err);
+    }
+
+    if (!trigger.empty()) {
+        parseTrigger(trigger, channels, &io);
+    }
+
+    masterIndices = getMasterIndices();
+    if (masterIndices.size() != 1) {
+        stringstream err;
+        err << getName() << " needs exactly one master!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(masterIndices.front());
+    m.open(MasterDevice::ReadWrite);
+    m.configureScope(&io);
+
+    const ec_scope_ring_header_t *header;
+    try {
+        header = (const ec_scope_ring_header_t *)
+            m.mapRegion(EC_IOCTL_MMAP_SCOPE, io.map_size);
+    } catch (MasterDeviceException &e) {
+        memset(&io, 0, sizeof(io));
+        m.configureScope(&io);
+        throw;
+    }
+    const volatile uint32_t *head = &header->head;
+    const uint8_t *data = (const uint8_t *) header + header->data_offset;
+    uint32_t depth = header->depth, sampleSize = header->sample_size;
+    uint32_t pos = *head, triggerCount = header->trigger_count;
+    unsigned int written = 0;
+    bool triggered = trigger.empty();
+    vector<uint8_t> sample(sampleSize);
+
+    signal(SIGINT, scopeSignal);
+    signal(SIGTERM, scopeSignal);
+    signal(SIGPIPE, scopeSignal);
+
+    if (!binary) {
+        ChannelVector::const_iterator ci;
+
+        cout << "seq,timestamp,app_time,trigger";
+        for (ci = channels.begin(); ci != channels.end(); ci++) {
+            cout << "," << ci->spec;
+        }
+        cout << endl;
+    }
+
+    while (!scopeStop && cout.good() && (!samples || written < samples)) {
+        uint32_t h = *head;
+        __sync_synchronize();
+
+        if (!triggered) {
+            if (header->trigger_count == triggerCount) {
+                usleep(SCOPE_POLL_US);
+                continue;
+            }
+            // Start output 'pre' samples before the trigger, as far as they
+            // are still in the ring.
+            pos = header->trigger_seq - pre;
+            if (h - pos > depth - 1) {
+                pos = h - (depth - 1);
+            }
+            triggered = true;
+        }
+
+        if (pos == h) {
+            cout.flush();
+            usleep(SCOPE_POLL_US);
+            continue;
+        }
+
+        if (h - pos > depth - 1) {
+            cerr << "Scope overrun, " << h - pos - (depth - 1)
+                << " samples lost." << endl;
+            pos = h - (depth - 1);
+        }
+
+        memcpy(sample.data(), data + (pos & (depth - 1)) * sampleSize,
+                sampleSize);
+        __sync_synchronize();
+        if (*head - pos > depth - 1) {
+            continue; // overwritten while copying
+        }
+        pos++;
+
+        if (binary) {
+            cout.write((const char *) sample.data(), sampleSize);
+        } else {
+            const ec_scope_sample_t *s =
+                (const ec_scope_sample_t *) sample.data();
+            const uint64_t *values = (const uint64_t *) (s + 1);
+            unsigned int i;
+
+            cout << s->seq << "," << s->timestamp << "," << s->app_time
+                << "," << (s->flags & EC_SCOPE_FLAG_TRIGGER ? 1 : 0);
+            for (i = 0; i < channels.size(); i++) {
+                cout << ",";
+                outputValue(cout, channels[i].type, values[i]);
+            }
+            cout << "\n";
+        }
+        written++;
+    }
+    cout.flush();
+
+    m.unmapRegion((void *) header, io.map_size);
+    memset(&io, 0, sizeof(io));
+    m.configureScope(&io);
+}
+
+/****************************************************************************/
+
+void CommandScope::parseChannel(
+        const string &spec,
+        ec_ioctl_scope_channel_t *channel,
+        Channel *info
+        )
+{
+    stringstream str(spec);
+    string domainStr, offsetStr, typeStr;
+    string::size_type dot;
+
+    if (!getline(str, domainStr, ':') || !getline(str, offsetStr, ':') ||
+            !getline(str, typeStr)) {
+        stringstream err;
+        err << "Invalid channel '" << spec << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    info->spec = spec;
+    info->type = findDataType(typeStr);
+    if (!info->type || !info->type->byteSize || info->type->code == 0x0009
+            || info->type->code == 0x000a || info->type->code == 0x000b) {
+        stringstream err;
+        err << "Invalid data type '" << typeStr << "' in channel '"
+            << spec << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    channel->domain_index = parseNumber("domain", domainStr);
+    dot = offsetStr.find('.');
+    channel->offset = parseNumber("offset", offsetStr.substr(0, dot));
+    channel->bit_position = dot == string::npos ?
+        0 : parseNumber("bit position", offsetStr.substr(dot + 1));
+    channel->bit_length =
+        info->type->code == 0x0001 ? 1 : info->type->byteSize * 8;
+
+    if (channel->bit_position > 7) {
+        stringstream err;
+        err << "Invalid bit position in channel '" << spec << "'!";
+        throwInvalidUsageException(err);
+    }
+}
+
+/****************************************************************************/
+
+void CommandScope::parseTrigger(
+        const string &spec,
+        const ChannelVector &channels,
+        ec_ioctl_scope_t *io
+        )
+{
+    string::size_type op = spec.find_first_of("<>");
+    unsigned int channel;
+    stringstream str;
+
+    if (op == string::npos) {
+        stringstream err;
+        err << "Invalid trigger '" << spec << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    channel = parseNumber("trigger channel", spec.substr(0, op));
+    if (channel >= channels.size()) {
+        stringstream err;
+        err << "Invalid trigger channel " << channel << "!";
+        throwInvalidUsageException(err);
+    }
+
+    str << spec.substr(op + 1);
+    str >> io->trigger_level;
+    if (str.fail()) {
+        stringstream err;
+        err << "Invalid trigger level '" << spec.substr(op + 1) << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    switch (channels[channel].type->code) {
+        case 0x0002: case 0x0003: case 0x0004: case 0x0010: case 0x0012:
+        case 0x0013: case 0x0014: case 0x0015:
+            io->trigger_signed = 1;
+            break;
+        default:
+            io->trigger_signed = 0;
+            break;
+    }
+
+    io->trigger_enable = 1;
+    io->trigger_channel = channel;
+    io->trigger_edge = spec[op] == '>' ?
+        EC_SCOPE_EDGE_RISING : EC_SCOPE_EDGE_FALLING;
+}
+
+/****************************************************************************/
+
+unsigned int CommandScope::parseNumber(
+        const string &name,
+        const string &value
+        )
+{
+    stringstream str;
+    unsigned int number;
+
+    str << value;
+    str >> resetiosflags(ios::basefield) // guess base from prefix
+        >> number;
+
+    if (value.empty() || str.fail() || !str.eof()) {
+        stringstream err;
+        err << "Invalid " << name << " '" << value << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    return number;
+}
+
+/****************************************************************************/
+
+void CommandScope::outputValue(
+        ostream &o,
+        const DataType *type,
+        uint64_t value
+        )
+{
+    unsigned int bits = type->code == 0x0001 ? 1 : type->byteSize * 8;
+    int64_t sval = bits < 64 ?
+        (int64_t) (value << (64 - bits)) >> (64 - bits) : (int64_t) value;
+
+    switch (type->code) {
+        case 0x0002: case 0x0003: case 0x0004: case 0x0010: case 0x0012:
+        case 0x0013: case 0x0014: case 0x0015: // signed integers
+            o << sval;
+            break;
+        case 0x0008: // float
+            {
+                uint32_t raw = value;
+                float fval;
+                memcpy(&fval, &raw, sizeof(fval));
+                o << fval;
+            }
+            break;
+        case 0x0011: // double
+            {
+                double fval;
+                memcpy(&fval, &value, sizeof(fval));
+                o << fval;
+            }
+            break;
+        case 0xfffb: case 0xfffc: case 0xfffd: case 0xfffe: // sm*
+            {
+                uint64_t sign = 1ULL << (bits - 1);
+                o << (value & sign ? -(int64_t) (value & (sign - 1)) :
+                        (int64_t) value);
+            }
+            break;
+        default: // unsigned integers, bool
+            o << value;
+            break;
+    }
+}
+
+/****************************************************************************/
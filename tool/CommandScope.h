@@ -0,0 +1,66 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ ****************************************************************************/
+
+
+#ifndef __COMMANDSCOPE_H__
+#define __COMMANDSCOPE_H__
+
+#include "Command.h"
+#include "DataTypeHandler.h"
+
+/****************************************************************************/
+
+class CommandScope:
+    public Command,
+    public DataTypeHandler
+{
+    public:
+        CommandScope();
+
+        string helpString(const string &) const;
+        void execute(const StringVector &);
+
+    protected:
+        struct Channel {
+            string spec;
+            const DataType *type;
+        };
+        typedef vector<Channel> ChannelVector;
+
+        void parseChannel(const string &, ec_ioctl_scope_channel_t *,
+                Channel *);
+        void parseTrigger(const string &, const ChannelVector &,
+                ec_ioctl_scope_t *);
+        static unsigned int parseNumber(const string &, const string &);
+        static void outputValue(ostream &, const DataType *, uint64_t);
+};
+
+/****************************************************************************/
+
+#endif
@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <vector>
 using namespace std;
 
 #include "CommandSdos.h"
@@ -139,54 +140,70 @@ void CommandSdos::listSlaveSdos(
         bool showHeader
         )
 {
-    ec_ioctl_slave_sdo_t sdo;
-    ec_ioctl_slave_sdo_entry_t entry;
+    ec_ioctl_slave_sdo_dict_export_t data;
+    vector<uint8_t> buffer;
+    const uint8_t *pos;
+    const ec_ioctl_sdo_export_sdo_t *sdo;
+    const ec_ioctl_sdo_export_entry_t *entry;
     unsigned int i, j;
     const DataType *d;
 
-    if (showHeader && slave.sdo_count)
+    /* Fetch the whole dictionary in one call. The first call only reports
+     * the size; retry if the dictionary grew in between. */
+    data.slave_position = slave.position;
+    data.buffer_size = 0;
+    data.buffer = NULL;
+    m.exportSdoDict(&data);
+
+    while (data.data_size > buffer.size()) {
+        buffer.resize(data.data_size);
+        data.buffer_size = buffer.size();
+        data.buffer = &buffer.front();
+        m.exportSdoDict(&data);
+    }
+
+    if (showHeader && data.sdo_count)
         cout << "=== Master " << m.getIndex()
             << ", Slave " << slave.position << " ===" << endl;
 
-    for (i = 0; i < slave.sdo_count; i++) {
-        m.getSdo(&sdo, slave.position, i);
+    pos = data.sdo_count ? &buffer.front() : NULL;
+
+    for (i = 0; i < data.sdo_count; i++) {
+        sdo = (const ec_ioctl_sdo_export_sdo_t *) pos;
+        pos += sizeof(*sdo);
 
         cout << "SDO 0x"
             << hex << setfill('0')
-            << setw(4) << sdo.sdo_index
-            << ", \"" << sdo.name << "\"" << endl;
+            << setw(4) << sdo->sdo_index
+            << ", \"" << sdo->name << "\"" << endl;
 
-        if (getVerbosity() == Quiet)
-            continue;
+        for (j = 0; j < sdo->entry_count; j++) {
+            entry = (const ec_ioctl_sdo_export_entry_t *) pos;
+            pos += sizeof(*entry);
 
-        for (j = 0; j <= sdo.max_subindex; j++) {
-            try {
-                m.getSdoEntry(&entry, slave.position, -i, j);
-            }
-            catch (MasterDeviceException &e) {
+            if (getVerbosity() == Quiet)
                 continue;
-            }
 
             cout << "  0x" << hex << setfill('0')
-                << setw(4) << sdo.sdo_index << ":"
-                << setw(2) << (unsigned int) entry.sdo_entry_subindex
+                << setw(4) << sdo->sdo_index << ":"
+                << setw(2) << (unsigned int) entry->subindex
                 << ", "
-                << (entry.read_access[EC_SDO_ENTRY_ACCESS_PREOP] ? "r" : "-")
-                << (entry.write_access[EC_SDO_ENTRY_ACCESS_PREOP] ? "w" : "-")
-                << (entry.read_access[EC_SDO_ENTRY_ACCESS_SAFEOP] ? "r" : "-")
-                << (entry.write_access[EC_SDO_ENTRY_ACCESS_SAFEOP] ? "w" : "-")
-                << (entry.read_access[EC_SDO_ENTRY_ACCESS_OP] ? "r" : "-")
-                << (entry.write_access[EC_SDO_ENTRY_ACCESS_OP] ? "w" : "-")
+                << (entry->read_access[EC_SDO_ENTRY_ACCESS_PREOP] ? "r" : "-")
+                << (entry->write_access[EC_SDO_ENTRY_ACCESS_PREOP] ? "w" : "-")
+                << (entry->read_access[EC_SDO_ENTRY_ACCESS_SAFEOP] ? "r" : "-")
+                << (entry->write_access[EC_SDO_ENTRY_ACCESS_SAFEOP] ? "w" : "-")
+                << (entry->read_access[EC_SDO_ENTRY_ACCESS_OP] ? "r" : "-")
+                << (entry->write_access[EC_SDO_ENTRY_ACCESS_OP] ? "w" : "-")
                 << ", ";
 
-            if ((d = findDataType(entry.data_type))) {
+            if ((d = findDataType(entry->data_type))) {
                 cout << d->name;
             } else {
-                cout << "type " << setw(4) << entry.data_type;
+                cout << "type " << setw(4) << entry->data_type;
             }
 
-            cout << ", " << dec << entry.bit_length << " bit, \""
-                << entry.description << "\"" << endl;
+            cout << ", " << dec << entry->bit_length << " bit, \""
+                << entry->description << "\"" << endl;
         }
     }
 }
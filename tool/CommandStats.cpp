@@ -0,0 +1,165 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+using namespace std;
+
+#include "CommandStats.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+CommandStats::CommandStats():
+    Command("stats", "Show hot-path latency histograms.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandStats::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << " [OPTIONS]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "The master keeps log2 histograms of the following values" << endl
+        << "since it was loaded or last reset:" << endl
+        << endl
+        << "  send        Duration of ecrt_master_send() [ns]." << endl
+        << "  receive     Duration of ecrt_master_receive() including" << endl
+        << "              device polling and datagram dispatch [ns]." << endl
+        << "  round-trip  Datagram round-trip time from sending to" << endl
+        << "              the poll that received it [ns]." << endl
+        << "  hw-round-trip" << endl
+        << "              Round-trip time between the NIC's transmit" << endl
+        << "              and receive timestamps [ns]. Only recorded" << endl
+        << "              if the master was loaded with" << endl
+        << "              hw_timestamps=1 and the driver supports" << endl
+        << "              hardware timestamps." << endl
+        << "  frames      Frames sent per ecrt_master_send() call." << endl
+        << "  bytes       Bytes sent per ecrt_master_send() call." << endl
+        << endl
+        << "Bucket [a, b) counts the samples with a <= value < b." << endl
+        << endl
+        << "Command-specific options:" << endl
+        << "  --reset  -r   Reset the histograms after reading them." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandStats::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    ec_ioctl_master_histograms_t data;
+    bool doReset = getReset();
+
+    if (args.size()) {
+        stringstream err;
+        err << "'" << getName() << "' takes no arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    masterIndices = getMasterIndices();
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(doReset ? MasterDevice::ReadWrite : MasterDevice::Read);
+        m.getHistograms(&data, doReset);
+
+        if (masterIndices.size() > 1) {
+            cout << "Master" << m.getIndex() << endl;
+        }
+        showHistograms(data);
+    }
+}
+
+/****************************************************************************/
+
+void CommandStats::showHistograms(const ec_ioctl_master_histograms_t &data)
+{
+    static const char *names[EC_HIST_COUNT] = {
+        "send [ns]",
+        "receive [ns]",
+        "round-trip [ns]",
+        "hw-round-trip [ns]",
+        "frames",
+        "bytes",
+        "cyclic latency [ns]",
+        "cyclic execution [ns]"
+    };
+    const unsigned int barWidth = 40;
+
+    for (unsigned int i = 0; i < EC_HIST_COUNT; i++) {
+        uint32_t peak = 0;
+
+        cout << names[i] << ": " << data.hist[i].count << " samples";
+        if (data.hist[i].count) {
+            cout << ", avg " << data.hist[i].sum / data.hist[i].count
+                << ", max " << data.hist[i].max;
+        }
+        cout << endl;
+
+        for (unsigned int b = 0; b < EC_HIST_BUCKETS; b++) {
+            if (data.hist[i].buckets[b] > peak) {
+                peak = data.hist[i].buckets[b];
+            }
+        }
+
+        for (unsigned int b = 0; b < EC_HIST_BUCKETS; b++) {
+            uint32_t count = data.hist[i].buckets[b];
+            uint64_t low = b ? 1ULL << (b - 1) : 0;
+
+            if (!count) {
+                continue;
+            }
+
+            cout << "  [" << setw(10) << low << ", ";
+            if (b < EC_HIST_BUCKETS - 1) {
+                cout << setw(10) << (1ULL << b) << ")";
+            }
+            else {
+                cout << setw(10) << "inf" << ")";
+            }
+            cout << " " << setw(10) << count << " "
+                << string((uint64_t) count * barWidth / peak, '#') << endl;
+        }
+    }
+}
+
+/*****************************************************************************/
@@ -0,0 +1,242 @@
+/*****************************************************************************
+ *
+ *  $Id$
+ *
+ *  Copyright (C) 2006-2009  Florian Pose, Ingenieurgemeinschaft IgH
+ *
+ *  This file is part of the IgH EtherCAT Master.
+ *
+ *  The IgH EtherCAT Master is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License version 2, as
+ *  published by the Free Software Foundation.
+ *
+ *  The IgH EtherCAT Master is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ *  Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with the IgH EtherCAT Master; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ *  ---
+ *
+ *  The license mentioned above concerns the source code only. Using the
+ *  EtherCAT technology and brand is only permitted in compliance with the
+ *  industrial property and similar rights of Beckhoff Automation GmbH.
+ *
+ *  vim: expandtab
+ *
+ ****************************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <sched.h>
+using namespace std;
+
+#include "CommandThreads.h"
+#include "MasterDevice.h"
+
+/*****************************************************************************/
+
+/** Thread names in the order of the master's thread types.
+ */
+static const char *threadNames[EC_IOCTL_THREADS] = {
+    "master",
+    "eoe",
+    "cyclic"
+};
+
+/** Scheduling policy names.
+ */
+static const struct {
+    const char *name;
+    int policy;
+} policies[] = {
+    {"normal", SCHED_OTHER},
+    {"fifo", SCHED_FIFO},
+    {"rr", SCHED_RR},
+    {}
+};
+
+/*****************************************************************************/
+
+CommandThreads::CommandThreads():
+    Command("threads", "Show or set CPU affinity and priority of the"
+            " master threads.")
+{
+}
+
+/*****************************************************************************/
+
+string CommandThreads::helpString(const string &binaryBaseName) const
+{
+    stringstream str;
+
+    str << binaryBaseName << " " << getName() << endl
+        << binaryBaseName << " " << getName()
+        << " set <THREAD> <CPUS> [<POLICY> [<PRIORITY>]]" << endl
+        << endl
+        << getBriefDescription() << endl
+        << endl
+        << "Threads:" << endl
+        << "  master  Idle and operation thread (the state machines)."
+        << endl
+        << "  eoe     Ethernet over EtherCAT thread." << endl
+        << "  cyclic  Cyclic engine thread (see ecrt_master_cyclic_start())."
+        << endl
+        << endl
+        << "CPUS is a CPU list like 2 or 2-3,6. POLICY is one of normal"
+        << endl
+        << "(default), fifo or rr. PRIORITY is the real-time priority" << endl
+        << "(1-99) for fifo and rr and the nice value (-20-19) for normal."
+        << endl
+        << endl
+        << "The new settings are applied to a running thread immediately"
+        << endl
+        << "and kept for the next start. The initial settings can be given"
+        << endl
+        << "per master with the thread_cpus, thread_policy, thread_priority"
+        << endl
+        << "and eoe_thread_* module parameters. The cyclic engine thread"
+        << endl
+        << "gets its settings from the application when it is started."
+        << endl
+        << "It can only be changed while it is running, and the change"
+        << endl
+        << "lasts for the current run only." << endl
+        << endl;
+
+    return str.str();
+}
+
+/****************************************************************************/
+
+void CommandThreads::execute(const StringVector &args)
+{
+    MasterIndexList masterIndices;
+    ec_ioctl_thread_t data;
+    unsigned int i, j;
+
+    if (args.size()) {
+        string arg = args[0];
+        transform(arg.begin(), arg.end(),
+                arg.begin(), (int (*) (int)) std::tolower);
+        if (arg != "set" || args.size() < 3 || args.size() > 5) {
+            stringstream err;
+            err << "'" << getName() << "' takes either no or"
+                << " 'set <THREAD> <CPUS> [<POLICY> [<PRIORITY>]]'"
+                << " arguments!";
+            throwInvalidUsageException(err);
+        }
+        setThread(args);
+        return;
+    }
+
+    masterIndices = getMasterIndices();
+    MasterIndexList::const_iterator mi;
+    for (mi = masterIndices.begin();
+            mi != masterIndices.end(); mi++) {
+        MasterDevice m(*mi);
+        m.open(MasterDevice::Read);
+
+        if (masterIndices.size() > 1) {
+            cout << "Master" << m.getIndex() << endl;
+        }
+        cout << "Thread       PID  CPU  Policy  Priority  Allowed CPUs"
+            << endl;
+
+        for (i = 0; i < EC_IOCTL_THREADS; i++) {
+            data.thread = i;
+            m.getThread(&data);
+
+            cout << left << setw(6) << threadNames[i] << right << "  "
+                << setw(8);
+            if (data.pid) {
+                cout << data.pid << "  " << setw(3) << data.cpu;
+            } else {
+                cout << "-" << "  " << setw(3) << "-";
+            }
+            cout << "  " << left << setw(6);
+            for (j = 0; policies[j].name; j++) {
+                if (policies[j].policy == data.policy) {
+                    break;
+                }
+            }
+            if (policies[j].name) {
+                cout << policies[j].name;
+            } else {
+                cout << data.policy;
+            }
+            cout << right << "  " << setw(8) << data.priority
+                << "  " << data.cpus << endl;
+        }
+    }
+}
+
+/****************************************************************************/
+
+void CommandThreads::setThread(const StringVector &args)
+{
+    ec_ioctl_thread_t data;
+    unsigned int i;
+
+    for (i = 0; i < EC_IOCTL_THREADS; i++) {
+        if (args[1] == threadNames[i]) {
+            break;
+        }
+    }
+    if (i == EC_IOCTL_THREADS) {
+        stringstream err;
+        err << "Invalid thread '" << args[1] << "'!";
+        throwInvalidUsageException(err);
+    }
+    data.thread = i;
+
+    if (args[2].size() >= sizeof(data.cpus)) {
+        stringstream err;
+        err << "CPU list '" << args[2] << "' too long!";
+        throwInvalidUsageException(err);
+    }
+    args[2].copy(data.cpus, sizeof(data.cpus) - 1);
+    data.cpus[args[2].size()] = 0;
+
+    data.policy = SCHED_OTHER;
+    if (args.size() > 3) {
+        for (i = 0; policies[i].name; i++) {
+            if (args[3] == policies[i].name) {
+                break;
+            }
+        }
+        if (!policies[i].name) {
+            stringstream err;
+            err << "Invalid policy '" << args[3] << "'!";
+            throwInvalidUsageException(err);
+        }
+        data.policy = policies[i].policy;
+    }
+
+    data.priority = 0;
+    if (args.size() > 4) {
+        stringstream strPrio;
+        strPrio << args[4];
+        strPrio >> data.priority;
+        if (strPrio.fail()) {
+            stringstream err;
+            err << "Invalid priority '" << args[4] << "'!";
+            throwInvalidUsageException(err);
+        }
+    } else if (data.policy != SCHED_OTHER) {
+        stringstream err;
+        err << "Policy '" << args[3] << "' needs a priority!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::ReadWrite);
+    m.setThread(&data);
+}
+
+/*****************************************************************************/
@@ -27,6 +27,8 @@
  *
  ****************************************************************************/
 
+#include <string.h>
+
 #include <iostream>
 #include <iomanip>
 using namespace std;
@@ -50,11 +52,22 @@ string CommandUpload::helpString(const string &binaryBaseName) const
     str << binaryBaseName << " " << getName()
         << " [OPTIONS] <INDEX> <SUBINDEX>" << endl
         << " [OPTIONS] <INDEX>" << endl
+        << binaryBaseName << " " << getName()
+        << " --batch [OPTIONS] <INDEX> <SUBINDEX> [<INDEX> <SUBINDEX> ...]"
+        << endl
         << endl
         << getBriefDescription() << endl
         << endl
         << "This command requires a single slave to be selected." << endl
         << endl
+        << "With --batch, each of the given SDO entries is read from" << endl
+        << "every selected slave (all slaves by default). The master" << endl
+        << "reads from different slaves in parallel. One line is" << endl
+        << "output per slave and entry:" << endl
+        << "  <POSITION> <INDEX>:<SUBINDEX> <VALUE>" << endl
+        << "If the data type is unknown, the value is output as raw" << endl
+        << "data." << endl
+        << endl
         << "The data type of the SDO entry is taken from the SDO" << endl
         << "dictionary by default. It can be overridden with the" << endl
         << "--type option. If the slave does not support the SDO" << endl
@@ -77,6 +90,8 @@ string CommandUpload::helpString(const string &binaryBaseName) const
         << "  --position -p <pos>    Slave selection. See the help of" << endl
         << "                         the 'slaves' command." << endl
         << "  --type     -t <type>   SDO entry data type (see above)." << endl
+        << "  --batch    -b          Read several entries from several" << endl
+        << "                         slaves at once." << endl
         << endl
         << numericInfo();
 
@@ -93,6 +108,11 @@ void CommandUpload::execute(const StringVector &args)
     const DataType *dataType = NULL;
     unsigned int uval;
 
+    if (getBatch()) {
+        executeBatch(args);
+        return;
+    }
+
     if (args.size() != 1 && args.size() != 2) {
         err << "'" << getName() << "' takes 1 or 2 arguments!";
         throwInvalidUsageException(err);
@@ -193,3 +213,162 @@ void CommandUpload::execute(const StringVector &args)
 }
 
 /*****************************************************************************/
+
+void CommandUpload::executeBatch(const StringVector &args)
+{
+    typedef pair<uint16_t, uint8_t> Entry;
+    vector<Entry> entries;
+    vector<Entry>::const_iterator ei;
+    SlaveList slaves;
+    SlaveList::const_iterator si;
+    vector<ec_sdo_batch_item_t> items;
+    vector<const DataType *> types;
+    vector<size_t> offsets;
+    vector<uint8_t> buffer;
+    const DataType *dataType = NULL;
+    ec_ioctl_sdo_batch_t data;
+    size_t offset, size, i, done, chunk;
+    unsigned int failed = 0, uval;
+    stringstream err;
+
+    if (args.empty() || args.size() % 2) {
+        err << "'" << getName() << " --batch' takes pairs of"
+            << " <INDEX> <SUBINDEX> arguments!";
+        throwInvalidUsageException(err);
+    }
+
+    for (i = 0; i < args.size(); i += 2) {
+        stringstream strIndex, strSubIndex;
+        Entry entry;
+
+        strIndex << args[i];
+        strIndex
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> entry.first;
+        if (strIndex.fail()) {
+            err << "Invalid SDO index '" << args[i] << "'!";
+            throwInvalidUsageException(err);
+        }
+
+        strSubIndex << args[i + 1];
+        strSubIndex
+            >> resetiosflags(ios::basefield) // guess base from prefix
+            >> uval;
+        if (strSubIndex.fail() || uval > 0xff) {
+            err << "Invalid SDO subindex '" << args[i + 1] << "'!";
+            throwInvalidUsageException(err);
+        }
+        entry.second = uval;
+
+        entries.push_back(entry);
+    }
+
+    if (!getDataType().empty()
+            && !(dataType = findDataType(getDataType()))) {
+        err << "Invalid data type '" << getDataType() << "'!";
+        throwInvalidUsageException(err);
+    }
+
+    MasterDevice m(getSingleMasterIndex());
+    m.open(MasterDevice::Read);
+    slaves = selectedSlaves(m);
+
+    // one operation per slave and entry, each with its own buffer area
+    offset = 0;
+    for (si = slaves.begin(); si != slaves.end(); si++) {
+        for (ei = entries.begin(); ei != entries.end(); ei++) {
+            ec_sdo_batch_item_t item;
+            const DataType *type = dataType;
+
+            if (!type) { // no data type specified: fetch from dictionary
+                ec_ioctl_slave_sdo_entry_t entry;
+
+                try {
+                    m.getSdoEntry(&entry, si->position,
+                            ei->first, ei->second);
+                    type = findDataType(entry.data_type);
+                } catch (MasterDeviceException &e) {
+                    // output raw data
+                }
+            }
+
+            memset(&item, 0, sizeof(item));
+            item.slave_position = si->position;
+            item.index = ei->first;
+            item.subindex = ei->second;
+            item.dir = EC_DIR_INPUT;
+            item.data_size = type && type->byteSize ?
+                type->byteSize : (size_t) BatchBufferSize;
+            offsets.push_back(offset);
+            offset += item.data_size;
+
+            items.push_back(item);
+            types.push_back(type);
+        }
+    }
+
+    if (items.empty()) {
+        return;
+    }
+
+    buffer.resize(offset);
+    for (i = 0; i < items.size(); i++) {
+        items[i].data = &buffer[offsets[i]];
+    }
+
+    // the master limits the number of operations per call
+    for (done = 0; done < items.size(); done += chunk) {
+        chunk = items.size() - done;
+        if (chunk > EC_SDO_BATCH_MAX_ITEMS) {
+            chunk = EC_SDO_BATCH_MAX_ITEMS;
+        }
+        size = 0;
+        for (i = done; i < done + chunk; i++) {
+            if (size + items[i].data_size > EC_SDO_BATCH_MAX_DATA) {
+                break;
+            }
+            size += items[i].data_size;
+        }
+        chunk = i - done;
+
+        data.items = &items[done];
+        data.count = chunk;
+        m.sdoBatch(&data);
+    }
+
+    m.close();
+
+    for (i = 0; i < items.size(); i++) {
+        const ec_sdo_batch_item_t &item = items[i];
+
+        cout << item.slave_position << " 0x" << hex << setfill('0')
+            << setw(4) << item.index << ":" << setw(2)
+            << (unsigned int) item.subindex << dec << " ";
+
+        if (item.error) {
+            failed++;
+            if (item.abort_code) {
+                cout << "SDO transfer aborted with code 0x"
+                    << setfill('0') << hex << setw(8) << item.abort_code
+                    << dec << ": " << abortText(item.abort_code) << endl;
+            } else {
+                cout << "Failed: " << strerror(-item.error) << endl;
+            }
+            continue;
+        }
+
+        try {
+            outputData(cout, types[i], item.data, item.result_size);
+        } catch (SizeException &e) {
+            failed++;
+            cout << e.what() << endl;
+        }
+    }
+
+    if (failed) {
+        err << failed << " of " << items.size() << " uploads failed.";
+        throwCommandException(err);
+    }
+}
+
+/*****************************************************************************/
@@ -45,6 +45,9 @@ class CommandUpload:
 
     protected:
         enum {DefaultBufferSize = 64 * 1024};
+        enum {BatchBufferSize = 1024};
+
+        void executeBatch(const StringVector &);
 };
 
 /****************************************************************************/
@@ -31,6 +31,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -42,10 +43,39 @@ using namespace std;
 
 /****************************************************************************/
 
+/** Returns a snapshot record.
+ *
+ * \return NULL, if there is no snapshot or no such record.
+ */
+template <class T>
+const T *MasterDevice::snapshotRecord(
+        unsigned int section, /**< Section. */
+        int index /**< Record index. */
+        ) const
+{
+    if (snapshot.empty() || index < 0) {
+        return NULL;
+    }
+
+    const ec_snapshot_header_t *header =
+        (const ec_snapshot_header_t *) &snapshot[0];
+
+    if ((unsigned int) index >= header->sections[section].count
+            || header->sections[section].record_size != sizeof(T)) {
+        return NULL;
+    }
+
+    return (const T *) &snapshot[header->sections[section].offset
+        + index * sizeof(T)];
+}
+
+/****************************************************************************/
+
 MasterDevice::MasterDevice(unsigned int index):
     index(index),
     masterCount(0U),
-    fd(-1)
+    fd(-1),
+    snapshotGeneration(0U)
 {
 }
 
@@ -61,6 +91,7 @@ MasterDevice::~MasterDevice()
 void MasterDevice::setIndex(unsigned int i)
 {
     index = i;
+    dropSnapshot();
 }
 
 /****************************************************************************/
@@ -101,6 +132,8 @@ void MasterDevice::close()
         ::close(fd);
         fd = -1;
     }
+
+    dropSnapshot();
 }
 
 /****************************************************************************/
@@ -129,6 +162,12 @@ void MasterDevice::getMaster(ec_ioctl_master_t *data)
 
 void MasterDevice::getConfig(ec_ioctl_config_t *data, unsigned int index)
 {
+    if (const ec_ioctl_config_t *rec =
+            snapshotRecord<ec_ioctl_config_t>(EC_SNAPSHOT_CONFIGS, index)) {
+        *data = *rec;
+        return;
+    }
+
     data->config_index = index;
 
     if (ioctl(fd, EC_IOCTL_CONFIG, data) < 0) {
@@ -147,6 +186,17 @@ void MasterDevice::getConfigPdo(
         uint16_t pdo_pos
         )
 {
+    if (sync_index < EC_MAX_SYNC_MANAGERS) {
+        const ec_ioctl_config_pdo_t *rec =
+            snapshotRecord<ec_ioctl_config_pdo_t>(EC_SNAPSHOT_CONFIG_PDOS,
+                    snapshotChild(EC_SNAPSHOT_CONFIG_PDOS,
+                        index * EC_MAX_SYNC_MANAGERS + sync_index, pdo_pos));
+        if (rec) {
+            *data = *rec;
+            return;
+        }
+    }
+
     data->config_index = index;
     data->sync_index = sync_index;
     data->pdo_pos = pdo_pos;
@@ -168,6 +218,19 @@ void MasterDevice::getConfigPdoEntry(
         uint8_t entry_pos
         )
 {
+    if (sync_index < EC_MAX_SYNC_MANAGERS) {
+        int pdo = snapshotChild(EC_SNAPSHOT_CONFIG_PDOS,
+                index * EC_MAX_SYNC_MANAGERS + sync_index, pdo_pos);
+        const ec_ioctl_config_pdo_entry_t *rec =
+            snapshotRecord<ec_ioctl_config_pdo_entry_t>(
+                    EC_SNAPSHOT_CONFIG_ENTRIES,
+                    snapshotChild(EC_SNAPSHOT_CONFIG_ENTRIES, pdo, entry_pos));
+        if (rec) {
+            *data = *rec;
+            return;
+        }
+    }
+
     data->config_index = index;
     data->sync_index = sync_index;
     data->pdo_pos = pdo_pos;
@@ -220,6 +283,12 @@ void MasterDevice::getConfigIdn(
 
 void MasterDevice::getDomain(ec_ioctl_domain_t *data, unsigned int index)
 {
+    if (const ec_ioctl_domain_t *rec =
+            snapshotRecord<ec_ioctl_domain_t>(EC_SNAPSHOT_DOMAINS, index)) {
+        *data = *rec;
+        return;
+    }
+
     data->index = index;
 
     if (ioctl(fd, EC_IOCTL_DOMAIN, data)) {
@@ -267,8 +336,110 @@ void MasterDevice::getPcap(ec_ioctl_pcap_data_t *data,
 
 /****************************************************************************/
 
+void MasterDevice::getHistograms(ec_ioctl_master_histograms_t *data,
+        bool reset)
+{
+    data->reset = reset;
+
+    if (ioctl(fd, EC_IOCTL_MASTER_HISTOGRAMS, data) < 0) {
+        stringstream err;
+        err << "Failed to get histograms: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getDictCache(ec_ioctl_dict_cache_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_DICT_CACHE_GET, data) < 0) {
+        stringstream err;
+        err << "Failed to get dictionary cache entry: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::addDictCache(ec_ioctl_dict_cache_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_DICT_CACHE_ADD, data) < 0) {
+        stringstream err;
+        err << "Failed to add dictionary cache entry: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::clearDictCache()
+{
+    if (ioctl(fd, EC_IOCTL_DICT_CACHE_CLEAR) < 0) {
+        stringstream err;
+        err << "Failed to clear dictionary cache: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::pcapFilter(ec_ioctl_pcap_filter_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_PCAP_FILTER, data) < 0) {
+        stringstream err;
+        err << "Failed to access pcap filter: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::configureScope(ec_ioctl_scope_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_SCOPE, data) < 0) {
+        stringstream err;
+        err << "Failed to configure scope: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+/** Maps a region of the master device read-only.
+ *
+ * \return Address of the mapping.
+ */
+void *MasterDevice::mapRegion(unsigned int region, size_t size)
+{
+    void *mem = mmap(0, size, PROT_READ, MAP_SHARED, fd,
+            EC_IOCTL_MMAP_OFFSET(region));
+
+    if (mem == MAP_FAILED) {
+        stringstream err;
+        err << "Failed to map region " << region << ": " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+
+    return mem;
+}
+
+/****************************************************************************/
+
+void MasterDevice::unmapRegion(void *mem, size_t size)
+{
+    munmap(mem, size);
+}
+
+/****************************************************************************/
+
 void MasterDevice::getSlave(ec_ioctl_slave_t *slave, uint16_t slaveIndex)
 {
+    if (const ec_ioctl_slave_t *rec =
+            snapshotRecord<ec_ioctl_slave_t>(EC_SNAPSHOT_SLAVES, slaveIndex)) {
+        *slave = *rec;
+        return;
+    }
+
     slave->position = slaveIndex;
 
     if (ioctl(fd, EC_IOCTL_SLAVE, slave)) {
@@ -290,6 +461,13 @@ void MasterDevice::getFmmu(
         unsigned int fmmuIndex
         )
 {
+    if (const ec_ioctl_domain_fmmu_t *rec =
+            snapshotRecord<ec_ioctl_domain_fmmu_t>(EC_SNAPSHOT_FMMUS,
+                snapshotChild(EC_SNAPSHOT_FMMUS, domainIndex, fmmuIndex))) {
+        *fmmu = *rec;
+        return;
+    }
+
     fmmu->domain_index = domainIndex;
     fmmu->fmmu_index = fmmuIndex;
 
@@ -308,6 +486,13 @@ void MasterDevice::getSync(
         uint8_t syncIndex
         )
 {
+    if (const ec_ioctl_slave_sync_t *rec =
+            snapshotRecord<ec_ioctl_slave_sync_t>(EC_SNAPSHOT_SYNCS,
+                snapshotChild(EC_SNAPSHOT_SYNCS, slaveIndex, syncIndex))) {
+        *sync = *rec;
+        return;
+    }
+
     sync->slave_position = slaveIndex;
     sync->sync_index = syncIndex;
 
@@ -327,6 +512,14 @@ void MasterDevice::getPdo(
         uint8_t pdoPos
         )
 {
+    int sync = snapshotChild(EC_SNAPSHOT_SYNCS, slaveIndex, syncIndex);
+    if (const ec_ioctl_slave_sync_pdo_t *rec =
+            snapshotRecord<ec_ioctl_slave_sync_pdo_t>(EC_SNAPSHOT_PDOS,
+                snapshotChild(EC_SNAPSHOT_PDOS, sync, pdoPos))) {
+        *pdo = *rec;
+        return;
+    }
+
     pdo->slave_position = slaveIndex;
     pdo->sync_index = syncIndex;
     pdo->pdo_pos = pdoPos;
@@ -348,6 +541,16 @@ void MasterDevice::getPdoEntry(
         uint8_t entryPos
         )
 {
+    int sync = snapshotChild(EC_SNAPSHOT_SYNCS, slaveIndex, syncIndex);
+    int pdo = snapshotChild(EC_SNAPSHOT_PDOS, sync, pdoPos);
+    if (const ec_ioctl_slave_sync_pdo_entry_t *rec =
+            snapshotRecord<ec_ioctl_slave_sync_pdo_entry_t>(
+                EC_SNAPSHOT_ENTRIES,
+                snapshotChild(EC_SNAPSHOT_ENTRIES, pdo, entryPos))) {
+        *entry = *rec;
+        return;
+    }
+
     entry->slave_position = slaveIndex;
     entry->sync_index = syncIndex;
     entry->pdo_pos = pdoPos;
@@ -400,6 +603,17 @@ void MasterDevice::getSdoEntry(
 
 /****************************************************************************/
 
+void MasterDevice::exportSdoDict(ec_ioctl_slave_sdo_dict_export_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_SLAVE_SDO_DICT_EXPORT, data)) {
+        stringstream err;
+        err << "Failed to export SDO dictionary: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::readSii(
         ec_ioctl_slave_sii_t *data
         )
@@ -502,6 +716,94 @@ void MasterDevice::setDebug(unsigned int debugLevel)
 
 /****************************************************************************/
 
+void MasterDevice::getCrcMonitor(ec_ioctl_crc_monitor_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_CRC_MONITOR, data) < 0) {
+        stringstream err;
+        err << "Failed to read error counters: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::setCrcMonitorInterval(unsigned int intervalMs)
+{
+    if (ioctl(fd, EC_IOCTL_CRC_MONITOR_INTERVAL, intervalMs) < 0) {
+        stringstream err;
+        err << "Failed to set error counter interval: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getSched(ec_ioctl_sched_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_SCHED, data) < 0) {
+        stringstream err;
+        err << "Failed to get scheduler statistics: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getRedundancyState(ec_master_redundancy_state_t *state)
+{
+    if (ioctl(fd, EC_IOCTL_MASTER_REDUNDANCY_STATE, state) < 0) {
+        stringstream err;
+        err << "Failed to get redundancy state: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getThread(ec_ioctl_thread_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_THREAD, data) < 0) {
+        stringstream err;
+        err << "Failed to get thread parameters: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::getCyclicState(ec_cyclic_state_t *state)
+{
+    if (ioctl(fd, EC_IOCTL_CYCLIC_STATE, state) < 0) {
+        stringstream err;
+        err << "Failed to get cyclic engine state: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::setThread(ec_ioctl_thread_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_THREAD_SET, data) < 0) {
+        stringstream err;
+        err << "Failed to set thread parameters: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
+void MasterDevice::setSchedWeight(ec_ioctl_sched_weight_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_SCHED_WEIGHT, data) < 0) {
+        stringstream err;
+        err << "Failed to set scheduling weight: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::rescan()
 {
     if (ioctl(fd, EC_IOCTL_MASTER_RESCAN, 0) < 0) {
@@ -543,6 +845,17 @@ void MasterDevice::sdoUpload(ec_ioctl_slave_sdo_upload_t *data)
 
 /****************************************************************************/
 
+void MasterDevice::sdoBatch(ec_ioctl_sdo_batch_t *data)
+{
+    if (ioctl(fd, EC_IOCTL_SDO_BATCH, data) < 0) {
+        stringstream err;
+        err << "Failed to execute SDO batch: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+}
+
+/****************************************************************************/
+
 void MasterDevice::dictUpload(ec_ioctl_slave_dict_upload_t *data)
 {
     if (ioctl(fd, EC_IOCTL_SLAVE_DICT_UPLOAD, data) < 0) {
@@ -554,6 +867,195 @@ void MasterDevice::dictUpload(ec_ioctl_slave_dict_upload_t *data)
 
 /****************************************************************************/
 
+/** Fetches a bulk snapshot of slaves, configurations and domains.
+ *
+ * While a snapshot is loaded, getSlave(), getSync(), getPdo(),
+ * getPdoEntry(), getConfig(), getConfigPdo(), getConfigPdoEntry(),
+ * getDomain() and getFmmu() are served from it instead of issuing one ioctl
+ * per object.
+ *
+ * \return False, if the snapshot has not changed since the last call.
+ */
+bool MasterDevice::loadSnapshot()
+{
+    ec_ioctl_snapshot_t data;
+    vector<uint8_t> buffer(snapshot.size());
+
+    data.generation = snapshotGeneration;
+
+    while (1) {
+        data.buffer_size = buffer.size();
+        data.buffer = buffer.empty() ? NULL : &buffer[0];
+
+        if (ioctl(fd, EC_IOCTL_SNAPSHOT, &data) < 0) {
+            stringstream err;
+            err << "Failed to get snapshot: " << strerror(errno);
+            throw MasterDeviceException(err);
+        }
+
+        if (data.copied) {
+            break;
+        }
+
+        if (data.current_generation == data.generation) {
+            return false;
+        }
+
+        // too small, or the snapshot grew in the meantime
+        buffer.resize(data.data_size);
+    }
+
+    const ec_snapshot_header_t *header =
+        (const ec_snapshot_header_t *) &buffer[0];
+
+    if (header->magic != EC_SNAPSHOT_MAGIC
+            || header->version != EC_SNAPSHOT_VERSION
+            || header->section_count != EC_SNAPSHOT_SECTION_COUNT) {
+        throw MasterDeviceException("Invalid snapshot header.");
+    }
+
+    buffer.resize(data.data_size);
+    snapshot.swap(buffer);
+    snapshotGeneration = header->generation;
+    indexSnapshot();
+    return true;
+}
+
+/****************************************************************************/
+
+/** Discards a loaded snapshot, so that the getters use ioctls again.
+ */
+void MasterDevice::dropSnapshot()
+{
+    unsigned int i;
+
+    snapshot.clear();
+    snapshotGeneration = 0;
+
+    for (i = 0; i < EC_SNAPSHOT_SECTION_COUNT; i++) {
+        snapshotFirst[i].clear();
+    }
+}
+
+/****************************************************************************/
+
+/** Builds the per-parent record offsets of a freshly loaded snapshot.
+ *
+ * The records of each child section are stored in parent order, so the
+ * first child of every parent is the sum of the child counts before it.
+ */
+void MasterDevice::indexSnapshot()
+{
+    const ec_snapshot_header_t *header =
+        (const ec_snapshot_header_t *) &snapshot[0];
+    unsigned int i, j, first;
+
+    for (i = 0; i < EC_SNAPSHOT_SECTION_COUNT; i++) {
+        snapshotFirst[i].clear();
+    }
+
+    first = 0;
+    for (i = 0; i < header->sections[EC_SNAPSHOT_SLAVES].count; i++) {
+        snapshotFirst[EC_SNAPSHOT_SYNCS].push_back(first);
+        first += snapshotRecord<ec_ioctl_slave_t>(
+                EC_SNAPSHOT_SLAVES, i)->sync_count;
+    }
+    snapshotFirst[EC_SNAPSHOT_SYNCS].push_back(first);
+
+    first = 0;
+    for (i = 0; i < header->sections[EC_SNAPSHOT_SYNCS].count; i++) {
+        snapshotFirst[EC_SNAPSHOT_PDOS].push_back(first);
+        first += snapshotRecord<ec_ioctl_slave_sync_t>(
+                EC_SNAPSHOT_SYNCS, i)->pdo_count;
+    }
+    snapshotFirst[EC_SNAPSHOT_PDOS].push_back(first);
+
+    first = 0;
+    for (i = 0; i < header->sections[EC_SNAPSHOT_PDOS].count; i++) {
+        snapshotFirst[EC_SNAPSHOT_ENTRIES].push_back(first);
+        first += snapshotRecord<ec_ioctl_slave_sync_pdo_t>(
+                EC_SNAPSHOT_PDOS, i)->entry_count;
+    }
+    snapshotFirst[EC_SNAPSHOT_ENTRIES].push_back(first);
+
+    first = 0;
+    for (i = 0; i < header->sections[EC_SNAPSHOT_CONFIGS].count; i++) {
+        const ec_ioctl_config_t *config =
+            snapshotRecord<ec_ioctl_config_t>(EC_SNAPSHOT_CONFIGS, i);
+        for (j = 0; j < EC_MAX_SYNC_MANAGERS; j++) {
+            snapshotFirst[EC_SNAPSHOT_CONFIG_PDOS].push_back(first);
+            first += config->syncs[j].pdo_count;
+        }
+    }
+    snapshotFirst[EC_SNAPSHOT_CONFIG_PDOS].push_back(first);
+
+    first = 0;
+    for (i = 0; i < header->sections[EC_SNAPSHOT_CONFIG_PDOS].count; i++) {
+        snapshotFirst[EC_SNAPSHOT_CONFIG_ENTRIES].push_back(first);
+        first += snapshotRecord<ec_ioctl_config_pdo_t>(
+                EC_SNAPSHOT_CONFIG_PDOS, i)->entry_count;
+    }
+    snapshotFirst[EC_SNAPSHOT_CONFIG_ENTRIES].push_back(first);
+
+    first = 0;
+    for (i = 0; i < header->sections[EC_SNAPSHOT_DOMAINS].count; i++) {
+        snapshotFirst[EC_SNAPSHOT_FMMUS].push_back(first);
+        first += snapshotRecord<ec_ioctl_domain_t>(
+                EC_SNAPSHOT_DOMAINS, i)->fmmu_count;
+    }
+    snapshotFirst[EC_SNAPSHOT_FMMUS].push_back(first);
+}
+
+/****************************************************************************/
+
+/** Returns the snapshot index of the \a pos-th child of a parent record.
+ *
+ * \return -1, if there is no snapshot or no such child.
+ */
+int MasterDevice::snapshotChild(
+        unsigned int section, /**< Child section. */
+        unsigned int parent, /**< Index of the parent record. */
+        unsigned int pos /**< Position of the child. */
+        ) const
+{
+    const vector<unsigned int> &first = snapshotFirst[section];
+
+    if (parent + 1 >= first.size()
+            || pos >= first[parent + 1] - first[parent]) {
+        return -1;
+    }
+
+    return first[parent] + pos;
+}
+
+/****************************************************************************/
+
+/** Blocks until at least one event is available.
+ *
+ * \return Number of events read.
+ */
+unsigned int MasterDevice::readEvents(
+        ec_event_t *events,
+        unsigned int count
+        )
+{
+    ssize_t ret;
+
+    do {
+        ret = ::read(fd, events, count * sizeof(ec_event_t));
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        stringstream err;
+        err << "Failed to read events: " << strerror(errno);
+        throw MasterDeviceException(err);
+    }
+
+    return ret / sizeof(ec_event_t);
+}
+
+/****************************************************************************/
+
 void MasterDevice::requestState(
         uint16_t slavePosition,
         uint8_t state
@@ -32,6 +32,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 using namespace std;
 
 #include "ecrt.h"
@@ -140,6 +141,14 @@ class MasterDevice
                 unsigned char *);
         void getPcap(ec_ioctl_pcap_data_t *, unsigned char, unsigned int,
                 unsigned char *);
+        void getHistograms(ec_ioctl_master_histograms_t *, bool);
+        void pcapFilter(ec_ioctl_pcap_filter_t *);
+        void configureScope(ec_ioctl_scope_t *);
+        void getDictCache(ec_ioctl_dict_cache_t *);
+        void addDictCache(ec_ioctl_dict_cache_t *);
+        void clearDictCache();
+        void *mapRegion(unsigned int, size_t);
+        void unmapRegion(void *, size_t);
         void getSlave(ec_ioctl_slave_t *, uint16_t);
         void getSync(ec_ioctl_slave_sync_t *, uint16_t, uint8_t);
         void getPdo(ec_ioctl_slave_sync_pdo_t *, uint16_t, uint8_t, uint8_t);
@@ -147,15 +156,25 @@ class MasterDevice
                 uint8_t, uint8_t);
         void getSdo(ec_ioctl_slave_sdo_t *, uint16_t, uint16_t);
         void getSdoEntry(ec_ioctl_slave_sdo_entry_t *, uint16_t, int, uint8_t);
+        void exportSdoDict(ec_ioctl_slave_sdo_dict_export_t *);
         void readSii(ec_ioctl_slave_sii_t *);
         void writeSii(ec_ioctl_slave_sii_t *);
         void readReg(ec_ioctl_slave_reg_t *);
         void writeReg(ec_ioctl_slave_reg_t *);
         void readWriteReg(ec_ioctl_slave_reg_t *);
         void setDebug(unsigned int);
+        void getCrcMonitor(ec_ioctl_crc_monitor_t *);
+        void setCrcMonitorInterval(unsigned int);
+        void getSched(ec_ioctl_sched_t *);
+        void getRedundancyState(ec_master_redundancy_state_t *);
+        void getThread(ec_ioctl_thread_t *);
+        void getCyclicState(ec_cyclic_state_t *);
+        void setThread(ec_ioctl_thread_t *);
+        void setSchedWeight(ec_ioctl_sched_weight_t *);
         void rescan();
         void sdoDownload(ec_ioctl_slave_sdo_download_t *);
         void sdoUpload(ec_ioctl_slave_sdo_upload_t *);
+        void sdoBatch(ec_ioctl_sdo_batch_t *);
         void requestState(uint16_t, uint8_t);
         void requestReboot(uint16_t);
         void requestRebootAll();
@@ -170,6 +189,10 @@ class MasterDevice
         void readSoe(ec_ioctl_slave_soe_read_t *);
         void writeSoe(ec_ioctl_slave_soe_write_t *);
         void dictUpload(ec_ioctl_slave_dict_upload_t *);
+        bool loadSnapshot();
+        void dropSnapshot();
+        uint32_t getSnapshotGeneration() const {return snapshotGeneration;}
+        unsigned int readEvents(ec_event_t *, unsigned int);
 
         unsigned int getMasterCount() const {return masterCount;}
 
@@ -177,6 +200,18 @@ class MasterDevice
         unsigned int index;
         unsigned int masterCount;
         int fd;
+
+        /** Bulk snapshot serving the getters above, if loaded. */
+        vector<uint8_t> snapshot;
+        uint32_t snapshotGeneration;
+        /** Per section: index of the first record of each parent record,
+         * with one extra element at the end. */
+        vector<unsigned int> snapshotFirst[EC_SNAPSHOT_SECTION_COUNT];
+
+        void indexSnapshot();
+        int snapshotChild(unsigned int, unsigned int, unsigned int) const;
+        template <class T>
+            const T *snapshotRecord(unsigned int, int) const;
 };
 
 /****************************************************************************/
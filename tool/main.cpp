@@ -42,8 +42,10 @@ using namespace std;
 #include "CommandData.h"
 #include "CommandDebug.h"
 #include "CommandDiag.h"
+#include "CommandDictCache.h"
 #include "CommandDomains.h"
 #include "CommandDownload.h"
+#include "CommandEvents.h"
 #ifdef EC_EOE
 #include "CommandEoe.h"
 #include "CommandEoeAddIf.h"
@@ -63,6 +65,8 @@ using namespace std;
 #include "CommandRegReadWrite.h"
 #include "CommandReboot.h"
 #include "CommandRescan.h"
+#include "CommandSched.h"
+#include "CommandScope.h"
 #include "CommandSdos.h"
 #include "CommandSiiRead.h"
 #include "CommandSiiWrite.h"
@@ -70,6 +74,8 @@ using namespace std;
 #include "CommandSoeRead.h"
 #include "CommandSoeWrite.h"
 #include "CommandStates.h"
+#include "CommandStats.h"
+#include "CommandThreads.h"
 #include "CommandUpload.h"
 #include "CommandVersion.h"
 #include "CommandXml.h"
@@ -96,6 +102,9 @@ bool force = false;
 bool emergency = false;
 bool helpRequested = false;
 bool reset = false;
+bool follow = false;
+bool batch = false;
+bool watch = false;
 string outputFile;
 string skin;
 
@@ -164,6 +173,9 @@ void getOptions(int argc, char **argv)
         {"emergency",   no_argument,       NULL, 'e'},
         {"force",       no_argument,       NULL, 'f'},
         {"reset",       no_argument,       NULL, 'r'},
+        {"follow",      no_argument,       NULL, 'F'},
+        {"batch",       no_argument,       NULL, 'b'},
+        {"watch",       no_argument,       NULL, 'w'},
         {"quiet",       no_argument,       NULL, 'q'},
         {"verbose",     no_argument,       NULL, 'v'},
         {"help",        no_argument,       NULL, 'h'},
@@ -171,7 +183,7 @@ void getOptions(int argc, char **argv)
     };
 
     do {
-        c = getopt_long(argc, argv, "m:a:p:d:t:o:s:efrqvh", longOptions, NULL);
+        c = getopt_long(argc, argv, "m:a:p:d:t:o:s:efrFbwqvh", longOptions, NULL);
 
         switch (c) {
             case 'm':
@@ -214,6 +226,18 @@ void getOptions(int argc, char **argv)
                 reset = true;
                 break;
 
+            case 'F':
+                follow = true;
+                break;
+
+            case 'b':
+                batch = true;
+                break;
+
+            case 'w':
+                watch = true;
+                break;
+
             case 'q':
                 verbosity = Command::Quiet;
                 break;
@@ -308,8 +332,10 @@ int main(int argc, char **argv)
     commandList.push_back(new CommandData());
     commandList.push_back(new CommandDebug());
     commandList.push_back(new CommandDiag());
+    commandList.push_back(new CommandDictCache());
     commandList.push_back(new CommandDomains());
     commandList.push_back(new CommandDownload());
+    commandList.push_back(new CommandEvents());
 #ifdef EC_EOE
     commandList.push_back(new CommandEoe());
     commandList.push_back(new CommandEoeAddIf());
@@ -329,6 +355,8 @@ int main(int argc, char **argv)
     commandList.push_back(new CommandRegReadWrite());
     commandList.push_back(new CommandReboot());
     commandList.push_back(new CommandRescan());
+    commandList.push_back(new CommandSched());
+    commandList.push_back(new CommandScope());
     commandList.push_back(new CommandSdos());
     commandList.push_back(new CommandSiiRead());
     commandList.push_back(new CommandSiiWrite());
@@ -336,6 +364,8 @@ int main(int argc, char **argv)
     commandList.push_back(new CommandSoeRead());
     commandList.push_back(new CommandSoeWrite());
     commandList.push_back(new CommandStates());
+    commandList.push_back(new CommandStats());
+    commandList.push_back(new CommandThreads());
     commandList.push_back(new CommandUpload());
     commandList.push_back(new CommandVersion());
     commandList.push_back(new CommandXml());
@@ -360,6 +390,9 @@ int main(int argc, char **argv)
                     cmd->setEmergency(emergency);
                     cmd->setForce(force);
                     cmd->setReset(reset);
+                    cmd->setFollow(follow);
+                    cmd->setBatch(batch);
+                    cmd->setWatch(watch);
                     cmd->execute(commandArgs);
                 } catch (InvalidUsageException &e) {
                     cerr << e.what() << endl << endl;
@@ -39,7 +39,8 @@
 #include <linux/tty_driver.h>
 #include <linux/tty_flip.h>
 #include <linux/termios.h>
-#include <linux/timer.h>
+#include <linux/workqueue.h>
+#include <linux/log2.h>
 #include <linux/version.h>
 #include <linux/serial.h>
 #include <linux/uaccess.h>
@@ -53,8 +54,9 @@
 #define PFX "ec_tty: "
 
 #define EC_TTY_MAX_DEVICES 32
-#define EC_TTY_TX_BUFFER_SIZE 100
-#define EC_TTY_RX_BUFFER_SIZE 100
+#define EC_TTY_DEFAULT_BUFFER_SIZE 4096
+#define EC_TTY_MIN_BUFFER_SIZE 64
+#define EC_TTY_MAX_BUFFER_SIZE (1024 * 1024)
 
 #define EC_TTY_DEBUG 0
 
@@ -62,15 +64,17 @@
 
 char *ec_master_version_str = EC_MASTER_VERSION; /**< Version string. */
 unsigned int debug_level = 0;
+static unsigned int tx_buffer_size = EC_TTY_DEFAULT_BUFFER_SIZE;
+static unsigned int rx_buffer_size = EC_TTY_DEFAULT_BUFFER_SIZE;
 
 static struct tty_driver *tty_driver = NULL;
 ec_tty_t *ttys[EC_TTY_MAX_DEVICES];
 struct semaphore tty_sem;
 
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0))
-void ec_tty_wakeup(struct timer_list *timer);
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 20))
+void ec_tty_wakeup(struct work_struct *);
 #else
-void ec_tty_wakeup(unsigned long);
+void ec_tty_wakeup(void *);
 #endif
 
 /*****************************************************************************/
@@ -84,6 +88,12 @@ MODULE_VERSION(EC_MASTER_VERSION);
 
 module_param_named(debug_level, debug_level, uint, S_IRUGO);
 MODULE_PARM_DESC(debug_level, "Debug level");
+module_param_named(tx_buffer_size, tx_buffer_size, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_buffer_size, "Transmit buffer size per interface"
+        " in bytes (rounded up to a power of two)");
+module_param_named(rx_buffer_size, rx_buffer_size, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_buffer_size, "Receive buffer size per interface"
+        " in bytes (rounded up to a power of two)");
 
 /** \endcond */
 
@@ -103,19 +113,27 @@ struct ec_tty {
     int minor;
     struct device *dev;
 
-    uint8_t tx_buffer[EC_TTY_TX_BUFFER_SIZE];
+    /* Both rings use free-running indices. The buffer sizes are powers of
+     * two, so the fill level is simply write_idx - read_idx. */
+    uint8_t *tx_buffer;
+    unsigned int tx_size;
     unsigned int tx_read_idx;
     unsigned int tx_write_idx;
     unsigned int wakeup;
 
-    uint8_t rx_buffer[EC_TTY_RX_BUFFER_SIZE];
+    uint8_t *rx_buffer;
+    unsigned int rx_size;
     unsigned int rx_read_idx;
     unsigned int rx_write_idx;
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3, 7, 0))
     struct tty_port port;
 #endif
 
-    struct timer_list timer;
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 20))
+    struct delayed_work work;
+#else
+    struct work_struct work;
+#endif
     struct tty_struct *tty;
     unsigned int open_count;
     struct semaphore sem;
@@ -128,6 +146,19 @@ static const struct tty_operations ec_tty_ops; // see below
 
 /*****************************************************************************/
 
+/** Clamps a requested buffer size and rounds it up to a power of two.
+ *
+ * \return Usable buffer size in bytes.
+ */
+static unsigned int ec_tty_buffer_size(unsigned int size)
+{
+    size = clamp(size, (unsigned int) EC_TTY_MIN_BUFFER_SIZE,
+            (unsigned int) EC_TTY_MAX_BUFFER_SIZE);
+    return roundup_pow_of_two(size);
+}
+
+/*****************************************************************************/
+
 /** Module initialization.
  *
  * \return 0 on success, else < 0
@@ -138,6 +169,9 @@ int __init ec_tty_init_module(void)
 
     printk(KERN_INFO PFX "TTY driver %s\n", EC_MASTER_VERSION);
 
+    tx_buffer_size = ec_tty_buffer_size(tx_buffer_size);
+    rx_buffer_size = ec_tty_buffer_size(rx_buffer_size);
+
     sema_init(&tty_sem, 1);
 
     for (i = 0; i < EC_TTY_MAX_DEVICES; i++) {
@@ -202,18 +236,29 @@ int ec_tty_init(ec_tty_t *t, int minor,
     struct ktermios *termios;
 
     t->minor = minor;
+    t->tx_size = tx_buffer_size;
     t->tx_read_idx = 0;
     t->tx_write_idx = 0;
     t->wakeup = 0;
+    t->rx_size = rx_buffer_size;
     t->rx_read_idx = 0;
     t->rx_write_idx = 0;
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0))
-    timer_setup(&t->timer, ec_tty_wakeup, 0);
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 20))
+    INIT_DELAYED_WORK(&t->work, ec_tty_wakeup);
 #else
-    init_timer(&t->timer);
-#endif    
+    INIT_WORK(&t->work, ec_tty_wakeup, t);
+#endif
     t->tty = NULL;
 
+    t->tx_buffer = kmalloc(t->tx_size, GFP_KERNEL);
+    t->rx_buffer = kmalloc(t->rx_size, GFP_KERNEL);
+    if (!t->tx_buffer || !t->rx_buffer) {
+        printk(KERN_ERR PFX "Failed to allocate ring buffers.\n");
+        kfree(t->tx_buffer);
+        kfree(t->rx_buffer);
+        return -ENOMEM;
+    }
+
     t->open_count = 0;
     sema_init(&t->sem, 1);
     t->ops = *ops;
@@ -227,6 +272,8 @@ int ec_tty_init(ec_tty_t *t, int minor,
     t->dev = tty_register_device(tty_driver, t->minor, NULL);
     if (IS_ERR(t->dev)) {
         printk(KERN_ERR PFX "Failed to register tty device.\n");
+        kfree(t->tx_buffer);
+        kfree(t->rx_buffer);
         return PTR_ERR(t->dev);
     }
 
@@ -251,15 +298,11 @@ int ec_tty_init(ec_tty_t *t, int minor,
         printk(KERN_ERR PFX "ERROR: Initial cflag 0x%x not accepted.\n",
                 cflag);
         tty_unregister_device(tty_driver, t->minor);
+        kfree(t->tx_buffer);
+        kfree(t->rx_buffer);
         return ret;
     }
 
-#if LINUX_VERSION_CODE < KERNEL_VERSION(4, 15, 0)
-    t->timer.function = ec_tty_wakeup;
-    t->timer.data = (unsigned long) t;
-#endif
-    t->timer.expires = jiffies + 10;
-    add_timer(&t->timer);
     return 0;
 }
 
@@ -267,52 +310,71 @@ int ec_tty_init(ec_tty_t *t, int minor,
 
 void ec_tty_clear(ec_tty_t *tty)
 {
-    del_timer_sync(&tty->timer);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 23)
+    cancel_delayed_work_sync(&tty->work);
+#else
+    cancel_delayed_work(&tty->work);
+    flush_scheduled_work();
+#endif
     tty_unregister_device(tty_driver, tty->minor);
+    kfree(tty->tx_buffer);
+    kfree(tty->rx_buffer);
 }
 
 /*****************************************************************************/
 
 unsigned int ec_tty_tx_size(ec_tty_t *tty)
 {
-    unsigned int ret;
-
-    if (tty->tx_write_idx >= tty->tx_read_idx) {
-        ret = tty->tx_write_idx - tty->tx_read_idx;
-    } else {
-        ret = EC_TTY_TX_BUFFER_SIZE + tty->tx_write_idx - tty->tx_read_idx;
-    }
-
-    return ret;
+    return tty->tx_write_idx - tty->tx_read_idx;
 }
 
 /*****************************************************************************/
 
 unsigned int ec_tty_tx_space(ec_tty_t *tty)
 {
-    return EC_TTY_TX_BUFFER_SIZE - 1 - ec_tty_tx_size(tty);
+    return tty->tx_size - ec_tty_tx_size(tty);
 }
 
 /*****************************************************************************/
 
 unsigned int ec_tty_rx_size(ec_tty_t *tty)
 {
-    unsigned int ret;
+    return tty->rx_write_idx - tty->rx_read_idx;
+}
 
-    if (tty->rx_write_idx >= tty->rx_read_idx) {
-        ret = tty->rx_write_idx - tty->rx_read_idx;
-    } else {
-        ret = EC_TTY_RX_BUFFER_SIZE + tty->rx_write_idx - tty->rx_read_idx;
-    }
+/*****************************************************************************/
 
-    return ret;
+unsigned int ec_tty_rx_space(ec_tty_t *tty)
+{
+    return tty->rx_size - ec_tty_rx_size(tty);
 }
 
 /*****************************************************************************/
 
-unsigned int ec_tty_rx_space(ec_tty_t *tty)
+/** Copies data into a ring buffer, wrapping at most once.
+ */
+static void ec_tty_ring_put(uint8_t *ring, unsigned int ring_size,
+        unsigned int idx, const uint8_t *data, unsigned int size)
+{
+    unsigned int off = idx & (ring_size - 1);
+    unsigned int first = min(size, ring_size - off);
+
+    memcpy(ring + off, data, first);
+    memcpy(ring, data + first, size - first);
+}
+
+/*****************************************************************************/
+
+/** Copies data out of a ring buffer, wrapping at most once.
+ */
+static void ec_tty_ring_get(const uint8_t *ring, unsigned int ring_size,
+        unsigned int idx, uint8_t *data, unsigned int size)
 {
-    return EC_TTY_RX_BUFFER_SIZE - 1 - ec_tty_rx_size(tty);
+    unsigned int off = idx & (ring_size - 1);
+    unsigned int first = min(size, ring_size - off);
+
+    memcpy(data, ring + off, first);
+    memcpy(data + first, ring, size - first);
 }
 
 /*****************************************************************************/
@@ -334,32 +396,41 @@ int ec_tty_get_serial_info(ec_tty_t *tty, struct serial_struct *data)
 
 /*****************************************************************************/
 
-/** Timer function.
+/** Deferred work function.
+ *
+ * Scheduled by ectty_tx_data() when ring space was freed, by
+ * ectty_rx_data() when data arrived and by ec_tty_open(), so idle
+ * interfaces cause no activity. If the TTY core cannot take all received
+ * data, the work re-schedules itself for the next tick until the receive
+ * ring is empty or the port is closed.
  */
-#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 15, 0))
-void ec_tty_wakeup(struct timer_list *timer)
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 20))
+void ec_tty_wakeup(struct work_struct *work)
 {
-	ec_tty_t *tty = from_timer(tty, timer, timer);
+    ec_tty_t *tty = container_of(work, ec_tty_t, work.work);
 #else
-void ec_tty_wakeup(unsigned long data)
+void ec_tty_wakeup(void *data)
 {
     ec_tty_t *tty = (ec_tty_t *) data;
 #endif
     size_t to_recv;
 
+    down(&tty->sem);
+
     /* Wake up any process waiting to send data */
     if (tty->wakeup) {
+        tty->wakeup = 0;
         if (tty->tty) {
 #if EC_TTY_DEBUG >= 1
             printk(KERN_INFO PFX "Waking up.\n");
 #endif
             tty_wakeup(tty->tty);
         }
-        tty->wakeup = 0;
     }
 
     /* Push received data into TTY core. */
     to_recv = ec_tty_rx_size(tty);
+    smp_rmb(); /* read the index before the data */
     if (to_recv && tty->tty) {
         unsigned char *cbuf;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 9, 0)
@@ -368,10 +439,12 @@ void ec_tty_wakeup(unsigned long data)
         int space = tty_prepare_flip_string(tty->tty, &cbuf, to_recv);
 #endif
 
+#if EC_TTY_DEBUG >= 1
         if (space < to_recv) {
-            printk(KERN_WARNING PFX "Insufficient space to_recv=%ld space=%d\n",
+            printk(KERN_INFO PFX "Insufficient space to_recv=%zu space=%d\n",
                     to_recv, space);
         }
+#endif
 
         if (space < 0) {
             to_recv = 0;
@@ -380,17 +453,14 @@ void ec_tty_wakeup(unsigned long data)
         }
 
         if (to_recv) {
-            unsigned int i;
-
 #if EC_TTY_DEBUG >= 1
             printk(KERN_INFO PFX "Pushing %zu bytes to TTY core.\n", to_recv);
 #endif
 
-            for (i = 0; i < to_recv; i++) {
-                cbuf[i] = tty->rx_buffer[tty->rx_read_idx];
-                tty->rx_read_idx =
-                    (tty->rx_read_idx + 1) % EC_TTY_RX_BUFFER_SIZE;
-            }
+            ec_tty_ring_get(tty->rx_buffer, tty->rx_size, tty->rx_read_idx,
+                    cbuf, to_recv);
+            smp_mb(); /* finish reading before releasing the space */
+            tty->rx_read_idx += to_recv;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 9, 0)
             tty_flip_buffer_push(tty->tty->port);
 #else
@@ -399,8 +469,12 @@ void ec_tty_wakeup(unsigned long data)
         }
     }
 
-    tty->timer.expires += 1;
-    add_timer(&tty->timer);
+    /* Retry the rest on the next tick. */
+    if (ec_tty_rx_size(tty) && tty->tty) {
+        schedule_delayed_work(&tty->work, 1);
+    }
+
+    up(&tty->sem);
 }
 
 /******************************************************************************
@@ -436,6 +510,9 @@ static int ec_tty_open(struct tty_struct *tty, struct file *file)
     down(&t->sem);
     t->open_count++;
     up(&t->sem);
+
+    /* Push data that arrived while the port was closed. */
+    schedule_delayed_work(&t->work, 0);
     return 0;
 }
 
@@ -468,7 +545,7 @@ static int ec_tty_write(
         )
 {
     ec_tty_t *t = (ec_tty_t *) tty->driver_data;
-    unsigned int data_size, i;
+    unsigned int data_size;
 
 #if EC_TTY_DEBUG >= 1
     printk(KERN_INFO PFX "%s(count=%i)\n", __func__, count);
@@ -479,10 +556,11 @@ static int ec_tty_write(
     }
 
     data_size = min(ec_tty_tx_space(t), (unsigned int) count);
-    for (i = 0; i < data_size; i++) {
-        t->tx_buffer[t->tx_write_idx] = buffer[i];
-        t->tx_write_idx = (t->tx_write_idx + 1) % EC_TTY_TX_BUFFER_SIZE;
-    }
+    smp_mb(); /* read the space before overwriting the data */
+    ec_tty_ring_put(t->tx_buffer, t->tx_size, t->tx_write_idx,
+            buffer, data_size);
+    smp_wmb(); /* publish the data before the index */
+    t->tx_write_idx += data_size;
 
 #if EC_TTY_DEBUG >= 1
     printk(KERN_INFO PFX "%s(): %u bytes written.\n", __func__, data_size);
@@ -505,8 +583,10 @@ static void ec_tty_put_char(struct tty_struct *tty, unsigned char ch)
 #endif
 
     if (ec_tty_tx_space(t)) {
-        t->tx_buffer[t->tx_write_idx] = ch;
-        t->tx_write_idx = (t->tx_write_idx + 1) % EC_TTY_TX_BUFFER_SIZE;
+        smp_mb();
+        t->tx_buffer[t->tx_write_idx & (t->tx_size - 1)] = ch;
+        smp_wmb();
+        t->tx_write_idx++;
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2, 6, 26)
         return 1;
 #endif
@@ -786,7 +866,7 @@ void ectty_free(ec_tty_t *tty)
 
 unsigned int ectty_tx_data(ec_tty_t *tty, uint8_t *buffer, size_t size)
 {
-    unsigned int data_size = min(ec_tty_tx_size(tty), (unsigned int)size), i;
+    unsigned int data_size = min(ec_tty_tx_size(tty), (unsigned int)size);
 
     if (data_size)  {
 #if EC_TTY_DEBUG >= 1
@@ -794,13 +874,15 @@ unsigned int ectty_tx_data(ec_tty_t *tty, uint8_t *buffer, size_t size)
 #endif
     }
 
-    for (i = 0; i < data_size; i++) {
-        buffer[i] = tty->tx_buffer[tty->tx_read_idx];
-        tty->tx_read_idx = (tty->tx_read_idx + 1) % EC_TTY_TX_BUFFER_SIZE;
-    }
-
     if (data_size) {
+        smp_rmb(); /* read the index before the data */
+        ec_tty_ring_get(tty->tx_buffer, tty->tx_size, tty->tx_read_idx,
+                buffer, data_size);
+        smp_mb(); /* finish reading before releasing the space */
+        tty->tx_read_idx += data_size;
+
         tty->wakeup = 1;
+        schedule_delayed_work(&tty->work, 0);
     }
 
     return data_size;
@@ -813,8 +895,6 @@ void ectty_rx_data(ec_tty_t *tty, const uint8_t *buffer, size_t size)
     size_t to_recv;
 
     if (size)  {
-        unsigned int i;
-
 #if EC_TTY_DEBUG >= 1
         printk(KERN_INFO PFX "Received %zu bytes.\n", size);
 #endif
@@ -825,10 +905,13 @@ void ectty_rx_data(ec_tty_t *tty, const uint8_t *buffer, size_t size)
             printk(KERN_WARNING PFX "Dropping %zu bytes.\n", size - to_recv);
         }
 
-        for (i = 0; i < size; i++) {
-            tty->rx_buffer[tty->rx_write_idx] = buffer[i];
-            tty->rx_write_idx =
-                (tty->rx_write_idx + 1) % EC_TTY_RX_BUFFER_SIZE;
+        if (to_recv) {
+            smp_mb(); /* read the space before overwriting the data */
+            ec_tty_ring_put(tty->rx_buffer, tty->rx_size, tty->rx_write_idx,
+                    buffer, to_recv);
+            smp_wmb(); /* publish the data before the index */
+            tty->rx_write_idx += to_recv;
+            schedule_delayed_work(&tty->work, 0);
         }
     }
 }